@@ -11,7 +11,9 @@
 
 #include <memory>
 #include <vector>
+#include <QCoreApplication>
 #include <QMetaType>
+#include <QStringList>
 #include <QUrl>
 #include <QtGlobal>
 #include <QtWebEngineCoreVersion>
@@ -164,49 +166,15 @@ int main(int argc, char *argv[])
     BrowserIPC ipc;
     if (ipc.hasExistingInstance())
     {
-        QString ipcMessage;
-
-        // If appArgUrls is not empty, concatenate the
-        // URLs into a string (length must be < BrowserIPC::BufferLength),
-        // and pass as a single message to existing process.
-        // Otherwise, pass message "new-window"
-        if (!appArgUrls.empty())
-        {
-            const int headerLen = static_cast<int>(sizeof(int));
-            for (size_t i = 0; i < appArgUrls.size(); ++i)
-            {
-                const QUrl &url = appArgUrls.at(i);
-                const QString urlString = url.toString();
-                const bool isLastUrl = i + 1 == appArgUrls.size();
-
-                int additionalLength = urlString.length();
-                if (!isLastUrl)
-                    additionalLength++;
-
-                if (ipcMessage.length() + additionalLength + headerLen > BrowserIPC::BufferLength)
-                    break;
-
-                ipcMessage += urlString;
-                if (!isLastUrl)
-                    ipcMessage += QLatin1Char('\t');
-            }
-        }
-        else
-        {
-            ipcMessage = QLatin1String("new-window");
-        }
-
-        std::string ipcMessageStdString = ipcMessage.toStdString();
-
-        size_t ipcBufferLen = ipcMessageStdString.size() + sizeof(int);
-
-        std::vector<char> messageBuffer(ipcBufferLen, '\0');
-        char *rawBuffer = messageBuffer.data();
-        const int stringLen = static_cast<int>(ipcMessageStdString.size());
-        memcpy(rawBuffer, &stringLen, sizeof(int));
-        memcpy(&rawBuffer[sizeof(int)], ipcMessageStdString.c_str(), ipcMessageStdString.size());
+        // Pass the URLs to the existing process as a single message. An empty
+        // message asks the existing process to open a new window
+        QStringList ipcMessage;
+        for (const QUrl &url : appArgUrls)
+            ipcMessage.append(url.toString());
 
-        ipc.sendMessage(const_cast<const char*>(rawBuffer), static_cast<int>(ipcBufferLen));
+        // The local socket needs an event dispatcher, which is created along with the application object
+        QCoreApplication ipcApp(argc, argv);
+        ipc.sendMessage(ipcMessage);
 
         return 0;
     }
@@ -7,6 +7,8 @@
 #include "DownloadManager.h"
 #include "SchemeRegistry.h"
 
+#include <optional>
+
 #include <QDir>
 #include <QDirIterator>
 #include <QFile>
@@ -21,6 +23,41 @@
 namespace adblock
 {
 
+namespace
+{
+    /// Creates a domain script that runs the given source in the user world of every frame, as soon as a document is created
+    DomainScript createDomainScript(const QString &source, const QString &name)
+    {
+        DomainScript result;
+        result.Source = source;
+        if (source.isEmpty())
+            return result;
+
+        result.Script.setSourceCode(source);
+        result.Script.setName(name);
+        result.Script.setRunsOnSubFrames(true);
+        result.Script.setWorldId(QWebEngineScript::UserWorld);
+        result.Script.setInjectionPoint(QWebEngineScript::DocumentCreation);
+        return result;
+    }
+
+    /// Escapes the given source for use in a template literal, and wraps it in a script that adds it to the document as a script tag
+    QString createPageInjectionSource(QString source)
+    {
+        const static QString mutationScript = QStringLiteral("function selfInject() { "
+                                         "try { let script = document.createElement('script'); "
+                                         "script.appendChild(document.createTextNode(`%1`)); "
+                                         "if (document.head || document.documentElement) { (document.head || document.documentElement).appendChild(script); } "
+                                         "else { setTimeout(selfInject, 100); } "
+                                         " } catch(exc) { console.error('Could not run mutation script: ' + exc); } } selfInject();");
+
+        source.replace(QLatin1String("\\"), QLatin1String("\\\\"));
+        source.replace(QLatin1String("`"), QLatin1String("\\`"));
+        source.replace(QLatin1String("${"), QLatin1String("\\${"));
+        return mutationScript.arg(source);
+    }
+}
+
 AdBlockManager::AdBlockManager(const ViperServiceLocator &serviceLocator, QObject *parent) :
     QObject(parent),
     m_filterContainer(),
@@ -80,8 +117,8 @@ AdBlockManager::AdBlockManager(const ViperServiceLocator &serviceLocator, QObjec
     },
     m_resourceMap(),
     m_resourceContentTypeMap(),
-    m_domainStylesheetCache(24),
-    m_jsInjectionCache(24),
+    m_domainStylesheetCache(MaxCachedStringBytes, 4),
+    m_jsInjectionCache(MaxCachedStringBytes, 4),
     m_emptyStr(),
     m_adBlockModel(nullptr),
     m_log(nullptr),
@@ -274,10 +311,10 @@ const QString &AdBlockManager::getStylesheet(const URL &url) const
     return m_filterContainer.getCombinedFilterStylesheet();
 }
 
-const QString &AdBlockManager::getDomainStylesheet(const URL &url)
+DomainScript AdBlockManager::getDomainStylesheet(const URL &url)
 {
     if (!m_enabled)
-        return m_emptyStr;
+        return DomainScript();
 
     QString domain = url.host().toLower();
     if (domain.startsWith(QLatin1String("www.")))
@@ -285,8 +322,8 @@ const QString &AdBlockManager::getDomainStylesheet(const URL &url)
 
     // Check for a cache hit
     std::string domainStdStr = domain.toStdString();
-    if (m_domainStylesheetCache.has(domainStdStr))
-        return m_domainStylesheetCache.get(domainStdStr);
+    if (std::optional<DomainScript> cachedStylesheet = m_domainStylesheetCache.tryGet(domainStdStr))
+        return *cachedStylesheet;
 
     const static QString styleScript = QStringLiteral("(function() {\n"
                                        "var doc = document;\n"
@@ -348,14 +385,15 @@ const QString &AdBlockManager::getDomainStylesheet(const URL &url)
     }
 
     // Insert the stylesheet into cache
-    m_domainStylesheetCache.put(domainStdStr, stylesheet);
-    return m_domainStylesheetCache.get(domainStdStr);
+    DomainScript result = createDomainScript(stylesheet, QLatin1String("viper-cosmetic-blocker"));
+    m_domainStylesheetCache.put(domainStdStr, result);
+    return result;
 }
 
-const QString &AdBlockManager::getDomainJavaScript(const URL &url)
+DomainScript AdBlockManager::getDomainJavaScript(const URL &url)
 {
     if (!m_enabled)
-        return m_emptyStr;
+        return DomainScript();
 
     const static QString cspScript = QStringLiteral("(function() {\n"
                                        "var doc = document;\n"
@@ -389,8 +427,8 @@ const QString &AdBlockManager::getDomainJavaScript(const URL &url)
     if (requestHostStdStr.empty())
         requestHostStdStr = domain.toStdString();
 
-    if (m_jsInjectionCache.has(requestHostStdStr))
-        return m_jsInjectionCache.get(requestHostStdStr);
+    if (std::optional<DomainScript> cachedScript = m_jsInjectionCache.tryGet(requestHostStdStr))
+        return *cachedScript;
 
     QString scriptlets;
     QString proceduralFilters;
@@ -433,8 +471,13 @@ const QString &AdBlockManager::getDomainJavaScript(const URL &url)
         result.replace(QStringLiteral("{{ADBLOCK_INTERNAL_COSMETIC}}"), proceduralFilters);
     }
 
-    m_jsInjectionCache.put(requestHostStdStr, result);
-    return m_jsInjectionCache.get(requestHostStdStr);
+    // Escape and wrap the script for injection into the page once, rather than on each navigation
+    DomainScript domainScript = createDomainScript(result, QLatin1String("viper-content-blocker-userworld"));
+    if (!result.isEmpty())
+        domainScript.PageSource = createPageInjectionSource(result);
+
+    m_jsInjectionCache.put(requestHostStdStr, domainScript);
+    return domainScript;
 }
 
 bool AdBlockManager::shouldBlockRequest(QWebEngineUrlRequestInfo &info, const QUrl &firstPartyUrl)
@@ -4,15 +4,16 @@
 #include "AdBlockFilter.h"
 #include "AdBlockFilterContainer.h"
 #include "AdBlockSubscription.h"
-#include "LRUCache.h"
 #include "ServiceLocator.h"
 #include "Settings.h"
+#include "ShardedLRUCache.h"
 #include "ISettingsObserver.h"
 #include "URL.h"
 
 #include <QHash>
 #include <QObject>
 #include <QString>
+#include <QWebEngineScript>
 #include <QWebEngineUrlRequestInfo>
 
 #include <deque>
@@ -27,6 +28,33 @@ namespace adblock
     class AdBlockModel;
     class RequestHandler;
 
+/// Maximum size, in bytes, of each cache of domain-specific stylesheets and scripts
+constexpr std::size_t MaxCachedStringBytes = 4 * 1024 * 1024;
+
+/// A domain-specific script of the ad block system, kept in the forms in which it is injected into pages
+struct DomainScript
+{
+    /// Source of the script, or an empty string if nothing applies to the domain
+    QString Source;
+
+    /// Script that runs the source in the user world as soon as a document is created
+    QWebEngineScript Script;
+
+    /// Source escaped and wrapped so that it adds itself to the document as a script tag, and runs in the
+    /// world of the page. Only set for the domain JavaScript
+    QString PageSource;
+};
+
+/// Measures the cost of a cached domain script by its size in bytes, counting the copy of the source
+/// held by the QWebEngineScript
+struct CachedScriptCost
+{
+    std::size_t operator()(const DomainScript &value) const
+    {
+        return static_cast<std::size_t>(2 * value.Source.size() + value.PageSource.size()) * sizeof(QChar);
+    }
+};
+
 /**
  * @defgroup AdBlock Advertisement Blocking System
  * An implementation of the AdBlockPlus and uBlock Origin style content filtering system
@@ -66,11 +94,11 @@ class AdBlockManager : public QObject, public ISettingsObserver
     /// Returns the base stylesheet for elements to be blocked. If the given url matches a generichide filter, this will return an empty string
     const QString &getStylesheet(const URL &url) const;
 
-    /// Returns the domain-specific blocking stylesheet, or an empty string if not applicable
-    const QString &getDomainStylesheet(const URL &url);
+    /// Returns the domain-specific blocking stylesheet script, which has an empty source if not applicable
+    DomainScript getDomainStylesheet(const URL &url);
 
-    /// Returns the domain-specific blocking javascript, or an empty string if not applicable
-    const QString &getDomainJavaScript(const URL &url);
+    /// Returns the domain-specific blocking javascript, which has an empty source if not applicable
+    DomainScript getDomainJavaScript(const URL &url);
 
     /// Returns true if the given request should be blocked, false if else
     bool shouldBlockRequest(QWebEngineUrlRequestInfo &info, const QUrl &firstPartyUrl);
@@ -193,10 +221,10 @@ private Q_SLOTS:
     QHash<QString, QString> m_resourceContentTypeMap;
 
     /// A cache of the most recently used domain-specific stylesheets
-    LRUCache<std::string, QString> m_domainStylesheetCache;
+    ShardedLRUCache<std::string, DomainScript, CachedScriptCost> m_domainStylesheetCache;
 
     /// A cache of the most recently used javascript injection scripts for specific URLs
-    LRUCache<std::string, QString> m_jsInjectionCache;
+    ShardedLRUCache<std::string, DomainScript, CachedScriptCost> m_jsInjectionCache;
 
     /// Empty string, used when getDomainStylesheet returns nothing
     QString m_emptyStr;
@@ -7,6 +7,7 @@
 #include "BookmarkStore.h"
 #include "BrowserIPC.h"
 #include "CookieJar.h"
+#include "CookieStore.h"
 #include "CookieWidget.h"
 #include "DatabaseFactory.h"
 #include "DownloadManager.h"
@@ -18,9 +19,11 @@
 #include "HistoryStore.h"
 #include "MainWindow.h"
 #include "SecurityManager.h"
+#include "TabHibernationScheduler.h"
 #include "SearchEngineManager.h"
 #include "Settings.h"
 #include "NetworkAccessManager.h"
+#include "PdfDocumentRegistry.h"
 #include "RequestInterceptor.h"
 #include "UserAgentManager.h"
 #include "UserScriptManager.h"
@@ -44,7 +47,8 @@
 #include <QtWebEngineCoreVersion>
 
 BrowserApplication::BrowserApplication(BrowserIPC *ipc, int &argc, char **argv) :
-    QApplication(argc, argv)
+    QApplication(argc, argv),
+    m_guiWatchdog(250, 100)
 {
     QCoreApplication::setOrganizationName(QLatin1String("Vaccarelli"));
     QCoreApplication::setApplicationName(QLatin1String("Viper Browser"));
@@ -58,20 +62,22 @@ BrowserApplication::BrowserApplication(BrowserIPC *ipc, int &argc, char **argv)
     // Web profiles must be set up immediately upon browser initialization
     setupWebProfiles();
 
-    // Set pointer to the IPC handler. This is checked for pending messages on a regular basis
+    // Set pointer to the IPC handler, and handle messages from other instances as soon as they arrive
     m_ipc = ipc;
-
-    // Check for IPC messages every 5 seconds
-    m_ipcTimerId = startTimer(1000 * 5);
+    if (m_ipc != nullptr)
+    {
+        connect(m_ipc, &BrowserIPC::messageReceived, this, &BrowserApplication::onIPCMessage);
+        m_ipc->listen();
+    }
 
     // Instantiate and load settings
     m_settings = new Settings;
     registerService(m_settings);
 
     // Initialize favicon storage module
-    //m_databaseScheduler.addWorker("FaviconStore",
-    //                              std::bind(DatabaseFactory::createDBWorker<FaviconStore>, m_settings->getPathValue(BrowserSetting::FaviconPath)));
-    m_faviconMgr = new FaviconManager(m_settings->getPathValue(BrowserSetting::FaviconPath));
+    m_databaseScheduler.addWorker("FaviconStore",
+                                  std::bind(DatabaseFactory::createDBWorker<FaviconStore>, m_settings->getPathValue(BrowserSetting::FaviconPath)));
+    m_faviconMgr = new FaviconManager(m_databaseScheduler);
     registerService(m_faviconMgr);
 
     // Bookmark setup
@@ -81,10 +87,12 @@ BrowserApplication::BrowserApplication(BrowserIPC *ipc, int &argc, char **argv)
     registerService(m_bookmarkManager);
 
     // Initialize cookie jar and cookie manager UI
-    m_cookieJar = new CookieJar(m_settings, false);
+    m_databaseScheduler.addWorker("CookieStore",
+                                  std::bind(DatabaseFactory::createDBWorker<CookieStore>, m_settings->getPathValue(BrowserSetting::CookiePath)));
+    m_cookieJar = new CookieJar(m_settings, &m_databaseScheduler, false);
     registerService(m_cookieJar);
 
-    m_cookieUI = new CookieWidget();
+    m_cookieUI = new CookieWidget(m_cookieJar);
     registerService(m_cookieUI);
 
     // Get default profile and load cookies now that the cookie jar is instantiated
@@ -151,6 +159,9 @@ BrowserApplication::BrowserApplication(BrowserIPC *ipc, int &argc, char **argv)
     // Set browser's saved sessions file
     m_sessionMgr.setSessionFile(m_settings->getPathValue(BrowserSetting::SessionFile));
 
+    // Automatically hibernate inactive background tabs
+    m_tabHibernationScheduler = new TabHibernationScheduler(m_settings);
+
     // Inject services into the security manager
     SecurityManager::instance().setServiceLocator(m_serviceLocator);
 
@@ -163,15 +174,27 @@ BrowserApplication::BrowserApplication(BrowserIPC *ipc, int &argc, char **argv)
         QDesktopServices::setUrlHandler(scheme, this, "openUrl");
 
     m_databaseScheduler.run();
+
+    // Watch for stalls of the GUI thread, and report long ones as they occur
+    connect(&m_guiWatchdog, &EventLoopWatchdog::stallDetected, this, [](qint64 durationMs){
+        if (durationMs >= 1000)
+            qWarning() << "BrowserApplication - GUI thread was blocked for" << durationMs << "ms";
+    });
+    m_guiWatchdog.start();
 }
 
 BrowserApplication::~BrowserApplication()
 {
-    m_ipc = nullptr;
-    killTimer(m_ipcTimerId);
+    if (m_ipc != nullptr)
+    {
+        disconnect(m_ipc, &BrowserIPC::messageReceived, this, &BrowserApplication::onIPCMessage);
+        m_ipc->close();
+        m_ipc = nullptr;
+    }
 
     m_databaseScheduler.stop();
 
+    delete m_tabHibernationScheduler;
     delete m_downloadMgr;
     delete m_networkAccessMgr;
     delete m_userAgentMgr;
@@ -181,6 +204,7 @@ BrowserApplication::~BrowserApplication()
     delete m_requestInterceptor;
 #endif
     delete m_viperSchemeHandler;
+    delete m_pdfDocumentRegistry;
     delete m_blockedSchemeHandler;
     delete m_cookieUI;
     delete m_autoFill;
@@ -253,6 +277,8 @@ MainWindow *BrowserApplication::getNewWindow()
 
     MainWindow *w = new MainWindow(m_serviceLocator, false);
     m_browserWindows.append(w);
+    m_tabHibernationScheduler->addTabWidget(w->getTabWidget());
+    m_sessionMgr.addWindow(w);
     connect(w, &MainWindow::aboutToClose, this, &BrowserApplication::maybeSaveSession);
     connect(w, &MainWindow::destroyed, [this, w](){
         if (m_browserWindows.contains(w))
@@ -292,6 +318,7 @@ MainWindow *BrowserApplication::getNewPrivateWindow()
 {
     MainWindow *w = new MainWindow(m_serviceLocator, true);
     m_browserWindows.append(w);
+    m_tabHibernationScheduler->addTabWidget(w->getTabWidget());
     connect(w, &MainWindow::destroyed, [this, w](){
         if (m_browserWindows.contains(w))
             m_browserWindows.removeOne(w);
@@ -354,16 +381,6 @@ void BrowserApplication::clearHistoryRange(HistoryType histType, std::pair<QDate
     //todo: support clearing form and search data
 }
 
-void BrowserApplication::timerEvent(QTimerEvent *event)
-{
-    QApplication::timerEvent(event);
-
-    if (event->timerId() == m_ipcTimerId)
-    {
-        checkBrowserIPC();
-    }
-}
-
 void BrowserApplication::installGlobalWebScripts()
 {
     BrowserScripts browserScriptContainer;
@@ -409,7 +426,10 @@ void BrowserApplication::setupWebProfiles()
 #endif
 
     // Instantiate scheme handlers
-    m_viperSchemeHandler = new ViperSchemeHandler(this);
+    m_pdfDocumentRegistry = new PdfDocumentRegistry;
+    registerService(m_pdfDocumentRegistry);
+
+    m_viperSchemeHandler = new ViperSchemeHandler(m_serviceLocator, this);
     m_blockedSchemeHandler = new BlockedSchemeHandler(m_serviceLocator, this);
 
     // Attach request interceptor and scheme handlers to web profiles
@@ -425,20 +445,9 @@ void BrowserApplication::setupWebProfiles()
     m_privateProfile->installUrlSchemeHandler("blocked", m_blockedSchemeHandler);
 }
 
-void BrowserApplication::checkBrowserIPC()
+void BrowserApplication::onIPCMessage(const QStringList &message)
 {
-    if (m_ipc == nullptr || !m_ipc->hasMessage())
-        return;
-
-    std::vector<char> message = m_ipc->getMessage();
-    if (message.empty() || message.at(0) == '\0')
-        return;
-
-    // Handle message
-    std::string messageStdString(message.data(), message.size());
-    QString messageStr = QString::fromStdString(messageStdString);
-
-    if (messageStr.compare(QLatin1String("new-window")) == 0)
+    if (message.isEmpty())
     {
         static_cast<void>(getNewWindow());
     }
@@ -461,8 +470,7 @@ void BrowserApplication::checkBrowserIPC()
         if (!activeWin)
             activeWin = getNewWindow();
 
-        QStringList urlList = messageStr.split(QChar('\t'), QString::SkipEmptyParts);
-        for (const QString &urlStr : urlList)
+        for (const QString &urlStr : message)
         {
             QUrl url = QUrl::fromUserInput(urlStr);
             if (!url.isEmpty() && !url.scheme().isEmpty() && url.isValid())
@@ -478,6 +486,11 @@ void BrowserApplication::checkBrowserIPC()
 
 void BrowserApplication::beforeBrowserQuit()
 {
+    m_guiWatchdog.stop();
+    const EventLoopStallStats &stallStats = m_guiWatchdog.getStats();
+    qDebug() << "BrowserApplication - GUI thread stalled" << stallStats.Count << "times, for"
+             << stallStats.TotalMs << "ms in total, longest stall was" << stallStats.LongestMs << "ms";
+
     const StartupMode mode = static_cast<StartupMode>(m_settings->getValue(BrowserSetting::StartupMode).toInt());
 
     // Get all windows that can be saved
@@ -6,10 +6,12 @@
 #include <QDateTime>
 #include <QList>
 #include <QPointer>
+#include <QStringList>
 
 #include "BookmarkNode.h"
 #include "ClearHistoryOptions.h"
 #include "DatabaseTaskScheduler.h"
+#include "EventLoopWatchdog.h"
 #include "ServiceLocator.h"
 #include "SessionManager.h"
 #include "Settings.h"
@@ -31,8 +33,10 @@ class FavoritePagesManager;
 class HistoryManager;
 class MainWindow;
 class NetworkAccessManager;
+class PdfDocumentRegistry;
 class RequestInterceptor;
 class Settings;
+class TabHibernationScheduler;
 class UserAgentManager;
 class UserScriptManager;
 class ViperSchemeHandler;
@@ -114,10 +118,6 @@ private Q_SLOTS:
     /// Clears the given history type(s) from the browser's storage within the given {start, end} date-time range
     void clearHistoryRange(HistoryType histType, std::pair<QDateTime, QDateTime> range);
 
-protected:
-    /// Called on a regular interval to check for messages in the IPC channel
-    void timerEvent(QTimerEvent *event) override;
-
 private:
     /// Installs core browser scripts into the script collection
     void installGlobalWebScripts();
@@ -129,17 +129,14 @@ private Q_SLOTS:
     /// This includes instantiation of request interceptors and custom scheme handlers.
     void setupWebProfiles();
 
-    /// Checks for any unread inter-process messages. This would be empty, or it would
-    /// contain a request to open one or more URLs.
-    void checkBrowserIPC();
+    /// Handles a message from another instance of the browser, which either contains one or more URLs
+    /// to open, or is empty to request a new window
+    void onIPCMessage(const QStringList &message);
 
 private:
     /// Inter-process communication handler
     BrowserIPC *m_ipc;
 
-    /// Unique identifier of the timer that is used to check for pending messages in the IPC channel
-    int m_ipcTimerId;
-
     /// Application settings
     Settings *m_settings;
 
@@ -179,12 +176,18 @@ private Q_SLOTS:
     /// List of browser windows
     QList< QPointer<MainWindow> > m_browserWindows;
 
+    /// Hibernates inactive background tabs of the browser windows
+    TabHibernationScheduler *m_tabHibernationScheduler;
+
     /// Browsing session manager
     SessionManager m_sessionMgr;
 
     /// Request interceptor
     RequestInterceptor *m_requestInterceptor;
 
+    /// Registry of the PDF documents that the viper scheme handler serves to the PDF.js viewer
+    PdfDocumentRegistry *m_pdfDocumentRegistry;
+
     /// viper scheme handler
     ViperSchemeHandler *m_viperSchemeHandler;
 
@@ -211,6 +214,9 @@ private Q_SLOTS:
 
     /// Database worker task scheduler
     DatabaseTaskScheduler m_databaseScheduler;
+
+    /// Records how often, and for how long, the GUI thread was blocked
+    EventLoopWatchdog m_guiWatchdog;
 };
 
 #define sBrowserApplication BrowserApplication::instance()
@@ -1,146 +1,341 @@
 #include "BookmarkImporter.h"
 #include "BookmarkNode.h"
 
-#include <stack>
+#include <functional>
 #include <utility>
+#include <vector>
+
 #include <QDebug>
 #include <QFile>
+#include <QTextStream>
 #include <QUrl>
 
-BookmarkImporter::BookmarkImporter(BookmarkManager *bookmarkMgr) :
-    m_bookmarkManager(bookmarkMgr),
-    m_folderStartTag("<DL><p>"),
-    m_folderEndTag("</DL><p>"),
-    m_folderNameStartTag("<DT><H3"),
-    m_folderNameEndTag("</H3>"),
-    m_bookmarkStartTag("<DT><A"),
-    m_bookmarkEndTag("</A>"),
-    m_startTag('<'),
-    m_endTag('>')
+namespace
 {
-}
+    /// Number of characters read from a bookmark file at a time
+    constexpr qint64 ReadChunkSize = 64 * 1024;
 
-bool BookmarkImporter::import(const QString &fileName, BookmarkNode *importFolder)
-{
-    if (!importFolder)
-        return false;
+    /**
+     * @class HtmlTokenizer
+     * @brief Splits HTML into tags and the text between them as it is fed, passing each token to a handler
+     *        without holding the rest of the document in memory
+     */
+    class HtmlTokenizer
+    {
+    public:
+        /// Types of tokens produced by the tokenizer
+        enum class TokenType
+        {
+            /// Contents of a tag, without the enclosing angle brackets
+            Tag,
 
-    // Attempt to read bookmark file contents
-    QFile file(fileName);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
-        return false;
-    QByteArray contents = file.readAll();
-    file.close();
+            /// Text between two tags
+            Text
+        };
 
-    if (contents.isEmpty())
-        return false;
+        /// Handles a token of the given type
+        using TokenHandler = std::function<void(TokenType, const QString&)>;
 
-    QString pageHtml = QString::fromUtf8(contents);
-    const int pageHtmlSize = pageHtml.size();
+        /// Constructs the tokenizer with the given token handler
+        explicit HtmlTokenizer(TokenHandler handler) :
+            m_handler(handler),
+            m_buffer(),
+            m_isInTag(false),
+            m_quote()
+        {
+        }
 
-    // Find first <DL><p> for root folder
-    int pos = pageHtml.indexOf(m_folderStartTag, 0, Qt::CaseInsensitive);
-    if (pos == -1)
-        return false;
-    pos += m_folderStartTag.size();
+        /// Tokenizes the next chunk of the document
+        void feed(const QString &chunk)
+        {
+            for (const QChar c : chunk)
+            {
+                if (!m_isInTag)
+                {
+                    if (c == QLatin1Char('<'))
+                    {
+                        emitToken(TokenType::Text);
+                        m_isInTag = true;
+                    }
+                    else
+                        m_buffer.append(c);
+                    continue;
+                }
 
-    BookmarkNode *currentNode = importFolder;
-    std::stack<BookmarkNode*> s;
+                // Skip over quoted attribute values, which may contain angle brackets
+                if (!m_quote.isNull())
+                {
+                    if (c == m_quote)
+                        m_quote = QChar();
+                    m_buffer.append(c);
+                    continue;
+                }
 
-    m_bookmarkManager->setCanUpdateList(false);
-    while (pos > 0 && pos < pageHtmlSize && currentNode != nullptr)
-    {
-        pos = pageHtml.indexOf(m_startTag, pos);
-        if (pos == -1)
-            break;
+                if ((c == QLatin1Char('"') || c == QLatin1Char('\'')) && m_buffer.endsWith(QLatin1Char('=')))
+                    m_quote = c;
+                else if (c == QLatin1Char('>')
+                         && (!m_buffer.startsWith(QLatin1String("!--")) || m_buffer.endsWith(QLatin1String("--"))))
+                {
+                    emitToken(TokenType::Tag);
+                    m_isInTag = false;
+                    continue;
+                }
 
-        // Determine element type by comparing pos to position of the next sub-folder, bookmark and closing folder tag
-        int nextFolderStartPos = pageHtml.indexOf(m_folderNameStartTag, pos, Qt::CaseInsensitive);
-        if (pos == nextFolderStartPos)
-        {
-            // Skip folder attributes and only get the name, contained within the <h3>element</h3>
-            pos = pageHtml.indexOf(m_endTag, pos + m_folderNameStartTag.size()) + 1;
-            int nameEndPos = pageHtml.indexOf(m_folderNameEndTag, pos, Qt::CaseInsensitive);
-            if (nameEndPos < 0)
-            {
-                qDebug() << "Error: invalid bookmark html. Halting import";
-                m_bookmarkManager->setCanUpdateList(true);
-                return false;
+                m_buffer.append(c);
             }
+        }
+
+        /// Passes any remaining text to the handler, once the end of the document has been reached
+        void finish()
+        {
+            if (!m_isInTag)
+                emitToken(TokenType::Text);
+            m_buffer.clear();
+        }
 
-            QString folderName = pageHtml.mid(pos, nameEndPos - pos);
+    private:
+        /// Passes the buffered token to the handler, if it is not empty
+        void emitToken(TokenType type)
+        {
+            if (m_buffer.isEmpty())
+                return;
 
-            // Create bookmark folder for the child element and start parsing child node
-            s.push(currentNode);
-            currentNode = m_bookmarkManager->addFolder(folderName, currentNode);
-            pos = pageHtml.indexOf(m_folderStartTag, nameEndPos + m_folderNameEndTag.size(), Qt::CaseInsensitive);
-            if (pos > 0)
-                pos += m_folderStartTag.size();
-            continue;
+            m_handler(type, m_buffer);
+            m_buffer.clear();
         }
 
-        int nextFolderEndPos = pageHtml.indexOf(m_folderEndTag, pos - 1, Qt::CaseInsensitive);
-        if (pos == nextFolderEndPos)
+    private:
+        /// Handler of each token
+        TokenHandler m_handler;
+
+        /// Contents of the current token
+        QString m_buffer;
+
+        /// True if the current token is a tag, false if it is text
+        bool m_isInTag;
+
+        /// Quote character of the attribute value that is being read, or a null character if not in a quoted value
+        QChar m_quote;
+    };
+
+    /// Returns the lower case name of the given tag, without the slash of an end tag
+    QString getTagName(const QString &tag)
+    {
+        const int nameStart = tag.startsWith(QLatin1Char('/')) ? 1 : 0;
+        int nameEnd = nameStart;
+        while (nameEnd < tag.size() && !tag.at(nameEnd).isSpace() && tag.at(nameEnd) != QLatin1Char('/'))
+            ++nameEnd;
+
+        return tag.mid(nameStart, nameEnd - nameStart).toLower();
+    }
+
+    /// Returns the value of the attribute with the given name in the tag, or an empty string if not found
+    QString getAttribute(const QString &tag, const QLatin1String &name)
+    {
+        // Attribute names follow the tag name, so a match at the start of the tag is ignored
+        int pos = 0;
+        while ((pos = tag.indexOf(name, pos + 1, Qt::CaseInsensitive)) > 0)
         {
-            // Current folder is done being imported, retrieve last folder from the stack and resume importing of that folder
-            pos += m_folderEndTag.size();
-            if (!s.empty())
+            if (!tag.at(pos - 1).isSpace())
+                continue;
+
+            int valuePos = pos + name.size();
+
+            while (valuePos < tag.size() && tag.at(valuePos).isSpace())
+                ++valuePos;
+            if (valuePos >= tag.size() || tag.at(valuePos) != QLatin1Char('='))
+                continue;
+
+            ++valuePos;
+            while (valuePos < tag.size() && tag.at(valuePos).isSpace())
+                ++valuePos;
+            if (valuePos >= tag.size())
+                return QString();
+
+            const QChar quote = tag.at(valuePos);
+            if (quote == QLatin1Char('"') || quote == QLatin1Char('\''))
             {
-                currentNode = s.top();
-                s.pop();
+                int valueEnd = tag.indexOf(quote, valuePos + 1);
+                if (valueEnd < 0)
+                    valueEnd = tag.size();
+                return tag.mid(valuePos + 1, valueEnd - valuePos - 1);
             }
-            else
-                currentNode = nullptr;
-            continue;
+
+            int valueEnd = valuePos;
+            while (valueEnd < tag.size() && !tag.at(valueEnd).isSpace())
+                ++valueEnd;
+            return tag.mid(valuePos, valueEnd - valuePos);
         }
 
-        int nextBookmarkPos = pageHtml.indexOf(m_bookmarkStartTag, pos, Qt::CaseInsensitive);
-        if (pos == nextBookmarkPos)
+        return QString();
+    }
+
+    /// Replaces the character references in the given text with the characters they represent
+    QString decodeEntities(const QString &text)
+    {
+        if (!text.contains(QLatin1Char('&')))
+            return text;
+
+        QString result;
+        result.reserve(text.size());
+
+        for (int i = 0; i < text.size(); ++i)
         {
-            // Get bookmark URL and name, add bookmark to current folder
-            pos += m_bookmarkStartTag.size() - 1;
-            int attrEndPos = pageHtml.indexOf(m_endTag, pos);
-            if (attrEndPos < 0)
+            const QChar c = text.at(i);
+            const int end = c == QLatin1Char('&') ? text.indexOf(QLatin1Char(';'), i + 1) : -1;
+            if (end < 0 || end - i > 10)
             {
-                qDebug() << "Error: invalid bookmark html. Halting import";
-                m_bookmarkManager->setCanUpdateList(true);
-                return false;
+                result.append(c);
+                continue;
             }
 
-            // URL parsing
-            QString attributeStr = pageHtml.mid(pos, attrEndPos - pos);
-            int urlStartPos = attributeStr.indexOf(QLatin1String("HREF="), 0, Qt::CaseInsensitive);
-            if (urlStartPos < 0)
+            const QString entity = text.mid(i + 1, end - i - 1);
+            QString decoded;
+            if (entity == QLatin1String("amp"))
+                decoded = QLatin1String("&");
+            else if (entity == QLatin1String("lt"))
+                decoded = QLatin1String("<");
+            else if (entity == QLatin1String("gt"))
+                decoded = QLatin1String(">");
+            else if (entity == QLatin1String("quot"))
+                decoded = QLatin1String("\"");
+            else if (entity == QLatin1String("apos"))
+                decoded = QLatin1String("'");
+            else if (entity == QLatin1String("nbsp"))
+                decoded = QChar(0xA0);
+            else if (entity.startsWith(QLatin1Char('#')))
             {
-                qDebug() << "Error: invalid bookmark html. Halting import";
-                m_bookmarkManager->setCanUpdateList(true);
-                return false;
+                bool ok = false;
+                const bool isHex = entity.startsWith(QLatin1String("#x"), Qt::CaseInsensitive);
+                const uint codePoint = isHex ? entity.mid(2).toUInt(&ok, 16) : entity.mid(1).toUInt(&ok, 10);
+                if (ok && codePoint > 0)
+                    decoded = QString::fromUcs4(&codePoint, 1);
             }
-            urlStartPos += 6;
-            int urlEndPos = attributeStr.indexOf(QLatin1Char('"'), urlStartPos);
-            if (urlEndPos < 0)
+
+            if (decoded.isEmpty())
             {
-                qDebug() << "Error: invalid bookmark html. Halting import";
-                m_bookmarkManager->setCanUpdateList(true);
-                return false;
+                result.append(c);
+                continue;
             }
 
-            QString url = attributeStr.mid(urlStartPos, urlEndPos - urlStartPos);
+            result.append(decoded);
+            i = end;
+        }
+
+        return result;
+    }
+}
+
+BookmarkImporter::BookmarkImporter(BookmarkManager *bookmarkMgr) :
+    m_bookmarkManager(bookmarkMgr)
+{
+}
+
+bool BookmarkImporter::import(const QString &fileName, BookmarkNode *importFolder)
+{
+    if (!importFolder || !m_bookmarkManager)
+        return false;
+
+    std::unique_ptr<BookmarkNode> importedNodes = readFile(fileName);
+    if (!importedNodes)
+        return false;
+
+    m_bookmarkManager->attachNodes(importedNodes.get(), importFolder);
+    return true;
+}
+
+std::unique_ptr<BookmarkNode> BookmarkImporter::readFile(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return nullptr;
+
+    std::unique_ptr<BookmarkNode> root = std::make_unique<BookmarkNode>(BookmarkNode::Folder, QString());
+
+    // Folders whose <DL> list is open. The first list of the file holds the contents of the root folder
+    std::vector<BookmarkNode*> openFolders;
+    bool foundBookmarkList = false;
+
+    // Folder created by the last <H3> element, whose contents are given by the next <DL> list
+    BookmarkNode *pendingFolder = nullptr;
 
-            // Bookmark name
-            pos = attrEndPos + 1;
-            int nameEndPos = pageHtml.indexOf(m_bookmarkEndTag, pos, Qt::CaseInsensitive);
+    // Text of the folder name or bookmark element being read, and the URL of the bookmark
+    enum class Element { None, FolderName, Bookmark };
+    Element currentElement = Element::None;
+    QString elementText, bookmarkUrl;
 
-            QString name = pageHtml.mid(pos, nameEndPos - pos);
+    HtmlTokenizer tokenizer([&](HtmlTokenizer::TokenType type, const QString &token){
+        if (type == HtmlTokenizer::TokenType::Text)
+        {
+            if (currentElement != Element::None)
+                elementText.append(token);
+            return;
+        }
 
-            m_bookmarkManager->appendBookmark(name, QUrl::fromUserInput(url), currentNode);
+        const QString tagName = getTagName(token);
+        if (!token.startsWith(QLatin1Char('/')))
+        {
+            if (tagName == QLatin1String("dl"))
+            {
+                foundBookmarkList = true;
+                if (pendingFolder)
+                    openFolders.push_back(pendingFolder);
+                else
+                    openFolders.push_back(openFolders.empty() ? root.get() : openFolders.back());
+                pendingFolder = nullptr;
+            }
+            else if (!openFolders.empty() && (tagName == QLatin1String("h3") || tagName == QLatin1String("a")))
+            {
+                pendingFolder = nullptr;
+                elementText.clear();
+                if (tagName == QLatin1String("h3"))
+                    currentElement = Element::FolderName;
+                else
+                {
+                    currentElement = Element::Bookmark;
+                    bookmarkUrl = decodeEntities(getAttribute(token, QLatin1String("href")));
+                }
+            }
+            return;
+        }
 
-            pos = nameEndPos + m_bookmarkEndTag.size();
-            continue;
+        if (tagName == QLatin1String("dl"))
+        {
+            if (!openFolders.empty())
+                openFolders.pop_back();
+            pendingFolder = nullptr;
+        }
+        else if (openFolders.empty())
+            currentElement = Element::None;
+        else if (tagName == QLatin1String("h3") && currentElement == Element::FolderName)
+        {
+            const QString name = decodeEntities(elementText).trimmed();
+            pendingFolder = openFolders.back()->appendNode(std::make_unique<BookmarkNode>(BookmarkNode::Folder, name));
+            currentElement = Element::None;
         }
-        ++pos;
+        else if (tagName == QLatin1String("a") && currentElement == Element::Bookmark)
+        {
+            if (!bookmarkUrl.isEmpty())
+            {
+                const QString name = decodeEntities(elementText).trimmed();
+                BookmarkNode *bookmark = openFolders.back()->appendNode(std::make_unique<BookmarkNode>(BookmarkNode::Bookmark, name));
+                bookmark->setURL(QUrl::fromUserInput(bookmarkUrl));
+            }
+            currentElement = Element::None;
+        }
+    });
+
+    QTextStream stream(&file);
+    stream.setCodec("UTF-8");
+    while (!stream.atEnd())
+        tokenizer.feed(stream.read(ReadChunkSize));
+    tokenizer.finish();
+
+    if (!foundBookmarkList)
+    {
+        qDebug() << "BookmarkImporter::readFile - no bookmark list found in file " << fileName;
+        return nullptr;
     }
-    m_bookmarkManager->setCanUpdateList(true);
 
-    return true;
+    return root;
 }
@@ -3,7 +3,9 @@
 
 #include "BookmarkManager.h"
 
-#include <QLatin1String>
+#include <memory>
+
+#include <QString>
 
 /**
  * @class BookmarkImporter
@@ -18,32 +20,27 @@ class BookmarkImporter
     explicit BookmarkImporter(BookmarkManager *bookmarkMgr);
 
     /**
-     * @brief import Attempts to import bookmarks from the given HTML file into a bookmark folder
+     * @brief import Attempts to import bookmarks from the given HTML file into a bookmark folder.
+     *        Must be called from the thread of the bookmark manager
      * @param fileName File containing Netscape formatted bookmark data
      * @param importFolder Root folder to import bookmarks into
      * @return True on successful import, false on failure
      */
     bool import(const QString &fileName, BookmarkNode *importFolder);
 
+    /**
+     * @brief Reads the bookmarks of the given HTML file into a detached folder, which is not a part of the
+     *        bookmark tree. The file is parsed as it is read, and the bookmark manager is not accessed,
+     *        so this can be called from any thread
+     * @param fileName File containing Netscape formatted bookmark data
+     * @return A folder containing the bookmarks and folders of the file, or a nullptr if the file could
+     *         not be read or does not contain a bookmark list
+     */
+    static std::unique_ptr<BookmarkNode> readFile(const QString &fileName);
+
 private:
     /// Bookmark node manager
     BookmarkManager *m_bookmarkManager;
-
-    /// Folder element opening and closing tags
-    QLatin1String m_folderStartTag;
-    QLatin1String m_folderEndTag;
-
-    /// Folder name element opening and closing tags
-    QLatin1String m_folderNameStartTag;
-    QLatin1String m_folderNameEndTag;
-
-    /// Bookmark element opening and closing tags
-    QLatin1String m_bookmarkStartTag;
-    QLatin1String m_bookmarkEndTag;
-
-    /// XML element opening and closing characters
-    QChar m_startTag;
-    QChar m_endTag;
 };
 
 #endif // BOOKMARKIMPORTER_H
@@ -1,14 +1,26 @@
 #include "BookmarkManager.h"
 #include "BookmarkNode.h"
 #include "BookmarkStore.h"
-#include "CommonUtil.h"
 #include "FaviconManager.h"
 
+#include <algorithm>
 #include <deque>
 #include <memory>
 
 #include <QTimer>
-#include <QtConcurrent>
+
+namespace
+{
+    /// Delay, in milliseconds, between a change to the bookmark collection and the saving of the journal
+    constexpr int JournalSaveDelay = 1000;
+
+    /// Delay, in milliseconds, between the loading of a bookmark's icon and the update of the UI, so the icons
+    /// loaded in quick succession are shown at once
+    constexpr int IconUpdateDelay = 250;
+
+    /// Number of imported bookmarks whose icons are requested from the favicon manager per event loop iteration
+    constexpr int IconLoadBatchSize = 64;
+}
 
 BookmarkManager::BookmarkManager(const ViperServiceLocator &serviceLocator, DatabaseTaskScheduler &taskScheduler, QObject *parent) :
     QObject(parent),
@@ -17,17 +29,25 @@ BookmarkManager::BookmarkManager(const ViperServiceLocator &serviceLocator, Data
     m_bookmarkBar(nullptr),
     m_bookmarkStore(nullptr),
     m_faviconManager(nullptr),
-    m_lookupCache(24),
-    m_nodeList(),
+    m_urlIndex(),
+    m_indexMutex(),
+    m_flatTree(std::make_shared<const FlatBookmarkTree>()),
     m_canUpdateList(true),
     m_nextBookmarkId(0),
     m_numBookmarks(0),
-    m_nodeListFuture(),
+    m_isResetListScheduled(false),
+    m_isIconUpdateScheduled(false),
+    m_pendingIconUrls(),
+    m_journal(),
+    m_isSaveScheduled(false),
     m_mutex()
 {
     m_faviconManager = serviceLocator.getServiceAs<FaviconManager>("FaviconManager");
     setObjectName(QLatin1String("BookmarkManager"));
 
+    if (m_faviconManager)
+        connect(m_faviconManager, &FaviconManager::faviconLoaded, this, &BookmarkManager::onFaviconLoaded);
+
     QTimer::singleShot(250, this, &BookmarkManager::checkIfLoaded);
 
     m_taskScheduler.onInit([this](){
@@ -42,6 +62,7 @@ BookmarkManager::BookmarkManager(const ViperServiceLocator &serviceLocator, Data
 
 BookmarkManager::~BookmarkManager()
 {
+    saveChanges();
 }
 
 BookmarkNode *BookmarkManager::getRoot() const
@@ -59,65 +80,17 @@ BookmarkNode *BookmarkManager::getBookmark(const QUrl &url)
     if (url.isEmpty())
         return nullptr;
 
-    const std::string urlStdStr = url.toString().toStdString();
-    if (m_lookupCache.has(urlStdStr))
-    {
-        BookmarkNode *node = m_lookupCache.get(urlStdStr);
-        if (node != nullptr)
-            return node;
-    }
-
-    if (!m_nodeListFuture.isCanceled() && m_nodeListFuture.isRunning())
-        m_nodeListFuture.waitForFinished();
-
-    for (BookmarkNode *node : m_nodeList)
-    {
-        if (node->getType() == BookmarkNode::Bookmark
-                && CommonUtil::doUrlsMatch(url, node->getURL(), true))
-            return node;
-    }
+    std::lock_guard<std::mutex> _(m_indexMutex);
+    auto it = m_urlIndex.find(getUrlKey(url));
+    if (it == m_urlIndex.end() || it->empty())
+        return nullptr;
 
-    return nullptr;
+    return it->front();
 }
 
 bool BookmarkManager::isBookmarked(const QUrl &url)
 {
-    if (url.isEmpty() || !m_rootNode.get())
-        return false;
-
-    const std::string urlStdStr = url.toString().toStdString();
-    if (m_lookupCache.has(urlStdStr) && m_lookupCache.get(urlStdStr) != nullptr)
-        return true;
-
-    std::deque<BookmarkNode*> queue;
-    queue.push_back(m_rootNode.get());
-    while (!queue.empty())
-    {
-        BookmarkNode *n = queue.front();
-
-        for (const auto &node : n->m_children)
-        {
-            BookmarkNode *childNode = node.get();
-            if (!childNode)
-                continue;
-
-            if (childNode->getType() == BookmarkNode::Folder)
-            {
-                queue.push_back(childNode);
-                continue;
-            }
-
-            if (CommonUtil::doUrlsMatch(url, childNode->getURL(), true))
-            {
-                m_lookupCache.put(urlStdStr, childNode);
-                return true;
-            }
-        }
-
-        queue.pop_front();
-    }
-
-    return false;
+    return getBookmark(url) != nullptr;
 }
 
 void BookmarkManager::appendBookmark(const QString &name, const QUrl &url, BookmarkNode *folder)
@@ -133,10 +106,12 @@ void BookmarkManager::appendBookmark(const QString &name, const QUrl &url, Bookm
     bookmark->setUniqueId(bookmarkId);
     bookmark->setURL(url);
     bookmark->setIcon(m_faviconManager ? m_faviconManager->getFavicon(url) : QIcon());
+    assignSortKey(bookmark, folder->getNumChildren() - 1);
+    addToIndex(bookmark);
 
     m_numBookmarks++;
 
-    scheduleBookmarkInsert(bookmark);
+    addToJournal(bookmark);
     scheduleResetList();
 }
 
@@ -158,10 +133,12 @@ void BookmarkManager::insertBookmark(const QString &name, const QUrl &url, Bookm
     bookmark->setUniqueId(bookmarkId);
     bookmark->setURL(url);
     bookmark->setIcon(m_faviconManager ? m_faviconManager->getFavicon(url) : QIcon());
+    assignSortKey(bookmark, position);
+    addToIndex(bookmark);
 
     m_numBookmarks++;
 
-    scheduleBookmarkInsert(bookmark);
+    addToJournal(bookmark);
     scheduleResetList();
 }
 
@@ -179,10 +156,11 @@ BookmarkNode *BookmarkManager::addFolder(const QString &name, BookmarkNode *pare
     BookmarkNode *folder = parent->appendNode(std::make_unique<BookmarkNode>(BookmarkNode::Folder, name));
     folder->setUniqueId(folderId);
     folder->setIcon(QIcon::fromTheme(QLatin1String("folder")));
+    assignSortKey(folder, parent->getNumChildren() - 1);
 
     m_numBookmarks++;
 
-    scheduleBookmarkInsert(folder);
+    addToJournal(folder);
     scheduleResetList();
 
     return folder;
@@ -190,35 +168,9 @@ BookmarkNode *BookmarkManager::addFolder(const QString &name, BookmarkNode *pare
 
 void BookmarkManager::removeBookmark(const QUrl &url)
 {
-    if (url.isEmpty())
-        return;
-
-    if (m_lookupCache.has(url.toString().toStdString()))
-    {
-        BookmarkNode * const &node = m_lookupCache.get(url.toString().toStdString());
-        if (node != nullptr)
-        {
-            BookmarkNode *nodeCopy = node;
-            removeBookmark(nodeCopy);
-            return;
-        }
-    }
-
-    if (!m_nodeListFuture.isCanceled() && m_nodeListFuture.isRunning())
-        m_nodeListFuture.waitForFinished();
-
-    for (BookmarkNode *node : m_nodeList)
-    {
-        if (node->getType() != BookmarkNode::Bookmark)
-            continue;
-
-        // Bookmark URLs are unique, once match is found, remove bookmark and return
-        if (CommonUtil::doUrlsMatch(url, node->getURL(), true))
-        {
-            removeBookmark(node);
-            return;
-        }
-    }
+    // Bookmark URLs are unique, so only the first match is removed
+    if (BookmarkNode *node = getBookmark(url))
+        removeBookmark(node);
 }
 
 void BookmarkManager::removeBookmark(BookmarkNode *item)
@@ -226,13 +178,11 @@ void BookmarkManager::removeBookmark(BookmarkNode *item)
     if (!item || item == m_rootNode.get())
         return;
 
-    // If node is a folder, add all sub-folders to the deletion queue. Otherwise just add the bookmark
-    std::deque<BookmarkNode*> processQueue, deleteQueue;
+    // Record the removal of the node and, if it is a folder, of everything it contains
+    std::deque<BookmarkNode*> processQueue;
 
     if (item->getType() == BookmarkNode::Folder)
         processQueue.push_back(item);
-    else
-        deleteQueue.push_back(item);
 
     while (!processQueue.empty())
     {
@@ -243,40 +193,22 @@ void BookmarkManager::removeBookmark(BookmarkNode *item)
             BookmarkNode *child = node->getNode(i);
             if (child->getType() == BookmarkNode::Folder)
                 processQueue.push_back(child);
-            else if (child->m_type == BookmarkNode::Bookmark)
+            else
             {
-                const std::string urlStdStr = child->m_url.toString().toStdString();
-                if (m_lookupCache.has(urlStdStr))
-                    m_lookupCache.put(urlStdStr, nullptr);
+                removeFromIndex(child);
+                addRemovalToJournal(child->getUniqueId());
             }
         }
 
-        deleteQueue.push_back(node);
+        addRemovalToJournal(node->getUniqueId());
         processQueue.pop_front();
     }
 
-    // Iterate through deletion queue, emitting a signal for each folder to be removed from the database
-    while (!deleteQueue.empty())
-    {
-        BookmarkNode *node = deleteQueue.back();
-        BookmarkNode *parent = node->getParent();
-        if (!parent)
-            parent = m_rootNode.get();
-
-        if (m_bookmarkStore)
-            m_taskScheduler.post(&BookmarkStore::removeNode, std::ref(m_bookmarkStore), node->getUniqueId(),
-                                 parent->getUniqueId(), node->getPosition());
-        //emit bookmarkDeleted(node->getUniqueId(), parent->getUniqueId(), node->getPosition());
-
-        deleteQueue.pop_back();
-    }
+    if (item->getType() != BookmarkNode::Folder)
+        addRemovalToJournal(item->getUniqueId());
 
     if (item->m_type == BookmarkNode::Bookmark)
-    {
-        const std::string urlStdStr = item->m_url.toString().toStdString();
-        if (m_lookupCache.has(urlStdStr))
-            m_lookupCache.put(urlStdStr, nullptr);
-    }
+        removeFromIndex(item);
 
     if (BookmarkNode *parent = item->getParent())
     {
@@ -292,7 +224,10 @@ void BookmarkManager::setBookmarkName(BookmarkNode *bookmark, const QString &nam
 
     bookmark->setName(name);
 
-    scheduleBookmarkUpdate(bookmark);
+    addToJournal(bookmark);
+    scheduleResetList();
+
+    emit bookmarkChanged(bookmark);
 }
 
 BookmarkNode *BookmarkManager::setBookmarkParent(BookmarkNode *bookmark, BookmarkNode *parent)
@@ -334,8 +269,9 @@ BookmarkNode *BookmarkManager::setBookmarkParent(BookmarkNode *bookmark, Bookmar
 
     bookmark = parent->getNode(parent->getNumChildren() - 1);
     bookmark->m_parent = parent;
+    assignSortKey(bookmark, parent->getNumChildren() - 1);
 
-    scheduleBookmarkUpdate(bookmark);
+    addToJournal(bookmark);
     scheduleResetList();
 
     return bookmark;
@@ -353,15 +289,24 @@ void BookmarkManager::setBookmarkPosition(BookmarkNode *bookmark, int position)
     if (position < 0 || position >= parent->getNumChildren() || position == currentPos)
         return;
 
+    // The node is re-created at its new position, so it must be re-indexed
+    const bool isBookmark = bookmark->getType() == BookmarkNode::Bookmark;
+    if (isBookmark)
+        removeFromIndex(bookmark);
+
     // Adjust position of node in parent's child list
     if (position > currentPos)
         ++position;
-    static_cast<void>(parent->insertNode(std::make_unique<BookmarkNode>(std::move(*bookmark)), position));
+    BookmarkNode *movedNode = parent->insertNode(std::make_unique<BookmarkNode>(std::move(*bookmark)), position);
     parent->removeNode(bookmark);
 
-    bookmark = parent->getNode(position);
+    // Only the moved node needs a new sort key
+    bookmark = movedNode;
+    assignSortKey(bookmark, bookmark->getPosition());
+    if (isBookmark)
+        addToIndex(bookmark);
 
-    scheduleBookmarkUpdate(bookmark);
+    addToJournal(bookmark);
     scheduleResetList();
 }
 
@@ -372,7 +317,10 @@ void BookmarkManager::setBookmarkShortcut(BookmarkNode *bookmark, const QString
 
     bookmark->setShortcut(shortcut);
 
-    scheduleBookmarkUpdate(bookmark);
+    addToJournal(bookmark);
+    scheduleResetList();
+
+    emit bookmarkChanged(bookmark);
 }
 
 void BookmarkManager::setBookmarkURL(BookmarkNode *bookmark, const QUrl &url)
@@ -380,17 +328,17 @@ void BookmarkManager::setBookmarkURL(BookmarkNode *bookmark, const QUrl &url)
     if (!bookmark || bookmark->getURL().matches(url, QUrl::None))
         return;
 
-    const QUrl oldUrl = bookmark->getURL();
-
-    // Update cache if applicable
-    const std::string oldUrlStr = oldUrl.toString().toStdString();
-    if (m_lookupCache.has(oldUrlStr))
-        m_lookupCache.put(oldUrlStr, nullptr);
+    removeFromIndex(bookmark);
 
     bookmark->setURL(url);
     bookmark->setIcon(m_faviconManager ? m_faviconManager->getFavicon(url) : QIcon());
 
-    scheduleBookmarkUpdate(bookmark);
+    addToIndex(bookmark);
+
+    addToJournal(bookmark);
+    scheduleResetList();
+
+    emit bookmarkChanged(bookmark);
 }
 
 void BookmarkManager::setRootNode(std::shared_ptr<BookmarkNode> node)
@@ -398,11 +346,9 @@ void BookmarkManager::setRootNode(std::shared_ptr<BookmarkNode> node)
     if (!node)
         return;
 
-    m_rootNode = node;
-
-    for (int i = 0; i < m_rootNode->getNumChildren(); ++i)
+    for (int i = 0; i < node->getNumChildren(); ++i)
     {
-        BookmarkNode *child = m_rootNode->getNode(i);
+        BookmarkNode *child = node->getNode(i);
         if (child->getType() == BookmarkNode::Folder
                 && child->getName().compare(QLatin1String("Bookmarks Bar")) == 0)
         {
@@ -412,7 +358,19 @@ void BookmarkManager::setRootNode(std::shared_ptr<BookmarkNode> node)
     }
 
     if (!m_bookmarkBar)
-        m_bookmarkBar = m_rootNode.get();
+        m_bookmarkBar = node.get();
+
+    std::shared_ptr<const FlatBookmarkTree> flatTree = std::make_shared<const FlatBookmarkTree>(node.get());
+    rebuildIndex(*flatTree);
+    m_numBookmarks.store(static_cast<int>(flatTree->size()));
+
+    {
+        std::lock_guard<std::mutex> _(m_mutex);
+        m_flatTree = std::move(flatTree);
+    }
+
+    // The root node is set last, as checkIfLoaded() waits on it before using the flat tree
+    m_rootNode = node;
 }
 
 void BookmarkManager::checkIfLoaded()
@@ -425,59 +383,210 @@ void BookmarkManager::checkIfLoaded()
 
     if (m_faviconManager != nullptr)
     {
-        std::deque<BookmarkNode*> queue;
-        queue.push_back(m_rootNode.get());
-        while (!queue.empty())
-        {
-            BookmarkNode *n = queue.front();
+        std::shared_ptr<const FlatBookmarkTree> flatTree = getFlatTree();
+        for (FlatBookmarkTree::NodeIndex index : flatTree->getBookmarks())
+            flatTree->getNode(index)->setIcon(m_faviconManager->getFavicon(flatTree->getURL(index)));
+    }
+
+    resetBookmarkList();
+}
+
+void BookmarkManager::onFaviconLoaded(const QUrl &pageUrl, const QIcon &icon)
+{
+    std::vector<BookmarkNode*> nodes;
+    {
+        std::lock_guard<std::mutex> _(m_indexMutex);
+        auto it = m_urlIndex.find(getUrlKey(pageUrl));
+        if (it == m_urlIndex.end())
+            return;
+        nodes = it.value();
+    }
+
+    for (BookmarkNode *node : nodes)
+    {
+        if (node->getURL().matches(pageUrl, QUrl::RemoveUserInfo | QUrl::RemoveQuery | QUrl::RemoveFragment))
+            node->setIcon(icon);
+    }
 
-            for (const auto &node : n->m_children)
+    if (m_isIconUpdateScheduled)
+        return;
+
+    m_isIconUpdateScheduled = true;
+    QTimer::singleShot(IconUpdateDelay, this, [this](){
+        m_isIconUpdateScheduled = false;
+        emit bookmarkIconsChanged();
+    });
+}
+
+void BookmarkManager::attachNodes(BookmarkNode *detachedFolder, BookmarkNode *folder)
+{
+    if (!detachedFolder || !folder || folder->getType() != BookmarkNode::Folder)
+        return;
+
+    waitToFinishList();
+
+    const int firstPosition = folder->getNumChildren();
+    for (auto &child : detachedFolder->m_children)
+        folder->appendNode(std::move(child));
+    detachedFolder->m_children.clear();
+
+    std::deque<BookmarkNode*> queue;
+    for (int i = firstPosition; i < folder->getNumChildren(); ++i)
+    {
+        BookmarkNode *node = folder->getNode(i);
+        assignSortKey(node, i);
+        queue.push_back(node);
+    }
+
+    // Parents are assigned their identifiers before their children, which reference them in the journal
+    const QIcon folderIcon = QIcon::fromTheme(QLatin1String("folder"));
+    while (!queue.empty())
+    {
+        BookmarkNode *node = queue.front();
+        queue.pop_front();
+
+        node->setUniqueId(m_nextBookmarkId++);
+        if (node->getType() == BookmarkNode::Folder)
+        {
+            node->setIcon(folderIcon);
+            for (int i = 0; i < node->getNumChildren(); ++i)
             {
-                BookmarkNode *childNode = node.get();
-                if (!childNode)
-                    continue;
-
-                if (childNode->getType() == BookmarkNode::Bookmark)
-                    childNode->setIcon(m_faviconManager->getFavicon(childNode->getURL()));
-                else if (childNode->getType() == BookmarkNode::Folder)
-                    queue.push_back(childNode);
+                BookmarkNode *child = node->getNode(i);
+                child->setSortKey((i + 1) * BookmarkNode::SortKeyGap);
+                queue.push_back(child);
             }
-
-            queue.pop_front();
         }
+        else
+        {
+            // Icons are requested once the import is done, as each lookup goes through the favicon cache
+            if (m_faviconManager)
+                m_pendingIconUrls.push_back(node->getURL());
+            addToIndex(node);
+        }
+
+        m_numBookmarks++;
+        addToJournal(node);
     }
 
-    resetBookmarkList();
+    scheduleResetList();
+
+    if (!m_pendingIconUrls.empty())
+        QTimer::singleShot(0, this, &BookmarkManager::loadPendingIcons);
 }
 
-void BookmarkManager::scheduleBookmarkInsert(const BookmarkNode *node)
+void BookmarkManager::loadPendingIcons()
 {
-    if (!m_bookmarkStore || node == m_rootNode.get())
+    if (!m_faviconManager)
+    {
+        m_pendingIconUrls.clear();
         return;
+    }
 
-    // params: int nodeId, int parentId, int nodeType, const QString &name, const QUrl &url, int position
-    m_taskScheduler.post(&BookmarkStore::insertNode, std::ref(m_bookmarkStore),
-                         node->getUniqueId(), node->getParent()->getUniqueId(),
-                         static_cast<int>(node->getType()), node->getName(),
-                         node->getURL(), node->getPosition());
+    // Icons that are not cached are set by onFaviconLoaded() once the favicon manager has loaded them
+    for (int i = 0; i < IconLoadBatchSize && !m_pendingIconUrls.empty(); ++i)
+    {
+        const QUrl url = m_pendingIconUrls.front();
+        m_pendingIconUrls.pop_front();
+        onFaviconLoaded(url, m_faviconManager->getFavicon(url));
+    }
+
+    if (!m_pendingIconUrls.empty())
+        QTimer::singleShot(0, this, &BookmarkManager::loadPendingIcons);
+}
+
+void BookmarkManager::saveChanges()
+{
+    m_isSaveScheduled = false;
+
+    // Changes are kept in the journal until the bookmark store is available
+    if (m_journal.empty() || !m_bookmarkStore)
+        return;
+
+    std::vector<BookmarkRecord> records;
+    std::vector<int> removedNodeIds;
+    for (const auto &change : m_journal)
+    {
+        if (change.second.has_value())
+            records.push_back(*change.second);
+        else
+            removedNodeIds.push_back(change.first);
+    }
+    m_journal.clear();
+
+    // Once the task scheduler has stopped, such as during shutdown, the store can be accessed directly
+    if (m_taskScheduler.isRunning())
+    {
+        m_taskScheduler.post(&BookmarkStore::applyChanges, std::ref(m_bookmarkStore), records, removedNodeIds);
+    }
+    else
+        m_bookmarkStore->applyChanges(records, removedNodeIds);
 }
 
-void BookmarkManager::scheduleBookmarkUpdate(const BookmarkNode *node)
+void BookmarkManager::assignSortKey(BookmarkNode *node, int position)
 {
-    if (!m_bookmarkStore || node == m_rootNode.get())
+    BookmarkNode *parent = node->getParent();
+    if (!parent)
         return;
 
-    // params: int nodeId, int parentId, const QString &name, const QString &url, const QString &shortcut, int position
-    m_taskScheduler.post(&BookmarkStore::updateNode, std::ref(m_bookmarkStore),
-                         node->getUniqueId(), node->getParent()->getUniqueId(),
-                         node->getName(), node->getURL(), node->getShortcut(),
-                         node->getPosition());
+    BookmarkNode *previous = position > 0 ? parent->getNode(position - 1) : nullptr;
+    BookmarkNode *next = parent->getNode(position + 1);
+
+    if (!previous && !next)
+        node->setSortKey(BookmarkNode::SortKeyGap);
+    else if (!next)
+        node->setSortKey(previous->getSortKey() + BookmarkNode::SortKeyGap);
+    else if (!previous)
+        node->setSortKey(next->getSortKey() - BookmarkNode::SortKeyGap);
+    else if (next->getSortKey() - previous->getSortKey() > 1)
+        node->setSortKey(previous->getSortKey() + (next->getSortKey() - previous->getSortKey()) / 2);
+    else
+    {
+        // No gap is left between the neighbours of the node, so spread out the keys of the whole folder
+        for (int i = 0; i < parent->getNumChildren(); ++i)
+        {
+            BookmarkNode *child = parent->getNode(i);
+            child->setSortKey((i + 1) * BookmarkNode::SortKeyGap);
+            if (child != node)
+                addToJournal(child);
+        }
+    }
+}
+
+void BookmarkManager::addToJournal(const BookmarkNode *node)
+{
+    if (!node || node == m_rootNode.get())
+        return;
+
+    m_journal[node->getUniqueId()] = node->getRecord();
+
+    scheduleSaveChanges();
+}
+
+void BookmarkManager::addRemovalToJournal(int nodeId)
+{
+    m_journal[nodeId] = std::nullopt;
+
+    scheduleSaveChanges();
+}
+
+void BookmarkManager::scheduleSaveChanges()
+{
+    if (m_isSaveScheduled)
+        return;
+
+    m_isSaveScheduled = true;
+    QTimer::singleShot(JournalSaveDelay, this, &BookmarkManager::saveChanges);
 }
 
 void BookmarkManager::scheduleResetList()
 {
-    if (m_canUpdateList)
-        m_nodeListFuture = QtConcurrent::run(this, &BookmarkManager::resetBookmarkList);
+    // The flat tree is built on this thread, which owns the bookmark nodes, once the current batch of
+    // changes has been made
+    if (!m_canUpdateList || m_isResetListScheduled)
+        return;
+
+    m_isResetListScheduled = true;
+    QTimer::singleShot(0, this, &BookmarkManager::waitToFinishList);
 }
 
 void BookmarkManager::setCanUpdateList(bool value)
@@ -489,40 +598,72 @@ void BookmarkManager::setCanUpdateList(bool value)
 
 void BookmarkManager::waitToFinishList()
 {
-    if (!m_nodeListFuture.isCanceled() && m_nodeListFuture.isRunning())
-        m_nodeListFuture.waitForFinished();
+    if (m_isResetListScheduled)
+        resetBookmarkList();
 }
 
 void BookmarkManager::resetBookmarkList()
 {
-    std::lock_guard<std::mutex> _(m_mutex);
+    m_isResetListScheduled = false;
 
-    int numBookmarks = 1;
-    std::vector<BookmarkNode*> nodeList;
+    std::shared_ptr<const FlatBookmarkTree> flatTree = std::make_shared<const FlatBookmarkTree>(m_rootNode.get());
+    m_numBookmarks.store(static_cast<int>(flatTree->size()));
 
-    std::deque<BookmarkNode*> queue;
-    queue.push_back(m_rootNode.get());
-    while (!queue.empty())
     {
-        BookmarkNode *n = queue.front();
+        std::lock_guard<std::mutex> _(m_mutex);
+        m_flatTree = std::move(flatTree);
+    }
 
-        for (const auto &node : n->m_children)
-        {
-            ++numBookmarks;
-            BookmarkNode *childNode = node.get();
-            if (!childNode)
-                continue;
+    emit bookmarksChanged();
+}
 
-            nodeList.push_back(childNode);
+std::shared_ptr<const FlatBookmarkTree> BookmarkManager::getFlatTree() const
+{
+    std::lock_guard<std::mutex> _(m_mutex);
+    return m_flatTree;
+}
 
-            if (childNode->getType() == BookmarkNode::Folder)
-                queue.push_back(childNode);
-        }
+QString BookmarkManager::getUrlKey(const QUrl &url)
+{
+    QString key = url.toString(QUrl::RemoveScheme | QUrl::RemoveUserInfo | QUrl::StripTrailingSlash).toLower();
+    if (key.startsWith(QLatin1String("//")))
+        key.remove(0, 2);
+    if (key.startsWith(QLatin1String("www.")))
+        key.remove(0, 4);
+    return key;
+}
 
-        queue.pop_front();
-    }
+void BookmarkManager::addToIndex(BookmarkNode *node)
+{
+    if (!node || node->getType() != BookmarkNode::Bookmark)
+        return;
 
-    m_numBookmarks.store(numBookmarks);
-    m_nodeList = std::move(nodeList);
-    emit bookmarksChanged();
+    std::lock_guard<std::mutex> _(m_indexMutex);
+    m_urlIndex[getUrlKey(node->getURL())].push_back(node);
+}
+
+void BookmarkManager::removeFromIndex(BookmarkNode *node)
+{
+    if (!node || node->getType() != BookmarkNode::Bookmark)
+        return;
+
+    std::lock_guard<std::mutex> _(m_indexMutex);
+    auto it = m_urlIndex.find(getUrlKey(node->getURL()));
+    if (it == m_urlIndex.end())
+        return;
+
+    std::vector<BookmarkNode*> &nodes = it.value();
+    nodes.erase(std::remove(nodes.begin(), nodes.end(), node), nodes.end());
+    if (nodes.empty())
+        m_urlIndex.erase(it);
+}
+
+void BookmarkManager::rebuildIndex(const FlatBookmarkTree &flatTree)
+{
+    QHash<QString, std::vector<BookmarkNode*>> urlIndex;
+    for (FlatBookmarkTree::NodeIndex index : flatTree.getBookmarks())
+        urlIndex[getUrlKey(flatTree.getURL(index))].push_back(flatTree.getNode(index));
+
+    std::lock_guard<std::mutex> _(m_indexMutex);
+    m_urlIndex.swap(urlIndex);
 }
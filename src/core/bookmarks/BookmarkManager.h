@@ -1,51 +1,55 @@
 #ifndef BOOKMARKNODEMANAGER_H
 #define BOOKMARKNODEMANAGER_H
 
+#include "BookmarkNode.h"
 #include "DatabaseTaskScheduler.h"
-#include "LRUCache.h"
+#include "FlatBookmarkTree.h"
 #include "ServiceLocator.h"
 
 #include <atomic>
+#include <deque>
+#include <memory>
 #include <mutex>
+#include <optional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
-#include <QFuture>
+#include <QHash>
+#include <QIcon>
 #include <QObject>
+#include <QString>
+#include <QUrl>
 
-class BookmarkNode;
 class BookmarkStore;
 class FaviconManager;
 
 /**
  * @class BookmarkManager
  * @brief Handles the in-memory bookmark collection, emitting a signal after any change
- *        to a bookmark occurs so the \ref BookmarkStore can save the state to the database.
+ *        to a bookmark occurs. Changed nodes are recorded in a journal, which is periodically
+ *        written to the database by the \ref BookmarkStore .
  * @ingroup Bookmarks
  */
 class BookmarkManager : public QObject
 {
     friend class BookmarkImporter;
     friend class BookmarkStore;
+    friend class BookmarkImporterTest;
     friend class BookmarkManagerTest;
 
     Q_OBJECT
 
 public:
-    using iterator = std::vector<BookmarkNode*>::iterator;
-    using const_iterator = std::vector<BookmarkNode*>::const_iterator;
-
     /// Constructs the bookmark node manager, given the service locator, task scheduler and a pointer to the manager's parent
     explicit BookmarkManager(const ViperServiceLocator &serviceLocator, DatabaseTaskScheduler &taskScheduler, QObject *parent);
 
     /// BookmarkManager destructor
     ~BookmarkManager();
 
-    /// Returns an iterator pointing to the first bookmark in the collection
-    const_iterator begin() const { return m_nodeList.cbegin(); }
-
-    /// Returns an iterator at the end of the bookmark collection
-    const_iterator end() const { return m_nodeList.cend(); }
+    /// Returns a snapshot of the bookmark collection, stored as a flat array of nodes for iteration.
+    /// The snapshot is replaced, rather than modified, when the collection changes, so it can be used from any thread
+    std::shared_ptr<const FlatBookmarkTree> getFlatTree() const;
 
     /// Returns the root of the bookmark tree
     BookmarkNode *getRoot() const;
@@ -109,6 +113,19 @@ class BookmarkManager : public QObject
     /// Sets the URL of a bookmark in the database
     void setBookmarkURL(BookmarkNode *bookmark, const QUrl &url);
 
+    /**
+     * @brief Moves the children of a detached folder, which is not a part of the bookmark tree, to the end of
+     *        the given folder. Each of the moved nodes is assigned a unique identifier, and the bookmark list
+     *        is only updated once all nodes have been attached
+     * @param detachedFolder Folder containing the nodes to attach, such as one created by the \ref BookmarkImporter
+     * @param folder Folder in the bookmark tree that the nodes will belong to
+     */
+    void attachNodes(BookmarkNode *detachedFolder, BookmarkNode *folder);
+
+    /// Writes the changes recorded in the journal to the database. This happens shortly after any change
+    /// is made, and when the bookmark manager is destroyed
+    void saveChanges();
+
 Q_SIGNALS:
     /// Emitted when one of the properties of the given bookmark has changed
     void bookmarkChanged(const BookmarkNode *node);
@@ -116,6 +133,9 @@ class BookmarkManager : public QObject
     /// Emitted when there has been a change to the bookmark tree that requires an update to the UI
     void bookmarksChanged();
 
+    /// Emitted after the icons of one or more bookmarks were replaced by icons loaded from the favicon database
+    void bookmarkIconsChanged();
+
     /// Emitted when the given bookmark has been added to the tree
     void bookmarkCreated(const BookmarkNode *node);
 
@@ -127,29 +147,57 @@ class BookmarkManager : public QObject
     /// Sets the root node of the bookmark tree - this is called by the \ref BookmarkStore after loading the data
     void setRootNode(std::shared_ptr<BookmarkNode> node);
 
-    /// Runs resetBookmarkList concurrently as long as a major change isn't being made to the bookmark collection
+    /// Schedules resetBookmarkList to run once control returns to the event loop, as long as a major change isn't
+    /// being made to the bookmark collection
     void scheduleResetList();
 
     /// Sets the flag indicating whether or not the flattened list of bookmarks should be updated
     void setCanUpdateList(bool value);
 
-    /// Waits on any asynchronous resetBookmarkList() operations
+    /// Runs a scheduled resetBookmarkList() operation immediately, so the flat tree reflects every change made so far
     void waitToFinishList();
 
 private Q_SLOTS:
     /// Runs on a regular interval until the root bookmark node has been populated
     void checkIfLoaded();
 
+    /// Sets the icon of each bookmark of the given page, once the icon has been loaded by the favicon manager
+    void onFaviconLoaded(const QUrl &pageUrl, const QIcon &icon);
+
+    /// Sets the icons of a batch of imported bookmarks, rescheduling itself until every imported bookmark has its icon
+    void loadPendingIcons();
+
 private:
-    /// Schedules an create bookmark operation in the repository
-    void scheduleBookmarkInsert(const BookmarkNode *node);
+    /// Assigns a sort key to the node at the given position of its parent folder, between the keys of its
+    /// neighbours. The keys of the folder are only renumbered when there is no gap left between them
+    void assignSortKey(BookmarkNode *node, int position);
+
+    /// Records the current state of the node in the journal, to be saved to the database
+    void addToJournal(const BookmarkNode *node);
 
-    /// Schedules a boookmark update to the database worker
-    void scheduleBookmarkUpdate(const BookmarkNode *node);
+    /// Records the removal of the node with the given unique identifier in the journal
+    void addRemovalToJournal(int nodeId);
 
-    /// Resets the flat list of bookmark node pointers, used for iteration & bookmark searches
+    /// Schedules the journal to be saved after a short delay, unless it is already scheduled
+    void scheduleSaveChanges();
+
+    /// Resets the flat copy of the bookmark tree, used for iteration. Runs on the thread of the bookmark manager,
+    /// as the nodes may only be read from there
     void resetBookmarkList();
 
+    /// Returns the key of the given URL in the URL index. URLs that only differ by their scheme,
+    /// user information, "www." prefix, letter case or a trailing slash share the same key
+    static QString getUrlKey(const QUrl &url);
+
+    /// Adds the given bookmark to the URL index
+    void addToIndex(BookmarkNode *node);
+
+    /// Removes the given bookmark from the URL index
+    void removeFromIndex(BookmarkNode *node);
+
+    /// Rebuilds the URL index from the given flat copy of the bookmark tree
+    void rebuildIndex(const FlatBookmarkTree &flatTree);
+
 private:
     /// Reference to the task scheduler. Needed to queue work for the \ref BookmarkStore
     DatabaseTaskScheduler &m_taskScheduler;
@@ -166,11 +214,14 @@ private Q_SLOTS:
     /// Pointer to the favicon manager
     FaviconManager *m_faviconManager;
 
-    /// Cache of bookmark nodes that were recently searched for within the application
-    LRUCache<std::string, BookmarkNode*> m_lookupCache;
+    /// Maps the URL key (see \ref getUrlKey ) of each bookmark to its nodes, in tree order
+    QHash<QString, std::vector<BookmarkNode*>> m_urlIndex;
 
-    /// Container of bookmark node pointers, flattened version of tree structure used for bookmark iteration
-    std::vector<BookmarkNode*> m_nodeList;
+    /// Guards the URL index, which may be queried from other threads
+    mutable std::mutex m_indexMutex;
+
+    /// Flattened copy of the tree structure, used for bookmark iteration
+    std::shared_ptr<const FlatBookmarkTree> m_flatTree;
 
     /// Flag indicating whether or not a major change is happening to the bookmark tree.
     /// If true, the flattened bookmark list will not update itself until this flag is set back to false.
@@ -182,10 +233,23 @@ private Q_SLOTS:
     /// Stores the number of bookmarks in the tree.
     std::atomic_int m_numBookmarks;
 
-    /// Future associated with the m_nodeList regeneration method
-    QFuture<void> m_nodeListFuture;
+    /// Flag indicating whether or not the flat copy of the bookmark tree is scheduled to be reset
+    bool m_isResetListScheduled;
+
+    /// Flag indicating whether or not \ref bookmarkIconsChanged is scheduled to be emitted
+    bool m_isIconUpdateScheduled;
+
+    /// URLs of the imported bookmarks whose icons have not yet been requested from the favicon manager
+    std::deque<QUrl> m_pendingIconUrls;
+
+    /// Changes that have not yet been saved, mapping the unique identifier of each changed node
+    /// to its new state, or to an empty value if the node was removed
+    std::unordered_map<int, std::optional<BookmarkRecord>> m_journal;
+
+    /// Flag indicating whether or not the journal is scheduled to be saved
+    bool m_isSaveScheduled;
 
-    /// Mutex
+    /// Guards the flat copy of the bookmark tree
     mutable std::mutex m_mutex;
 };
 
@@ -10,7 +10,8 @@ BookmarkNode::BookmarkNode() :
     m_url(),
     m_icon(),
     m_shortcut(),
-    m_type(BookmarkNode::Bookmark)
+    m_type(BookmarkNode::Bookmark),
+    m_sortKey(0)
 {
 }
 
@@ -21,7 +22,8 @@ BookmarkNode::BookmarkNode(BookmarkNode::NodeType type, const QString &name) :
     m_url(),
     m_icon(),
     m_shortcut(),
-    m_type(type)
+    m_type(type),
+    m_sortKey(0)
 {
 }
 
@@ -32,9 +34,13 @@ BookmarkNode::BookmarkNode(BookmarkNode &&other) noexcept
     m_url = other.m_url;
     m_shortcut = other.m_shortcut;
     m_type = other.m_type;
+    m_sortKey = other.m_sortKey;
     m_parent = other.m_parent;
     m_icon = std::move(other.m_icon);
     m_children = std::move(other.m_children);
+
+    for (auto &child : m_children)
+        child->m_parent = this;
 }
 
 int BookmarkNode::getPosition() const
@@ -51,6 +57,16 @@ int BookmarkNode::getPosition() const
     return m_parent->getNumChildren() - 1;
 }
 
+qint64 BookmarkNode::getSortKey() const
+{
+    return m_sortKey;
+}
+
+void BookmarkNode::setSortKey(qint64 sortKey)
+{
+    m_sortKey = sortKey;
+}
+
 BookmarkNode::NodeType BookmarkNode::getType() const
 {
     return m_type;
@@ -111,6 +127,12 @@ void BookmarkNode::setUniqueId(int id)
     m_id = id;
 }
 
+BookmarkRecord BookmarkNode::getRecord() const
+{
+    return BookmarkRecord { m_id, m_parent ? m_parent->getUniqueId() : -1, static_cast<int>(m_type),
+                            m_name, m_url, m_shortcut, m_sortKey };
+}
+
 QDataStream& operator<<(QDataStream &out, BookmarkNode *&node)
 {
     std::intptr_t ptr = reinterpret_cast<std::intptr_t>(node);
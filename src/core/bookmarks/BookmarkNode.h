@@ -12,6 +12,35 @@
 #include <QString>
 #include <QUrl>
 
+/**
+ * @struct BookmarkRecord
+ * @brief Values of a bookmark node as they are stored in the bookmark database
+ * @ingroup Bookmarks
+ */
+struct BookmarkRecord
+{
+    /// Unique identifier of the node
+    int ID;
+
+    /// Unique identifier of the parent folder
+    int ParentID;
+
+    /// Type of the node, see \ref BookmarkNode::NodeType
+    int Type;
+
+    /// Name of the node
+    QString Name;
+
+    /// URL of the node, empty for folders
+    QUrl URL;
+
+    /// Shortcut to load the bookmark
+    QString Shortcut;
+
+    /// Sort key of the node among its siblings
+    qint64 Position;
+};
+
 /**
  * @class BookmarkNode
  * @brief Individual node that is a part of the Bookmarks tree. Each node
@@ -20,8 +49,11 @@
  */
 class BookmarkNode : public TreeNode<BookmarkNode> , public sqlite::Row
 {
+    friend class BookmarkImporter;
     friend class BookmarkManager;
     friend class BookmarkStore;
+    friend class FlatBookmarkTree;
+    friend class FlatBookmarkTreeTest;
 
 public:
     /// List of the specific types of bookmark nodes. At the moment, there are only bookmarks and folders.
@@ -40,6 +72,10 @@ class BookmarkNode : public TreeNode<BookmarkNode> , public sqlite::Row
     /// Returns the position of the bookmark node in relation to its siblings
     int getPosition() const;
 
+    /// Returns the key that orders the node among its siblings. Keys are spaced apart, so that a node
+    /// can be placed between two siblings without changing the keys of any other node
+    qint64 getSortKey() const;
+
     /// Returns this node's type
     NodeType getType() const;
 
@@ -59,12 +95,21 @@ class BookmarkNode : public TreeNode<BookmarkNode> , public sqlite::Row
     void setIcon(const QIcon &icon);
 
 protected:
+    /// Default distance between the sort keys of adjacent siblings
+    static constexpr qint64 SortKeyGap = 1024;
+
     /// Returns the unique identifier of the node
     int getUniqueId() const;
 
     /// Sets the unique identifier of the node
     void setUniqueId(int id);
 
+    /// Sets the key that orders the node among its siblings
+    void setSortKey(qint64 sortKey);
+
+    /// Returns the values of the node as they are stored in the database
+    BookmarkRecord getRecord() const;
+
     /// Sets the name of the bookmark node to the given value
     void setName(const QString &name);
 
@@ -96,6 +141,9 @@ class BookmarkNode : public TreeNode<BookmarkNode> , public sqlite::Row
     /// Type of node
     NodeType m_type;
 
+    /// Key that orders the node among its siblings
+    qint64 m_sortKey;
+
 public:
     /// Writes the bookmark node into the prepared statement
     void marshal(sqlite::PreparedStatement &stmt) const override
@@ -110,7 +158,7 @@ class BookmarkNode : public TreeNode<BookmarkNode> , public sqlite::Row
              << m_name
              << m_url
              << m_shortcut
-             << getPosition();
+             << m_sortKey;
     }
 
     /// Not used
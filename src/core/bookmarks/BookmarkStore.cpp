@@ -9,13 +9,13 @@
 
 BookmarkStore::BookmarkStore(const QString &databaseFile) :
     DatabaseWorker(databaseFile),
-    m_rootNode(std::make_shared<BookmarkNode>(BookmarkNode::Folder, QLatin1String("Bookmarks")))
+    m_rootNode(std::make_shared<BookmarkNode>(BookmarkNode::Folder, QLatin1String("Bookmarks"))),
+    m_queryMap()
 {
 }
 
 BookmarkStore::~BookmarkStore()
 {
-    save();
 }
 
 std::shared_ptr<BookmarkNode> BookmarkStore::getRootNode() const
@@ -42,64 +42,48 @@ int BookmarkStore::getMaxUniqueId() const
     return std::max(0, lastUniqueId);
 }
 
-void BookmarkStore::insertNode(int nodeId, int parentId, int nodeType, const QString &name, const QUrl &url, int position)
+void BookmarkStore::applyChanges(const std::vector<BookmarkRecord> &records, const std::vector<int> &removedNodeIds)
 {
-    auto stmt = m_database.prepare(R"(INSERT OR REPLACE INTO Bookmarks(ID, ParentID, Type, Name, URL, Position) VALUES (?, ?, ?, ?, ?, ?))");
-    stmt << nodeId
-         << parentId
-         << nodeType
-         << name
-         << url
-         << position;
-
-    if (!stmt.execute())
-        qWarning() << "BookmarkStore::onBookmarkCreated - could not create bookmark node.";
-
-    stmt = m_database.prepare(R"(UPDATE Bookmarks SET Position = Position + 1 WHERE ParentID = ? AND Position >= ?)");
-    stmt << parentId
-         << position;
-
-    if (!stmt.execute())
-        qWarning() << "BookmarkStore::onBookmarkCreated - could not update bookmark positions.";
-}
-
-void BookmarkStore::removeNode(int nodeId, int parentId, int position)
-{
-    auto stmt = m_database.prepare(R"(DELETE FROM Bookmarks WHERE ID = ? OR ParentID = ?)");
-    stmt << nodeId
-         << nodeId;
-    if (!stmt.execute())
-        qWarning() << "BookmarkStore::onBookmarkDeleted - could not delete bookmark node.";
-
-    // Update positions
-    stmt = m_database.prepare(R"(UPDATE Bookmarks SET Position = Position - 1 WHERE ParentID = ? AND Position >= ?)");
-    stmt << parentId
-         << position;
-    if (!stmt.execute())
-        qWarning() << "BookmarkStore::onBookmarkDeleted - could not update bookmark positions";
-}
+    if (records.empty() && removedNodeIds.empty())
+        return;
 
-void BookmarkStore::updateNode(int nodeId, int parentId, const QString &name, const QUrl &url, const QString &shortcut, int position)
-{
-    auto stmt =
-            m_database.prepare(R"(UPDATE Bookmarks SET ParentID = ?, Name = ?, URL = ?, Shortcut = ?, Position = ? WHERE ID = ?)");
-    stmt << parentId
-         << name
-         << url
-         << shortcut
-         << position
-         << nodeId;
+    if (!m_database.beginTransaction())
+    {
+        qWarning() << "BookmarkStore::applyChanges - could not start transaction";
+        return;
+    }
 
-    if (!stmt.execute())
-        qWarning() << "BookmarkStore::onBookmarkChanged - could not update bookmark node.";
+    sqlite::PreparedStatement &removeStmt = m_queryMap.at(StoredQuery::RemoveNode);
+    for (int nodeId : removedNodeIds)
+    {
+        removeStmt.reset();
+        removeStmt << nodeId;
+        if (!removeStmt.execute())
+            qWarning() << "BookmarkStore::applyChanges - could not delete bookmark node " << nodeId;
+    }
 
-    stmt = m_database.prepare(R"(UPDATE Bookmarks SET Position = Position + 1 WHERE ParentID = ? AND Position >= ? AND ID != ?)");
-    stmt << parentId
-         << position
-         << nodeId;
+    sqlite::PreparedStatement &upsertStmt = m_queryMap.at(StoredQuery::UpsertNode);
+    for (const BookmarkRecord &record : records)
+    {
+        upsertStmt.reset();
+        upsertStmt << record.ID
+                   << record.ParentID
+                   << record.Type
+                   << record.Name
+                   << record.URL
+                   << record.Shortcut
+                   << record.Position;
+        if (!upsertStmt.execute())
+            qWarning() << "BookmarkStore::applyChanges - could not save bookmark " << record.Name << ", id " << record.ID;
+    }
 
-    if (!stmt.execute())
-        qWarning() << "BookmarkStore::onBookmarkChanged - could not update bookmark positions.";
+    if (!m_database.commitTransaction())
+    {
+        qWarning() << "BookmarkStore::applyChanges - could not commit transaction. Message: "
+                   << QString::fromStdString(m_database.getLastError());
+        if (!m_database.rollbackTransaction())
+            qWarning() << "BookmarkStore::applyChanges - could not roll back transaction";
+    }
 }
 
 void BookmarkStore::loadFolder(BookmarkNode *folder)
@@ -110,7 +94,7 @@ void BookmarkStore::loadFolder(BookmarkNode *folder)
         return;
     }
 
-    auto stmt = m_database.prepare(R"(SELECT ID, Type, Name, URL, Shortcut FROM Bookmarks WHERE ParentID = ? ORDER BY Position ASC)");
+    auto stmt = m_database.prepare(R"(SELECT ID, Type, Name, URL, Shortcut, Position FROM Bookmarks WHERE ParentID = ? ORDER BY Position ASC)");
 
     // Iteratively load folder and all of its subfolders
     std::deque<BookmarkNode*> subFolders;
@@ -132,15 +116,18 @@ void BookmarkStore::loadFolder(BookmarkNode *folder)
             QString name;
             QUrl url;
             QString shortcut;
+            qint64 sortKey = 0;
             stmt >> uniqueId
                  >> nodeTypeInt
                  >> name
                  >> url
-                 >> shortcut;
+                 >> shortcut
+                 >> sortKey;
 
             BookmarkNode::NodeType nodeType = static_cast<BookmarkNode::NodeType>(nodeTypeInt);
             BookmarkNode *subNode = n->appendNode(std::make_unique<BookmarkNode>(nodeType, name));
             subNode->setUniqueId(uniqueId);
+            subNode->setSortKey(sortKey);
 
             switch (nodeType)
             {
@@ -190,53 +177,27 @@ void BookmarkStore::setup()
 
     BookmarkNode *bookmarkBar = m_rootNode->appendNode(std::make_unique<BookmarkNode>(BookmarkNode::Folder, QLatin1String("Bookmarks Bar")));
     bookmarkBar->setUniqueId(1);
-    insertNode(1, 0, static_cast<int>(BookmarkNode::Folder), bookmarkBar->getName(), bookmarkBar->getURL(), 0);
+    bookmarkBar->setSortKey(BookmarkNode::SortKeyGap);
 
     BookmarkNode *bookmark = bookmarkBar->appendNode(std::make_unique<BookmarkNode>(BookmarkNode::Bookmark, QLatin1String("Search Engine")));
     bookmark->setURL(QUrl(QLatin1String("https://www.startpage.com")));
     bookmark->setUniqueId(2);
-    insertNode(2, 1, static_cast<int>(BookmarkNode::Bookmark), bookmark->getName(), bookmark->getURL(), 0);
+    bookmark->setSortKey(BookmarkNode::SortKeyGap);
+
+    prepareQueries();
+    applyChanges({ bookmarkBar->getRecord(), bookmark->getRecord() }, {});
 }
 
-void BookmarkStore::save()
+void BookmarkStore::prepareQueries()
 {
-    if (!m_database.beginTransaction())
-    {
-        qWarning() << "BookmarkStore::save - could not start transaction";
-        return;
-    }
-
-    if (!m_database.execute("DELETE FROM Bookmarks"))
-        qWarning() << "BookmarkStore::save - Could not clear bookmarks table";
-
-    auto stmt = m_database.prepare(R"(INSERT INTO Bookmarks(ID, ParentID, Type, Name, URL, Shortcut, Position) VALUES (?, ?, ?, ?, ?, ?, ?))");
-
-    auto saveNode = [&stmt](BookmarkNode *node) {
-        stmt << *node;
-        if (!stmt.execute())
-            qWarning() << "Could not save bookmark " << node->getName() << ", id " << node->getUniqueId();
-        stmt.reset();
-    };
-
-    std::deque<BookmarkNode*> queue;
-    queue.push_back(m_rootNode.get());
-    while (!queue.empty())
-    {
-        BookmarkNode *node = queue.back();
-        saveNode(node);
-        queue.pop_back();
-
-        for (auto &child : node->m_children)
-        {
-            if (child->getType() == BookmarkNode::Folder)
-                queue.push_back(child.get());
-            else
-                saveNode(child.get());
-        }
-    }
-
-    if (!m_database.commitTransaction())
-        qWarning() << "BookmarkStore::save - could not commit transaction";
+    m_queryMap.clear();
+
+    m_queryMap.insert(
+                std::make_pair(StoredQuery::UpsertNode,
+                               m_database.prepare(R"(INSERT OR REPLACE INTO Bookmarks(ID, ParentID, Type, Name, URL, Shortcut, Position) VALUES (?, ?, ?, ?, ?, ?, ?))")));
+    m_queryMap.insert(
+                std::make_pair(StoredQuery::RemoveNode,
+                               m_database.prepare(R"(DELETE FROM Bookmarks WHERE ID = ?)")));
 }
 
 void BookmarkStore::load()
@@ -292,6 +253,8 @@ void BookmarkStore::load()
         }
     }
 
+    prepareQueries();
+
     // Don't load twice
     if (m_rootNode->getNumChildren() == 0)
     {
@@ -1,8 +1,8 @@
 #ifndef BOOKMARKSTORE_H
 #define BOOKMARKSTORE_H
 
+#include "BookmarkNode.h"
 #include "DatabaseWorker.h"
-#include "LRUCache.h"
 
 #include <map>
 #include <memory>
@@ -12,7 +12,6 @@
 #include <QObject>
 #include <QString>
 
-class BookmarkNode;
 class BookmarkManager;
 
 /**
@@ -44,21 +43,16 @@ class BookmarkStore : public DatabaseWorker
     /// the next unique id when a bookmark is created
     int getMaxUniqueId() const;
 
-    /// Inserts or replaces the given bookmark node into the database
-    void insertNode(int nodeId, int parentId, int nodeType, const QString &name, const QUrl &url, int position);
-
-    /// Removes a node from the database with the given id, parent id and position
-    void removeNode(int nodeId, int parentId, int position);
-
-    /// Saves a change in one or more properties of the given node
-    void updateNode(int nodeId, int parentId, const QString &name, const QUrl &url, const QString &shortcut, int position);
+    /// Inserts or replaces each of the given records, and removes the nodes with the given identifiers,
+    /// in a single transaction. Only the rows of the given nodes are written
+    void applyChanges(const std::vector<BookmarkRecord> &records, const std::vector<int> &removedNodeIds);
 
 private:
     /// Loads bookmark information from the database
     void loadFolder(BookmarkNode *folder);
 
-    /// Saves all bookmarks to the database
-    void save();
+    /// Prepares the statements used to write changes to the database
+    void prepareQueries();
 
 protected:
     /// Returns true if the bookmark database contains the table structure(s) needed for it to function properly,
@@ -71,9 +65,20 @@ class BookmarkStore : public DatabaseWorker
     /// Loads bookmarks from the database
     void load() override;
 
+private:
+    /// Used to access prepared database queries
+    enum class StoredQuery
+    {
+        UpsertNode,
+        RemoveNode
+    };
+
 private:
     /// Root bookmark folder
     std::shared_ptr<BookmarkNode> m_rootNode;
+
+    /// Cache of frequently-executed sql statements
+    std::map<StoredQuery, sqlite::PreparedStatement> m_queryMap;
 };
 
 #endif // BOOKMARKSTORE_H
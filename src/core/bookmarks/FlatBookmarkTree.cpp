@@ -0,0 +1,93 @@
+#include "FlatBookmarkTree.h"
+
+#include <utility>
+
+#include <QHash>
+
+FlatBookmarkTree::FlatBookmarkTree(const BookmarkNode *root) :
+    FlatBookmarkTree()
+{
+    if (!root)
+        return;
+
+    QHash<QString, uint32_t> stringIds;
+    QHash<QUrl, uint32_t> urlIds;
+
+    m_strings.push_back(QString());
+    stringIds.insert(QString(), 0);
+    m_urls.push_back(QUrl());
+    urlIds.insert(QUrl(), 0);
+
+    auto internString = [&](const QString &value) -> uint32_t {
+        auto it = stringIds.find(value);
+        if (it != stringIds.end())
+            return it.value();
+
+        const uint32_t id = static_cast<uint32_t>(m_strings.size());
+        m_strings.push_back(value);
+        stringIds.insert(value, id);
+        return id;
+    };
+
+    auto internUrl = [&](const QUrl &value) -> uint32_t {
+        auto it = urlIds.find(value);
+        if (it != urlIds.end())
+            return it.value();
+
+        const uint32_t id = static_cast<uint32_t>(m_urls.size());
+        m_urls.push_back(value);
+        urlIds.insert(value, id);
+        return id;
+    };
+
+    // Depth-first traversal, where each entry of the stack holds a node and the index of its parent.
+    // Children are pushed in reverse so they are visited in order
+    std::vector<std::pair<const BookmarkNode*, NodeIndex>> stack;
+    stack.push_back(std::make_pair(root, InvalidIndex));
+
+    // Indices of the folders on the path to the current node, used to close their subtree ranges
+    std::vector<NodeIndex> openFolders;
+
+    while (!stack.empty())
+    {
+        const BookmarkNode *node = stack.back().first;
+        const NodeIndex parentIndex = stack.back().second;
+        stack.pop_back();
+
+        const NodeIndex index = static_cast<NodeIndex>(m_uniqueIds.size());
+
+        // Any folder that is not an ancestor of this node has no more descendants
+        while (!openFolders.empty() && openFolders.back() != parentIndex)
+        {
+            m_subtreeEnds[openFolders.back()] = index;
+            openFolders.pop_back();
+        }
+
+        m_uniqueIds.push_back(node->getUniqueId());
+        m_parentIndices.push_back(parentIndex);
+        m_subtreeEnds.push_back(index + 1);
+        m_types.push_back(static_cast<uint8_t>(node->getType()));
+        m_nameIds.push_back(internString(node->getName()));
+        m_shortcutIds.push_back(internString(node->getShortcut()));
+        m_urlIds.push_back(internUrl(node->getURL()));
+        m_nodes.push_back(const_cast<BookmarkNode*>(node));
+
+        if (node->getType() == BookmarkNode::Folder)
+        {
+            m_folderIndices.push_back(index);
+            openFolders.push_back(index);
+
+            for (int i = node->getNumChildren() - 1; i >= 0; --i)
+            {
+                if (const BookmarkNode *child = node->getNode(i))
+                    stack.push_back(std::make_pair(child, index));
+            }
+        }
+        else
+            m_bookmarkIndices.push_back(index);
+    }
+
+    const NodeIndex endIndex = static_cast<NodeIndex>(m_uniqueIds.size());
+    for (NodeIndex folderIndex : openFolders)
+        m_subtreeEnds[folderIndex] = endIndex;
+}
@@ -0,0 +1,118 @@
+#ifndef FLATBOOKMARKTREE_H
+#define FLATBOOKMARKTREE_H
+
+#include "BookmarkNode.h"
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <QString>
+#include <QUrl>
+
+/**
+ * @class FlatBookmarkTree
+ * @brief Immutable copy of the bookmark tree, stored as parallel arrays in depth-first order.
+ *
+ * Each property of the nodes is kept in its own contiguous array, indexed by the position of the node
+ * in a depth-first traversal, so scanning every bookmark is a linear walk through memory rather than
+ * a walk through the nodes of the tree. Names, shortcuts and URLs are interned, with each node storing
+ * the index of its value in a table shared by all nodes. The root node is always at index 0, and the
+ * nodes of a folder directly follow it.
+ *
+ * Nodes can be mapped back to their \ref BookmarkNode , which acts as a stable handle for the UI
+ * models. Those handles may only be dereferenced from the thread that owns the bookmark tree.
+ *
+ * @ingroup Bookmarks
+ */
+class FlatBookmarkTree
+{
+public:
+    /// Index of a node in the flat tree
+    using NodeIndex = uint32_t;
+
+    /// Parent index of the root node
+    static constexpr NodeIndex InvalidIndex = std::numeric_limits<NodeIndex>::max();
+
+    /// Constructs an empty flat tree
+    FlatBookmarkTree() = default;
+
+    /// Constructs the flat tree from the bookmark tree with the given root node
+    explicit FlatBookmarkTree(const BookmarkNode *root);
+
+    /// Returns the number of nodes in the tree, including the root node
+    std::size_t size() const { return m_uniqueIds.size(); }
+
+    /// Returns true if the tree has no nodes, false if else
+    bool empty() const { return m_uniqueIds.empty(); }
+
+    /// Returns the unique identifier of the node at the given index
+    int getUniqueId(NodeIndex index) const { return m_uniqueIds[index]; }
+
+    /// Returns the index of the parent of the given node, or \ref InvalidIndex for the root node
+    NodeIndex getParentIndex(NodeIndex index) const { return m_parentIndices[index]; }
+
+    /// Returns the index after the last descendant of the given node. The descendants of a folder
+    /// occupy the range [index + 1, getSubtreeEnd(index))
+    NodeIndex getSubtreeEnd(NodeIndex index) const { return m_subtreeEnds[index]; }
+
+    /// Returns the type of the node at the given index
+    BookmarkNode::NodeType getType(NodeIndex index) const { return static_cast<BookmarkNode::NodeType>(m_types[index]); }
+
+    /// Returns the name of the node at the given index
+    const QString &getName(NodeIndex index) const { return m_strings[m_nameIds[index]]; }
+
+    /// Returns the shortcut of the node at the given index
+    const QString &getShortcut(NodeIndex index) const { return m_strings[m_shortcutIds[index]]; }
+
+    /// Returns the URL of the node at the given index, which is empty for folders
+    const QUrl &getURL(NodeIndex index) const { return m_urls[m_urlIds[index]]; }
+
+    /// Returns the bookmark node that the entry at the given index was created from
+    BookmarkNode *getNode(NodeIndex index) const { return m_nodes[index]; }
+
+    /// Returns the indices of all bookmarks, in depth-first order
+    const std::vector<NodeIndex> &getBookmarks() const { return m_bookmarkIndices; }
+
+    /// Returns the indices of all folders, including the root node, in depth-first order
+    const std::vector<NodeIndex> &getFolders() const { return m_folderIndices; }
+
+private:
+    /// Unique identifiers of the nodes
+    std::vector<int> m_uniqueIds;
+
+    /// Index of the parent of each node
+    std::vector<NodeIndex> m_parentIndices;
+
+    /// Index after the last descendant of each node
+    std::vector<NodeIndex> m_subtreeEnds;
+
+    /// Type of each node
+    std::vector<uint8_t> m_types;
+
+    /// Index of the name of each node in the string table
+    std::vector<uint32_t> m_nameIds;
+
+    /// Index of the shortcut of each node in the string table
+    std::vector<uint32_t> m_shortcutIds;
+
+    /// Index of the URL of each node in the URL table
+    std::vector<uint32_t> m_urlIds;
+
+    /// Handle of each node in the bookmark tree
+    std::vector<BookmarkNode*> m_nodes;
+
+    /// Indices of the bookmark nodes
+    std::vector<NodeIndex> m_bookmarkIndices;
+
+    /// Indices of the folder nodes
+    std::vector<NodeIndex> m_folderIndices;
+
+    /// Interned names and shortcuts. The first entry is the empty string
+    std::vector<QString> m_strings;
+
+    /// Interned URLs. The first entry is the empty URL
+    std::vector<QUrl> m_urls;
+};
+
+#endif // FLATBOOKMARKTREE_H
@@ -0,0 +1,360 @@
+#ifndef SHARDEDLRUCACHE_H
+#define SHARDEDLRUCACHE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/// Default cost function of the \ref ShardedLRUCache , which counts each entry as a cost of one
+template <typename ValueType>
+struct UnitCost
+{
+    std::size_t operator()(const ValueType &) const
+    {
+        return 1;
+    }
+};
+
+/// Hit, miss and eviction counters of a \ref ShardedLRUCache
+struct CacheStatistics
+{
+    /// Number of lookups that found the requested entry
+    uint64_t Hits = 0;
+
+    /// Number of lookups that did not find the requested entry
+    uint64_t Misses = 0;
+
+    /// Number of entries removed to make room for newer entries
+    uint64_t Evictions = 0;
+
+    /// Number of entries currently in the cache
+    std::size_t Size = 0;
+
+    /// Total cost of the entries currently in the cache
+    std::size_t Cost = 0;
+};
+
+/**
+ * @class ShardedLRUCache
+ * @brief A thread-safe least recently used cache, bounded by the total cost of its entries.
+ *
+ * Keys are distributed over a fixed number of shards, each with its own lock, recency list and
+ * an equal part of the cost budget, so threads working on different keys rarely contend.
+ * Entries of a shard are stored in a node pool and linked by index, which avoids allocating
+ * a list node for every insertion.
+ *
+ * The cost of an entry is given by the CostFunction (one per entry by default, making the budget a
+ * maximum number of entries), or explicitly when it is inserted. Values are returned by copy, so
+ * implicitly shared or pointer types are preferred. ValueType must be default constructible.
+ */
+template <typename KeyType, typename ValueType,
+          typename CostFunction = UnitCost<ValueType>,
+          typename Hash = std::hash<KeyType>>
+class ShardedLRUCache
+{
+    /// Index of a node in the pool of a shard
+    using NodeIndex = uint32_t;
+
+    /// Marks the absence of a node
+    static constexpr NodeIndex InvalidNode = std::numeric_limits<NodeIndex>::max();
+
+    /// Entry of the cache, linked into the recency list of its shard
+    struct Node
+    {
+        KeyType Key;
+        ValueType Value;
+        std::size_t Cost;
+        NodeIndex Previous;
+        NodeIndex Next;
+    };
+
+    /// Independently locked partition of the cache
+    struct Shard
+    {
+        /// Guards every member of the shard
+        mutable std::mutex Mutex;
+
+        /// Pool of nodes, both in use and free
+        std::vector<Node> Nodes;
+
+        /// Indices of unused nodes in the pool
+        std::vector<NodeIndex> FreeNodes;
+
+        /// Maps each key to the index of its node
+        std::unordered_map<KeyType, NodeIndex, Hash> Index;
+
+        /// Most recently used node
+        NodeIndex Head = InvalidNode;
+
+        /// Least recently used node
+        NodeIndex Tail = InvalidNode;
+
+        /// Total cost of the nodes in use
+        std::size_t TotalCost = 0;
+
+        /// Maximum total cost of the shard
+        std::size_t MaxCost = 0;
+
+        /// Counters of the shard
+        uint64_t Hits = 0, Misses = 0, Evictions = 0;
+    };
+
+public:
+    /**
+     * @brief Constructs the cache
+     * @param maxCost Maximum total cost of the entries in the cache, split evenly between the shards
+     * @param numShards Number of independently locked partitions. Small caches should use a single shard,
+     *                  as an uneven distribution of keys will otherwise evict entries early
+     * @param costFunction Computes the cost of a value when it is inserted without an explicit cost
+     */
+    explicit ShardedLRUCache(std::size_t maxCost, std::size_t numShards = 8, CostFunction costFunction = CostFunction()) :
+        m_shards(std::max<std::size_t>(numShards, 1)),
+        m_hash(),
+        m_costFunction(costFunction),
+        m_maxCost(maxCost)
+    {
+        const std::size_t shardCost = std::max<std::size_t>(maxCost / m_shards.size(), 1);
+        for (Shard &shard : m_shards)
+            shard.MaxCost = shardCost;
+    }
+
+    /// Returns true if the cache contains an item associated with the given key, false if else.
+    /// This does not change the recency of the entry, nor the hit and miss counters
+    bool has(const KeyType &key) const
+    {
+        const Shard &shard = getShard(key);
+        std::lock_guard<std::mutex> lock(shard.Mutex);
+        return shard.Index.find(key) != shard.Index.end();
+    }
+
+    /// Returns a copy of the value associated with the given key, marking it as the most recently used
+    /// entry, or an empty optional if the key is not in the cache
+    std::optional<ValueType> tryGet(const KeyType &key)
+    {
+        Shard &shard = getShard(key);
+        std::lock_guard<std::mutex> lock(shard.Mutex);
+
+        auto it = shard.Index.find(key);
+        if (it == shard.Index.end())
+        {
+            ++shard.Misses;
+            return std::nullopt;
+        }
+
+        ++shard.Hits;
+        moveToFront(shard, it->second);
+        return shard.Nodes[it->second].Value;
+    }
+
+    /// Places the key-value pair into the front of the cache, with a cost given by the cost function
+    bool put(const KeyType &key, ValueType value)
+    {
+        const std::size_t cost = m_costFunction(value);
+        return put(key, std::move(value), cost);
+    }
+
+    /// Places the key-value pair into the front of the cache with the given cost, evicting the least recently used
+    /// entries of its shard until the cost fits. Returns false if the cost alone exceeds the budget of a shard, in
+    /// which case any previous value of the key is removed
+    bool put(const KeyType &key, ValueType value, std::size_t cost)
+    {
+        Shard &shard = getShard(key);
+        std::lock_guard<std::mutex> lock(shard.Mutex);
+
+        auto it = shard.Index.find(key);
+        if (cost > shard.MaxCost)
+        {
+            if (it != shard.Index.end())
+                removeNode(shard, it);
+            return false;
+        }
+
+        if (it != shard.Index.end())
+        {
+            Node &node = shard.Nodes[it->second];
+            shard.TotalCost = shard.TotalCost - node.Cost + cost;
+            node.Value = std::move(value);
+            node.Cost = cost;
+            moveToFront(shard, it->second);
+        }
+        else
+        {
+            const NodeIndex index = allocateNode(shard);
+            Node &node = shard.Nodes[index];
+            node.Key = key;
+            node.Value = std::move(value);
+            node.Cost = cost;
+            shard.TotalCost += cost;
+            linkFront(shard, index);
+            shard.Index.emplace(key, index);
+        }
+
+        // Never evict the entry that was just inserted, as it is known to fit on its own
+        while (shard.TotalCost > shard.MaxCost && shard.Tail != shard.Head)
+        {
+            removeNode(shard, shard.Index.find(shard.Nodes[shard.Tail].Key));
+            ++shard.Evictions;
+        }
+
+        return true;
+    }
+
+    /// Removes the entry associated with the given key, returning true if it was found
+    bool remove(const KeyType &key)
+    {
+        Shard &shard = getShard(key);
+        std::lock_guard<std::mutex> lock(shard.Mutex);
+
+        auto it = shard.Index.find(key);
+        if (it == shard.Index.end())
+            return false;
+
+        removeNode(shard, it);
+        return true;
+    }
+
+    /// Clears the cache. The counters are not reset
+    void clear()
+    {
+        for (Shard &shard : m_shards)
+        {
+            std::lock_guard<std::mutex> lock(shard.Mutex);
+            shard.Nodes.clear();
+            shard.FreeNodes.clear();
+            shard.Index.clear();
+            shard.Head = shard.Tail = InvalidNode;
+            shard.TotalCost = 0;
+        }
+    }
+
+    /// Returns the sum of the counters of each shard
+    CacheStatistics getStatistics() const
+    {
+        CacheStatistics result;
+        for (const Shard &shard : m_shards)
+        {
+            std::lock_guard<std::mutex> lock(shard.Mutex);
+            result.Hits += shard.Hits;
+            result.Misses += shard.Misses;
+            result.Evictions += shard.Evictions;
+            result.Size += shard.Index.size();
+            result.Cost += shard.TotalCost;
+        }
+        return result;
+    }
+
+    /// Returns the maximum total cost of the cache
+    std::size_t getMaxCost() const
+    {
+        return m_maxCost;
+    }
+
+private:
+    /// Returns the shard that the given key belongs to
+    Shard &getShard(const KeyType &key)
+    {
+        return m_shards[m_hash(key) % m_shards.size()];
+    }
+
+    /// Returns the shard that the given key belongs to
+    const Shard &getShard(const KeyType &key) const
+    {
+        return m_shards[m_hash(key) % m_shards.size()];
+    }
+
+    /// Returns the index of an unused node, growing the pool if there are none
+    NodeIndex allocateNode(Shard &shard)
+    {
+        if (!shard.FreeNodes.empty())
+        {
+            const NodeIndex index = shard.FreeNodes.back();
+            shard.FreeNodes.pop_back();
+            return index;
+        }
+
+        shard.Nodes.push_back(Node { KeyType(), ValueType(), 0, InvalidNode, InvalidNode });
+        return static_cast<NodeIndex>(shard.Nodes.size() - 1);
+    }
+
+    /// Unlinks the node referenced by the iterator, returning it to the pool
+    void removeNode(Shard &shard, typename std::unordered_map<KeyType, NodeIndex, Hash>::iterator it)
+    {
+        const NodeIndex index = it->second;
+        shard.Index.erase(it);
+        unlink(shard, index);
+
+        // Release the resources held by the entry while it sits in the pool
+        Node &node = shard.Nodes[index];
+        shard.TotalCost -= node.Cost;
+        node.Key = KeyType();
+        node.Value = ValueType();
+        node.Cost = 0;
+        shard.FreeNodes.push_back(index);
+    }
+
+    /// Places the node at the front of the recency list
+    void linkFront(Shard &shard, NodeIndex index)
+    {
+        Node &node = shard.Nodes[index];
+        node.Previous = InvalidNode;
+        node.Next = shard.Head;
+
+        if (shard.Head != InvalidNode)
+            shard.Nodes[shard.Head].Previous = index;
+        shard.Head = index;
+
+        if (shard.Tail == InvalidNode)
+            shard.Tail = index;
+    }
+
+    /// Removes the node from the recency list
+    void unlink(Shard &shard, NodeIndex index)
+    {
+        Node &node = shard.Nodes[index];
+
+        if (node.Previous != InvalidNode)
+            shard.Nodes[node.Previous].Next = node.Next;
+        else
+            shard.Head = node.Next;
+
+        if (node.Next != InvalidNode)
+            shard.Nodes[node.Next].Previous = node.Previous;
+        else
+            shard.Tail = node.Previous;
+
+        node.Previous = node.Next = InvalidNode;
+    }
+
+    /// Marks the node as the most recently used entry of its shard
+    void moveToFront(Shard &shard, NodeIndex index)
+    {
+        if (shard.Head == index)
+            return;
+
+        unlink(shard, index);
+        linkFront(shard, index);
+    }
+
+private:
+    /// Partitions of the cache
+    std::vector<Shard> m_shards;
+
+    /// Hashes keys to select their shard
+    Hash m_hash;
+
+    /// Computes the cost of values inserted without an explicit cost
+    CostFunction m_costFunction;
+
+    /// Maximum total cost of the cache
+    std::size_t m_maxCost;
+};
+
+#endif // SHARDEDLRUCACHE_H
@@ -8,22 +8,67 @@
 
 #include <QFileInfo>
 #include <QDebug>
+#include <QMetaObject>
 
 #include "BrowserApplication.h"
 #include "CookieJar.h"
+#include "CookieStore.h"
+#include "DatabaseTaskScheduler.h"
 #include "Settings.h"
 
-CookieJar::CookieJar(Settings *settings, bool privateJar, QObject *parent) :
+#include <algorithm>
+
+namespace
+{
+    /// Delay between a change to the jar and the writing of pending changes to the cookie database, in milliseconds
+    constexpr int CookieSaveDelay = 2000;
+
+    /// Shortest interval between two passes over the expired cookies, in milliseconds
+    constexpr qint64 MinExpiryInterval = 1000;
+
+    /// Longest interval between two passes over the expired cookies, in milliseconds
+    constexpr qint64 MaxExpiryInterval = 60 * 60 * 1000;
+}
+
+CookieJar::CookieJar(Settings *settings, DatabaseTaskScheduler *taskScheduler, bool privateJar, QObject *parent) :
     QNetworkCookieJar(parent),
     m_enableCookies(false),
     m_privateJar(privateJar),
     m_store(nullptr),
     m_exemptParties(),
+    m_exemptHostIndex(std::make_shared<DomainSuffixIndex>()),
+    m_cookieDomains(),
     m_exemptThirdPartyCookieFileName(),
-    m_mutex()
+    m_taskScheduler(privateJar ? nullptr : taskScheduler),
+    m_cookieStore(nullptr),
+    m_expiryQueue(),
+    m_expirationTimes(),
+    m_expiryTimer(),
+    m_pendingChanges(),
+    m_isSaveScheduled(false),
+    m_storedCookies(),
+    m_areStoredCookiesLoaded(false)
 {
     setObjectName(QLatin1String("CookieJar"));
 
+    m_expiryTimer.setSingleShot(true);
+    connect(&m_expiryTimer, &QTimer::timeout, this, &CookieJar::removeExpired);
+
+    if (m_taskScheduler)
+    {
+        m_taskScheduler->onInit([this](){
+            m_cookieStore = static_cast<CookieStore*>(m_taskScheduler->getWorker("CookieStore"));
+            if (!m_cookieStore)
+                return;
+
+            QHash<QByteArray, QByteArray> storedCookies = m_cookieStore->getCookieDigests();
+            QMetaObject::invokeMethod(this, [this, storedCookies](){
+                m_storedCookies = storedCookies;
+                m_areStoredCookiesLoaded = true;
+            }, Qt::QueuedConnection);
+        });
+    }
+
     if (settings)
     {
         m_enableCookies = settings->getValue(BrowserSetting::EnableCookies).toBool();
@@ -59,6 +104,8 @@ CookieJar::~CookieJar()
 {
     disconnect(m_store, 0, 0, 0);
 
+    saveChanges();
+
     if (!m_privateJar)
         saveExemptThirdParties();
 }
@@ -68,24 +115,42 @@ bool CookieJar::hasCookiesFor(const QString &host) const
     if (host.isEmpty())
         return false;
 
-    // If host string of format "xxx.yyy.zzz", must check for any cookies ending
-    // in ".yyy.zzz"
+    // If host string of format "xxx.yyy.zzz", must check for any cookies belonging
+    // to "yyy.zzz" or one of its subdomains
     QString hostSearch = host;
     int numDots = host.count(QChar('.'));
     if (numDots > 1)
-        hostSearch = host.right(host.size() - host.indexOf(QChar('.'), 0));
+        hostSearch = host.mid(host.indexOf(QChar('.'), 0) + 1);
 
-    auto cookies = allCookies();
-    for (const QNetworkCookie &cookie : cookies)
-        if (cookie.domain().endsWith(hostSearch))
-            return true;
-    return false;
+    return m_cookieDomains.containsSubdomainOf(hostSearch);
 }
 
 void CookieJar::eraseAllCookies()
 {
     QList<QNetworkCookie> noCookies;
     setAllCookies(noCookies);
+    m_cookieDomains.clear();
+
+    m_expiryQueue = decltype(m_expiryQueue)();
+    m_expirationTimes.clear();
+    m_expiryTimer.stop();
+
+    // Changes made before the cookies were erased no longer need to be written
+    m_pendingChanges.clear();
+    m_storedCookies.clear();
+    if (m_taskScheduler)
+    {
+        if (m_taskScheduler->isRunning())
+        {
+            m_taskScheduler->post([this](){
+                if (m_cookieStore)
+                    m_cookieStore->removeAllCookies();
+            });
+        }
+        else if (m_cookieStore)
+            m_cookieStore->removeAllCookies();
+    }
+
     m_store->deleteAllCookies();
 
     emit cookiesRemoved();
@@ -110,18 +175,8 @@ void CookieJar::setThirdPartyCookiesEnabled(bool value)
     m_store->setCookieFilter([=](const QWebEngineCookieStore::FilterRequest &request) -> bool {
         if (request.thirdParty && m_enableCookies)
         {
-            const QString originHost = request.origin.host();
-            for (auto &url : m_exemptParties)
-            {
-                const QString urlHost = url.host();
-                if (urlHost == originHost)
-                    return true;
-
-                const int domainIndex = originHost.indexOf(urlHost);
-                if (domainIndex > 0 && originHost.at(domainIndex - 1) == QLatin1Char('.'))
-                    return true;
-            }
-            return false;
+            std::shared_ptr<const DomainSuffixIndex> exemptHosts = std::atomic_load(&m_exemptHostIndex);
+            return exemptHosts->containsParentOf(request.origin.host());
         }
         return m_enableCookies;
     });
@@ -135,16 +190,42 @@ const QSet<URL> &CookieJar::getExemptThirdPartyHosts() const
     return m_exemptParties;
 }
 
+void CookieJar::getCookiePage(const QString &filter, const QNetworkCookie &after, int limit,
+                              std::function<void(std::vector<QNetworkCookie>)> callback)
+{
+    if (!m_taskScheduler)
+    {
+        callback(std::vector<QNetworkCookie>());
+        return;
+    }
+
+    // Write the pending changes first, so the page reflects the current state of the jar
+    saveChanges();
+
+    m_taskScheduler->post([this, filter, after, limit, callback](){
+        std::vector<QNetworkCookie> cookies;
+        if (m_cookieStore)
+            cookies = m_cookieStore->getCookiePage(filter, after, limit);
+
+        // The jar outlives the database thread, so the page is handed back to the jar's thread
+        QMetaObject::invokeMethod(this, [callback, cookies]() {
+            callback(cookies);
+        }, Qt::QueuedConnection);
+    });
+}
+
 void CookieJar::addThirdPartyExemption(const QUrl &hostUrl)
 {
     URL url(hostUrl);
     m_exemptParties.insert(url);
+    updateExemptHostIndex();
 }
 
 void CookieJar::removeThirdPartyExemption(const QUrl &hostUrl)
 {
     URL url(hostUrl);
     m_exemptParties.remove(hostUrl);
+    updateExemptHostIndex();
 }
 
 void CookieJar::loadExemptThirdParties()
@@ -164,6 +245,8 @@ void CookieJar::loadExemptThirdParties()
         if (!host.isEmpty())
             m_exemptParties.insert(URL(host));
     }
+
+    updateExemptHostIndex();
 }
 
 void CookieJar::saveExemptThirdParties()
@@ -197,10 +280,22 @@ void CookieJar::saveExemptThirdParties()
 void CookieJar::onCookieAdded(const QNetworkCookie &cookie)
 {
     try {
-        std::lock_guard<std::mutex> _(m_mutex);
-
         if (m_enableCookies)
-            static_cast<void>(insertCookie(cookie));
+        {
+            // A cookie with the same name, domain and path as one in the jar replaces it, and
+            // an expired cookie is not inserted, so the index only changes in the other cases
+            const bool replaced = deleteCookie(cookie);
+            const bool inserted = insertCookie(cookie);
+            if (inserted && !replaced)
+                m_cookieDomains.insert(cookie.domain());
+            else if (!inserted && replaced)
+                m_cookieDomains.remove(cookie.domain());
+
+            if (inserted)
+                trackCookie(cookie);
+            else if (replaced)
+                untrackCookie(cookie);
+        }
         else
             m_store->deleteCookie(cookie);
     } catch (const std::exception &ex) {
@@ -210,8 +305,11 @@ void CookieJar::onCookieAdded(const QNetworkCookie &cookie)
 
 void CookieJar::onCookieRemoved(const QNetworkCookie &cookie)
 {
-    std::lock_guard<std::mutex> _(m_mutex);
-    static_cast<void>(deleteCookie(cookie));
+    if (deleteCookie(cookie))
+    {
+        m_cookieDomains.remove(cookie.domain());
+        untrackCookie(cookie);
+    }
 }
 
 void CookieJar::onSettingChanged(BrowserSetting setting, const QVariant &value)
@@ -237,24 +335,161 @@ void CookieJar::onSettingChanged(BrowserSetting setting, const QVariant &value)
 
 void CookieJar::removeExpired()
 {
-    if (m_privateJar)
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    while (!m_expiryQueue.empty() && m_expiryQueue.top().Time <= now)
+    {
+        const QNetworkCookie cookie = m_expiryQueue.top().Cookie;
+        const qint64 expiration = m_expiryQueue.top().Time;
+        m_expiryQueue.pop();
+
+        // Skip the entries of cookies that were removed, or replaced by a cookie with another expiration date
+        auto it = m_expirationTimes.find(CookieStore::getCookieKey(cookie));
+        if (it == m_expirationTimes.end() || it.value() != expiration)
+            continue;
+
+        if (deleteCookie(cookie))
+        {
+            m_cookieDomains.remove(cookie.domain());
+            untrackCookie(cookie);
+        }
+        else
+            m_expirationTimes.erase(it);
+    }
+
+    scheduleExpiry();
+}
+
+void CookieJar::updateExemptHostIndex()
+{
+    std::shared_ptr<DomainSuffixIndex> exemptHosts = std::make_shared<DomainSuffixIndex>();
+    for (const auto &url : m_exemptParties)
+    {
+        const QString host = url.host();
+        if (!host.isEmpty())
+            exemptHosts->insert(host);
+    }
+
+    std::atomic_store(&m_exemptHostIndex, std::shared_ptr<const DomainSuffixIndex>(std::move(exemptHosts)));
+}
+
+void CookieJar::trackCookie(const QNetworkCookie &cookie)
+{
+    const QByteArray key = CookieStore::getCookieKey(cookie);
+
+    if (cookie.isSessionCookie())
+        m_expirationTimes.remove(key);
+    else
+    {
+        const qint64 expiration = cookie.expirationDate().toMSecsSinceEpoch();
+        m_expirationTimes.insert(key, expiration);
+
+        // Cookies that are refreshed often leave behind many outdated entries
+        if (m_expiryQueue.size() > 2 * static_cast<std::size_t>(m_expirationTimes.size()) + 1024)
+            rebuildExpiryQueue();
+        else
+            m_expiryQueue.push(CookieExpiry{ expiration, cookie });
+
+        if (m_expiryQueue.top().Time == expiration)
+            scheduleExpiry();
+    }
+
+    if (m_taskScheduler)
+    {
+        m_pendingChanges[key] = CookieChange{ cookie, false };
+        scheduleSaveChanges();
+    }
+}
+
+void CookieJar::untrackCookie(const QNetworkCookie &cookie)
+{
+    const QByteArray key = CookieStore::getCookieKey(cookie);
+    m_expirationTimes.remove(key);
+
+    if (m_taskScheduler)
+    {
+        m_pendingChanges[key] = CookieChange{ cookie, true };
+        scheduleSaveChanges();
+    }
+}
+
+void CookieJar::rebuildExpiryQueue()
+{
+    std::vector<CookieExpiry> entries;
+    entries.reserve(static_cast<std::size_t>(m_expirationTimes.size()));
+
+    const QList<QNetworkCookie> cookies = allCookies();
+    for (const QNetworkCookie &cookie : cookies)
+    {
+        if (!cookie.isSessionCookie())
+            entries.push_back(CookieExpiry{ cookie.expirationDate().toMSecsSinceEpoch(), cookie });
+    }
+
+    m_expiryQueue = decltype(m_expiryQueue)(std::greater<CookieExpiry>(), std::move(entries));
+}
+
+void CookieJar::scheduleExpiry()
+{
+    if (m_expiryQueue.empty())
+    {
+        m_expiryTimer.stop();
+        return;
+    }
+
+    const qint64 delay = m_expiryQueue.top().Time - QDateTime::currentMSecsSinceEpoch();
+    m_expiryTimer.start(static_cast<int>(std::clamp(delay, MinExpiryInterval, MaxExpiryInterval)));
+}
+
+void CookieJar::scheduleSaveChanges()
+{
+    if (m_isSaveScheduled)
+        return;
+
+    m_isSaveScheduled = true;
+    QTimer::singleShot(CookieSaveDelay, this, &CookieJar::saveChanges);
+}
+
+void CookieJar::saveChanges()
+{
+    m_isSaveScheduled = false;
+
+    if (m_pendingChanges.isEmpty() || !m_taskScheduler)
         return;
 
-    QList<QNetworkCookie> cookies = allCookies();
-    if (cookies.empty())
+    // Changes are kept until the cookie database is available, and the stored cookies are known. Should the
+    // database thread have stopped before then, the changes are written without being compared
+    if (!m_cookieStore || (!m_areStoredCookiesLoaded && m_taskScheduler->isRunning()))
+    {
+        scheduleSaveChanges();
         return;
+    }
 
-    QDateTime now = QDateTime::currentDateTime();
-    int numCookies = cookies.size();
-    for (int i = numCookies - 1; i >= 0; --i)
+    std::vector<QNetworkCookie> savedCookies, removedCookies;
+    for (auto it = m_pendingChanges.cbegin(); it != m_pendingChanges.cend(); ++it)
     {
-        const QNetworkCookie &cookie = cookies.at(i);
-        QDateTime expireDate = cookie.expirationDate();
-        if (cookie.isSessionCookie() || expireDate > now)
+        const CookieChange &change = it.value();
+        if (change.IsRemoved)
+        {
+            if (!m_areStoredCookiesLoaded || m_storedCookies.remove(it.key()) > 0)
+                removedCookies.push_back(change.Cookie);
+            continue;
+        }
+
+        QByteArray digest = CookieStore::getCookieDigest(change.Cookie);
+        auto storedIt = m_storedCookies.find(it.key());
+        if (storedIt != m_storedCookies.end() && storedIt.value() == digest)
             continue;
 
-        cookies.removeAt(i);
+        m_storedCookies.insert(it.key(), std::move(digest));
+        savedCookies.push_back(change.Cookie);
     }
+    m_pendingChanges.clear();
 
-    setAllCookies(cookies);
+    if (savedCookies.empty() && removedCookies.empty())
+        return;
+
+    // Once the task scheduler has stopped, such as during shutdown, the store can be accessed directly
+    if (m_taskScheduler->isRunning())
+        m_taskScheduler->post(&CookieStore::applyChanges, std::ref(m_cookieStore), savedCookies, removedCookies);
+    else
+        m_cookieStore->applyChanges(savedCookies, removedCookies);
 }
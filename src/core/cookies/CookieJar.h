@@ -1,23 +1,40 @@
 #ifndef COOKIEJAR_H
 #define COOKIEJAR_H
 
+#include "DomainSuffixIndex.h"
 #include "ISettingsObserver.h"
 #include "URL.h"
 
+#include <functional>
 #include <map>
 #include <memory>
-#include <mutex>
+#include <queue>
+#include <vector>
+#include <QByteArray>
 #include <QDateTime>
+#include <QHash>
+#include <QNetworkCookie>
 #include <QNetworkCookieJar>
 #include <QSet>
+#include <QTimer>
 #include <QUrl>
 #include <QWebEngineCookieStore>
 
+class CookieStore;
+class DatabaseTaskScheduler;
 class Settings;
 
 /**
  * @class CookieJar
  * @brief Implements ability to store and load cookies on disk
+ *
+ * The jar mirrors the web engine's cookie store, and is only used from the thread of the application, with the
+ * exception of the third party cookie filter. Changes to the jar are written to the \ref CookieStore in batches,
+ * a short time after they are made.
+ *
+ * The web engine persists cookies on its own, so the cookie database is never read back into the jar. It only
+ * serves the cookie manager, and cookies that the web engine announces again with the same attributes as their
+ * stored copy, such as every cookie when it loads its cookies at startup, are not written again.
  */
 class CookieJar : public QNetworkCookieJar, public ISettingsObserver
 {
@@ -26,8 +43,9 @@ class CookieJar : public QNetworkCookieJar, public ISettingsObserver
     Q_OBJECT
 
 public:
-    /// Constructs the cookie jar
-    explicit CookieJar(Settings *settings, bool privateJar = false, QObject *parent =nullptr);
+    /// Constructs the cookie jar, given the application settings and the scheduler of the database thread.
+    /// Cookies are not written to the cookie database if the scheduler is null or if this is a private jar
+    explicit CookieJar(Settings *settings, DatabaseTaskScheduler *taskScheduler, bool privateJar = false, QObject *parent = nullptr);
 
     /// Saves cookies to database before calling ~QNetworkCookieJar
     ~CookieJar();
@@ -48,6 +66,12 @@ class CookieJar : public QNetworkCookieJar, public ISettingsObserver
     /// Returns a const reference to the set of exempt third party hosts that can set cookies.
     const QSet<URL> &getExemptThirdPartyHosts() const;
 
+    /// Loads a page of up to the given number of cookies from the cookie database, following the given cookie in order
+    /// of domain, path and name. If the filter is not empty, only cookies with a domain or name containing it are loaded.
+    /// The callback is invoked on the thread of the cookie jar
+    void getCookiePage(const QString &filter, const QNetworkCookie &after, int limit,
+                       std::function<void(std::vector<QNetworkCookie>)> callback);
+
 Q_SIGNALS:
     /// Emitted when a new cookie has been added to the jar
     void cookieAdded();
@@ -79,10 +103,55 @@ private Q_SLOTS:
     /// Saves the host names of all third parties that are exempt from the cookie filter to the storage file
     void saveExemptThirdParties();
 
-    /// Removes expired cookies from both the database and the list in memory
+    /// Removes the cookies that have expired from the list in memory and from the database
     void removeExpired();
 
+    /// Rebuilds the index of exempt third party hosts that is read by the cookie filter
+    void updateExemptHostIndex();
+
+    /// Records the expiration date of a cookie that was added to the jar, and queues it to be saved
+    void trackCookie(const QNetworkCookie &cookie);
+
+    /// Forgets the expiration date of a cookie that was removed from the jar, and queues its removal from the database
+    void untrackCookie(const QNetworkCookie &cookie);
+
+    /// Rebuilds the queue of expiration dates from the cookies in the jar, dropping the entries of cookies that
+    /// have since been removed or replaced
+    void rebuildExpiryQueue();
+
+    /// Starts the timer that removes expired cookies, to fire when the next cookie expires
+    void scheduleExpiry();
+
+    /// Schedules the pending changes to be written to the cookie database, if not already scheduled
+    void scheduleSaveChanges();
+
+    /// Writes the pending changes to the cookie database
+    void saveChanges();
+
 private:
+    /// Expiration date of a cookie, ordered so that the queue of expiration dates gives the earliest date first
+    struct CookieExpiry
+    {
+        /// Expiration date of the cookie, in milliseconds since the epoch
+        qint64 Time;
+
+        /// The cookie
+        QNetworkCookie Cookie;
+
+        /// Returns true if this cookie expires after the other cookie, false if else
+        bool operator>(const CookieExpiry &other) const { return Time > other.Time; }
+    };
+
+    /// A change to a cookie that has not yet been written to the cookie database
+    struct CookieChange
+    {
+        /// The cookie
+        QNetworkCookie Cookie;
+
+        /// True if the cookie was removed from the jar, false if it was added or replaced
+        bool IsRemoved;
+    };
+
     /// True if cookies are enabled by the user, false if all cookies will immediately be removed
     bool m_enableCookies;
 
@@ -95,11 +164,44 @@ private Q_SLOTS:
     /// Set of exempt third party cookie setters
     QSet<URL> m_exemptParties;
 
+    /// Index of the hosts of the exempt third parties. The cookie filter runs on the network thread, so it
+    /// reads an immutable copy of the index which is replaced whenever the exemptions change
+    std::shared_ptr<const DomainSuffixIndex> m_exemptHostIndex;
+
+    /// Index of the domains of the cookies in the jar, with one entry per cookie
+    DomainSuffixIndex m_cookieDomains;
+
     /// Name of the file containing exceptions to the third-party cookie filtering policy (if enabled)
     QString m_exemptThirdPartyCookieFileName;
 
-    /// Mutex used within the handlers for a cookie being added or removed
-    mutable std::mutex m_mutex;
+    /// Scheduler of the database thread
+    DatabaseTaskScheduler *m_taskScheduler;
+
+    /// Cookie database, which is only accessed on the database thread while the task scheduler is running
+    CookieStore *m_cookieStore;
+
+    /// Min-heap of the expiration dates of persistent cookies. Entries of cookies that were removed or replaced
+    /// are skipped when they reach the top of the heap
+    std::priority_queue<CookieExpiry, std::vector<CookieExpiry>, std::greater<CookieExpiry>> m_expiryQueue;
+
+    /// Current expiration date of each persistent cookie in the jar, by the key of the cookie
+    QHash<QByteArray, qint64> m_expirationTimes;
+
+    /// Timer that removes cookies as they expire
+    QTimer m_expiryTimer;
+
+    /// Changes not yet written to the cookie database, by the key of the cookie
+    QHash<QByteArray, CookieChange> m_pendingChanges;
+
+    /// True if the pending changes are scheduled to be written, false if else
+    bool m_isSaveScheduled;
+
+    /// Digest of each cookie in the cookie database, by the key of the cookie, used to skip saving cookies that
+    /// have not changed. See \ref CookieStore::getCookieDigest
+    QHash<QByteArray, QByteArray> m_storedCookies;
+
+    /// True once the digests of the stored cookies have been loaded from the cookie database
+    bool m_areStoredCookiesLoaded;
 };
 
 #endif // COOKIEJAR_H
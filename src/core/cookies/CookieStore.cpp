@@ -0,0 +1,222 @@
+#include "CookieStore.h"
+
+#include <QDateTime>
+#include <QDebug>
+
+namespace
+{
+    /// Version of the cookie table structure. Older versions of the browser stored cookies in a different table
+    /// structure within the same file
+    constexpr int CookieSchemaVersion = 1;
+}
+
+CookieStore::CookieStore(const QString &databaseFile) :
+    DatabaseWorker(databaseFile),
+    m_queryMap()
+{
+}
+
+CookieStore::~CookieStore()
+{
+    m_queryMap.clear();
+}
+
+void CookieStore::applyChanges(const std::vector<QNetworkCookie> &savedCookies, const std::vector<QNetworkCookie> &removedCookies)
+{
+    if (savedCookies.empty() && removedCookies.empty())
+        return;
+
+    if (!m_database.beginTransaction())
+    {
+        qWarning() << "CookieStore::applyChanges - could not start transaction";
+        return;
+    }
+
+    sqlite::PreparedStatement &removeStmt = m_queryMap.at(StoredQuery::RemoveCookie);
+    for (const QNetworkCookie &cookie : removedCookies)
+    {
+        removeStmt.reset();
+        removeStmt << cookie.domain()
+                   << cookie.path()
+                   << cookie.name();
+        if (!removeStmt.execute())
+            qWarning() << "CookieStore::applyChanges - could not delete cookie " << cookie.name() << " of " << cookie.domain();
+    }
+
+    sqlite::PreparedStatement &upsertStmt = m_queryMap.at(StoredQuery::UpsertCookie);
+    for (const QNetworkCookie &cookie : savedCookies)
+    {
+        const qint64 expiration = cookie.isSessionCookie() ? 0 : cookie.expirationDate().toMSecsSinceEpoch();
+
+        upsertStmt.reset();
+        upsertStmt << cookie.domain()
+                   << cookie.path()
+                   << cookie.name()
+                   << cookie.value()
+                   << expiration
+                   << (cookie.isSecure() ? 1 : 0)
+                   << (cookie.isHttpOnly() ? 1 : 0);
+        if (!upsertStmt.execute())
+            qWarning() << "CookieStore::applyChanges - could not save cookie " << cookie.name() << " of " << cookie.domain();
+    }
+
+    if (!m_database.commitTransaction())
+    {
+        qWarning() << "CookieStore::applyChanges - could not commit transaction. Message: "
+                   << QString::fromStdString(m_database.getLastError());
+        if (!m_database.rollbackTransaction())
+            qWarning() << "CookieStore::applyChanges - could not roll back transaction";
+    }
+}
+
+void CookieStore::removeAllCookies()
+{
+    if (!exec(QLatin1String("DELETE FROM Cookies")))
+        qWarning() << "In CookieStore::removeAllCookies - Unable to clear Cookies table.";
+}
+
+void CookieStore::removeExpiredCookies(qint64 currentTime)
+{
+    auto stmt = m_database.prepare(R"(DELETE FROM Cookies WHERE Expiration > 0 AND Expiration <= ?)");
+    stmt << currentTime;
+    if (!stmt.execute())
+        qWarning() << "In CookieStore::removeExpiredCookies - Unable to remove expired cookies.";
+}
+
+void CookieStore::removeSessionCookies()
+{
+    if (!exec(QLatin1String("DELETE FROM Cookies WHERE Expiration = 0")))
+        qWarning() << "In CookieStore::removeSessionCookies - Unable to remove session cookies.";
+}
+
+std::vector<QNetworkCookie> CookieStore::getCookiePage(const QString &filter, const QNetworkCookie &after, int limit)
+{
+    std::vector<QNetworkCookie> result;
+
+    if (limit <= 0)
+        return result;
+
+    // Match the filter anywhere in the domain or name, treating its wildcard characters literally
+    QString pattern = filter;
+    pattern.replace(QLatin1Char('\\'), QLatin1String("\\\\"))
+           .replace(QLatin1Char('%'), QLatin1String("\\%"))
+           .replace(QLatin1Char('_'), QLatin1String("\\_"));
+    pattern = QLatin1Char('%') + pattern + QLatin1Char('%');
+
+    // Keyset pagination: resume after the key of the last cookie that was loaded. The row value comparison is a
+    // single range constraint on the primary key, so each page starts with a seek regardless of how many pages
+    // came before it. Cookies that do not match the filter are skipped while scanning forward from there
+    sqlite::PreparedStatement &query = m_queryMap.at(StoredQuery::GetCookiePage);
+    query.reset();
+    query << after.domain()
+          << after.path()
+          << after.name()
+          << (filter.isEmpty() ? 0 : 1)
+          << pattern
+          << pattern
+          << limit;
+
+    result.reserve(static_cast<size_t>(limit));
+    while (query.next())
+        result.push_back(readCookie(query));
+
+    return result;
+}
+
+QHash<QByteArray, QByteArray> CookieStore::getCookieDigests()
+{
+    QHash<QByteArray, QByteArray> result;
+
+    auto query = m_database.prepare(R"(SELECT Domain, Path, Name, Value, Expiration, IsSecure, IsHttpOnly FROM Cookies)");
+    while (query.next())
+    {
+        const QNetworkCookie cookie = readCookie(query);
+        result.insert(getCookieKey(cookie), getCookieDigest(cookie));
+    }
+
+    return result;
+}
+
+QByteArray CookieStore::getCookieKey(const QNetworkCookie &cookie)
+{
+    QByteArray key = cookie.domain().toUtf8();
+    key.append('\0').append(cookie.path().toUtf8()).append('\0').append(cookie.name());
+    return key;
+}
+
+QByteArray CookieStore::getCookieDigest(const QNetworkCookie &cookie)
+{
+    // The expiration date and flags come first, as the value may contain any character
+    const qint64 expiration = cookie.isSessionCookie() ? 0 : cookie.expirationDate().toMSecsSinceEpoch();
+    QByteArray digest = QByteArray::number(expiration);
+    digest.append('\0')
+          .append(cookie.isSecure() ? '1' : '0')
+          .append(cookie.isHttpOnly() ? '1' : '0')
+          .append(cookie.value());
+    return digest;
+}
+
+QNetworkCookie CookieStore::readCookie(sqlite::PreparedStatement &query)
+{
+    QString domain, path;
+    QByteArray name, value;
+    qint64 expiration = 0;
+    int isSecure = 0, isHttpOnly = 0;
+    query >> domain
+          >> path
+          >> name
+          >> value
+          >> expiration
+          >> isSecure
+          >> isHttpOnly;
+
+    QNetworkCookie cookie(name, value);
+    cookie.setDomain(domain);
+    cookie.setPath(path);
+    if (expiration > 0)
+        cookie.setExpirationDate(QDateTime::fromMSecsSinceEpoch(expiration));
+    cookie.setSecure(isSecure != 0);
+    cookie.setHttpOnly(isHttpOnly != 0);
+    return cookie;
+}
+
+bool CookieStore::hasProperStructure()
+{
+    return hasTable(QLatin1String("Cookies")) && getSchemaVersion(QLatin1String("Cookies")) >= CookieSchemaVersion;
+}
+
+void CookieStore::setup()
+{
+    if (!exec(QLatin1String("DROP TABLE IF EXISTS Cookies")))
+        qWarning() << "In CookieStore::setup - unable to remove the cookie table of an older version.";
+
+    if (!exec(QLatin1String("CREATE TABLE Cookies(Domain TEXT NOT NULL, Path TEXT NOT NULL, Name BLOB NOT NULL, Value BLOB, "
+                            "Expiration INTEGER DEFAULT 0, IsSecure INTEGER DEFAULT 0, IsHttpOnly INTEGER DEFAULT 0, "
+                            "PRIMARY KEY(Domain, Path, Name))")))
+    {
+        qWarning() << "In CookieStore::setup - unable to create cookie table.";
+        return;
+    }
+
+    setSchemaVersion(QLatin1String("Cookies"), CookieSchemaVersion);
+}
+
+void CookieStore::load()
+{
+    if (!exec(QLatin1String("CREATE INDEX IF NOT EXISTS Cookie_Expiration_Index ON Cookies(Expiration)")))
+        qWarning() << "In CookieStore::load - unable to create index on the expiration column of the cookie table.";
+
+    removeExpiredCookies(QDateTime::currentMSecsSinceEpoch());
+    removeSessionCookies();
+
+    m_queryMap.insert(std::make_pair(StoredQuery::UpsertCookie,
+                                     m_database.prepare(R"(INSERT OR REPLACE INTO Cookies(Domain, Path, Name, Value, Expiration, IsSecure, IsHttpOnly)
+                                                        VALUES (?, ?, ?, ?, ?, ?, ?))")));
+    m_queryMap.insert(std::make_pair(StoredQuery::RemoveCookie,
+                                     m_database.prepare(R"(DELETE FROM Cookies WHERE Domain = ? AND Path = ? AND Name = ?)")));
+    m_queryMap.insert(std::make_pair(StoredQuery::GetCookiePage,
+                                     m_database.prepare(R"(SELECT Domain, Path, Name, Value, Expiration, IsSecure, IsHttpOnly FROM Cookies
+                                                        WHERE (Domain, Path, Name) > (?, ?, ?)
+                                                        AND (? = 0 OR Domain LIKE ? ESCAPE '\' OR Name LIKE ? ESCAPE '\')
+                                                        ORDER BY Domain ASC, Path ASC, Name ASC LIMIT ?)")));
+}
@@ -0,0 +1,95 @@
+#ifndef COOKIESTORE_H
+#define COOKIESTORE_H
+
+#include "DatabaseWorker.h"
+
+#include <map>
+#include <vector>
+
+#include <QByteArray>
+#include <QHash>
+#include <QNetworkCookie>
+#include <QString>
+
+/**
+ * @class CookieStore
+ * @brief Persists the cookies of the \ref CookieJar , and lets the cookie manager load them one page at a time.
+ *
+ * Cookies are keyed by their domain, path and name. The key is ordered by domain first, so the cookies of a
+ * domain are stored next to each other, and pages of cookies are read in order of their domain.
+ */
+class CookieStore : public DatabaseWorker
+{
+    friend class DatabaseFactory;
+
+public:
+    /// Constructs the cookie store, given the path to the cookie database
+    explicit CookieStore(const QString &databaseFile);
+
+    /// Destructor
+    ~CookieStore();
+
+    /// Inserts or replaces each of the saved cookies, and removes each of the removed cookies,
+    /// in a single transaction
+    void applyChanges(const std::vector<QNetworkCookie> &savedCookies, const std::vector<QNetworkCookie> &removedCookies);
+
+    /// Removes every cookie from the store
+    void removeAllCookies();
+
+    /// Removes the cookies that expired on or before the given time, in milliseconds since the epoch
+    void removeExpiredCookies(qint64 currentTime);
+
+    /// Removes the cookies that only last for the session that stored them, which are saved with an expiration of 0
+    void removeSessionCookies();
+
+    /**
+     * @brief Loads a page of cookies, ordered by their domain, path and name
+     * @param filter If not empty, only cookies with a domain or name containing this text are loaded
+     * @param after The last cookie of the previous page. Loading starts from the first cookie if it has no domain
+     * @param limit Maximum number of cookies to load
+     * @return The cookies that follow the given cookie
+     */
+    std::vector<QNetworkCookie> getCookiePage(const QString &filter, const QNetworkCookie &after, int limit);
+
+    /// Returns the digest of every stored cookie, by the key of the cookie
+    QHash<QByteArray, QByteArray> getCookieDigests();
+
+    /// Returns the key used to identify a cookie, which is unique to its domain, path and name
+    static QByteArray getCookieKey(const QNetworkCookie &cookie);
+
+    /// Returns the digest of the stored attributes of a cookie, namely its value, expiration date and flags.
+    /// A cookie with the same key and digest as a stored cookie does not need to be saved again
+    static QByteArray getCookieDigest(const QNetworkCookie &cookie);
+
+protected:
+    /// Returns true if the cookie database contains the table structure(s) needed for it to function properly,
+    /// false if else.
+    bool hasProperStructure() override;
+
+    /// Creates the cookie table, replacing any table left by older versions of the browser
+    void setup() override;
+
+    /// Removes expired cookies and the session cookies of the previous session, and prepares the statements
+    /// used to access the database
+    void load() override;
+
+private:
+    /// Reads a cookie from the current row of a query on the cookie table, which selects the domain, path, name,
+    /// value, expiration date and flags of the cookie in that order
+    static QNetworkCookie readCookie(sqlite::PreparedStatement &query);
+
+private:
+    /// Used to access prepared database queries
+    enum class StoredQuery
+    {
+        UpsertCookie,
+        RemoveCookie,
+        GetCookiePage
+    };
+
+private:
+    /// Cache of frequently-executed sql statements
+    std::map<StoredQuery, sqlite::PreparedStatement> m_queryMap;
+};
+
+#endif // COOKIESTORE_H
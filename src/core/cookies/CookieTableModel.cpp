@@ -1,23 +1,38 @@
-#include <QNetworkAccessManager>
+#include <QPointer>
 #include <QWebEngineCookieStore>
 #include <QWebEngineProfile>
 
-#include "BrowserApplication.h"
+#include "CookieJar.h"
+#include "CookieStore.h"
 #include "CookieTableModel.h"
-#include "NetworkAccessManager.h"
 
-CookieTableModel::CookieTableModel(QObject *parent) :
+#include <utility>
+
+namespace
+{
+    /// Number of cookies to load in each call to fetchMore(..)
+    constexpr int CookiePageSize = 250;
+}
+
+CookieTableModel::CookieTableModel(CookieJar *cookieJar, QObject *parent) :
     QAbstractTableModel(parent),
+    m_cookieJar(cookieJar),
     m_cookieStore(QWebEngineProfile::defaultProfile()->cookieStore()),
     m_checkedState(),
     m_cookies(),
-    m_searchResults(),
-    m_searchModeOn(false)
+    m_cookieKeys(),
+    m_searchText(),
+    m_hasMoreCookies(false),
+    m_isFetching(false),
+    m_loadGeneration(0)
 {
     loadCookies();
 
     connect(m_cookieStore, &QWebEngineCookieStore::cookieAdded, this, &CookieTableModel::onCookieAdded);
     connect(m_cookieStore, &QWebEngineCookieStore::cookieRemoved, this, &CookieTableModel::onCookieRemoved);
+
+    if (m_cookieJar)
+        connect(m_cookieJar, &CookieJar::cookiesRemoved, this, &CookieTableModel::eraseCookies);
 }
 
 QVariant CookieTableModel::headerData(int section, Qt::Orientation orientation, int role) const
@@ -43,9 +58,6 @@ int CookieTableModel::rowCount(const QModelIndex &parent) const
     if (parent.isValid())
         return 0;
 
-    if (m_searchModeOn)
-        return m_searchResults.size();
-
     return m_cookies.size();
 }
 
@@ -56,6 +68,32 @@ int CookieTableModel::columnCount(const QModelIndex &parent) const
     return 3;
 }
 
+bool CookieTableModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+        return false;
+
+    return m_hasMoreCookies && !m_isFetching;
+}
+
+void CookieTableModel::fetchMore(const QModelIndex &parent)
+{
+    if (!canFetchMore(parent) || !m_cookieJar)
+        return;
+
+    m_isFetching = true;
+
+    // The callback is invoked on the thread of the cookie jar, which outlives the model
+    QPointer<CookieTableModel> self(this);
+    const int loadGeneration = m_loadGeneration;
+    const QNetworkCookie lastCookie = m_cookies.empty() ? QNetworkCookie() : m_cookies.last();
+    m_cookieJar->getCookiePage(m_searchText, lastCookie, CookiePageSize,
+                               [self, loadGeneration](std::vector<QNetworkCookie> cookies) {
+        if (self)
+            self->onCookiesFetched(std::move(cookies), loadGeneration);
+    });
+}
+
 QVariant CookieTableModel::data(const QModelIndex &index, int role) const
 {
     // Check if column is 0 for checkbox state
@@ -72,17 +110,6 @@ QVariant CookieTableModel::data(const QModelIndex &index, int role) const
     if (!index.isValid())
         return QVariant();
 
-    if (m_searchModeOn && index.row() < m_searchResults.size())
-    {
-        QNetworkCookie cookie = m_searchResults.at(index.row());
-        switch (index.column())
-        {
-            case 1: return cookie.domain();
-            case 2: return cookie.name();
-            default: return QVariant();
-        }
-    }
-
     if (index.row() < m_cookies.size())
     {
         QNetworkCookie cookie = m_cookies.at(index.row());
@@ -133,13 +160,11 @@ bool CookieTableModel::removeRows(int row, int count, const QModelIndex &parent)
     beginRemoveRows(parent, row, row + count - 1);
     for (int i = 0; i < count; ++i)
     {
-        QNetworkCookie cookie = (m_searchModeOn ? m_searchResults.at(row + i) : m_cookies.at(row + i));
+        QNetworkCookie cookie = m_cookies.at(row);
         m_cookieStore->deleteCookie(cookie);
-        if (m_searchModeOn)
-            m_searchResults.removeAt(row + i);
-        else
-            m_cookies.removeAt(row + i);
-        m_checkedState.removeAt(row + i);
+        m_cookieKeys.remove(CookieStore::getCookieKey(cookie));
+        m_cookies.removeAt(row);
+        m_checkedState.removeAt(row);
     }
     endRemoveRows();
     return true;
@@ -154,14 +179,7 @@ bool CookieTableModel::removeColumns(int column, int count, const QModelIndex &p
 
 QNetworkCookie CookieTableModel::getCookie(const QModelIndex &index) const
 {
-    if (m_searchModeOn)
-    {
-        if (index.row() >= m_searchResults.size())
-            return QNetworkCookie();
-        return m_searchResults.at(index.row());
-    }
-
-    if (index.row() >= m_cookies.size())
+    if (index.row() < 0 || index.row() >= m_cookies.size())
         return QNetworkCookie();
 
     return m_cookies.at(index.row());
@@ -174,78 +192,109 @@ const QList<int> &CookieTableModel::getCheckedStates() const
 
 void CookieTableModel::searchFor(const QString &text)
 {
-    // Clear existing rows to reset view
-    //removeRows(0, rowCount());
-    beginRemoveRows(QModelIndex(), 0, rowCount() - 1);
-    endRemoveRows();
+    m_searchText = text;
+    loadCookies();
+}
 
-    // If empty string, return to normal view
-    if (text.isEmpty())
-    {
-        m_searchModeOn = false;
-        loadCookies();
-        for (int i = 0; i < m_checkedState.size(); ++i)
-            m_checkedState[i] = Qt::Unchecked;
-        insertRows(0, rowCount());
-        m_searchResults.clear();
-        return;
-    }
+void CookieTableModel::loadCookies()
+{
+    beginResetModel();
 
-    // Reset any previous search results
-    m_searchResults.clear();
+    m_checkedState.clear();
+    m_cookies.clear();
+    m_cookieKeys.clear();
+    m_hasMoreCookies = true;
+    m_isFetching = false;
+    ++m_loadGeneration;
 
-    // Search for cookies with a name or domain value that match the search parameter
-    QByteArray textBytesLower = text.toLower().toUtf8();
-    for (const QNetworkCookie &cookie : m_cookies)
-    {
-        if (cookie.name().toLower().contains(textBytesLower)
-                || cookie.domain().contains(text, Qt::CaseInsensitive))
-        {
-            m_searchResults.append(cookie);
-        }
-    }
+    endResetModel();
+}
+
+void CookieTableModel::eraseCookies()
+{
+    beginResetModel();
 
-    // Enable search mode
-    m_searchModeOn = true;
+    m_checkedState.clear();
+    m_cookies.clear();
+    m_cookieKeys.clear();
+    m_hasMoreCookies = false;
+    m_isFetching = false;
+    ++m_loadGeneration;
 
-    // Insert the new rows into the model
-    insertRows(0, rowCount());
+    endResetModel();
 }
 
-void CookieTableModel::loadCookies()
+void CookieTableModel::onCookieAdded(const QNetworkCookie &cookie)
 {
-    int checkboxSize = m_checkedState.size();
-    int cookieSize = m_cookies.size();
-    if (checkboxSize < m_cookies.size())
+    // Cookies that have yet to be loaded will be shown along with the page that contains them
+    const int row = findCookie(cookie);
+    if (row >= 0)
     {
-        for (int i = 0; i < cookieSize - checkboxSize; ++i)
-            m_checkedState.append(Qt::Unchecked);
+        m_cookies[row] = cookie;
+        emit dataChanged(index(row, 1), index(row, 2));
     }
+    else if (!m_hasMoreCookies && matchesSearch(cookie))
+        appendCookie(cookie);
 }
 
-void CookieTableModel::eraseCookies()
+void CookieTableModel::onCookieRemoved(const QNetworkCookie &cookie)
 {
-    int numCookies = m_cookies.size();
-    m_cookies.clear();
-    m_checkedState.clear();
-    emit dataChanged(index(0, 0), index(numCookies - 1, 2));
+    const int row = findCookie(cookie);
+    if (row < 0)
+        return;
+
+    beginRemoveRows(QModelIndex(), row, row);
+    m_cookieKeys.remove(CookieStore::getCookieKey(cookie));
+    m_cookies.removeAt(row);
+    m_checkedState.removeAt(row);
+    endRemoveRows();
 }
 
-void CookieTableModel::onCookieAdded(const QNetworkCookie &cookie)
+void CookieTableModel::onCookiesFetched(std::vector<QNetworkCookie> &&cookies, int loadGeneration)
 {
-    int rowNum = m_cookies.size();
-    beginInsertRows(QModelIndex(), rowNum, rowNum);;
+    if (loadGeneration != m_loadGeneration)
+        return;
+
+    m_isFetching = false;
+    m_hasMoreCookies = cookies.size() == static_cast<size_t>(CookiePageSize);
+
+    for (const QNetworkCookie &cookie : cookies)
+        appendCookie(cookie);
+}
+
+void CookieTableModel::appendCookie(const QNetworkCookie &cookie)
+{
+    const QByteArray key = CookieStore::getCookieKey(cookie);
+    if (m_cookieKeys.contains(key))
+        return;
+
+    const int rowNum = m_cookies.size();
+    beginInsertRows(QModelIndex(), rowNum, rowNum);
     m_cookies.append(cookie);
+    m_checkedState.append(Qt::Unchecked);
+    m_cookieKeys.insert(key);
     endInsertRows();
 }
 
-void CookieTableModel::onCookieRemoved(const QNetworkCookie &cookie)
+int CookieTableModel::findCookie(const QNetworkCookie &cookie) const
 {
-    int index = m_cookies.indexOf(cookie);
-    if (index < 0)
-        return;
+    if (!m_cookieKeys.contains(CookieStore::getCookieKey(cookie)))
+        return -1;
 
-    beginRemoveRows(QModelIndex(), index, index);
-    m_cookies.removeAt(index);
-    endRemoveRows();
+    for (int i = 0; i < m_cookies.size(); ++i)
+    {
+        if (m_cookies.at(i).hasSameIdentifier(cookie))
+            return i;
+    }
+
+    return -1;
+}
+
+bool CookieTableModel::matchesSearch(const QNetworkCookie &cookie) const
+{
+    if (m_searchText.isEmpty())
+        return true;
+
+    return QString::fromUtf8(cookie.name()).contains(m_searchText, Qt::CaseInsensitive)
+            || cookie.domain().contains(m_searchText, Qt::CaseInsensitive);
 }
@@ -1,9 +1,14 @@
 #ifndef COOKIETABLEMODEL_H
 #define COOKIETABLEMODEL_H
 
+#include <vector>
+
 #include <QAbstractTableModel>
+#include <QByteArray>
 #include <QList>
 #include <QNetworkCookie>
+#include <QSet>
+#include <QString>
 
 class CookieJar;
 class QWebEngineCookieStore;
@@ -11,6 +16,8 @@ class QWebEngineCookieStore;
 /**
  * @class CookieTableModel
  * @brief Handles formatting of general cookie information in the \ref CookieWidget top table
+ *
+ * Cookies are loaded from the cookie database one page at a time, as the view requests them.
  */
 class CookieTableModel : public QAbstractTableModel
 {
@@ -19,8 +26,8 @@ class CookieTableModel : public QAbstractTableModel
     Q_OBJECT
 
 public:
-    /// Constructs the cookie table model
-    explicit CookieTableModel(QObject *parent = nullptr);
+    /// Constructs the cookie table model, given a pointer to the cookie jar
+    explicit CookieTableModel(CookieJar *cookieJar, QObject *parent = nullptr);
 
     // Header:
     QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
@@ -29,6 +36,12 @@ class CookieTableModel : public QAbstractTableModel
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
     int columnCount(const QModelIndex &parent = QModelIndex()) const override;
 
+    /// Returns true if there are more cookies to load, otherwise returns false
+    bool canFetchMore(const QModelIndex &parent) const override;
+
+    /// Loads the next page of cookies
+    void fetchMore(const QModelIndex &parent) override;
+
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
 
     // Editable
@@ -56,7 +69,7 @@ public Q_SLOTS:
     /// the matching subset of cookies in the model
     void searchFor(const QString &text);
 
-    /// Reloads the local copy of the browser's cookies
+    /// Clears the cookies shown by the model, to be loaded again from the first page
     void loadCookies();
 
 private Q_SLOTS:
@@ -70,20 +83,46 @@ private Q_SLOTS:
     void onCookieRemoved(const QNetworkCookie &cookie);
 
 private:
+    /// Handles the result of fetching the next page of cookies. Pages that were requested before
+    /// the last call to loadCookies() are discarded
+    void onCookiesFetched(std::vector<QNetworkCookie> &&cookies, int loadGeneration);
+
+    /// Appends the cookie to the end of the model, if it is not already shown
+    void appendCookie(const QNetworkCookie &cookie);
+
+    /// Returns the row of the cookie with the same domain, path and name as the given cookie, or -1 if not found
+    int findCookie(const QNetworkCookie &cookie) const;
+
+    /// Returns true if the cookie matches the current search text, false if else
+    bool matchesSearch(const QNetworkCookie &cookie) const;
+
+private:
+    /// Cookie jar
+    CookieJar *m_cookieJar;
+
     /// Cookie store
     QWebEngineCookieStore *m_cookieStore;
 
     /// Stores each row's checked state
     QList<int> m_checkedState;
 
-    /// Stores a copy of the browser's cookies
+    /// Cookies that have been loaded into the model
     QList<QNetworkCookie> m_cookies;
 
-    /// Stores a copy of the browser's cookies that match a search query
-    QList<QNetworkCookie> m_searchResults;
+    /// Keys of the cookies that have been loaded, used to avoid showing a cookie twice
+    QSet<QByteArray> m_cookieKeys;
+
+    /// Text that the domain or name of each cookie must contain, or an empty string to show all cookies
+    QString m_searchText;
+
+    /// True if the last page of cookies was full, in which case there may be more to fetch
+    bool m_hasMoreCookies;
+
+    /// True while a page of cookies is being fetched
+    bool m_isFetching;
 
-    /// True if the model is displaying the results of a cookie search, false if else
-    bool m_searchModeOn;
+    /// Incremented on each call to loadCookies()
+    int m_loadGeneration;
 };
 
 #endif // COOKIETABLEMODEL_H
@@ -0,0 +1,140 @@
+#include "DomainSuffixIndex.h"
+
+#include <utility>
+#include <vector>
+
+DomainSuffixIndex::DomainSuffixIndex() :
+    m_root()
+{
+}
+
+void DomainSuffixIndex::insert(const QString &domain)
+{
+    Node *node = &m_root;
+    ++node->SubtreeCount;
+
+    QString label;
+    int end = domain.size();
+    while (previousLabel(domain, end, label))
+    {
+        std::unique_ptr<Node> &child = node->Children[label];
+        if (!child)
+            child = std::make_unique<Node>();
+
+        node = child.get();
+        ++node->SubtreeCount;
+    }
+
+    ++node->Count;
+}
+
+bool DomainSuffixIndex::remove(const QString &domain)
+{
+    // Path of the domain, from the root to its node, paired with the label of each node within its parent
+    std::vector<std::pair<Node*, QString>> path;
+    path.push_back({ &m_root, QString() });
+
+    QString label;
+    int end = domain.size();
+    while (previousLabel(domain, end, label))
+    {
+        auto it = path.back().first->Children.find(label);
+        if (it == path.back().first->Children.end())
+            return false;
+
+        path.push_back({ it->second.get(), label });
+    }
+
+    if (path.back().first->Count == 0)
+        return false;
+
+    --path.back().first->Count;
+    for (auto &entry : path)
+        --entry.first->SubtreeCount;
+
+    // Prune the branch of nodes that no longer lead to any domain
+    for (std::size_t i = path.size() - 1; i > 0; --i)
+    {
+        if (path.at(i).first->SubtreeCount > 0)
+            break;
+
+        path.at(i - 1).first->Children.erase(path.at(i).second);
+    }
+
+    return true;
+}
+
+void DomainSuffixIndex::clear()
+{
+    m_root.Children.clear();
+    m_root.Count = 0;
+    m_root.SubtreeCount = 0;
+}
+
+bool DomainSuffixIndex::empty() const
+{
+    return m_root.SubtreeCount == 0;
+}
+
+std::size_t DomainSuffixIndex::size() const
+{
+    return static_cast<std::size_t>(m_root.SubtreeCount);
+}
+
+bool DomainSuffixIndex::containsParentOf(const QString &host) const
+{
+    const Node *node = &m_root;
+
+    QString label;
+    int end = host.size();
+    while (previousLabel(host, end, label))
+    {
+        auto it = node->Children.find(label);
+        if (it == node->Children.end())
+            return false;
+
+        node = it->second.get();
+        if (node->Count > 0)
+            return true;
+    }
+
+    return false;
+}
+
+bool DomainSuffixIndex::containsSubdomainOf(const QString &domain) const
+{
+    const Node *node = &m_root;
+
+    QString label;
+    int end = domain.size();
+    while (previousLabel(domain, end, label))
+    {
+        auto it = node->Children.find(label);
+        if (it == node->Children.end())
+            return false;
+
+        node = it->second.get();
+    }
+
+    return node != &m_root && node->SubtreeCount > 0;
+}
+
+bool DomainSuffixIndex::previousLabel(const QString &domain, int &end, QString &label)
+{
+    // Empty labels, such as the one before the leading dot of a cookie domain, are skipped
+    while (end > 0)
+    {
+        const int dotPos = domain.lastIndexOf(QLatin1Char('.'), end - 1);
+        const int start = dotPos + 1;
+        const int length = end - start;
+        end = dotPos;
+
+        if (length > 0)
+        {
+            label = domain.mid(start, length);
+            return true;
+        }
+    }
+
+    return false;
+}
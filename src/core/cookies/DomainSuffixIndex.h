@@ -0,0 +1,88 @@
+#ifndef DOMAINSUFFIXINDEX_H
+#define DOMAINSUFFIXINDEX_H
+
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+
+#include <QHash>
+#include <QString>
+
+/**
+ * @class DomainSuffixIndex
+ * @brief Stores domain names in a tree of their labels, in reverse order, so that "www.example.com" is found
+ *        under "com", then "example", then "www".
+ *
+ * This allows checking whether a host belongs to one of the domains in the index, or whether the index has any
+ * domain within a given domain, by following one path from the root of the tree, regardless of the number of
+ * domains in the index. A domain may be inserted more than once, in which case it must be removed as many times.
+ * Leading dots, as used by cookie domains, are ignored.
+ */
+class DomainSuffixIndex
+{
+public:
+    /// Constructs an empty index
+    DomainSuffixIndex();
+
+    /// Adds a domain to the index
+    void insert(const QString &domain);
+
+    /// Removes one occurrence of the domain from the index. Returns true if the domain was found, false if else
+    bool remove(const QString &domain);
+
+    /// Removes every domain from the index
+    void clear();
+
+    /// Returns true if the index is empty, false if else
+    bool empty() const;
+
+    /// Returns the number of domains in the index, including repeated domains
+    std::size_t size() const;
+
+    /// Returns true if the given host, or a domain that it belongs to, is in the index. For example,
+    /// "www.example.com" matches an index containing "example.com", but "badexample.com" does not
+    bool containsParentOf(const QString &host) const;
+
+    /// Returns true if the given domain, or one of its subdomains, is in the index. For example,
+    /// an index containing "www.example.com" has a subdomain of "example.com"
+    bool containsSubdomainOf(const QString &domain) const;
+
+private:
+    /// Hashes the labels of a domain with the hash function used by Qt containers
+    struct LabelHash
+    {
+        std::size_t operator()(const QString &label) const noexcept
+        {
+            return static_cast<std::size_t>(qHash(label));
+        }
+    };
+
+    /// A domain within the tree, formed by the labels on the path from the root to the node
+    struct Node
+    {
+        /// Subdomains of this domain, by their leftmost label
+        std::unordered_map<QString, std::unique_ptr<Node>, LabelHash> Children;
+
+        /// Number of times this domain was inserted into the index
+        int Count = 0;
+
+        /// Number of domains in the index that are this domain or one of its subdomains
+        int SubtreeCount = 0;
+    };
+
+    /**
+     * Reads the label of a domain that ends before the given position, moving right to left.
+     *
+     * @param domain The domain name
+     * @param end Position after the last character of the label, which is moved to the start of the next label
+     * @param label Receives the label
+     * @return True if a label was read, false if the start of the domain was reached
+     */
+    static bool previousLabel(const QString &domain, int &end, QString &label);
+
+private:
+    /// Root of the tree, which stands for the empty domain
+    Node m_root;
+};
+
+#endif // DOMAINSUFFIXINDEX_H
@@ -2,12 +2,22 @@
 
 #include <QDebug>
 
+#include <limits>
+#include <utility>
+#include <vector>
+
 DatabaseWorker::DatabaseWorker(const QString &dbFile) :
     m_database(dbFile.toStdString())
 {
     if (!m_database.isValid())
         qWarning() << "Unable to open database " << dbFile;
 
+    // Allow free pages to be reclaimed in small steps during maintenance. Only takes effect on new
+    // databases, and must be set before the journal mode writes the database header. Existing
+    // databases are converted by performMaintenance() or compact()
+    if (!m_database.execute("PRAGMA auto_vacuum=INCREMENTAL"))
+        qWarning() << "In DatabaseWorker constructor - could not set auto vacuum mode.";
+
     // Turn synchronous setting off
     if (!m_database.execute("PRAGMA journal_mode=WAL"))
         qWarning() << "In DatabaseWorker constructor - could not set journal mode.";
@@ -26,6 +36,42 @@ bool DatabaseWorker::exec(const QString &queryString)
     return m_database.execute(queryString.toStdString());
 }
 
+void DatabaseWorker::performMaintenance(int maxFreePages)
+{
+    // 2 = incremental
+    if (getPragmaValue(QLatin1String("auto_vacuum")) != 2)
+    {
+        // Rebuilding the database blocks every other task for as long as it takes to copy its contents, so
+        // only do so when the pages in use are few, and enough pages are free for the rebuild to be worthwhile.
+        // Free pages are not copied, so a large file that is mostly free, such as after clearing the history,
+        // is still converted
+        const qint64 freePageCount = getPragmaValue(QLatin1String("freelist_count"));
+        const qint64 usedSize = getPragmaValue(QLatin1String("page_size"))
+                * (getPragmaValue(QLatin1String("page_count")) - freePageCount);
+        if (usedSize <= MaxVacuumSize && freePageCount >= maxFreePages)
+            compact();
+    }
+    else if (!exec(QString("PRAGMA incremental_vacuum(%1)").arg(maxFreePages)))
+    {
+        qWarning() << "In DatabaseWorker::performMaintenance - could not vacuum database.";
+    }
+
+    if (!m_database.execute("PRAGMA wal_checkpoint(TRUNCATE)"))
+        qWarning() << "In DatabaseWorker::performMaintenance - could not checkpoint write-ahead log.";
+}
+
+bool DatabaseWorker::compact()
+{
+    if (!m_database.execute("PRAGMA auto_vacuum=INCREMENTAL") || !m_database.execute("VACUUM"))
+    {
+        qWarning() << "In DatabaseWorker::compact - could not rebuild database. Message: "
+                   << QString::fromStdString(m_database.getLastError());
+        return false;
+    }
+
+    return true;
+}
+
 bool DatabaseWorker::hasTable(const QString &tableName)
 {
     sqlite::PreparedStatement stmt = m_database.prepare(R"(SELECT COUNT(*) FROM sqlite_master WHERE type = 'table' AND name = ?)");
@@ -39,3 +85,95 @@ bool DatabaseWorker::hasTable(const QString &tableName)
 
     return false;
 }
+
+qint64 DatabaseWorker::getPragmaValue(const QString &pragma)
+{
+    qint64 value = 0;
+    auto stmt = m_database.prepare(QString("PRAGMA %1").arg(pragma).toStdString());
+    if (stmt.next())
+        stmt >> value;
+    return value;
+}
+
+int DatabaseWorker::getSchemaVersion(const QString &tableName)
+{
+    if (!hasTable(QLatin1String("SchemaVersions")))
+        return 0;
+
+    int version = 0;
+    auto stmt = m_database.prepare(R"(SELECT Version FROM SchemaVersions WHERE TableName = ?)");
+    stmt << tableName;
+    if (stmt.next())
+        stmt >> version;
+    return version;
+}
+
+bool DatabaseWorker::setSchemaVersion(const QString &tableName, int version)
+{
+    if (!m_database.execute("CREATE TABLE IF NOT EXISTS SchemaVersions(TableName TEXT PRIMARY KEY, Version INTEGER NOT NULL)"))
+    {
+        qWarning() << "In DatabaseWorker::setSchemaVersion - could not create schema version table. Message: "
+                   << QString::fromStdString(m_database.getLastError());
+        return false;
+    }
+
+    auto stmt = m_database.prepare(R"(INSERT OR REPLACE INTO SchemaVersions(TableName, Version) VALUES (?, ?))");
+    stmt << tableName
+         << version;
+    if (!stmt.execute())
+    {
+        qWarning() << "In DatabaseWorker::setSchemaVersion - could not update schema version. Message: "
+                   << QString::fromStdString(m_database.getLastError());
+        return false;
+    }
+
+    return true;
+}
+
+bool DatabaseWorker::convertColumn(const QString &tableName, const QString &idColumn, const QString &dataColumn,
+                                   const std::function<QByteArray(const QByteArray&)> &convert)
+{
+    auto selectStmt = m_database.prepare(QString("SELECT %1, %2 FROM %3 WHERE %1 > ? ORDER BY %1 LIMIT %4")
+                                         .arg(idColumn, dataColumn, tableName).arg(ConversionBatchSize).toStdString());
+    auto updateStmt = m_database.prepare(QString("UPDATE %1 SET %2 = ? WHERE %3 = ?")
+                                         .arg(tableName, dataColumn, idColumn).toStdString());
+
+    std::vector<std::pair<qint64, QByteArray>> records;
+    records.reserve(ConversionBatchSize);
+
+    qint64 lastId = std::numeric_limits<qint64>::min();
+    do
+    {
+        records.clear();
+
+        selectStmt.reset();
+        selectStmt << lastId;
+        while (selectStmt.next())
+        {
+            qint64 id = 0;
+            QByteArray data;
+            selectStmt >> id
+                       >> data;
+            records.push_back(std::make_pair(id, convert(data)));
+        }
+
+        for (const auto &record : records)
+        {
+            updateStmt.reset();
+            updateStmt << record.second
+                       << record.first;
+            if (!updateStmt.execute())
+            {
+                qWarning() << "In DatabaseWorker::convertColumn - could not convert " << tableName << "." << dataColumn
+                           << ". Message: " << QString::fromStdString(m_database.getLastError());
+                return false;
+            }
+        }
+
+        if (!records.empty())
+            lastId = records.back().first;
+    }
+    while (records.size() == ConversionBatchSize);
+
+    return true;
+}
@@ -4,8 +4,12 @@
 #include "sqlite/SQLiteWrapper.h"
 #include "bindings/QtSQLite.h"
 
+#include <QByteArray>
 #include <QString>
 
+#include <cstddef>
+#include <functional>
+
 /**
  * @class DatabaseWorker
  * @brief Base class of all browser components that use their own database for
@@ -14,6 +18,13 @@
 class DatabaseWorker
 {
 public:
+    /// Number of rows read into memory at a time by \ref convertColumn
+    static constexpr std::size_t ConversionBatchSize = 256;
+
+    /// Largest amount of data, in bytes, that \ref performMaintenance copies when rebuilding a database to enable
+    /// incremental vacuum. Larger databases are only rebuilt by \ref compact
+    static constexpr qint64 MaxVacuumSize = 32 * 1024 * 1024;
+
     /**
      * @brief DatabaseWorker Constructs an object that interacts with a SQLite database
      * @param dbFile Full path of the database file
@@ -26,10 +37,47 @@ class DatabaseWorker
     /// Executes the given query string, returning true on success, false on failure.
     bool exec(const QString &queryString);
 
+    /// Returns up to the given number of free pages to the file system and truncates the write-ahead log.
+    /// A database that was created without incremental vacuum support is rebuilt once to enable it, if the
+    /// pages in use hold no more than \ref MaxVacuumSize bytes and at least the given number of pages are free.
+    /// Intended to be run as a low priority task, see \ref DatabaseTaskScheduler::postIdle
+    void performMaintenance(int maxFreePages = 1024);
+
+    /// Rebuilds the database regardless of its size, returning every free page to the file system and enabling
+    /// incremental vacuum. Blocks the database for as long as it takes to copy its contents, so it is only meant
+    /// to follow an explicit request by the user. Returns true on success, false on failure
+    bool compact();
+
 protected:
     /// Returns true if the database contains the given table, false if else.
     bool hasTable(const QString &tableName);
 
+    /// Returns the integer value of the given pragma, or 0 if it could not be read
+    qint64 getPragmaValue(const QString &pragma);
+
+    /// Returns the schema version of the given table, which is 0 until set by \ref setSchemaVersion
+    int getSchemaVersion(const QString &tableName);
+
+    /// Stores the schema version of the given table, returning true on success. Versions are kept per table, so that
+    /// stores sharing a database file can track their one-time data migrations independently of each other
+    bool setSchemaVersion(const QString &tableName, int version);
+
+    /**
+     * @brief Replaces every value of a column by the result of the given conversion
+     *
+     * Rows are read and written in batches of \ref ConversionBatchSize, in the order of the id column, so that
+     * large tables are never held in memory at once. The caller is responsible for wrapping the conversion in a
+     * transaction.
+     *
+     * @param tableName Name of the table
+     * @param idColumn Name of the integer primary key of the table
+     * @param dataColumn Name of the column to convert
+     * @param convert Function that returns the new value of the column, given its current value
+     * @return True if every row was converted, false on error
+     */
+    bool convertColumn(const QString &tableName, const QString &idColumn, const QString &dataColumn,
+                       const std::function<QByteArray(const QByteArray&)> &convert);
+
 protected:
     /// Returns true if the database contains the table structure(s) needed for it to function properly, false if else.
     virtual bool hasProperStructure() = 0;
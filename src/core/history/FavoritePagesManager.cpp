@@ -6,7 +6,6 @@
 
 #include <chrono>
 #include <QByteArray>
-#include <QBuffer>
 #include <QFile>
 #include <QSet>
 #include <QJsonArray>
@@ -17,21 +16,6 @@
 
 const QString FavoritePagesManager::Version = QStringLiteral("1.1");
 
-QString WebPageInformation::getThumbnailInBase64() const
-{
-    QString result = QLatin1String("data:image/png;base64, ");
-
-    QByteArray data;
-    QBuffer buffer(&data);
-    Thumbnail.save(&buffer, "PNG");
-
-    if (data.isEmpty())
-        return QString();
-
-    result.append(data.toBase64());
-    return result;
-}
-
 FavoritePagesManager::FavoritePagesManager(HistoryManager *historyMgr, WebPageThumbnailStore *thumbnailStore, const QString &dataFile, QObject *parent) :
     QObject(parent),
     m_timerId(0),
@@ -86,7 +70,10 @@ QVariantList FavoritePagesManager::getFavorites() const
             item[QLatin1String("position")] = pageInfo.Position;
             item[QLatin1String("title")] = pageInfo.Title;
             item[QLatin1String("url")] = pageInfo.URL;
-            item[QLatin1String("thumbnail")] = pageInfo.getThumbnailInBase64();
+            if (m_thumbnailStore && m_thumbnailStore->hasThumbnail(pageInfo.URL))
+                item[QLatin1String("thumbnail")] = WebPageThumbnailStore::getThumbnailUrl(pageInfo.URL).toString();
+            else
+                item[QLatin1String("thumbnail")] = QString();
             result.append(item);
         }
     };
@@ -108,7 +95,6 @@ void FavoritePagesManager::addFavorite(const QUrl &url, const QString &title)
     pageInfo.Position = static_cast<int>(m_favoritePages.size());
     pageInfo.URL = url;
     pageInfo.Title = title;
-    pageInfo.Thumbnail = m_thumbnailStore->getThumbnail(url);
 
     if (title.isEmpty())
     {
@@ -192,7 +178,6 @@ void FavoritePagesManager::loadFavorites()
         pageInfo.Position = currentPage.value(QLatin1String("position")).toInt();
         pageInfo.Title = currentPage.value(QLatin1String("title")).toString();
         pageInfo.URL = QUrl(currentPage.value(QLatin1String("url")).toString());
-        pageInfo.Thumbnail = m_thumbnailStore->getThumbnail(pageInfo.URL);
 
         m_favoritePages.push_back(pageInfo);
         favoritedUrls.insert(pageInfo.URL);
@@ -249,9 +234,8 @@ void FavoritePagesManager::loadFromHistory()
                 it = m_mostVisitedPages.erase(it);
             else
             {
-                // Set position and get the thumbnail if we will keep this result
+                // Set the position if we will keep this result
                 it->Position = itemPosition++;
-                it->Thumbnail = m_thumbnailStore->getThumbnail(it->URL);
                 ++it;
             }
         }
@@ -4,7 +4,6 @@
 #include <vector>
 
 #include <QDateTime>
-#include <QImage>
 #include <QMetaType>
 #include <QObject>
 #include <QString>
@@ -15,8 +14,7 @@
 class HistoryManager;
 class WebPageThumbnailStore;
 
-/// Stores information about a specific web page, such as its URL, title
-/// and a thumbnail
+/// Stores information about a specific web page, such as its URL and title
 struct WebPageInformation
 {
     /// Position of the web page on the favorites web page
@@ -27,12 +25,6 @@ struct WebPageInformation
 
     /// URL of the page
     QUrl URL;
-
-    /// A small image of the web page
-    QImage Thumbnail;
-
-    /// Returns the thumbnail as a base-64 encoded string
-    QString getThumbnailInBase64() const;
 };
 
 /// Stores information about an entry that the user removed from the New Tab page
@@ -75,7 +67,8 @@ class FavoritePagesManager : public QObject
     bool isPresent(const QUrl &url) const;
 
 public Q_SLOTS:
-    /// Returns a list of the user's favorite web pages. The QVariants in the list may be converted to \ref WebPageInformation
+    /// Returns a list of the user's favorite web pages. The QVariants in the list may be converted to \ref WebPageInformation .
+    /// Thumbnails are referred to by a URL that they can be loaded from, rather than included in the list
     QVariantList getFavorites() const;
 
     /// Adds an item to the list of favorited (pinned) web pages
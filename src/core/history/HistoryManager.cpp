@@ -7,6 +7,8 @@
 #include <array>
 
 #include <QDateTime>
+#include <QMetaObject>
+#include <QPointer>
 #include <QUrl>
 
 #include <QDebug>
@@ -41,6 +43,8 @@ HistoryManager::HistoryManager(const ViperServiceLocator &serviceLocator, Databa
 
         m_lastVisitId = m_historyStore->getLastVisitId();
     });
+
+    scheduleMaintenance();
 }
 
 HistoryManager::~HistoryManager()
@@ -62,7 +66,24 @@ void HistoryManager::clearAllHistory()
     m_recentItems.clear();
     m_historyItems.clear();
 
-    m_taskScheduler.post(&HistoryStore::clearAllHistory, std::ref(m_historyStore));
+    // Listeners reload their contents when notified, so wait until the history has been removed from the store
+    QPointer<HistoryManager> self(this);
+    m_taskScheduler.post([self, &historyStore = m_historyStore](){
+        historyStore->clearAllHistory();
+
+        // Little data is left to copy, so this is the cheapest time to return the space of the history to
+        // the file system, and to enable incremental vacuum on a database too large for regular maintenance
+        historyStore->compact();
+
+        if (self)
+        {
+            QMetaObject::invokeMethod(self.data(), [self](){
+                if (self)
+                    emit self->historyCleared();
+            }, Qt::QueuedConnection);
+        }
+    });
+    scheduleMaintenance();
 }
 
 void HistoryManager::clearHistoryFrom(const QDateTime &start)
@@ -80,6 +101,7 @@ void HistoryManager::clearHistoryInRange(std::pair<QDateTime, QDateTime> range)
         onRecentItemsLoaded(m_historyStore->getRecentItems());
         emit historyCleared();
     });
+    scheduleMaintenance();
 
     auto visitRemover = [&range](VisitEntry v){
         return v >= range.first && v <= range.second;
@@ -177,6 +199,22 @@ void HistoryManager::getHistoryFrom(const QDateTime &startDate, std::function<vo
     });
 }
 
+void HistoryManager::getVisitPage(const QDateTime &startDate, const QDateTime &endDate, qint64 endRowId, int limit,
+                                  std::function<void(std::vector<HistoryVisit>)> callback)
+{
+    m_taskScheduler.post([this, startDate, endDate, endRowId, limit, callback](){
+        callback(m_historyStore->getVisitPage(startDate, endDate, endRowId, limit));
+    });
+}
+
+void HistoryManager::getNewerVisitPage(const QDateTime &startDate, qint64 startRowId, int limit,
+                                       std::function<void(std::vector<HistoryVisit>)> callback)
+{
+    m_taskScheduler.post([this, startDate, startRowId, limit, callback](){
+        callback(m_historyStore->getNewerVisitPage(startDate, startRowId, limit));
+    });
+}
+
 void HistoryManager::contains(const QUrl &url, std::function<void(bool)> callback)
 {
     m_taskScheduler.post([this, url, callback](){
@@ -221,6 +259,13 @@ void HistoryManager::onSettingChanged(BrowserSetting setting, const QVariant &va
         setStoragePolicy(static_cast<HistoryStoragePolicy>(value.toInt()));
 }
 
+void HistoryManager::scheduleMaintenance()
+{
+    m_taskScheduler.postIdle([this](){
+        m_historyStore->performMaintenance();
+    });
+}
+
 void HistoryManager::onRecentItemsLoaded(std::deque<HistoryEntry> &&entries)
 {
     m_recentItems = std::move(entries);
@@ -242,17 +287,3 @@ void HistoryManager::loadMostVisitedEntries(int limit, std::function<void(std::v
         callback(m_historyStore->loadMostVisitedEntries(limit));
     });
 }
-
-void HistoryManager::loadWordDatabase(std::function<void(std::map<int, QString>)> callback)
-{
-    m_taskScheduler.post([this, callback](){
-        callback(m_historyStore->getWords());
-    });
-}
-
-void HistoryManager::loadHistoryWordMapping(std::function<void(std::map<int, std::vector<int>>)> callback)
-{
-    m_taskScheduler.post([this, callback](){
-        callback(m_historyStore->getEntryWordMapping());
-    });
-}
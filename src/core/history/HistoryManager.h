@@ -77,6 +77,17 @@ class HistoryManager : public QObject, public ISettingsObserver
     /// the callback once the data has been fetched
     void getHistoryFrom(const QDateTime &startDate, std::function<void(std::vector<URLRecord>)> callback);
 
+    /// Loads up to the given number of visits made on or after the start date, ordered from most to least recent,
+    /// that precede the visit at the given date and row identifier. The visits are passed to the callback once
+    /// they have been fetched
+    void getVisitPage(const QDateTime &startDate, const QDateTime &endDate, qint64 endRowId, int limit,
+                      std::function<void(std::vector<HistoryVisit>)> callback);
+
+    /// Loads up to the given number of the visits that follow the visit at the given date and row identifier,
+    /// ordered from most to least recent. The visits are passed to the callback once they have been fetched
+    void getNewerVisitPage(const QDateTime &startDate, qint64 startRowId, int limit,
+                           std::function<void(std::vector<HistoryVisit>)> callback);
+
     /// Checks if the given URL is contained in the history database, passing the result as a boolean
     /// in the given callback function
     void contains(const QUrl &url, std::function<void(bool)> callback);
@@ -102,13 +113,6 @@ class HistoryManager : public QObject, public ISettingsObserver
     /// determine which web pages' thumbnails to retrieve for the "New Tab" page
     void loadMostVisitedEntries(int limit, std::function<void(std::vector<WebPageInformation>)> callback);
 
-    /// Loads the word table into a map, returning the data in the callback function. Used by the
-    /// URL suggestion worker when recommending matches based on user input
-    void loadWordDatabase(std::function<void(std::map<int, QString>)> callback);
-
-    /// Loads a mapping of history entries to the lists of their corresponding words
-    void loadHistoryWordMapping(std::function<void(std::map<int, std::vector<int>>)> callback);
-
 Q_SIGNALS:
     /// Emitted when a page has been visited
     void pageVisited(const QUrl &url, const QString &title);
@@ -124,6 +128,9 @@ private Q_SLOTS:
     /// Adds the history visit to the in-memory history store.
     void addVisitToLocalStore(const QUrl &url, const QString &title, const QDateTime &visitTime, bool wasTypedByUser);
 
+    /// Queues a low priority task to reclaim free space in the history database and checkpoint its write-ahead log
+    void scheduleMaintenance();
+
     /// Handles the recent history record load event - called during instantiation of the \ref HistoryStore
     void onRecentItemsLoaded(std::deque<HistoryEntry> &&entries);
 
@@ -1,6 +1,10 @@
 #include "CommonUtil.h"
 #include "HistoryStore.h"
 
+#include <algorithm>
+#include <array>
+#include <limits>
+
 #include <QDateTime>
 #include <QUrl>
 #include <QDebug>
@@ -20,12 +24,6 @@ HistoryStore::~HistoryStore()
 
 void HistoryStore::clearAllHistory()
 {
-    if (!exec(QLatin1String("DELETE FROM URLWords")))
-        qWarning() << "In HistoryStore::clearAllHistory - Unable to clear History Word Mapping table.";
-
-    if (!exec(QLatin1String("DELETE FROM Words")))
-        qWarning() << "In HistoryStore::clearAllHistory - Unable to clear History Word table.";
-
     if (!exec(QLatin1String("DELETE FROM History")))
         qWarning() << "In HistoryStore::clearAllHistory - Unable to clear History table.";
 
@@ -35,25 +33,12 @@ void HistoryStore::clearAllHistory()
 
 void HistoryStore::clearHistoryFrom(const QDateTime &start)
 {
-    auto stmt = m_database.prepare(R"(DELETE FROM Visits WHERE Date >= ?)");
-    stmt << start;
-    if (!stmt.execute())
-        qWarning() << "In HistoryStore::clearHistoryFrom - Unable to clear history.";
-
-    if (!m_database.execute("DELETE FROM History WHERE VisitID NOT IN (SELECT DISTINCT VisitID FROM Visits)"))
-        qWarning() << "In HistoryStore::clearHistoryFrom - Unable to clear history.";
+    removeVisitsBetween(start.toMSecsSinceEpoch(), std::numeric_limits<qint64>::max());
 }
 
 void HistoryStore::clearHistoryInRange(std::pair<QDateTime, QDateTime> range)
 {
-    auto stmt = m_database.prepare(R"(DELETE FROM Visits WHERE Date >= ? AND Date <= ?)");
-    stmt << range.first
-         << range.second;
-    if (!stmt.execute())
-        qWarning() << "In HistoryStore::clearHistoryInRange - Unable to clear history.";
-
-    if (!m_database.execute("DELETE FROM History WHERE VisitID NOT IN (SELECT DISTINCT VisitID FROM Visits)"))
-        qWarning() << "In HistoryStore::clearHistoryInRange - Unable to clear history. ";
+    removeVisitsBetween(range.first.toMSecsSinceEpoch(), range.second.toMSecsSinceEpoch());
 }
 
 bool HistoryStore::contains(const QUrl &url) const
@@ -125,50 +110,92 @@ std::vector<URLRecord> HistoryStore::getHistoryBetween(const QDateTime &startDat
     if (!startDate.isValid() || !endDate.isValid())
         return result;
 
-    auto queryVisitIds = m_database.prepare(R"(SELECT DISTINCT VisitID FROM Visits WHERE Date >= ? AND Date <= ?
-                                            ORDER BY Date ASC)");
-    auto queryHistoryItem = m_database.prepare(R"(SELECT URL, Title, URLTypedCount FROM History WHERE VisitID = ?)");
-    auto queryVisitDates = m_database.prepare(R"(SELECT Date FROM Visits WHERE VisitID = ?
-                                              AND Date >= ? AND Date <= ? ORDER BY Date ASC)");
-
-    queryVisitIds << startDate
-                  << endDate;
-    while (queryVisitIds.next())
+    // Load every visit in the range along with its history item in a single pass, rather
+    // than querying for the item and its visits separately for each distinct visit ID
+    auto query = m_database.prepare(R"(SELECT V.VisitID, V.Date, H.URL, H.Title, H.URLTypedCount
+                                    FROM Visits AS V INDEXED BY Visit_Date_Index
+                                    INNER JOIN History AS H ON H.VisitID = V.VisitID
+                                    WHERE V.Date >= ? AND V.Date <= ?
+                                    ORDER BY V.Date ASC)");
+    query << startDate
+          << endDate;
+
+    std::vector<HistoryEntry> entries;
+    std::vector<std::vector<VisitEntry>> visits;
+    QHash<int, size_t> entryIndices;
+
+    while (query.next())
     {
         int visitId = 0;
-        queryVisitIds >> visitId;
-
-        queryHistoryItem.reset();
-        queryHistoryItem << visitId;
-        if (!queryHistoryItem.execute() || !queryHistoryItem.next())
-            continue;
+        QDateTime visitDate;
+        query >> visitId
+              >> visitDate;
 
-        HistoryEntry entry;
-        entry.VisitID = visitId;
-        queryHistoryItem >> entry.URL
-                         >> entry.Title
-                         >> entry.URLTypedCount;
-
-        std::vector<VisitEntry> visits;
-        queryVisitDates.reset();
-        queryVisitDates << visitId
-                        << startDate
-                        << endDate;
-        while (queryVisitDates.next())
+        auto it = entryIndices.find(visitId);
+        if (it == entryIndices.end())
         {
-            QDateTime temp = QDateTime();
-            queryVisitDates >> temp;
-            visits.push_back(temp);
+            HistoryEntry entry;
+            entry.VisitID = visitId;
+            query >> entry.URL
+                  >> entry.Title
+                  >> entry.URLTypedCount;
+
+            it = entryIndices.insert(visitId, entries.size());
+            entries.push_back(std::move(entry));
+            visits.emplace_back();
         }
 
-        entry.LastVisit = visits.at(visits.size() - 1);
-        entry.NumVisits = static_cast<int>(visits.size());
-        result.push_back( URLRecord{ std::move(entry), std::move(visits) } );
+        visits[it.value()].push_back(visitDate);
+    }
+
+    result.reserve(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        HistoryEntry &entry = entries[i];
+        entry.LastVisit = visits[i].back();
+        entry.NumVisits = static_cast<int>(visits[i].size());
+        result.push_back( URLRecord{ std::move(entry), std::move(visits[i]) } );
     }
 
     return result;
 }
 
+std::vector<HistoryVisit> HistoryStore::getVisitPage(const QDateTime &startDate, const QDateTime &endDate, qint64 endRowId, int limit)
+{
+    if (!startDate.isValid() || !endDate.isValid() || limit <= 0)
+        return std::vector<HistoryVisit>();
+
+    // Keyset pagination: resume from the (date, rowid) position of the last visit that was loaded. The row value
+    // comparison is a single range constraint on the date index, whose entries are ordered by (Date, rowid),
+    // so it is a seek regardless of how many pages came before it
+    sqlite::PreparedStatement &query = m_statements.at(Statement::GetVisitPage);
+    query.reset();
+    query << startDate
+          << endDate
+          << endRowId
+          << limit;
+
+    return readVisitPage(query, limit);
+}
+
+std::vector<HistoryVisit> HistoryStore::getNewerVisitPage(const QDateTime &startDate, qint64 startRowId, int limit)
+{
+    if (!startDate.isValid() || limit <= 0)
+        return std::vector<HistoryVisit>();
+
+    // The same seek as getVisitPage, in the other direction. The closest visits come first, so reverse them
+    // into the order of the other pages
+    sqlite::PreparedStatement &query = m_statements.at(Statement::GetNewerVisitPage);
+    query.reset();
+    query << startDate
+          << startRowId
+          << limit;
+
+    std::vector<HistoryVisit> result = readVisitPage(query, limit);
+    std::reverse(result.begin(), result.end());
+    return result;
+}
+
 int HistoryStore::getTimesVisitedHost(const QUrl &url) const
 {
     auto query = m_database.prepare(R"(SELECT COUNT(NumVisits) FROM (SELECT VisitID, COUNT(VisitID) AS NumVisits
@@ -205,58 +232,6 @@ int HistoryStore::getTimesVisited(const QUrl &url) const
     return 0;
 }
 
-std::map<int, QString> HistoryStore::getWords() const
-{
-    std::map<int, QString> result;
-
-    auto stmt = m_database.prepare(R"(SELECT WordID, Word FROM Words ORDER BY WordID ASC)");
-    if (stmt.execute())
-    {
-        while (stmt.next())
-        {
-            int wordId = 0;
-            QString word;
-
-            stmt >> wordId
-                 >> word;
-            result.insert(std::make_pair(wordId, word));
-        }
-    }
-
-    return result;
-}
-
-std::map<int, std::vector<int>> HistoryStore::getEntryWordMapping() const
-{
-    std::map<int, std::vector<int>> result;
-
-    auto queryDistinctHistoryId = m_database.prepare(R"(SELECT DISTINCT(HistoryID) FROM URLWords ORDER BY HistoryID ASC)");
-    auto queryHistoryWordMapping =
-            m_database.prepare(R"(SELECT WordID FROM URLWords WHERE HistoryID = ?)");
-
-    while (queryDistinctHistoryId.next())
-    {
-        int historyId = 0;
-        queryDistinctHistoryId >> historyId;
-        //queryDistinctHistoryId.value(0).toInt();
-
-        std::vector<int> wordIds;
-        queryHistoryWordMapping.reset();
-        queryHistoryWordMapping << historyId;
-        while (queryHistoryWordMapping.next())
-        {
-            int wordId = 0;
-            queryHistoryWordMapping >> wordId;
-            wordIds.push_back(wordId);
-        }
-
-        if (!wordIds.empty())
-            result.insert(std::make_pair(historyId, wordIds));
-    }
-
-    return result;
-}
-
 void HistoryStore::addVisit(const QUrl &url, const QString &title, const QDateTime &visitTime, const QUrl &requestedUrl, bool wasTypedByUser)
 {
     auto existingEntry = getEntry(url);
@@ -274,8 +249,6 @@ void HistoryStore::addVisit(const QUrl &url, const QString &title, const QDateTi
 
         if (!stmtUpdate.execute())
             qWarning() << "HistoryStore::addVisit - could not save entry to database.";
-
-        tokenizeAndSaveUrl(static_cast<int>(visitId), url, title);
     }
     else
     {
@@ -289,9 +262,7 @@ void HistoryStore::addVisit(const QUrl &url, const QString &title, const QDateTi
                 << title
                 << urlTypedCount;
 
-        if (stmtNew.execute())
-            tokenizeAndSaveUrl(static_cast<int>(visitId), url, title);
-        else
+        if (!stmtNew.execute())
             qWarning() << "HistoryStore::addVisit - could not save entry to database.";
     }
 
@@ -319,30 +290,6 @@ uint64_t HistoryStore::getLastVisitId() const
     return m_lastVisitID;
 }
 
-void HistoryStore::tokenizeAndSaveUrl(int visitId, const QUrl &url, const QString &title)
-{
-    QStringList urlWords = CommonUtil::tokenizePossibleUrl(url.toString().toUpper());
-
-    if (!title.startsWith(QLatin1String("http"), Qt::CaseInsensitive))
-        urlWords = urlWords + title.toUpper().split(QLatin1Char(' '), QString::SkipEmptyParts);
-
-    sqlite::PreparedStatement &stmtInsertWord = m_statements.at(Statement::CreateWordRecord);
-    sqlite::PreparedStatement &stmtAssociateWord = m_statements.at(Statement::CreateUrlWordRecord);
-
-    for (const QString &word : urlWords)
-    {
-        stmtInsertWord.reset();
-        stmtAssociateWord.reset();
-
-        stmtInsertWord << word;
-        stmtInsertWord.execute();
-
-        stmtAssociateWord << visitId
-                          << word;
-        stmtAssociateWord.execute();
-    }
-}
-
 bool HistoryStore::hasProperStructure()
 {
     // Verify existence of Visits and History tables
@@ -362,33 +309,20 @@ void HistoryStore::setup()
     {
         qWarning() << "In HistoryStore::setup - unable to create visit table.";
     }
-
-    if (!exec(QLatin1String("CREATE TABLE IF NOT EXISTS Words(WordID INTEGER PRIMARY KEY AUTOINCREMENT, Word TEXT NOT NULL, UNIQUE (Word))")))
-    {
-        qWarning() << "In HistoryStore::setup - unable to create words table.";
-    }
-
-    if (!exec(QLatin1String("CREATE TABLE IF NOT EXISTS URLWords(HistoryID INTEGER NOT NULL, WordID INTEGER NOT NULL, "
-                                  "FOREIGN KEY(HistoryID) REFERENCES History(VisitID) ON DELETE CASCADE, "
-                                  "FOREIGN KEY(WordID) REFERENCES Words(WordID) ON DELETE CASCADE, PRIMARY KEY(HistoryID, WordID))")))
-    {
-        qWarning() << "In HistoryStore::setup - unable to create url-word association table.";
-    }
 }
 
 void HistoryStore::load()
 {
-    purgeOldEntries();
-    checkForUpdate();
-
+    // Create the indices ahead of purging, as deletions are made by date range
     if (!exec(QLatin1String("CREATE INDEX IF NOT EXISTS Visit_ID_Index ON Visits(VisitID)")))
         qWarning() << "In HistoryStore::load - unable to create index on the visit ID column of the visit table.";
 
     if (!exec(QLatin1String("CREATE INDEX IF NOT EXISTS Visit_Date_Index ON Visits(Date)")))
         qWarning() << "In HistoryStore::load - unable to create index on the date column of the visit table.";
 
-    if (!exec(QLatin1String("CREATE INDEX IF NOT EXISTS Word_Index ON Words(Word)")))
-        qWarning() << "In HistoryStore::load - unable to create index on the word column of the words table.";
+    checkForUpdate();
+    dropLegacyTables();
+    purgeOldEntries();
 
     // Create and cache our prepared statements
     auto cacheStatement = [this](Statement statement, const std::string &sql) {
@@ -398,20 +332,46 @@ void HistoryStore::load()
     cacheStatement(Statement::CreateHistoryRecord, R"(INSERT INTO History(VisitID, URL, Title, URLTypedCount) VALUES(?, ?, ?, ?))");
     cacheStatement(Statement::UpdateHistoryRecord, R"(INSERT OR REPLACE INTO History(VisitID, URL, Title, URLTypedCount) VALUES(?, ?, ?, ?))");
     cacheStatement(Statement::CreateVisitRecord, R"(INSERT INTO Visits(VisitID, Date) VALUES (?, ?))");
-    cacheStatement(Statement::CreateWordRecord, R"(INSERT OR IGNORE INTO Words(Word) VALUES (?))");
-    cacheStatement(Statement::CreateUrlWordRecord, R"(INSERT OR IGNORE INTO URLWords(HistoryID, WordID) VALUES (?, (SELECT WordID FROM Words WHERE Word = ?)))");
     cacheStatement(Statement::GetHistoryRecord, "SELECT History.VisitID, History.URL, History.Title, History.URLTypedCount, V.NumVisits, "
                                                 " V.RecentVisit FROM History INNER JOIN"
                                                 " (SELECT VisitID, MAX(Date) AS RecentVisit, COUNT(Date) AS NumVisits "
                                                 " FROM Visits INDEXED BY Visit_ID_Index GROUP BY VisitID) AS V"
                                                 " ON History.VisitID = V.VisitID "
                                                 " WHERE History.URL = ?");
+    cacheStatement(Statement::GetVisitPage, R"(SELECT V.rowid, V.VisitID, V.Date, H.URL, H.Title
+                                            FROM Visits AS V INDEXED BY Visit_Date_Index
+                                            INNER JOIN History AS H ON H.VisitID = V.VisitID
+                                            WHERE V.Date >= ? AND (V.Date, V.rowid) < (?, ?)
+                                            ORDER BY V.Date DESC, V.rowid DESC LIMIT ?)");
+    cacheStatement(Statement::GetNewerVisitPage, R"(SELECT V.rowid, V.VisitID, V.Date, H.URL, H.Title
+                                                 FROM Visits AS V INDEXED BY Visit_Date_Index
+                                                 INNER JOIN History AS H ON H.VisitID = V.VisitID
+                                                 WHERE (V.Date, V.rowid) > (?, ?)
+                                                 ORDER BY V.Date ASC, V.rowid ASC LIMIT ?)");
 
     auto stmt = m_database.prepare(R"(SELECT MAX(VisitID) FROM History)");
     if (stmt.next())
         stmt >> m_lastVisitID;
 }
 
+std::vector<HistoryVisit> HistoryStore::readVisitPage(sqlite::PreparedStatement &query, int limit)
+{
+    std::vector<HistoryVisit> result;
+    result.reserve(static_cast<size_t>(limit));
+    while (query.next())
+    {
+        HistoryVisit visit;
+        query >> visit.RowID
+              >> visit.VisitID
+              >> visit.Date
+              >> visit.URL
+              >> visit.Title;
+        result.push_back(std::move(visit));
+    }
+
+    return result;
+}
+
 void HistoryStore::checkForUpdate()
 {
     // Check if table structure needs update before loading
@@ -444,25 +404,86 @@ void HistoryStore::checkForUpdate()
     }
 }
 
+void HistoryStore::dropLegacyTables()
+{
+    // Suggestions are answered from the in-memory URLSuggestionIndex, so the database no longer keeps an
+    // index of its own. Remove the full-text table and its triggers along with the older word tables
+    const std::array<QLatin1String, 3> triggers {
+        QLatin1String("HistoryFTS_Insert"), QLatin1String("HistoryFTS_Update"), QLatin1String("HistoryFTS_Delete")
+    };
+    for (const QLatin1String &trigger : triggers)
+    {
+        if (!exec(QString("DROP TRIGGER IF EXISTS %1").arg(trigger)))
+            qWarning() << "In HistoryStore::dropLegacyTables - unable to drop trigger " << trigger;
+    }
+
+    if (hasTable(QLatin1String("HistoryFTS")) && !exec(QLatin1String("DROP TABLE HistoryFTS")))
+        qWarning() << "In HistoryStore::dropLegacyTables - unable to drop full-text index.";
+
+    if (hasTable(QLatin1String("URLWords")) && !exec(QLatin1String("DROP TABLE URLWords")))
+        qWarning() << "In HistoryStore::dropLegacyTables - unable to drop legacy url-word association table.";
+
+    if (hasTable(QLatin1String("Words")) && !exec(QLatin1String("DROP TABLE Words")))
+        qWarning() << "In HistoryStore::dropLegacyTables - unable to drop legacy words table.";
+}
+
 void HistoryStore::purgeOldEntries()
 {
     // Clear visits that are >8 weeks old
-    quint64 purgeDate = static_cast<quint64>(QDateTime::currentMSecsSinceEpoch());
-    const quint64 tmp = quint64{4838400000};
-    if (purgeDate > tmp)
+    const qint64 purgeDate = QDateTime::currentMSecsSinceEpoch() - qint64{4838400000};
+    if (purgeDate > 0)
+        removeVisitsBetween(0, purgeDate - 1);
+}
+
+void HistoryStore::removeVisitsBetween(qint64 startMSecs, qint64 endMSecs)
+{
+    if (!m_database.beginTransaction())
     {
-        purgeDate -= tmp;
+        qWarning() << "In HistoryStore::removeVisitsBetween - could not start transaction";
+        return;
+    }
 
-        auto stmt = m_database.prepare(R"(DELETE FROM Visits WHERE Date < ?)");
-        stmt << purgeDate;
-        if (!stmt.execute())
-        {
-            qWarning() << "HistoryStore - Could not purge old history entries.";
-        }
+    // Remember which entries had visits in the range, so that only those need to be checked for
+    // orphans, instead of scanning the whole History table with a NOT IN subquery
+    if (!exec(QLatin1String("CREATE TEMP TABLE IF NOT EXISTS RemovedVisitIDs(VisitID INTEGER PRIMARY KEY)"))
+            || !exec(QLatin1String("DELETE FROM temp.RemovedVisitIDs")))
+    {
+        qWarning() << "In HistoryStore::removeVisitsBetween - could not prepare temporary table. Message: "
+                   << QString::fromStdString(m_database.getLastError());
+        m_database.rollbackTransaction();
+        return;
+    }
+
+    auto stmtCollect = m_database.prepare(R"(INSERT OR IGNORE INTO temp.RemovedVisitIDs(VisitID)
+                                          SELECT VisitID FROM Visits WHERE Date >= ? AND Date <= ?)");
+    stmtCollect << startMSecs
+                << endMSecs;
+
+    auto stmtRemoveVisits = m_database.prepare(R"(DELETE FROM Visits WHERE Date >= ? AND Date <= ?)");
+    stmtRemoveVisits << startMSecs
+                     << endMSecs;
+
+    if (!stmtCollect.execute() || !stmtRemoveVisits.execute())
+    {
+        qWarning() << "In HistoryStore::removeVisitsBetween - unable to clear visits.";
+        m_database.rollbackTransaction();
+        return;
+    }
 
-        if (!m_database.execute(R"(DELETE FROM History WHERE VisitID NOT IN (SELECT VisitID FROM Visits);)"))
-            qWarning() << "HistoryStore - Error purging unused history entries. Message: " << QString::fromStdString(m_database.getLastError());
+    if (!exec(QLatin1String("DELETE FROM History WHERE VisitID IN (SELECT R.VisitID FROM temp.RemovedVisitIDs AS R "
+                            "LEFT JOIN Visits AS V ON V.VisitID = R.VisitID WHERE V.VisitID IS NULL)")))
+    {
+        qWarning() << "In HistoryStore::removeVisitsBetween - unable to clear unused history entries. Message: "
+                   << QString::fromStdString(m_database.getLastError());
+        m_database.rollbackTransaction();
+        return;
     }
+
+    if (!exec(QLatin1String("DELETE FROM temp.RemovedVisitIDs")))
+        qWarning() << "In HistoryStore::removeVisitsBetween - unable to empty temporary table.";
+
+    if (!m_database.commitTransaction())
+        qWarning() << "In HistoryStore::removeVisitsBetween - could not commit transaction";
 }
 
 std::vector<WebPageInformation> HistoryStore::loadMostVisitedEntries(int limit)
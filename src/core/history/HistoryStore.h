@@ -31,9 +31,9 @@ class HistoryStore : public DatabaseWorker
         CreateHistoryRecord,  /// INSERT OR REPLACE INTO History(VisitID, URL, Title, URLTypedCount) VALUES(?, ?, ?, ?)
         UpdateHistoryRecord,  /// UPDATE History SET Title = ?, URLTypedCount = ? WHERE VisitID = ?
         CreateVisitRecord,    /// INSERT INTO Visits(VisitID, Date) VALUES (?, ?)
-        CreateWordRecord,     /// INSERT OR IGNORE INTO Words(Word) VALUES(?)
-        CreateUrlWordRecord,  /// INSERT OR IGNORE INTO URLWords(HistoryID, WordID) VALUES(?, (SELECT WordID FROM Words WHERE Word = ?))
-        GetHistoryRecord      /// SELECT History.VisitID, History.URL, History.Title, History.URLTypedCount, V.NumVisits, ...
+        GetHistoryRecord,     /// SELECT History.VisitID, History.URL, History.Title, History.URLTypedCount, V.NumVisits, ...
+        GetVisitPage,         /// SELECT V.rowid, V.VisitID, V.Date, H.URL, H.Title FROM Visits AS V ... WHERE (V.Date, V.rowid) < (?, ?) ...
+        GetNewerVisitPage     /// SELECT V.rowid, V.VisitID, V.Date, H.URL, H.Title FROM Visits AS V ... WHERE (V.Date, V.rowid) > (?, ?) ...
     };
 
 public:
@@ -72,18 +72,22 @@ class HistoryStore : public DatabaseWorker
     /// Loads and returns a list of all \ref HistoryEntry items visited between the given start date and end dates
     std::vector<URLRecord> getHistoryBetween(const QDateTime &startDate, const QDateTime &endDate) const;
 
+    /// Loads up to the given number of visits made on or after the start date, ordered from most to least recent,
+    /// that precede the visit at the given date and row identifier. Used to page through a range of history
+    /// without loading all of it at once
+    std::vector<HistoryVisit> getVisitPage(const QDateTime &startDate, const QDateTime &endDate, qint64 endRowId, int limit);
+
+    /// Loads up to the given number of visits that follow the visit at the given date and row identifier, taking the
+    /// least recent of them, and returns them ordered from most to least recent. Used to page back towards the most
+    /// recent visits after older pages have been loaded
+    std::vector<HistoryVisit> getNewerVisitPage(const QDateTime &startDate, qint64 startRowId, int limit);
+
     /// Returns the number of times the user has visited the given website by its hostname
     int getTimesVisitedHost(const QUrl &url) const;
 
     /// Returns the number of times that the given URL has been visited
     int getTimesVisited(const QUrl &url) const;
 
-    /// Returns all of the words stored in the words table
-    std::map<int, QString> getWords() const;
-
-    /// Returns a mapping of history entries to the list of word IDs associated with them
-    std::map<int, std::vector<int>> getEntryWordMapping() const;
-
     /// Fetches the set of most frequently visited web pages, up to the given limit. This is used to
     /// determine which web pages' thumbnails to retrieve for the "New Tab" page
     std::vector<WebPageInformation> loadMostVisitedEntries(int limit = 10);
@@ -106,15 +110,23 @@ class HistoryStore : public DatabaseWorker
     void load() override;
 
 private:
-    /// Splits the given URL into distinct words, saving the association in the database
-    void tokenizeAndSaveUrl(int visitId, const QUrl &url, const QString &title);
-
     /// Called during the load() routine, this checks if any of the table structures need to be updated
     void checkForUpdate();
 
-    /// Removes history items that are more than six months old
+    /// Reads each visit in the result set of a visit page query, up to the given number of visits
+    std::vector<HistoryVisit> readVisitPage(sqlite::PreparedStatement &query, int limit);
+
+    /// Drops the tables and triggers that were used to search the history for URL suggestions, when migrating
+    /// an older database
+    void dropLegacyTables();
+
+    /// Removes history items that are more than eight weeks old
     void purgeOldEntries();
 
+    /// Removes the visits made within the given range of times, in milliseconds since the epoch,
+    /// along with any history entries that no longer have a visit
+    void removeVisitsBetween(qint64 startMSecs, qint64 endMSecs);
+
 private:
     /// Stores the last visit ID that has been used to record browsing history. Auto increments for each new history item
     uint64_t m_lastVisitID;
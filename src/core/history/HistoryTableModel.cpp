@@ -2,17 +2,41 @@
 #include "HistoryManager.h"
 #include "FaviconManager.h"
 
+#include <algorithm>
+#include <iterator>
+#include <limits>
 #include <utility>
 
+#include <QMetaObject>
+#include <QPointer>
+
+namespace
+{
+    /// Returns the form of the given URL that is compared against the pages of loaded favicons
+    QString getIconUrlKey(const QUrl &url)
+    {
+        return url.adjusted(QUrl::RemoveUserInfo | QUrl::RemoveQuery | QUrl::RemoveFragment).toString();
+    }
+}
+
 HistoryTableModel::HistoryTableModel(const ViperServiceLocator &serviceLocator, QObject *parent) :
     QAbstractTableModel(parent),
     m_historyManager(serviceLocator.getServiceAs<HistoryManager>("HistoryManager")),
     m_faviconManager(serviceLocator.getServiceAs<FaviconManager>("FaviconManager")),
     m_targetDate(),
-    m_loadedDate(),
+    m_cursorDate(),
+    m_cursorRowId(0),
+    m_hasMoreVisits(false),
+    m_hasNewerVisits(false),
+    m_isFetching(false),
+    m_loadGeneration(0),
     m_commonData(),
+    m_itemIndices(),
+    m_itemsByIconUrl(),
     m_history()
 {
+    if (m_faviconManager)
+        connect(m_faviconManager, &FaviconManager::faviconLoaded, this, &HistoryTableModel::onFaviconLoaded);
 }
 
 QVariant HistoryTableModel::headerData(int section, Qt::Orientation orientation, int role) const
@@ -50,65 +74,235 @@ int HistoryTableModel::columnCount(const QModelIndex &parent) const
     return 3;
 }
 
-bool HistoryTableModel::canFetchMore(const QModelIndex &/*parent*/) const
+bool HistoryTableModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+        return false;
+
+    return m_hasMoreVisits && !m_isFetching;
+}
+
+void HistoryTableModel::fetchMore(const QModelIndex &parent)
+{
+    if (!canFetchMore(parent) || !m_historyManager)
+        return;
+
+    m_isFetching = true;
+
+    // The callback is invoked on the database thread, so hand the results back to the thread of the model
+    QPointer<HistoryTableModel> self(this);
+    const int loadGeneration = m_loadGeneration;
+    m_historyManager->getVisitPage(m_targetDate, m_cursorDate, m_cursorRowId, VisitPageSize,
+                                   [self, loadGeneration](std::vector<HistoryVisit> visits) {
+        if (!self)
+            return;
+
+        QMetaObject::invokeMethod(self.data(), [self, loadGeneration, visits]() mutable {
+            if (self)
+                self->onHistoryFetched(std::move(visits), loadGeneration);
+        }, Qt::QueuedConnection);
+    });
+}
+
+bool HistoryTableModel::canFetchNewer() const
+{
+    return m_hasNewerVisits && !m_isFetching && !m_history.empty();
+}
+
+void HistoryTableModel::fetchNewer()
 {
-    return m_targetDate < m_loadedDate;
+    if (!canFetchNewer() || !m_historyManager)
+        return;
+
+    m_isFetching = true;
+
+    QPointer<HistoryTableModel> self(this);
+    const int loadGeneration = m_loadGeneration;
+    const HistoryTableRow &firstRow = m_history.front();
+    m_historyManager->getNewerVisitPage(firstRow.VisitDate, firstRow.RowID, VisitPageSize,
+                                        [self, loadGeneration](std::vector<HistoryVisit> visits) {
+        if (!self)
+            return;
+
+        QMetaObject::invokeMethod(self.data(), [self, loadGeneration, visits]() mutable {
+            if (self)
+                self->onNewerHistoryFetched(std::move(visits), loadGeneration);
+        }, Qt::QueuedConnection);
+    });
 }
 
-void HistoryTableModel::fetchMore(const QModelIndex &/*parent*/)
+void HistoryTableModel::onHistoryFetched(std::vector<HistoryVisit> &&visits, int loadGeneration)
 {
-    qint64 daysLeft = m_targetDate.daysTo(m_loadedDate);
-    if (daysLeft <= 0)
+    if (loadGeneration != m_loadGeneration)
+        return;
+
+    m_isFetching = false;
+    m_hasMoreVisits = visits.size() == static_cast<size_t>(VisitPageSize);
+
+    if (visits.empty())
+        return;
+
+    const HistoryVisit &lastVisit = visits.back();
+    m_cursorDate = lastVisit.Date;
+    m_cursorRowId = lastVisit.RowID;
+
+    std::vector<HistoryTableRow> rows = createRows(visits);
+
+    const int currentRowCount = rowCount();
+    beginInsertRows(QModelIndex(), currentRowCount, currentRowCount + static_cast<int>(rows.size()) - 1);
+    m_history.insert(m_history.end(), std::make_move_iterator(rows.begin()), std::make_move_iterator(rows.end()));
+    endInsertRows();
+
+    // Make room by removing the most recent rows, which are loaded again if the view scrolls back up
+    const int numExcessRows = rowCount() - MaxLoadedVisits;
+    if (numExcessRows > 0)
     {
-        m_loadedDate = m_targetDate;
+        removeLoadedRows(0, numExcessRows - 1);
+        m_hasNewerVisits = true;
+    }
+}
+
+void HistoryTableModel::onNewerHistoryFetched(std::vector<HistoryVisit> &&visits, int loadGeneration)
+{
+    if (loadGeneration != m_loadGeneration)
         return;
+
+    m_isFetching = false;
+    m_hasNewerVisits = visits.size() == static_cast<size_t>(VisitPageSize);
+
+    if (visits.empty())
+        return;
+
+    std::vector<HistoryTableRow> rows = createRows(visits);
+
+    beginInsertRows(QModelIndex(), 0, static_cast<int>(rows.size()) - 1);
+    m_history.insert(m_history.begin(), std::make_move_iterator(rows.begin()), std::make_move_iterator(rows.end()));
+    endInsertRows();
+
+    // Remove the oldest rows instead, and resume fetching older pages from the new last row
+    const int numExcessRows = rowCount() - MaxLoadedVisits;
+    if (numExcessRows > 0)
+    {
+        removeLoadedRows(MaxLoadedVisits, rowCount() - 1);
+
+        const HistoryTableRow &lastRow = m_history.back();
+        m_cursorDate = lastRow.VisitDate;
+        m_cursorRowId = lastRow.RowID;
+        m_hasMoreVisits = true;
     }
-    m_historyManager->getHistoryBetween(m_loadedDate.addDays(-1), m_loadedDate,
-                                    std::bind(&HistoryTableModel::onHistoryFetched, this, std::placeholders::_1));
 }
 
-void HistoryTableModel::onHistoryFetched(std::vector<URLRecord> &&entries)
+std::vector<HistoryTableRow> HistoryTableModel::createRows(const std::vector<HistoryVisit> &visits)
 {
-    QDateTime nextLoadedDate = m_loadedDate.addDays(-1);
+    std::vector<HistoryTableRow> rows;
+    rows.reserve(visits.size());
+    for (const HistoryVisit &visit : visits)
+    {
+        HistoryTableRow row;
+        row.ItemIndex = getItemIndex(visit);
+        row.RowID = visit.RowID;
+        row.VisitDate = visit.Date;
+        row.VisitString = visit.Date.toString("MMMM d yyyy, h:mm ap");
+        rows.push_back(row);
+    }
+    return rows;
+}
+
+void HistoryTableModel::removeLoadedRows(int first, int last)
+{
+    beginRemoveRows(QModelIndex(), first, last);
+    m_history.erase(m_history.begin() + first, m_history.begin() + last + 1);
+    endRemoveRows();
 
-    QMap<qint64, int> tmpVisitInfo; // Used to sort visits by date
-    for (auto &it : entries)
+    // Keep only the common data of the remaining rows, in the order they first appear
+    std::vector<int> newIndices(m_commonData.size(), -1);
+    std::vector<HistoryTableItem> commonData;
+    for (HistoryTableRow &row : m_history)
     {
-        // Load entry into common entry list, then specific visits into a temporary map for sorting
-        HistoryTableItem tableItem;
-        tableItem.Title = it.getTitle();
-        tableItem.URL = it.getUrl().toString();
-        tableItem.Favicon = m_faviconManager->getFavicon(it.getUrl()).pixmap(16, 16);
-        m_commonData.push_back(tableItem);
-
-        int itemIndex = static_cast<int>(m_commonData.size()) - 1;
-        for (const auto &visit : it.getVisits())
+        int &newIndex = newIndices[static_cast<size_t>(row.ItemIndex)];
+        if (newIndex < 0)
         {
-            auto time = visit.toMSecsSinceEpoch();
-            if (!tmpVisitInfo.contains(time))
-                tmpVisitInfo.insert(time, itemIndex);
+            newIndex = static_cast<int>(commonData.size());
+            commonData.push_back(std::move(m_commonData[static_cast<size_t>(row.ItemIndex)]));
         }
+        row.ItemIndex = newIndex;
     }
+    m_commonData = std::move(commonData);
+
+    for (auto it = m_itemIndices.begin(); it != m_itemIndices.end();)
+    {
+        const int newIndex = newIndices[static_cast<size_t>(it.value())];
+        if (newIndex < 0)
+        {
+            it = m_itemIndices.erase(it);
+            continue;
+        }
 
-    int currentRowCount = rowCount();
-    beginInsertRows(QModelIndex(), currentRowCount, currentRowCount + tmpVisitInfo.size() - 1);
+        it.value() = newIndex;
+        ++it;
+    }
 
-    // Insert history entries into m_history sorted by most recently visited
-    QMapIterator<qint64, int> mapIt(tmpVisitInfo);
-    mapIt.toBack();
-    while (mapIt.hasPrevious())
+    for (auto it = m_itemsByIconUrl.begin(); it != m_itemsByIconUrl.end();)
     {
-        mapIt.previous();
-        QDateTime dateTime = QDateTime::fromMSecsSinceEpoch(mapIt.key());
+        std::vector<int> &itemIndices = it.value();
+        for (int &itemIndex : itemIndices)
+            itemIndex = newIndices[static_cast<size_t>(itemIndex)];
+        itemIndices.erase(std::remove(itemIndices.begin(), itemIndices.end(), -1), itemIndices.end());
 
-        HistoryTableRow row;
-        row.ItemIndex = mapIt.value();
-        row.VisitString = dateTime.toString("MMMM d yyyy, h:mm ap");
-        m_history.push_back(row);
+        if (itemIndices.empty())
+            it = m_itemsByIconUrl.erase(it);
+        else
+            ++it;
     }
+}
 
-    m_loadedDate = nextLoadedDate;
-    endInsertRows();
+void HistoryTableModel::onFaviconLoaded(const QUrl &pageUrl, const QIcon &icon)
+{
+    auto it = m_itemsByIconUrl.find(getIconUrlKey(pageUrl));
+    if (it == m_itemsByIconUrl.end())
+        return;
+
+    const std::vector<int> &itemIndices = it.value();
+    const QPixmap favicon = icon.pixmap(16, 16);
+    for (int itemIndex : itemIndices)
+        m_commonData[static_cast<size_t>(itemIndex)].Favicon = favicon;
+
+    // Notify the view of each run of consecutive rows that show the page
+    const int numRows = rowCount();
+    int firstChangedRow = -1;
+    for (int row = 0; row <= numRows; ++row)
+    {
+        const bool isChanged = row < numRows
+                && std::find(itemIndices.begin(), itemIndices.end(), m_history[static_cast<size_t>(row)].ItemIndex) != itemIndices.end();
+        if (isChanged && firstChangedRow < 0)
+        {
+            firstChangedRow = row;
+        }
+        else if (!isChanged && firstChangedRow >= 0)
+        {
+            emit dataChanged(index(firstChangedRow, 0), index(row - 1, 0), { Qt::DecorationRole });
+            firstChangedRow = -1;
+        }
+    }
+}
+
+int HistoryTableModel::getItemIndex(const HistoryVisit &visit)
+{
+    auto it = m_itemIndices.find(visit.VisitID);
+    if (it != m_itemIndices.end())
+        return it.value();
+
+    HistoryTableItem tableItem;
+    tableItem.Title = visit.Title;
+    tableItem.URL = visit.URL.toString();
+    if (m_faviconManager)
+        tableItem.Favicon = m_faviconManager->getFavicon(visit.URL).pixmap(16, 16);
+    m_commonData.push_back(tableItem);
+
+    const int itemIndex = static_cast<int>(m_commonData.size()) - 1;
+    m_itemIndices.insert(visit.VisitID, itemIndex);
+    m_itemsByIconUrl[getIconUrlKey(visit.URL)].push_back(itemIndex);
+    return itemIndex;
 }
 
 QVariant HistoryTableModel::data(const QModelIndex &index, int role) const
@@ -151,12 +345,19 @@ void HistoryTableModel::loadFromDate(const QDateTime &date)
     beginResetModel();
     m_targetDate = date;
 
-    // Set loaded date to a time in the future, as fetchMore() will grab history items one day at a time
+    // Begin paging from a time in the future, as fetchMore() will grab visits in order of most to least recent
     QDateTime tomorrow = QDateTime(QDate::currentDate(), QTime(0, 0));
-    m_loadedDate = tomorrow.addDays(1);
+    m_cursorDate = tomorrow.addDays(1);
+    m_cursorRowId = std::numeric_limits<qint64>::max();
+    m_hasMoreVisits = true;
+    m_hasNewerVisits = false;
+    m_isFetching = false;
+    ++m_loadGeneration;
 
     // Clear old model data
     m_commonData.clear();
+    m_itemIndices.clear();
+    m_itemsByIconUrl.clear();
     m_history.clear();
 
     endResetModel();
@@ -7,7 +7,8 @@
 #include <vector>
 #include <QAbstractTableModel>
 #include <QDateTime>
-#include <QMap>
+#include <QHash>
+#include <QIcon>
 #include <QPixmap>
 #include <QUrl>
 
@@ -42,6 +43,12 @@ struct HistoryTableRow
     /// Index of the history table item
     int ItemIndex;
 
+    /// Row identifier of the visit, used along with its date to page through the history
+    qint64 RowID;
+
+    /// Date/time of visit
+    QDateTime VisitDate;
+
     /// Date/time of visit in string format
     QString VisitString;
 };
@@ -49,6 +56,10 @@ struct HistoryTableRow
 /**
  * @class HistoryTableModel
  * @brief Loads browser history within a given range of dates into a table view
+ *
+ * Visits are loaded one page at a time as the view scrolls down. At most \ref MaxLoadedVisits are
+ * kept in memory, so the pages furthest from the newest page are removed, and loaded again by
+ * \ref fetchMore or \ref fetchNewer once the view scrolls back to them.
  */
 class HistoryTableModel : public QAbstractTableModel
 {
@@ -57,6 +68,12 @@ class HistoryTableModel : public QAbstractTableModel
     friend class HistoryWidget;
 
 public:
+    /// Number of visits that are loaded at a time
+    static constexpr int VisitPageSize = 250;
+
+    /// Maximum number of visits kept in the model
+    static constexpr int MaxLoadedVisits = 8 * VisitPageSize;
+
     /// Constructs the table model given a reference to the service locator, and an optional parent object pointer
     explicit HistoryTableModel(const ViperServiceLocator &serviceLocator, QObject *parent = nullptr);
 
@@ -77,12 +94,35 @@ class HistoryTableModel : public QAbstractTableModel
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
 
 protected:
-    /// Loads all history items beginning at the given date
+    /// Loads history items visited on or after the given date, one page at a time as the view requests them
     void loadFromDate(const QDateTime &date);
 
+    /// Returns true if more recent visits than those in the model were removed, and can be loaded again
+    bool canFetchNewer() const;
+
+    /// Loads the page of visits that precedes the first row of the model, inserting them at the top
+    void fetchNewer();
+
+private Q_SLOTS:
+    /// Sets the favicon of the history items of the given page, once its icon has been loaded by the favicon manager
+    void onFaviconLoaded(const QUrl &pageUrl, const QIcon &icon);
+
 private:
-    /// Callback registered in fetchMore(..) - this handles the result of fetching more history entries
-    void onHistoryFetched(std::vector<URLRecord> &&entries);
+    /// Callback registered in fetchMore(..) - this handles the result of fetching the next page of visits.
+    /// Pages that were requested before the last call to loadFromDate(..) are discarded
+    void onHistoryFetched(std::vector<HistoryVisit> &&visits, int loadGeneration);
+
+    /// Callback registered in fetchNewer() - inserts the page of more recent visits at the top of the model
+    void onNewerHistoryFetched(std::vector<HistoryVisit> &&visits, int loadGeneration);
+
+    /// Converts the given visits, ordered from most to least recent, into rows of the model
+    std::vector<HistoryTableRow> createRows(const std::vector<HistoryVisit> &visits);
+
+    /// Removes the given range of rows, along with the common data that is no longer referenced by any row
+    void removeLoadedRows(int first, int last);
+
+    /// Returns the index of the common data for the given visit, creating it if needed
+    int getItemIndex(const HistoryVisit &visit);
 
 private:
     /// History manager
@@ -91,15 +131,36 @@ class HistoryTableModel : public QAbstractTableModel
     /// Favicon manager
     FaviconManager *m_faviconManager;
 
-    /// Date-time requested from the last call to loadFromDate(..) - when the date is older than 24 hours, it is loaded incrementially
+    /// Date-time requested from the last call to loadFromDate(..). Visits are loaded up to this date
     QDateTime m_targetDate;
 
-    /// Date of the most recently loaded history item
-    QDateTime m_loadedDate;
+    /// Date of the least recent visit that has been loaded
+    QDateTime m_cursorDate;
+
+    /// Row identifier of the least recent visit that has been loaded
+    qint64 m_cursorRowId;
+
+    /// True if the last page of visits was full, or older rows were removed, in which case there may be more to fetch
+    bool m_hasMoreVisits;
+
+    /// True if more recent rows were removed from the model, and may be fetched again
+    bool m_hasNewerVisits;
+
+    /// True while a page of visits is being fetched
+    bool m_isFetching;
+
+    /// Incremented on each call to loadFromDate(..)
+    int m_loadGeneration;
 
     /// Common history data
     std::vector<HistoryTableItem> m_commonData;
 
+    /// Maps the visit ID of each history entry to the index of its common data
+    QHash<int, int> m_itemIndices;
+
+    /// Maps the URL of each history entry, as matched against the pages of loaded favicons, to the indices of its common data
+    QHash<QString, std::vector<int>> m_itemsByIconUrl;
+
     /// List of visited history items, ordered by most to least recent visit
     std::vector<HistoryTableRow> m_history;
 };
@@ -121,6 +121,28 @@ struct HistoryEntry final : public sqlite::Row
     }
 };
 
+/**
+ * @struct HistoryVisit
+ * @brief A single visit to a web page, as loaded one page of results at a time by the \ref HistoryTableModel
+ */
+struct HistoryVisit
+{
+    /// Row identifier of the visit. Orders visits that share the same date
+    qint64 RowID;
+
+    /// Unique visit ID of the associated history entry
+    int VisitID;
+
+    /// Date and time of the visit
+    VisitEntry Date;
+
+    /// URL of the page
+    QUrl URL;
+
+    /// Title of the web page
+    QString Title;
+};
+
 /**
  * @class URLRecord
  * @brief Contains a full record of a URL in the history database,
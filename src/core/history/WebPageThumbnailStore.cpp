@@ -10,22 +10,57 @@
 #include <algorithm>
 #include <array>
 #include <chrono>
-#include <set>
+#include <optional>
 #include <utility>
+#include <vector>
 #include <QBuffer>
+#include <QDateTime>
+#include <QFutureWatcher>
+#include <QMetaObject>
 #include <QMimeType>
-#include <QPixmap>
 #include <QPointer>
+#include <QSet>
 #include <QTimer>
 #include <QTimerEvent>
+#include <QtConcurrent>
 
 #include <QDebug>
 
+namespace
+{
+    /// Schema version of the Thumbnails table at which thumbnails are stored as raw PNG data, rather than base64 text
+    constexpr int RawThumbnailDataVersion = 1;
+
+    /// Maximum size, in bytes, of the encoded thumbnails held in memory
+    constexpr std::size_t MaxThumbnailCacheBytes = 8 * 1024 * 1024;
+
+    /// Maximum number of hosts whose thumbnail is shared with another host
+    constexpr std::size_t MaxHostAliases = 256;
+
+    /// Maximum number of pending thumbnails kept in the database between saves
+    constexpr int MaxPendingThumbnails = 200;
+
+    /// Delay, in milliseconds, between the processing of a thumbnail and writing it to the database,
+    /// so thumbnails of pages loaded around the same time are written together
+    constexpr int WriteDelay = 5000;
+
+    /// Number of the most frequently visited pages whose thumbnails are saved
+    constexpr int MostVisitedLimit = 100;
+
+    /// Prefix of the thumbnail URLs in the viper scheme, following the scheme name
+    const QString ThumbnailUrlPrefix = QStringLiteral("thumbnails/");
+}
+
+const QSize WebPageThumbnailStore::ThumbnailSize = QSize(375, 500);
+
 WebPageThumbnailStore::WebPageThumbnailStore(const ViperServiceLocator &serviceLocator, const QString &databaseFile, QObject *parent) :
     QObject(parent),
     DatabaseWorker(databaseFile),
     m_timerId(0),
-    m_thumbnails(),
+    m_thumbnails(MaxThumbnailCacheBytes, 1),
+    m_hostAliases(MaxHostAliases, 1),
+    m_unwrittenThumbnails(),
+    m_isWriteScheduled(false),
     m_bookmarkManager(serviceLocator.getServiceAs<BookmarkManager>("BookmarkManager")),
     m_historyManager(serviceLocator.getServiceAs<HistoryManager>("HistoryManager")),
     m_mimeDatabase()
@@ -40,37 +75,106 @@ WebPageThumbnailStore::WebPageThumbnailStore(const ViperServiceLocator &serviceL
 WebPageThumbnailStore::~WebPageThumbnailStore()
 {
     killTimer(m_timerId);
+    writePendingThumbnails();
 }
 
-QImage WebPageThumbnailStore::getThumbnail(const QUrl &url)
+bool WebPageThumbnailStore::hasThumbnail(const QUrl &url)
 {
-    const QString host = url.host().toLower();
+    const QString host = resolveAlias(url.host().toLower());
     if (host.isEmpty())
-        return QImage();
+        return false;
+
+    if (m_thumbnails.has(host) || m_unwrittenThumbnails.contains(host))
+        return true;
+
+    auto stmt = m_database.prepare(R"(SELECT EXISTS(SELECT 1 FROM PendingThumbnails WHERE Host = ?)
+                                      OR EXISTS(SELECT 1 FROM Thumbnails WHERE Host = ?))");
+    stmt << host
+         << host;
+    if (!stmt.next())
+        return false;
+
+    int exists = 0;
+    stmt >> exists;
+    return exists != 0;
+}
+
+QByteArray WebPageThumbnailStore::getThumbnailData(const QString &host)
+{
+    const QString thumbnailHost = resolveAlias(host.toLower());
+    if (thumbnailHost.isEmpty())
+        return QByteArray();
 
     // First, check in-memory storage. Then check the database for a thumbnail.
-    auto it = m_thumbnails.find(host);
-    if (it != m_thumbnails.end())
+    if (std::optional<QByteArray> data = m_thumbnails.tryGet(thumbnailHost))
+        return *data;
+
+    auto it = m_unwrittenThumbnails.find(thumbnailHost);
+    if (it != m_unwrittenThumbnails.end())
         return it.value();
 
-    auto stmt = m_database.prepare(R"(SELECT Thumbnail FROM Thumbnails WHERE Host = ?)");
-    stmt << host;
+    // Thumbnails captured in this session take precedence over those that were saved before it
+    auto stmt = m_database.prepare(R"(SELECT Thumbnail FROM PendingThumbnails WHERE Host = ?
+                                      UNION ALL SELECT Thumbnail FROM Thumbnails WHERE Host = ? LIMIT 1)");
+    stmt << thumbnailHost
+         << thumbnailHost;
     if (stmt.next())
     {
         QByteArray data;
         stmt >> data;
-        QByteArray decoded = QByteArray::fromBase64(data);
 
-        QBuffer buffer(&decoded);
-        QImage image;
-        image.load(&buffer, "PNG");
+        m_thumbnails.put(thumbnailHost, data);
+        return data;
+    }
 
-        m_thumbnails.insert(host, image);
+    return QByteArray();
+}
 
-        return image;
-    }
+QUrl WebPageThumbnailStore::getThumbnailUrl(const QUrl &pageUrl)
+{
+    const QString host = pageUrl.host().toLower();
+    if (host.isEmpty())
+        return QUrl();
 
-    return QImage();
+    return QUrl(QString("viper://%1%2").arg(ThumbnailUrlPrefix, host));
+}
+
+QString WebPageThumbnailStore::getHostFromThumbnailUrl(const QUrl &thumbnailUrl)
+{
+    if (thumbnailUrl.scheme().compare(QLatin1String("viper"), Qt::CaseInsensitive) != 0)
+        return QString();
+
+    QString path = thumbnailUrl.toString(QUrl::RemoveScheme | QUrl::RemoveQuery | QUrl::RemoveFragment);
+    while (path.startsWith(QLatin1Char('/')))
+        path = path.mid(1);
+
+    if (!path.startsWith(ThumbnailUrlPrefix))
+        return QString();
+
+    return path.mid(ThumbnailUrlPrefix.size()).toLower();
+}
+
+QByteArray WebPageThumbnailStore::processThumbnail(const QImage &frame)
+{
+    if (frame.isNull())
+        return QByteArray();
+
+    // Crop the top of the page to the aspect ratio of the thumbnail, so it is not stretched
+    QImage image = frame;
+    const int croppedHeight = frame.width() * ThumbnailSize.height() / ThumbnailSize.width();
+    if (croppedHeight > 0 && croppedHeight < frame.height())
+        image = frame.copy(0, 0, frame.width(), croppedHeight);
+
+    image = image.scaled(ThumbnailSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    if (image.isNull() || image.allGray())
+        return QByteArray();
+
+    QByteArray data;
+    QBuffer buffer(&data);
+    if (!image.save(&buffer, "PNG"))
+        return QByteArray();
+
+    return data;
 }
 
 void WebPageThumbnailStore::onPageLoaded(bool ok)
@@ -102,13 +206,19 @@ void WebPageThumbnailStore::onPageLoaded(bool ok)
             return;
     }
 
-    std::vector<QUrl> urls { originalUrl };
-    if (!CommonUtil::doUrlsMatch(originalUrl, url, true))
-        urls.push_back(url);
+    // The first host is the one that the thumbnail is stored under, and any other host is an alias of it
+    std::vector<QString> hosts { originalUrl.host().toLower() };
+    const QString host = url.host().toLower();
+    if (!host.isEmpty() && host != hosts.front())
+        hosts.push_back(host);
+    if (hosts.front().isEmpty())
+        hosts.erase(hosts.begin());
+    if (hosts.empty())
+        return;
 
     // Wait one second before trying to get the thumbnails, otherwise
     // we might get a blank thumbnail
-    QTimer::singleShot(1000, this, [this, ww, urls]() {
+    QTimer::singleShot(1000, this, [this, ww, hosts]() {
         if (ww.isNull())
             return;
         if (WebView *view = ww->view())
@@ -116,20 +226,17 @@ void WebPageThumbnailStore::onPageLoaded(bool ok)
             if (view->getProgress() < 100)
                 return;
 
-            const QPixmap &pixmap = view->getThumbnail();
-            if (pixmap.isNull())
+            // Only the capture of the frame needs to happen on this thread
+            const QImage frame = view->grabFrame();
+            if (frame.isNull())
                 return;
 
-            const QImage image = pixmap.toImage();
-            if (image.allGray())
-                return;
-
-            for (const QUrl &url : urls)
-            {
-                const QString host = url.host().toLower();
-                if (!host.isEmpty())
-                    m_thumbnails.insert(host, image);
-            }
+            QFutureWatcher<QByteArray> *watcher = new QFutureWatcher<QByteArray>(this);
+            connect(watcher, &QFutureWatcher<QByteArray>::finished, this, [this, watcher, hosts](){
+                onThumbnailProcessed(hosts, watcher->future().result());
+                watcher->deleteLater();
+            });
+            watcher->setFuture(QtConcurrent::run(&WebPageThumbnailStore::processThumbnail, frame));
         }
     });
 }
@@ -144,7 +251,7 @@ void WebPageThumbnailStore::timerEvent(QTimerEvent *event)
 
 bool WebPageThumbnailStore::hasProperStructure()
 {
-    return hasTable(QLatin1String("Thumbnails"));
+    return hasTable(QLatin1String("Thumbnails")) && hasTable(QLatin1String("PendingThumbnails"));
 }
 
 void WebPageThumbnailStore::setup()
@@ -153,74 +260,185 @@ void WebPageThumbnailStore::setup()
     // Id  |  Host  | Thumbnail
     // pk    string   string/blob
 
+    // PendingThumbnails table, holding thumbnails that may not be kept:
+    // Host  | Thumbnail | Captured
+    // pk      blob        integer (ms since epoch)
+
     // Setup table structure
     if (!m_database.execute("CREATE TABLE IF NOT EXISTS Thumbnails(Id INTEGER PRIMARY KEY, Host TEXT UNIQUE, Thumbnail BLOB)"))
         qWarning() << "WebPageThumbnailStore - could not create thumbnail database. Error message: "
                    << QString::fromStdString(m_database.getLastError());
+
+    if (!m_database.execute("CREATE TABLE IF NOT EXISTS PendingThumbnails(Host TEXT PRIMARY KEY, Thumbnail BLOB, Captured INTEGER)"))
+        qWarning() << "WebPageThumbnailStore - could not create pending thumbnail table. Error message: "
+                   << QString::fromStdString(m_database.getLastError());
 }
 
 void WebPageThumbnailStore::load()
 {
-    // load only when needed, not during instantiation
+    // Thumbnails are loaded only when needed, not during instantiation.
+    // Convert any thumbnails that were stored as base64 text into raw PNG data
+    const QString tableName = QLatin1String("Thumbnails");
+    if (getSchemaVersion(tableName) >= RawThumbnailDataVersion)
+        return;
+
+    if (!m_database.beginTransaction())
+        return;
+
+    const bool converted = convertColumn(tableName, QLatin1String("Id"), QLatin1String("Thumbnail"), [](const QByteArray &data) {
+        return QByteArray::fromBase64(data);
+    });
+    if (!converted || !setSchemaVersion(tableName, RawThumbnailDataVersion))
+    {
+        qWarning() << "WebPageThumbnailStore - could not convert thumbnail data";
+        m_database.rollbackTransaction();
+        return;
+    }
+
+    if (!m_database.commitTransaction())
+        qWarning() << "WebPageThumbnailStore - could not commit thumbnail data conversion";
+}
+
+QString WebPageThumbnailStore::resolveAlias(const QString &host)
+{
+    if (std::optional<QString> aliasedHost = m_hostAliases.tryGet(host))
+        return *aliasedHost;
+    return host;
+}
+
+void WebPageThumbnailStore::onThumbnailProcessed(const std::vector<QString> &hosts, const QByteArray &data)
+{
+    if (hosts.empty() || data.isEmpty())
+        return;
+
+    // Keep one copy of the thumbnail in memory, referred to by each of the hosts
+    const QString &primaryHost = hosts.front();
+    m_hostAliases.remove(primaryHost);
+    m_thumbnails.put(primaryHost, data);
+
+    for (const QString &host : hosts)
+    {
+        if (host != primaryHost)
+            m_hostAliases.put(host, primaryHost);
+        m_unwrittenThumbnails.insert(host, data);
+    }
+
+    if (!m_isWriteScheduled)
+    {
+        m_isWriteScheduled = true;
+        QTimer::singleShot(WriteDelay, this, &WebPageThumbnailStore::writePendingThumbnails);
+    }
+}
+
+void WebPageThumbnailStore::writePendingThumbnails()
+{
+    m_isWriteScheduled = false;
+
+    if (m_unwrittenThumbnails.isEmpty())
+        return;
+
+    if (!m_database.beginTransaction())
+        return;
+
+    const qint64 captureTime = QDateTime::currentMSecsSinceEpoch();
+    auto insertStmt = m_database.prepare(R"(INSERT OR REPLACE INTO PendingThumbnails(Host, Thumbnail, Captured) VALUES (?, ?, ?))");
+    for (auto it = m_unwrittenThumbnails.cbegin(); it != m_unwrittenThumbnails.cend(); ++it)
+    {
+        insertStmt.reset();
+        insertStmt << it.key()
+                   << it.value()
+                   << captureTime;
+        if (!insertStmt.execute())
+            qWarning() << "WebPageThumbnailStore - could not write pending thumbnail to database.";
+    }
+
+    // Limit the pending thumbnails to those that were captured most recently
+    auto trimStmt = m_database.prepare(R"(DELETE FROM PendingThumbnails WHERE Host NOT IN
+                                          (SELECT Host FROM PendingThumbnails ORDER BY Captured DESC LIMIT ?))");
+    trimStmt << MaxPendingThumbnails;
+    if (!trimStmt.execute())
+        qWarning() << "WebPageThumbnailStore - could not remove older pending thumbnails.";
+
+    if (!m_database.commitTransaction())
+    {
+        qWarning() << "WebPageThumbnailStore - could not commit pending thumbnails. Error message: "
+                   << QString::fromStdString(m_database.getLastError());
+        m_database.rollbackTransaction();
+    }
+
+    m_unwrittenThumbnails.clear();
 }
 
 void WebPageThumbnailStore::onMostVisitedPagesLoaded(std::vector<WebPageInformation> &&results)
 {
-    std::set<std::string> mostVisitedHosts;
+    QSet<QString> mostVisitedHosts;
 
     // Load top history entries into set
     for (const auto &entry : results)
     {
-        const std::string host = entry.URL.host().toLower().toStdString();
-        if (!host.empty())
+        const QString host = entry.URL.host().toLower();
+        if (!host.isEmpty())
             mostVisitedHosts.insert(host);
     }
 
     // Load all bookmarks into set
-    for (auto it : *m_bookmarkManager)
+    std::shared_ptr<const FlatBookmarkTree> bookmarks = m_bookmarkManager->getFlatTree();
+    for (FlatBookmarkTree::NodeIndex index : bookmarks->getBookmarks())
     {
-        if (it->getType() == BookmarkNode::Bookmark)
-        {
-            const std::string host = it->getURL().host().toLower().toStdString();
-            if (!host.empty())
-                mostVisitedHosts.insert(host);
-        }
+        const QString host = bookmarks->getURL(index).host().toLower();
+        if (!host.isEmpty())
+            mostVisitedHosts.insert(host);
     }
 
-    // Save applicable thumbnails
-    auto stmt = m_database.prepare(R"(INSERT OR REPLACE INTO Thumbnails(Host, Thumbnail) VALUES (?, ?))");
+    // Move the applicable pending thumbnails into the table of saved thumbnails
+    writePendingThumbnails();
 
-    for (auto it = m_thumbnails.begin(); it != m_thumbnails.end(); ++it)
-    {
-        const std::string host = it.key().toStdString();
-        if (mostVisitedHosts.find(host) == mostVisitedHosts.end())
-            continue;
+    if (!m_database.beginTransaction())
+        return;
 
-        const QImage &image = it.value();
-        if (image.isNull())
+    auto saveStmt = m_database.prepare(R"(INSERT OR REPLACE INTO Thumbnails(Host, Thumbnail)
+                                          SELECT Host, Thumbnail FROM PendingThumbnails WHERE Host = ?)");
+    auto removeStmt = m_database.prepare(R"(DELETE FROM PendingThumbnails WHERE Host = ?)");
+    for (const QString &host : mostVisitedHosts)
+    {
+        saveStmt.reset();
+        saveStmt << host;
+        if (!saveStmt.execute())
+        {
+            qWarning() << "WebPageThumbnailStore - could not save thumbnail to database.";
             continue;
+        }
 
-        QByteArray data;
-        QBuffer buffer(&data);
-        image.save(&buffer, "PNG");
-
-        data = data.toBase64();
-        stmt << host
-             << data;
+        removeStmt.reset();
+        removeStmt << host;
+        removeStmt.execute();
+    }
 
-        if (!stmt.execute())
-            qWarning() << "WebPageThumbnailStore - could not save thumbnail to database.";
+    if (!m_database.commitTransaction())
+    {
+        qWarning() << "WebPageThumbnailStore - could not commit saved thumbnails. Error message: "
+                   << QString::fromStdString(m_database.getLastError());
+        m_database.rollbackTransaction();
     }
 }
 
 void WebPageThumbnailStore::save()
 {
-    // iterate through the in-memory collection, and if any of the hostnames of a page's thumbnail
-    // is (1) in the top 100 most visited web pages (see HistoryManager), or (2) is favorited by
-    // the user, or (3) is bookmarked, then save to the DB
+    // Go through the pending thumbnails, and if any of the hostnames of a page's thumbnail
+    // is (1) in the top 100 most visited web pages (see HistoryManager), or (2) is bookmarked,
+    // then save it to the table of thumbnails that are kept
     if (!m_historyManager || !m_bookmarkManager)
         return;
 
-    int historyLimit = std::min(m_thumbnails.size(), 100);
-    m_historyManager->loadMostVisitedEntries(historyLimit, std::bind(&WebPageThumbnailStore::onMostVisitedPagesLoaded, this, std::placeholders::_1));
+    // The entries are loaded on the database thread, so hand them back to the thread of the thumbnail store
+    QPointer<WebPageThumbnailStore> self(this);
+    m_historyManager->loadMostVisitedEntries(MostVisitedLimit, [self](std::vector<WebPageInformation> results) {
+        if (!self)
+            return;
+
+        QMetaObject::invokeMethod(self.data(), [self, results]() mutable {
+            if (self)
+                self->onMostVisitedPagesLoaded(std::move(results));
+        }, Qt::QueuedConnection);
+    });
 }
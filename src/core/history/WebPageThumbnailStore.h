@@ -1,46 +1,86 @@
 #ifndef WEBPAGETHUMBNAILSTORE_H
 #define WEBPAGETHUMBNAILSTORE_H
 
+#include "CommonUtil.h"
 #include "DatabaseWorker.h"
 #include "HistoryManager.h"
 #include "ServiceLocator.h"
+#include "ShardedLRUCache.h"
 
+#include <cstddef>
 #include <vector>
 
+#include <QByteArray>
 #include <QHash>
 #include <QImage>
 #include <QMimeDatabase>
 #include <QObject>
-#include <QPixmap>
+#include <QSize>
 #include <QString>
 #include <QUrl>
 
 class BookmarkManager;
 class HistoryManager;
 
+/// Measures the cost of a cached thumbnail by the size of its encoded image data
+struct ThumbnailDataCost
+{
+    std::size_t operator()(const QByteArray &value) const
+    {
+        return static_cast<std::size_t>(value.size());
+    }
+};
+
 /**
  * @class WebPageThumbnailStore
  * @brief A data store that contains thumbnails of web pages that are
  *        either commonly visited, bookmarked or otherwise favorited by
  *        the user.
+ *
+ * Thumbnails are scaled and encoded as PNG images on a worker thread. The encoded thumbnails
+ * are kept in a cache that is limited by size, and are written to a table of pending thumbnails
+ * in the database so they can be read back after being evicted. When the store is saved, the
+ * pending thumbnails of frequently visited and bookmarked hosts are kept, and the rest of them
+ * are limited to the most recently captured ones.
  */
 class WebPageThumbnailStore : public QObject, private DatabaseWorker
 {
     friend class BrowserApplication;
     friend class DatabaseFactory;
+    friend class WebPageThumbnailStoreTest;
 
     Q_OBJECT
 
 public:
+    /// Size of the thumbnails, in pixels
+    static const QSize ThumbnailSize;
+
     /// Constructs the thumbnail storage manager, given a reference to the service locator, the path to the database file and an optional parent object
     explicit WebPageThumbnailStore(const ViperServiceLocator &serviceLocator, const QString &databaseFile, QObject *parent = nullptr);
 
     /// Destructor
     ~WebPageThumbnailStore();
 
-    /// Attempts to find a thumbnail associated with the given URL, returning said thumbnail
-    /// as a QImage if found, or returning a null pixmap if it could not be found.
-    QImage getThumbnail(const QUrl &url);
+    /// Returns true if a thumbnail of the host of the given URL is available, false if else
+    bool hasThumbnail(const QUrl &url);
+
+    /// Returns the PNG encoded thumbnail of the given host, or an empty byte array if no thumbnail could be found
+    QByteArray getThumbnailData(const QString &host);
+
+    /// Returns the URL, in the viper scheme, from which the thumbnail of the given page's host can be loaded
+    static QUrl getThumbnailUrl(const QUrl &pageUrl);
+
+    /// Returns the host named by a thumbnail URL created by \ref getThumbnailUrl , or an empty string if
+    /// the given URL does not refer to a thumbnail
+    static QString getHostFromThumbnailUrl(const QUrl &thumbnailUrl);
+
+    /**
+     * @brief Scales a captured frame of a web page down to the thumbnail size and encodes it.
+     *        Safe to call from any thread
+     * @param frame Image of the visible area of the web page
+     * @return The PNG encoded thumbnail, or an empty byte array if the frame is empty or consists only of shades of gray
+     */
+    static QByteArray processThumbnail(const QImage &frame);
 
 public Q_SLOTS:
     /// Handles the loadFinished event which is emitted by a \ref WebWidget
@@ -57,13 +97,22 @@ public Q_SLOTS:
     /// Creates the table structure if it has not already been created
     void setup() override;
 
-    /// This would load thumbnails from the database into memory, but instead
-    /// the thumbnails are loaded as needed and so this does nothing
+    /// This would load thumbnails from the database into memory, but instead the thumbnails
+    /// are loaded as needed, and so this only converts data stored in an older format
     void load() override;
 
 private:
-    /// Callback registered during a call to save() - handles the query to fetch the most frequently
-    /// visited web pages
+    /// Returns the host that the given host shares its thumbnail with, or the given host if it has no alias
+    QString resolveAlias(const QString &host);
+
+    /// Called on the thread of the store when a thumbnail has been processed for the given hosts
+    void onThumbnailProcessed(const std::vector<QString> &hosts, const QByteArray &data);
+
+    /// Writes the thumbnails that are waiting in memory to the pending thumbnails table
+    void writePendingThumbnails();
+
+    /// Called on the thread of the thumbnail store once the most frequently visited web pages, requested
+    /// by save(), have been loaded from the history database
     void onMostVisitedPagesLoaded(std::vector<WebPageInformation> &&results);
 
     /// Saves thumbnails of web pages into the database
@@ -73,8 +122,18 @@ public Q_SLOTS:
     /// Identifier of the timer that is periodically invoked to call the save() method
     int m_timerId;
 
-    /// Hashmap of web hostnames to their corresponding thumbnails
-    QHash<QString, QImage> m_thumbnails;
+    /// Cache of PNG encoded thumbnails, by the host they were captured from
+    ShardedLRUCache<QString, QByteArray, ThumbnailDataCost> m_thumbnails;
+
+    /// Maps the host of a page that was reached through a redirect to the host of the page that redirected to it,
+    /// which is the host its thumbnail is stored under, so both hosts share one thumbnail in the cache
+    ShardedLRUCache<QString, QString> m_hostAliases;
+
+    /// Thumbnails that have not yet been written to the database, by host
+    QHash<QString, QByteArray> m_unwrittenThumbnails;
+
+    /// True if a call to writePendingThumbnails() has been scheduled, false if else
+    bool m_isWriteScheduled;
 
     /// Pointer to the \ref BookmarkManager
     BookmarkManager *m_bookmarkManager;
@@ -4,28 +4,66 @@
 #include "NetworkAccessManager.h"
 #include "URL.h"
 
+#include <algorithm>
 #include <functional>
-#include <stdexcept>
+#include <optional>
+#include <utility>
+#include <vector>
 
 #include <QBuffer>
 #include <QDebug>
 #include <QFileInfo>
+#include <QFutureWatcher>
+#include <QImage>
+#include <QMetaObject>
 #include <QNetworkRequest>
 #include <QNetworkReply>
 #include <QPainter>
 #include <QSvgRenderer>
+#include <QTimer>
 #include <QtConcurrent>
 
-FaviconManager::FaviconManager(const QString &databaseFile) :
+namespace
+{
+    /// Maximum total size, in bytes, of the encoded data of the icons held in the icon cache
+    constexpr std::size_t MaxIconCacheBytes = 4 * 1024 * 1024;
+
+    /// Delay, in milliseconds, between the first icon of a batch being queued and the batch being saved
+    constexpr int IconSaveDelay = 250;
+
+    /// Maximum number of pages whose icons are held in the icon cache. The icons themselves are shared with the
+    /// icon data cache, so this mostly bounds the number of page URLs
+    constexpr std::size_t MaxPageIconCacheEntries = 1024;
+}
+
+FaviconManager::FaviconManager(DatabaseTaskScheduler &taskScheduler) :
     QObject(nullptr),
+    m_taskScheduler(taskScheduler),
     m_faviconStore(nullptr),
     m_networkAccessManager(nullptr),
-    m_iconMap(),
-    m_iconCache(64),
-    m_mutex()
+    m_iconDataCache(MaxIconCacheBytes, 4),
+    m_iconCache(MaxPageIconCacheEntries),
+    m_pendingDownloads(),
+    m_pendingIcons(),
+    m_pendingUpdates(),
+    m_pendingLookups(),
+    m_lookupMutex(),
+    m_taskGuard(std::make_shared<TaskGuard>())
 {
     setObjectName(QLatin1String("FaviconManager"));
-    m_faviconStore = DatabaseFactory::createWorker<FaviconStore>(databaseFile);
+
+    std::shared_ptr<TaskGuard> guard = m_taskGuard;
+    m_taskScheduler.onInit([this, guard](){
+        std::lock_guard<std::mutex> _(guard->mutex);
+        if (guard->isAlive)
+            m_faviconStore = static_cast<FaviconStore*>(m_taskScheduler.getWorker("FaviconStore"));
+    });
+}
+
+FaviconManager::~FaviconManager()
+{
+    std::lock_guard<std::mutex> _(m_taskGuard->mutex);
+    m_taskGuard->isAlive = false;
 }
 
 void FaviconManager::setNetworkAccessManager(NetworkAccessManager *networkAccessManager)
@@ -35,106 +73,190 @@ void FaviconManager::setNetworkAccessManager(NetworkAccessManager *networkAccess
 
 QIcon FaviconManager::getFavicon(const QUrl &url)
 {
-    QString pageUrl = getUrlAsString(url);
-    if (!m_faviconStore || pageUrl.isEmpty())
+    const std::string cacheKey = getUrlAsString(url).toStdString();
+    if (cacheKey.empty())
         return QIcon(QLatin1String(":/blank_favicon.png"));
 
-    const std::string urlStdStr = pageUrl.toStdString();
-
     // Check for cache hit
-    try
-    {
-        if (m_iconCache.has(urlStdStr))
-        {
-            return m_iconCache.get(urlStdStr);
-        }
-    }
-    catch (std::out_of_range &err)
+    if (std::optional<QIcon> cachedIcon = m_iconCache.tryGet(cacheKey))
+        return *cachedIcon;
+
+    // The store is only read on the database thread, so the icon is announced by faviconLoaded once it is available
+    loadFavicons({ url });
+    return QIcon(QLatin1String(":/blank_favicon.png"));
+}
+
+QIcon FaviconManager::getCachedFavicon(const QUrl &url)
+{
+    const std::string cacheKey = getUrlAsString(url).toStdString();
+    if (!cacheKey.empty())
     {
-        qDebug() << "FaviconManager::getFavicon - caught error while fetching icon from cache. Error: " << err.what();
+        if (std::optional<QIcon> cachedIcon = m_iconCache.tryGet(cacheKey))
+            return *cachedIcon;
     }
 
-    int iconId = m_faviconStore->getFaviconId(url);
-    if (iconId < 0)
-        return QIcon(QLatin1String(":/blank_favicon.png"));
+    return QIcon(QLatin1String(":/blank_favicon.png"));
+}
 
-    auto it = m_iconMap.find(iconId);
-    if (it == m_iconMap.end())
+void FaviconManager::loadFavicons(const std::vector<QUrl> &urls)
+{
+    std::vector<std::pair<QUrl, std::string>> lookups;
     {
-        auto &record = m_faviconStore->getDataRecord(iconId);
-        if (record.iconData.isEmpty())
-            return QIcon(QLatin1String(":/blank_favicon.png"));
-
-        QIcon icon = CommonUtil::iconFromBase64(record.iconData);
-        auto result = m_iconMap.emplace(std::make_pair(iconId, icon));
-        if (result.second)
-            it = result.first;
-        else
-            return icon;
+        std::lock_guard<std::mutex> _(m_lookupMutex);
+        for (const QUrl &url : urls)
+        {
+            std::string cacheKey = getUrlAsString(url).toStdString();
+            if (cacheKey.empty() || m_iconCache.contains(cacheKey) || !m_pendingLookups.insert(cacheKey).second)
+                continue;
+
+            lookups.push_back(std::make_pair(url, std::move(cacheKey)));
+        }
     }
 
-    try
+    if (lookups.empty())
+        return;
+
+    postStoreTask([this, lookups](){
+        std::vector<LoadedFavicon> results;
+        results.reserve(lookups.size());
+        for (const auto &lookup : lookups)
+        {
+            LoadedFavicon result { lookup.first, lookup.second, -1, std::vector<QImage>(), 0 };
+            if (m_faviconStore)
+                result.iconId = m_faviconStore->getFaviconId(lookup.first);
+
+            // Icons are decoded into images here, as only the pixmaps of the QIcon need the GUI thread
+            if (result.iconId >= 0 && !m_iconDataCache.contains(result.iconId))
+            {
+                const QByteArray iconData = m_faviconStore->getIconData(result.iconId);
+                result.images = CommonUtil::imagesFromBytes(iconData);
+                result.dataSize = iconData.size();
+                if (result.images.empty())
+                    result.iconId = -1;
+            }
+
+            results.push_back(std::move(result));
+        }
+
+        QMetaObject::invokeMethod(this, [this, results](){
+            onFaviconsLoaded(results);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void FaviconManager::onFaviconsLoaded(const std::vector<LoadedFavicon> &results)
+{
     {
-        std::lock_guard<std::mutex> _(m_mutex);
-        m_iconCache.put(urlStdStr, it->second);
+        std::lock_guard<std::mutex> _(m_lookupMutex);
+        for (const LoadedFavicon &result : results)
+            m_pendingLookups.erase(result.cacheKey);
     }
-    catch (std::out_of_range &err)
+
+    for (const LoadedFavicon &result : results)
     {
-        qDebug() << "FaviconManager::getFavicon - caught error while updating icon cache. Error: " << err.what();
-    }
+        // Pages without an icon are looked up again the next time they are requested, as their icon may still be downloading
+        if (result.iconId < 0)
+            continue;
+
+        QIcon icon;
+        if (std::optional<QIcon> cachedIcon = m_iconDataCache.tryGet(result.iconId))
+            icon = *cachedIcon;
+        else if (!result.images.empty())
+        {
+            icon = CommonUtil::iconFromImages(result.images);
+            cacheIcon(result.iconId, icon, result.dataSize);
+        }
+
+        if (icon.isNull())
+            continue;
 
-    return it->second;
+        m_iconCache.put(result.cacheKey, icon);
+        emit faviconLoaded(result.pageUrl, icon);
+    }
 }
 
 void FaviconManager::updateIcon(const QUrl &iconUrl, const QUrl &pageUrl, const QIcon &pageIcon)
 {
-    if (!m_faviconStore
-            || iconUrl.isEmpty()
+    if (iconUrl.isEmpty()
             || iconUrl.scheme().startsWith(QLatin1String("data")))
         return;
 
-    const QString pageUrlStr = getUrlAsString(pageUrl);
-    const std::string urlStdStr = pageUrlStr.toStdString();
+    // Only the pixmaps of the icon need this thread, the images are encoded when they are saved
+    PageIconUpdate update { iconUrl, pageUrl, CommonUtil::iconToImages(pageIcon), pageIcon };
 
-    QByteArray pageIconData = CommonUtil::iconToBase64(pageIcon);
+    if (!update.images.empty())
+        m_iconCache.put(getUrlAsString(pageUrl).toStdString(), pageIcon);
 
-    if (!pageIconData.isEmpty() && m_iconCache.has(urlStdStr))
-    {
-        try
-        {
-            std::lock_guard<std::mutex> _(m_mutex);
-            m_iconCache.put(urlStdStr, pageIcon);
-        }
-        catch (std::out_of_range &err)
+    // Icons are saved in batches, as pages report their icon on every load
+    const bool isFlushScheduled = !m_pendingUpdates.empty();
+    m_pendingUpdates.push_back(std::move(update));
+
+    if (!isFlushScheduled)
+        QTimer::singleShot(IconSaveDelay, this, &FaviconManager::flushPendingUpdates);
+}
+
+void FaviconManager::flushPendingUpdates()
+{
+    if (m_pendingUpdates.empty())
+        return;
+
+    std::vector<PageIconUpdate> pendingUpdates;
+    pendingUpdates.swap(m_pendingUpdates);
+
+    // Records are written on the database thread
+    postStoreTask([this, pendingUpdates](){
+        if (!m_faviconStore)
+            return;
+
+        std::vector<std::pair<QUrl, QUrl>> pageIcons;
+        pageIcons.reserve(pendingUpdates.size());
+        for (const PageIconUpdate &update : pendingUpdates)
+            pageIcons.push_back(std::make_pair(update.pageUrl, update.iconUrl));
+
+        // add page url -> icon mappings to favicon store
+        const std::vector<int> iconIds = m_faviconStore->addPageMappings(pageIcons);
+
+        std::vector<std::pair<QUrl, QByteArray>> icons;
+        std::vector<std::pair<std::size_t, int>> cachedIcons;
+        std::vector<QUrl> missingIcons;
+        for (std::size_t i = 0; i < pendingUpdates.size() && i < iconIds.size(); ++i)
         {
-            qDebug() << "FaviconManager::updateIcon - caught error while updating icon cache. Error: " << err.what();
+            const PageIconUpdate &update = pendingUpdates.at(i);
+            if (update.images.empty())
+            {
+                if (m_faviconStore->getIconData(iconIds.at(i)).isEmpty())
+                    missingIcons.push_back(update.iconUrl);
+                continue;
+            }
+
+            QByteArray iconData = CommonUtil::imagesToBytes(update.images);
+            if (iconData.isEmpty())
+                continue;
+
+            cachedIcons.push_back(std::make_pair(i, iconData.size()));
+            icons.push_back(std::make_pair(update.iconUrl, std::move(iconData)));
         }
-    }
-
-    const int iconId = m_faviconStore->getFaviconIdForIconUrl(iconUrl);
-    FaviconData &dataRecord = m_faviconStore->getDataRecord(iconId);
-    if (dataRecord.iconData.isEmpty() || !pageIconData.isEmpty())
-        dataRecord.iconData = pageIconData;
 
-    // add page url -> icon mapping to favicon store
-    m_faviconStore->addPageMapping(pageUrl, iconId);
+        const std::vector<int> savedIconIds = m_faviconStore->saveIcons(icons);
+        for (std::size_t i = 0; i < savedIconIds.size(); ++i)
+            cacheIcon(savedIconIds.at(i), pendingUpdates.at(cachedIcons.at(i).first).icon, cachedIcons.at(i).second);
 
-    if (!dataRecord.iconData.isEmpty())
-    {
-        m_faviconStore->saveDataRecord(dataRecord);
+        if (missingIcons.empty())
+            return;
 
-        QIcon icon = CommonUtil::iconFromBase64(dataRecord.iconData);
-        auto it = m_iconMap.find(iconId);
-        if (it != m_iconMap.end())
-            it->second = icon;
-        else
-            m_iconMap.emplace(std::make_pair(iconId, icon));
+        QMetaObject::invokeMethod(this, [this, missingIcons](){
+            for (const QUrl &iconUrl : missingIcons)
+                downloadIcon(iconUrl);
+        }, Qt::QueuedConnection);
+    });
+}
 
+void FaviconManager::downloadIcon(const QUrl &iconUrl)
+{
+    if (!m_networkAccessManager || m_pendingDownloads.contains(iconUrl))
         return;
-    }
 
-    if (!m_networkAccessManager)
-        return;
+    m_pendingDownloads.insert(iconUrl);
 
     QNetworkRequest request(iconUrl);
     QNetworkReply *reply = m_networkAccessManager->get(request);
@@ -148,16 +270,38 @@ void FaviconManager::updateIcon(const QUrl &iconUrl, const QUrl &pageUrl, const
     }
 }
 
+void FaviconManager::cacheIcon(int iconId, const QIcon &icon, int dataSize)
+{
+    m_iconDataCache.put(iconId, icon, static_cast<std::size_t>(std::max(dataSize, 1)));
+}
+
 void FaviconManager::onReplyFinished(QNetworkReply *reply)
 {
+    // The request may have been redirected, so use the URL that was originally requested
+    const QUrl iconUrl = reply->request().url();
     QString format = QFileInfo(getUrlAsString(reply->url())).suffix();
     QByteArray data = reply->readAll();
-    if (data.isNull())
+    reply->deleteLater();
+
+    if (data.isEmpty())
     {
-        reply->deleteLater();
+        m_pendingDownloads.remove(iconUrl);
         return;
     }
 
+    QFutureWatcher<DecodedFavicon> *watcher = new QFutureWatcher<DecodedFavicon>(this);
+    connect(watcher, &QFutureWatcher<DecodedFavicon>::finished, this, [this, watcher](){
+        onIconDecoded(watcher->future().result());
+        watcher->deleteLater();
+    });
+    watcher->setFuture(QtConcurrent::run(&FaviconManager::decodeIcon, iconUrl, data, format));
+}
+
+DecodedFavicon FaviconManager::decodeIcon(const QUrl &iconUrl, QByteArray data, QString format)
+{
+    DecodedFavicon result;
+    result.iconUrl = iconUrl;
+
     QImage img;
     bool success = false;
 
@@ -173,8 +317,10 @@ void FaviconManager::onReplyFinished(QNetworkReply *reply)
     {
         QSvgRenderer svgRenderer(data);
         img = QImage(32, 32, QImage::Format_ARGB32);
+        img.fill(Qt::transparent);
         QPainter painter(&img);
         svgRenderer.render(&painter);
+        painter.end();
         success = !img.isNull();
     }
     // Default handler
@@ -185,25 +331,72 @@ void FaviconManager::onReplyFinished(QNetworkReply *reply)
         success = img.load(&buffer, imageFormat.c_str());
     }
 
-    if (success)
+    if (!success)
     {
-        QIcon icon(QPixmap::fromImage(img));
-        const int iconId = m_faviconStore->getFaviconIdForIconUrl(reply->url());
-        FaviconData &record = m_faviconStore->getDataRecord(iconId);
-        record.iconData = CommonUtil::iconToBase64(icon);
-
-        m_faviconStore->saveDataRecord(record);
-
-        auto it = m_iconMap.find(iconId);
-        if (it != m_iconMap.end())
-            it->second = icon;
-        else
-            m_iconMap.emplace(std::make_pair(iconId, icon));
+        qDebug() << "FaviconManager::decodeIcon - failed to load image from response. Format was " << format;
+        return result;
     }
-    else
-        qDebug() << "FaviconManager::onReplyFinished - failed to load image from response. Format was " << format;
 
-    reply->deleteLater();
+    // Keep large icons at a typical favicon resolution
+    if (img.width() > 64 || img.height() > 64)
+        img = img.scaled(32, 32, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+    result.iconData = CommonUtil::imagesToBytes({ img });
+    result.image = std::move(img);
+    return result;
+}
+
+void FaviconManager::onIconDecoded(const DecodedFavicon &result)
+{
+    m_pendingDownloads.remove(result.iconUrl);
+
+    if (result.image.isNull() || result.iconData.isEmpty())
+        return;
+
+    // Pixmaps may only be created on the GUI thread
+    QIcon icon(QPixmap::fromImage(result.image));
+
+    // Icons are saved in batches, as a page may reference several at once
+    const bool isFlushScheduled = !m_pendingIcons.empty();
+    m_pendingIcons.push_back(std::make_pair(result, icon));
+
+    if (!isFlushScheduled)
+        QTimer::singleShot(IconSaveDelay, this, &FaviconManager::flushPendingIcons);
+}
+
+void FaviconManager::flushPendingIcons()
+{
+    if (m_pendingIcons.empty())
+        return;
+
+    std::vector<std::pair<DecodedFavicon, QIcon>> pendingIcons;
+    pendingIcons.swap(m_pendingIcons);
+
+    postStoreTask([this, pendingIcons](){
+        if (!m_faviconStore)
+            return;
+
+        std::vector<std::pair<QUrl, QByteArray>> icons;
+        icons.reserve(pendingIcons.size());
+        for (const auto &pendingIcon : pendingIcons)
+            icons.push_back(std::make_pair(pendingIcon.first.iconUrl, pendingIcon.first.iconData));
+
+        const std::vector<int> iconIds = m_faviconStore->saveIcons(icons);
+        for (size_t i = 0; i < iconIds.size(); ++i)
+            cacheIcon(iconIds.at(i), pendingIcons.at(i).second, pendingIcons.at(i).first.iconData.size());
+    });
+}
+
+void FaviconManager::postStoreTask(std::function<void()> &&task)
+{
+    // While a task holds the lock, the manager cannot be destroyed. Events that a task posts to the manager are
+    // discarded by Qt if the manager is destroyed before they are delivered, so they may safely refer to it
+    std::shared_ptr<TaskGuard> guard = m_taskGuard;
+    m_taskScheduler.post([guard, task = std::move(task)](){
+        std::lock_guard<std::mutex> _(guard->mutex);
+        if (guard->isAlive)
+            task();
+    });
 }
 
 QString FaviconManager::getUrlAsString(const QUrl &url) const
@@ -5,15 +5,21 @@
 #include "DatabaseWorker.h"
 #include "FaviconStore.h"
 #include "FaviconTypes.h"
-#include "LRUCache.h"
+#include "ShardedLRUCache.h"
 
-#include <unordered_map>
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include <QHash>
 #include <QIcon>
+#include <QImage>
 #include <QObject>
+#include <QSet>
 #include <QString>
 #include <QUrl>
 
@@ -30,48 +36,144 @@ class FaviconManager : public QObject
     Q_OBJECT
 
 public:
-    /// Constructs the favicon manager
-    explicit FaviconManager(const QString &databaseFile);
+    /// Constructs the favicon manager, given a reference to the task scheduler that runs the \ref FaviconStore
+    explicit FaviconManager(DatabaseTaskScheduler &taskScheduler);
+
+    /// Waits for a database task of the favicon manager that is running, and keeps any queued task from running
+    ~FaviconManager();
 
     /// Passes the instance of the network access manager, so the favicon manager can download
     /// new icons as they are referenced by a web page.
     void setNetworkAccessManager(NetworkAccessManager *networkAccessManager);
 
-    /// Searches for a favicon associated with the given URL, returning either the favicon
-    /// or an empty favicon if it could not be found
+    /// Returns the favicon associated with the given URL if it is in the icon cache. Otherwise returns a blank
+    /// favicon, and looks up the icon on the database thread, emitting \ref faviconLoaded if it is found.
+    /// May be called from any thread
     QIcon getFavicon(const QUrl &url);
 
+    /// Returns the favicon associated with the given URL if it is in the icon cache, or a blank favicon otherwise,
+    /// without looking up the icon. May be called from any thread
+    QIcon getCachedFavicon(const QUrl &url);
+
+    /// Looks up the icons of the given pages that are not in the icon cache, with a single task on the database thread,
+    /// emitting \ref faviconLoaded for each icon that is found. Used by components that show lists of pages. May be
+    /// called from any thread
+    void loadFavicons(const std::vector<QUrl> &urls);
+
     /**
-     * @brief Attempts to update favicon for a specific URL in the database.
+     * @brief Queues an update of the favicon of a specific URL in the database. Updates are saved in batches,
+     *        with the icon data being encoded on the database thread.
      * @param iconUrl The location in which the favicon is stored.
      * @param pageUrl The URL of the page displaying the favicon.
      * @param pageIcon The favicon on the page.
      */
     void updateIcon(const QUrl &iconUrl, const QUrl &pageUrl, const QIcon &pageIcon);
 
+Q_SIGNALS:
+    /// Emitted when the icon of a page, for which \ref getFavicon returned a blank favicon, has been loaded from
+    /// the database. Applies to every URL that matches the given URL apart from its user info, query and fragment
+    void faviconLoaded(const QUrl &pageUrl, const QIcon &icon);
+
 private Q_SLOTS:
     /// Called after the request for a favicon has been completed
     void onReplyFinished(QNetworkReply *reply);
 
 private:
+    /// Icon of a page, as looked up on the database thread
+    struct LoadedFavicon
+    {
+        /// URL of the page
+        QUrl pageUrl;
+
+        /// Key of the page in the icon cache
+        std::string cacheKey;
+
+        /// Identifier of the icon, or -1 if the page has no stored icon
+        int iconId;
+
+        /// Images of the icon, unless the icon was already in the icon data cache
+        std::vector<QImage> images;
+
+        /// Size of the encoded data of the icon
+        int dataSize;
+    };
+
+    /// Shared by the favicon manager and the tasks it posts to the database thread, so that a task never runs
+    /// after the manager has been destroyed
+    struct TaskGuard
+    {
+        /// Held by a task while it runs, and by the destructor of the manager
+        std::mutex mutex;
+
+        /// Set to false when the manager is destroyed
+        bool isAlive { true };
+    };
+
+    /// Posts the given task to the database thread. The task only runs if the manager still exists, and the manager
+    /// is not destroyed while the task is running
+    void postStoreTask(std::function<void()> &&task);
+
+    /// Places the icons that were looked up on the database thread into the icon cache, and announces them with
+    /// \ref faviconLoaded . Called on the thread of the favicon manager
+    void onFaviconsLoaded(const std::vector<LoadedFavicon> &results);
+
+    /// Requests the icon at the given URL, unless a request for the same icon is already in progress
+    void downloadIcon(const QUrl &iconUrl);
+
+    /// Decodes the data of a downloaded icon, which may be compressed or in SVG form. This runs on the
+    /// global thread pool, and so only deals with QImage and never with QPixmap
+    static DecodedFavicon decodeIcon(const QUrl &iconUrl, QByteArray data, QString format);
+
+    /// Converts a decoded icon into a QIcon and queues it to be saved. Called on the thread of the favicon manager
+    void onIconDecoded(const DecodedFavicon &result);
+
+    /// Saves all icons that were queued by \ref onIconDecoded on the database thread
+    void flushPendingIcons();
+
+    /// Encodes and saves all icons that were queued by \ref updateIcon on the database thread, in one batch. Icons
+    /// that were referenced without their data, and that are not stored yet, are then downloaded
+    void flushPendingUpdates();
+
+    /// Places the icon with the given identifier into the icon cache, with a cost of the size of its encoded data
+    void cacheIcon(int iconId, const QIcon &icon, int dataSize);
+
     /// Returns the given URL in string form
     QString getUrlAsString(const QUrl &url) const;
 
 private:
-    /// Favicon data store
-    std::unique_ptr<FaviconStore> m_faviconStore;
+    /// Reference to the task scheduler, which runs the favicon store on the database thread
+    DatabaseTaskScheduler &m_taskScheduler;
+
+    /// Favicon data store. Only accessed from the database thread
+    FaviconStore *m_faviconStore;
 
     /// Used to download icons when a new one is referenced
     NetworkAccessManager *m_networkAccessManager;
 
-    /// Mapping of favicon IDs (as stored in \ref FaviconStore ) to their corresponding QIcons
-    std::unordered_map<int, QIcon> m_iconMap;
+    /// Cache of decoded icons, by their favicon ID (as stored in \ref FaviconStore ), limited by the
+    /// total size of their encoded data
+    ShardedLRUCache<int, QIcon> m_iconDataCache;
 
     /// Cache of most recently visited URLs and the icons associated with those pages
-    LRUCache<std::string, QIcon> m_iconCache;
+    ShardedLRUCache<std::string, QIcon> m_iconCache;
+
+    /// URLs of icons that are either being downloaded or decoded
+    QSet<QUrl> m_pendingDownloads;
+
+    /// Decoded icons waiting to be saved, paired with their QIcon form
+    std::vector<std::pair<DecodedFavicon, QIcon>> m_pendingIcons;
+
+    /// Icons reported by web pages, waiting to be saved
+    std::vector<PageIconUpdate> m_pendingUpdates;
+
+    /// Cache keys of the pages whose icon is being looked up on the database thread
+    std::unordered_set<std::string> m_pendingLookups;
+
+    /// Guards the set of pending lookups, as \ref getFavicon may be called from any thread
+    std::mutex m_lookupMutex;
 
-    /// Used when updating the LRU cache for thread safety
-    mutable std::mutex m_mutex;
+    /// Guards the tasks posted to the database thread against the destruction of the manager
+    std::shared_ptr<TaskGuard> m_taskGuard;
 };
 
 #endif // FAVICONMANAGER_H
@@ -1,15 +1,35 @@
-#include "CommonUtil.h"
 #include "FaviconStore.h"
 #include "URL.h"
 
-#include <array>
+#include <utility>
+#include <vector>
+
 #include <QDebug>
 
+namespace
+{
+    /// Returns the lower-case host of the given URL, without any "www." prefix
+    QString getNormalizedHost(const QUrl &url)
+    {
+        QString host = url.host().toLower();
+        if (host.startsWith(QLatin1String("www.")))
+            host.remove(0, 4);
+        return host;
+    }
+
+    /// Schema version of the FaviconData table at which icon data is stored as raw bytes, rather than base64 text
+    constexpr int RawIconDataVersion = 1;
+
+    /// Returns the lower-case registrable domain (eTLD+1) of the given URL
+    QString getRegistrableDomain(const QUrl &url)
+    {
+        return URL(url).getSecondLevelDomain().toLower();
+    }
+}
+
 FaviconStore::FaviconStore(const QString &databaseFile) :
     DatabaseWorker(databaseFile),
-    m_originMap(),
-    m_iconDataMap(),
-    m_webPageMap(),
+    m_iconUrlIndex(),
     m_newFaviconID(1),
     m_newDataID(1),
     m_queryMap()
@@ -25,27 +45,38 @@ int FaviconStore::getFaviconId(const QUrl &url)
     if (url.isEmpty())
         return -1;
 
-    auto it = m_webPageMap.find(url);
-    if (it != m_webPageMap.end())
-        return *it;
-
-    auto iconQuery = m_database.prepare(R"(SELECT FaviconID FROM FaviconMap WHERE PageURL LIKE ?)");
+    sqlite::PreparedStatement &exactQuery = m_queryMap.at(StoredQuery::FindIconExactURL);
+    exactQuery.reset();
+    exactQuery << url;
+    if (exactQuery.next())
+    {
+        int iconId = 0;
+        exactQuery >> iconId;
+        exactQuery.reset();
+        return iconId;
+    }
 
-    QString searchTemplate("%%1%");
-    std::array<QString, 2> searchTerms = { searchTemplate.arg(url.host()),
-                                           searchTemplate.arg(URL(url).getSecondLevelDomain()) };
-    for (size_t i = 0; i < searchTerms.size(); ++i)
+    // Fall back to any page on the same host, and then to any page on the same registrable domain
+    const std::pair<StoredQuery, QString> fallbacks[] = {
+        { StoredQuery::FindIconByHost, getNormalizedHost(url) },
+        { StoredQuery::FindIconByDomain, getRegistrableDomain(url) }
+    };
+    for (const auto &fallback : fallbacks)
     {
-        iconQuery << searchTerms.at(i);
+        if (fallback.second.isEmpty())
+            continue;
+
+        sqlite::PreparedStatement &iconQuery = m_queryMap.at(fallback.first);
+        iconQuery.reset();
+        iconQuery << fallback.second;
 
         if (iconQuery.next())
         {
             int iconId = 0;
             iconQuery >> iconId;
+            iconQuery.reset();
             return iconId;
         }
-
-        iconQuery.reset();
     }
 
     return -1;
@@ -53,22 +84,11 @@ int FaviconStore::getFaviconId(const QUrl &url)
 
 int FaviconStore::getFaviconIdForIconUrl(const QUrl &url)
 {
-    for (const auto &it : m_originMap)
-    {
-        if (CommonUtil::doUrlsMatch(url, it.second, true))
-            return it.first;
-        if (url.matches(it.second, QUrl::RemoveScheme | QUrl::RemoveQuery | QUrl::RemoveFragment))
-            return it.first;
-    }
+    const QString key = getIconUrlKey(url);
 
-    auto idQuery = m_database.prepare(R"(SELECT FaviconID FROM Favicons WHERE URL = ?)");
-    idQuery << url;
-    if (idQuery.next())
-    {
-        int iconId = 0;
-        idQuery >> iconId;
-        return iconId;
-    }
+    auto it = m_iconUrlIndex.find(key);
+    if (it != m_iconUrlIndex.end())
+        return it.value();
 
     int id = m_newFaviconID++;
     sqlite::PreparedStatement &insertStmt = m_queryMap.at(StoredQuery::InsertFavicon);
@@ -79,68 +99,115 @@ int FaviconStore::getFaviconIdForIconUrl(const QUrl &url)
     if (!insertStmt.execute())
         qWarning() << "In FaviconStore::getFaviconIdForIconUrl - could not add favicon metadata to Favicons table.";
 
+    m_iconUrlIndex.insert(key, id);
     return id;
 }
 
-QByteArray FaviconStore::getIconData(int faviconId) const
+QByteArray FaviconStore::getIconData(int faviconId)
 {
-    auto it = m_iconDataMap.find(faviconId);
-    if (it != m_iconDataMap.end())
-        return it->second.iconData;
+    QByteArray result;
 
-    return QByteArray();
+    sqlite::PreparedStatement &stmt = m_queryMap.at(StoredQuery::FindIconData);
+    stmt.reset();
+    stmt << faviconId;
+    if (stmt.next())
+    {
+        int dataId = 0;
+        stmt >> dataId
+             >> result;
+        stmt.reset();
+    }
+
+    return result;
 }
 
-FaviconData &FaviconStore::getDataRecord(int faviconId)
+void FaviconStore::saveIconData(int faviconId, const QByteArray &iconData)
 {
-    auto it = m_iconDataMap.find(faviconId);
-    if (it != m_iconDataMap.end())
-        return it->second;
+    sqlite::PreparedStatement &findStmt = m_queryMap.at(StoredQuery::FindIconData);
+    findStmt.reset();
+    findStmt << faviconId;
 
-    FaviconData iconData;
-    iconData.faviconId = faviconId;
-    iconData.id = m_newDataID++;
+    if (findStmt.next())
+    {
+        FaviconData dataRecord;
+        findStmt >> dataRecord.id;
+        findStmt.reset();
+
+        sqlite::PreparedStatement &updateStmt = m_queryMap.at(StoredQuery::UpdateIconData);
+        updateStmt.reset();
+        updateStmt << iconData
+                   << dataRecord.id;
+        if (!updateStmt.execute())
+            qWarning() << "In FaviconStore::saveIconData - could not update favicon data.";
+
+        return;
+    }
 
-    sqlite::PreparedStatement &stmt = m_queryMap.at(StoredQuery::InsertIconData);
-    stmt.reset();
-    stmt << iconData;
-    if (!stmt.execute())
-        qWarning() << "In FaviconStore::getDataRecord - could not add favicon icon data to FaviconData table";
+    FaviconData dataRecord;
+    dataRecord.id = m_newDataID++;
+    dataRecord.faviconId = faviconId;
+    dataRecord.iconData = iconData;
 
-    auto result = m_iconDataMap.emplace(std::make_pair(faviconId, iconData));
-    return result.first->second;
+    sqlite::PreparedStatement &insertStmt = m_queryMap.at(StoredQuery::InsertIconData);
+    insertStmt.reset();
+    insertStmt << dataRecord;
+    if (!insertStmt.execute())
+        qWarning() << "In FaviconStore::saveIconData - could not add favicon icon data to FaviconData table";
 }
 
-void FaviconStore::saveDataRecord(FaviconData &dataRecord)
+std::vector<int> FaviconStore::saveIcons(const std::vector<std::pair<QUrl, QByteArray>> &icons)
 {
-    auto stmt = m_database.prepare(R"(UPDATE FaviconData SET Data = ? WHERE DataID = ?)");
-    stmt << dataRecord.iconData
-         << dataRecord.id;
-    if (!stmt.execute())
-        qWarning() << "In FaviconStore::saveDataRecord - could not update favicon data.";
-}
+    std::vector<int> result;
+    result.reserve(icons.size());
 
-void FaviconStore::addPageMapping(const QUrl &webPageUrl, int faviconId)
-{
-    auto it = m_webPageMap.find(webPageUrl);
-    if (it != m_webPageMap.end())
-    {
-        if (it.value() == faviconId)
-            return;
+    const bool inTransaction = m_database.beginTransaction();
 
-        *it = faviconId;
+    for (const auto &icon : icons)
+    {
+        const int iconId = getFaviconIdForIconUrl(icon.first);
+        saveIconData(iconId, icon.second);
+        result.push_back(iconId);
     }
-    else
-        m_webPageMap.insert(webPageUrl, faviconId);
 
-    auto stmt = m_database.prepare(R"(INSERT OR REPLACE INTO FaviconMap(PageURL, FaviconID) VALUES (?, ?))");
+    if (inTransaction && !m_database.commitTransaction())
+        qWarning() << "In FaviconStore::saveIcons - unable to commit icon data";
+
+    return result;
+}
+
+void FaviconStore::addPageMapping(const QUrl &webPageUrl, int faviconId)
+{
+    sqlite::PreparedStatement &stmt = m_queryMap.at(StoredQuery::InsertPageMapping);
+    stmt.reset();
     stmt << webPageUrl
+         << getNormalizedHost(webPageUrl)
+         << getRegistrableDomain(webPageUrl)
          << faviconId;
 
     if (!stmt.execute())
         qDebug() << "In FaviconStore::addPageMapping - could not update webpage mapping.";
 }
 
+std::vector<int> FaviconStore::addPageMappings(const std::vector<std::pair<QUrl, QUrl>> &pageIcons)
+{
+    std::vector<int> result;
+    result.reserve(pageIcons.size());
+
+    const bool inTransaction = m_database.beginTransaction();
+
+    for (const auto &pageIcon : pageIcons)
+    {
+        const int iconId = getFaviconIdForIconUrl(pageIcon.second);
+        addPageMapping(pageIcon.first, iconId);
+        result.push_back(iconId);
+    }
+
+    if (inTransaction && !m_database.commitTransaction())
+        qWarning() << "In FaviconStore::addPageMappings - unable to commit page mappings";
+
+    return result;
+}
+
 void FaviconStore::setupQueries()
 {
     m_queryMap.clear();
@@ -151,12 +218,35 @@ void FaviconStore::setupQueries()
     m_queryMap.insert(
                 std::make_pair(StoredQuery::InsertIconData,
                                m_database.prepare(R"(INSERT OR REPLACE INTO FaviconData(DataID, FaviconID, Data) VALUES (?, ?, ?))")));
+    m_queryMap.insert(
+                std::make_pair(StoredQuery::UpdateIconData,
+                               m_database.prepare(R"(UPDATE FaviconData SET Data = ? WHERE DataID = ?)")));
+    m_queryMap.insert(
+                std::make_pair(StoredQuery::FindIconData,
+                               m_database.prepare(R"(SELECT DataID, Data FROM FaviconData WHERE FaviconID = ? LIMIT 1)")));
     m_queryMap.insert(
                 std::make_pair(StoredQuery::FindIconExactURL,
-                               m_database.prepare(R"(SELECT URL FROM Favicons WHERE FaviconID = (SELECT m.FaviconID FROM FaviconMap m WHERE m.PageURL = ?))")));
+                               m_database.prepare(R"(SELECT FaviconID FROM FaviconMap WHERE PageURL = ?)")));
+    m_queryMap.insert(
+                std::make_pair(StoredQuery::FindIconByHost,
+                               m_database.prepare(R"(SELECT FaviconID FROM FaviconMap INDEXED BY favicon_map_host WHERE Host = ? ORDER BY MapID DESC LIMIT 1)")));
     m_queryMap.insert(
-                std::make_pair(StoredQuery::FindIconLikeURL,
-                               m_database.prepare(R"(SELECT URL FROM Favicons WHERE FaviconID IN (SELECT m.FaviconID FROM FaviconMap m WHERE m.PageURL LIKE ?))")));
+                std::make_pair(StoredQuery::FindIconByDomain,
+                               m_database.prepare(R"(SELECT FaviconID FROM FaviconMap INDEXED BY favicon_map_etld1 WHERE ETLD1 = ? ORDER BY MapID DESC LIMIT 1)")));
+    m_queryMap.insert(
+                std::make_pair(StoredQuery::InsertPageMapping,
+                               m_database.prepare(R"(INSERT OR REPLACE INTO FaviconMap(PageURL, Host, ETLD1, FaviconID) VALUES (?, ?, ?, ?))")));
+}
+
+QString FaviconStore::getIconUrlKey(const QUrl &url) const
+{
+    QString key = url.toString(QUrl::RemoveScheme | QUrl::RemoveUserInfo | QUrl::RemoveQuery
+                               | QUrl::RemoveFragment | QUrl::StripTrailingSlash).toLower();
+    if (key.startsWith(QLatin1String("//")))
+        key.remove(0, 2);
+    if (key.startsWith(QLatin1String("www.")))
+        key.remove(0, 4);
+    return key;
 }
 
 bool FaviconStore::hasProperStructure()
@@ -172,8 +262,105 @@ void FaviconStore::setup()
     exec(QLatin1String("CREATE TABLE IF NOT EXISTS Favicons(FaviconID INTEGER PRIMARY KEY, URL TEXT UNIQUE)"));
     exec(QLatin1String("CREATE TABLE IF NOT EXISTS FaviconData(DataID INTEGER PRIMARY KEY, FaviconID INTEGER NOT NULL, Data BLOB, "
                "FOREIGN KEY(FaviconID) REFERENCES Favicons(FaviconID))"));
-    exec(QLatin1String("CREATE TABLE IF NOT EXISTS FaviconMap(MapID INTEGER PRIMARY KEY, PageURL TEXT UNIQUE, FaviconID INTEGER NOT NULL, "
-               "FOREIGN KEY(FaviconID) REFERENCES Favicons(FaviconID))"));
+    exec(QLatin1String("CREATE TABLE IF NOT EXISTS FaviconMap(MapID INTEGER PRIMARY KEY, PageURL TEXT UNIQUE, Host TEXT, ETLD1 TEXT, "
+               "FaviconID INTEGER NOT NULL, FOREIGN KEY(FaviconID) REFERENCES Favicons(FaviconID))"));
+}
+
+void FaviconStore::checkForUpdate()
+{
+    // Check if the page mapping table has the normalized host and domain columns
+    auto stmt = m_database.prepare(R"(PRAGMA table_info(FaviconMap))");
+
+    bool hasHostColumn = false;
+    const QString hostColumn("Host");
+
+    while (stmt.next())
+    {
+        int cid = 0;
+        QString colName;
+
+        stmt >> cid
+             >> colName;
+
+        if (colName.compare(hostColumn) == 0)
+        {
+            hasHostColumn = true;
+            break;
+        }
+    }
+
+    if (hasHostColumn)
+        return;
+
+    if (!exec(QLatin1String("ALTER TABLE FaviconMap ADD Host TEXT"))
+            || !exec(QLatin1String("ALTER TABLE FaviconMap ADD ETLD1 TEXT")))
+    {
+        qWarning() << "In FaviconStore::checkForUpdate - unable to add host columns to page mapping table";
+        return;
+    }
+
+    // Populate the new columns of existing page mappings
+    std::vector<std::pair<int, QUrl>> mappings;
+    auto query = m_database.prepare(R"(SELECT MapID, PageURL FROM FaviconMap)");
+    while (query.next())
+    {
+        int mapId = 0;
+        QUrl pageUrl;
+        query >> mapId
+              >> pageUrl;
+        mappings.push_back(std::make_pair(mapId, pageUrl));
+    }
+
+    if (!m_database.beginTransaction())
+        return;
+
+    auto updateStmt = m_database.prepare(R"(UPDATE FaviconMap SET Host = ?, ETLD1 = ? WHERE MapID = ?)");
+    for (const auto &mapping : mappings)
+    {
+        updateStmt.reset();
+        updateStmt << getNormalizedHost(mapping.second)
+                   << getRegistrableDomain(mapping.second)
+                   << mapping.first;
+        if (!updateStmt.execute())
+        {
+            qWarning() << "In FaviconStore::checkForUpdate - unable to update page mapping. Message: "
+                       << QString::fromStdString(m_database.getLastError());
+            m_database.rollbackTransaction();
+            return;
+        }
+    }
+
+    if (!m_database.commitTransaction())
+        qWarning() << "In FaviconStore::checkForUpdate - unable to commit page mapping update";
+}
+
+void FaviconStore::migrateIconData()
+{
+    const QString tableName = QLatin1String("FaviconData");
+    if (getSchemaVersion(tableName) >= RawIconDataVersion)
+        return;
+
+    if (!m_database.beginTransaction())
+        return;
+
+    const bool converted = convertColumn(tableName, QLatin1String("DataID"), QLatin1String("Data"), [](const QByteArray &data) {
+        return QByteArray::fromBase64(data);
+    });
+    if (!converted || !setSchemaVersion(tableName, RawIconDataVersion))
+    {
+        qWarning() << "In FaviconStore::migrateIconData - unable to convert icon data";
+        m_database.rollbackTransaction();
+        return;
+    }
+
+    if (!m_database.commitTransaction())
+        qWarning() << "In FaviconStore::migrateIconData - unable to commit icon data conversion";
+}
+
+void FaviconStore::load()
+{
+    checkForUpdate();
+    migrateIconData();
 
     // Create indices
     exec(QLatin1String("CREATE INDEX IF NOT EXISTS favicons_url ON Favicons(URL)"));
@@ -181,12 +368,12 @@ void FaviconStore::setup()
     exec(QLatin1String("CREATE INDEX IF NOT EXISTS favicon_data_foreign_id ON FaviconData(FaviconID)"));
     exec(QLatin1String("CREATE INDEX IF NOT EXISTS favicon_map_url ON FaviconMap(PageURL)"));
     exec(QLatin1String("CREATE INDEX IF NOT EXISTS favicon_map_data_id ON FaviconMap(FaviconID)"));
-}
+    exec(QLatin1String("CREATE INDEX IF NOT EXISTS favicon_map_host ON FaviconMap(Host)"));
+    exec(QLatin1String("CREATE INDEX IF NOT EXISTS favicon_map_etld1 ON FaviconMap(ETLD1)"));
 
-void FaviconStore::load()
-{
     setupQueries();
 
+    // Icon data and page mappings are loaded on demand, only the icon URLs are indexed
     auto query = m_database.prepare(R"(SELECT FaviconID, URL FROM Favicons)");
     while (query.next())
     {
@@ -194,28 +381,7 @@ void FaviconStore::load()
         QUrl iconUrl;
         query >> iconId
               >> iconUrl;
-        m_originMap.emplace(std::make_pair(iconId, iconUrl));
-    }
-
-    query = m_database.prepare(R"(SELECT DataID, FaviconID, Data FROM FaviconData)");
-    while (query.next())
-    {
-        FaviconData data;
-        query >> data;
-
-        m_iconDataMap.emplace(std::make_pair(data.faviconId, data));
-    }
-
-    query = m_database.prepare(R"(SELECT PageURL, FaviconID FROM FaviconMap)");
-    while (query.next())
-    {
-        QUrl pageUrl;
-        int faviconId = 0;
-
-        query >> pageUrl
-              >> faviconId;
-
-        m_webPageMap.insert(pageUrl, faviconId);
+        m_iconUrlIndex.insert(getIconUrlKey(iconUrl), iconId);
     }
 
     // Fetch maximum favicon ID and data ID values so new entry IDs can be calculated with more ease
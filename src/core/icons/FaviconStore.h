@@ -3,10 +3,12 @@
 
 #include "DatabaseWorker.h"
 #include "FaviconTypes.h"
-#include "LRUCache.h"
 
 #include <map>
 #include <memory>
+#include <utility>
+#include <vector>
+
 #include <QHash>
 #include <QIcon>
 #include <QSet>
@@ -15,7 +17,10 @@
 
 /**
  * @class FaviconStore
- * @brief Maintains a record of favicons from websites frequented by the user
+ * @brief Maintains a record of favicons from websites frequented by the user.
+ *
+ * Only an index of icon URLs to their identifiers is kept in memory. Page mappings and icon data are
+ * read from the database on demand, and are expected to be cached by the \ref FaviconManager
  */
 class FaviconStore : public DatabaseWorker
 {
@@ -31,30 +36,46 @@ class FaviconStore : public DatabaseWorker
     /// Destroys the favicon storage object, saving data to the favicon database
     ~FaviconStore();
 
-    /// Returns the Id of the favicon associated with the given URL
+    /// Returns the Id of the favicon associated with the given URL. If the page itself has no icon, the icon of another
+    /// page on the same host, or else the same registrable domain, is returned. Each lookup is resolved through an index
     int getFaviconId(const QUrl &url);
 
-    /// Returns the identifier of the favicon associated with the given data URL (ie the URL of the icon itself)
+    /// Returns the identifier of the favicon associated with the given data URL (ie the URL of the icon itself),
+    /// creating a new record if it was not found
     int getFaviconIdForIconUrl(const QUrl &url);
 
     /// Returns the icon data for the favicon with the given identifier, or an empty
-    /// byte array if it could not be found
-    QByteArray getIconData(int faviconId) const;
+    /// byte array if it could not be found. See \ref CommonUtil::iconFromBytes
+    QByteArray getIconData(int faviconId);
 
-    /// Returns a reference to the icon data structure associated with the given favicon ID,
-    /// inserting a new record if it was not found.
-    FaviconData &getDataRecord(int faviconId);
+    /// Saves the icon data of the favicon with the given identifier, replacing any existing data
+    void saveIconData(int faviconId, const QByteArray &iconData);
 
-    /// Saves the given record to the database
-    void saveDataRecord(FaviconData &dataRecord);
+    /// Saves the data of each of the given icons, keyed by the URL of the icon, in a single transaction.
+    /// Returns the favicon identifier of each icon, in the same order as the input
+    std::vector<int> saveIcons(const std::vector<std::pair<QUrl, QByteArray>> &icons);
 
     /// Maps the given web page to a favicon, referenced by its unique ID
     void addPageMapping(const QUrl &webPageUrl, int faviconId);
 
+    /// Maps each of the given web pages to the icon at the paired icon URL, in a single transaction.
+    /// Returns the favicon identifier of each icon, in the same order as the input
+    std::vector<int> addPageMappings(const std::vector<std::pair<QUrl, QUrl>> &pageIcons);
+
 private:
     /// Instantiates the stored query objects
     void setupQueries();
 
+    /// Adds the normalized host and registrable domain columns to the page mapping table, if missing
+    void checkForUpdate();
+
+    /// Converts icon data stored as base64-encoded PNG images into the raw image bytes
+    void migrateIconData();
+
+    /// Returns the key of the given icon URL in the icon URL index. Icon URLs that only differ by their
+    /// scheme, user information, "www." prefix, query or fragment share the same key
+    QString getIconUrlKey(const QUrl &url) const;
+
 protected:
     /// Returns true if the favicon database contains the table structure(s) needed for it to function properly,
     /// false if else.
@@ -63,7 +84,7 @@ class FaviconStore : public DatabaseWorker
     /// Sets initial table structures of the database
     void setup() override;
 
-    /// Loads records from the database
+    /// Loads the icon URL index from the database
     void load() override;
 
 private:
@@ -72,19 +93,17 @@ class FaviconStore : public DatabaseWorker
     {
         InsertFavicon,
         InsertIconData,
+        UpdateIconData,
+        FindIconData,
         FindIconExactURL,
-        FindIconLikeURL
+        FindIconByHost,
+        FindIconByDomain,
+        InsertPageMapping
     };
 
 private:
-    /// Mapping of unique favicon IDs to their respective data URLs
-    FaviconOriginMap m_originMap;
-
-    /// Mapping of unique favicon IDs to their icon data containers
-    FaviconDataMap m_iconDataMap;
-
-    /// Mapping of visited URLs to their corresponding favicon IDs
-    WebPageIconMap m_webPageMap;
+    /// Index of icon URL keys (see \ref getIconUrlKey ) to their unique favicon IDs
+    QHash<QString, int> m_iconUrlIndex;
 
     /// Used when adding new records to the favicon table
     int m_newFaviconID;
@@ -7,9 +7,11 @@
 #include <QIcon>
 
 #include <unordered_map>
+#include <vector>
 
 #include <QByteArray>
 #include <QHash>
+#include <QImage>
 #include <QString>
 #include <QSet>
 #include <QUrl>
@@ -59,6 +61,36 @@ struct FaviconData final : public sqlite::Row
     }
 };
 
+/// Result of decoding a downloaded favicon, see \ref FaviconManager
+struct DecodedFavicon
+{
+    /// URL from which the icon was downloaded
+    QUrl iconUrl;
+
+    /// Decoded icon image, or a null image if the data could not be decoded
+    QImage image;
+
+    /// Encoded form of the image, as stored in the favicon database
+    QByteArray iconData;
+};
+
+/// Icon reported by a web page, waiting to be saved, see \ref FaviconManager::updateIcon
+struct PageIconUpdate
+{
+    /// URL of the icon
+    QUrl iconUrl;
+
+    /// URL of the page displaying the icon
+    QUrl pageUrl;
+
+    /// Image of each resolution of the icon, to be encoded on the database thread. Empty if the
+    /// page did not provide the icon data, in which case the icon is downloaded if it is not stored yet
+    std::vector<QImage> images;
+
+    /// The icon, as provided by the page
+    QIcon icon;
+};
+
 /// Mapping of specific web pages to their favicon records
 struct FaviconMap
 {
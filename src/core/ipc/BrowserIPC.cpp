@@ -1,15 +1,28 @@
 #include "BrowserIPC.h"
 
-#include <QString>
+#include <QDataStream>
 #include <QDebug>
+#include <QDir>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QStandardPaths>
+#include <QString>
 
 #include <cstring>
+#include <string>
 
-BrowserIPC::BrowserIPC() :
+BrowserIPC::BrowserIPC(QObject *parent) :
+    QObject(parent),
     m_buffer(QLatin1String("_Viper_Browser_IPC_")),
     m_semaphore(QLatin1String("_Viper_Browser_Sem_"), 1),
-    m_hasPreExistingInstance(false)
+    m_hasPreExistingInstance(false),
+    m_server(nullptr),
+    m_pendingData(),
+    m_sharedMemoryTimer()
 {
+    m_sharedMemoryTimer.setInterval(1000 * 5);
+    connect(&m_sharedMemoryTimer, &QTimer::timeout, this, &BrowserIPC::checkSharedMemory);
+
     m_semaphore.acquire();
 
     // Fix for linux and perhaps other *nix systems (see: https://habr.com/ru/post/173281/)
@@ -35,6 +48,7 @@ BrowserIPC::BrowserIPC() :
 
 BrowserIPC::~BrowserIPC()
 {
+    close();
     release();
 }
 
@@ -53,6 +67,177 @@ bool BrowserIPC::hasExistingInstance() const
     return m_hasPreExistingInstance;
 }
 
+void BrowserIPC::listen()
+{
+    if (m_server != nullptr)
+        return;
+
+    // Only the first instance of the application listens, so a socket left behind by an instance
+    // that did not exit normally can be removed
+    const QString serverName = getServerName();
+    QLocalServer::removeServer(serverName);
+
+    m_server = new QLocalServer(this);
+    m_server->setSocketOptions(QLocalServer::UserAccessOption);
+    connect(m_server, &QLocalServer::newConnection, this, &BrowserIPC::onNewConnection);
+
+    if (!m_server->listen(serverName))
+        qWarning() << "BrowserIPC::listen() - could not listen on" << serverName << ":" << m_server->errorString();
+
+    m_sharedMemoryTimer.start();
+}
+
+void BrowserIPC::close()
+{
+    m_sharedMemoryTimer.stop();
+    m_pendingData.clear();
+
+    // Sockets of accepted connections are children of the server
+    delete m_server;
+    m_server = nullptr;
+}
+
+void BrowserIPC::sendMessage(const QStringList &message)
+{
+    QLocalSocket socket;
+    socket.connectToServer(getServerName());
+    if (socket.waitForConnected(1000))
+    {
+        socket.write(encodeMessage(message));
+        while (socket.bytesToWrite() > 0 && socket.waitForBytesWritten(1000)) {}
+
+        if (socket.bytesToWrite() == 0)
+        {
+            socket.disconnectFromServer();
+            return;
+        }
+
+        socket.abort();
+    }
+
+    sendSharedMemoryMessage(message);
+}
+
+QByteArray BrowserIPC::encodeMessage(const QStringList &message)
+{
+    QByteArray payload;
+    {
+        QDataStream stream(&payload, QIODevice::WriteOnly);
+        stream.setVersion(QDataStream::Qt_5_0);
+        stream << message;
+    }
+
+    QByteArray frame;
+    QDataStream stream(&frame, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << static_cast<quint32>(payload.size());
+    frame.append(payload);
+    return frame;
+}
+
+int BrowserIPC::decodeMessage(QByteArray &buffer, QStringList &message)
+{
+    const int headerLength = static_cast<int>(sizeof(quint32));
+    if (buffer.size() < headerLength)
+        return 0;
+
+    quint32 length = 0;
+    {
+        QDataStream stream(buffer);
+        stream.setVersion(QDataStream::Qt_5_0);
+        stream >> length;
+    }
+
+    if (length > MaxMessageLength)
+        return -1;
+
+    const int frameLength = headerLength + static_cast<int>(length);
+    if (buffer.size() < frameLength)
+        return 0;
+
+    QStringList decoded;
+    QDataStream stream(buffer.mid(headerLength, static_cast<int>(length)));
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream >> decoded;
+
+    buffer.remove(0, frameLength);
+
+    if (stream.status() != QDataStream::Ok)
+        return -1;
+
+    message = decoded;
+    return 1;
+}
+
+void BrowserIPC::onNewConnection()
+{
+    while (QLocalSocket *socket = m_server->nextPendingConnection())
+    {
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket](){
+            readMessages(socket);
+        });
+        connect(socket, &QLocalSocket::disconnected, this, [this, socket](){
+            m_pendingData.remove(socket);
+            socket->deleteLater();
+        });
+
+        // The sender may have written its message before the connection was accepted
+        if (socket->bytesAvailable() > 0)
+            readMessages(socket);
+    }
+}
+
+void BrowserIPC::readMessages(QLocalSocket *socket)
+{
+    std::vector<QStringList> messages;
+    {
+        QByteArray &data = m_pendingData[socket];
+        data.append(socket->readAll());
+
+        QStringList message;
+        int result = 0;
+        while ((result = decodeMessage(data, message)) > 0)
+            messages.push_back(message);
+
+        if (result < 0)
+        {
+            qDebug() << "BrowserIPC::readMessages() - received an invalid message";
+            m_pendingData.remove(socket);
+            socket->abort();
+        }
+    }
+
+    for (const QStringList &message : messages)
+        emit messageReceived(message);
+}
+
+void BrowserIPC::checkSharedMemory()
+{
+    if (!hasMessage())
+        return;
+
+    std::vector<char> message = getMessage();
+    if (message.empty() || message.at(0) == '\0')
+        return;
+
+    const QString messageStr = QString::fromStdString(std::string(message.data(), message.size()));
+    if (messageStr.compare(QLatin1String("new-window")) == 0)
+        emit messageReceived(QStringList());
+    else
+        emit messageReceived(messageStr.split(QChar('\t'), QString::SkipEmptyParts));
+}
+
+QString BrowserIPC::getServerName()
+{
+#ifdef Q_OS_UNIX
+    // Place the socket in the user's runtime directory, so each user has their own browser instance
+    const QString runtimePath = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    if (!runtimePath.isEmpty())
+        return QDir(runtimePath).filePath(QLatin1String("viper-browser-ipc"));
+#endif
+    return QLatin1String("_Viper_Browser_IPC_Socket_");
+}
+
 bool BrowserIPC::hasMessage()
 {
     if (!m_buffer.isAttached())
@@ -127,9 +312,35 @@ std::vector<char> BrowserIPC::getMessage()
     return result;
 }
 
-void BrowserIPC::sendMessage(const char *data, int length)
+void BrowserIPC::sendSharedMemoryMessage(const QStringList &message)
 {
-    if (data == nullptr || length < 1 || length > BufferLength)
+    if (!m_buffer.isAttached())
+    {
+        qDebug() << "BrowserIPC:: failed to send message";
+        return;
+    }
+
+    // Concatenate the URLs into a string, separated by tabs, that fits in the buffer along with its
+    // length. An empty message is sent as "new-window"
+    const int headerLen = static_cast<int>(sizeof(int));
+    QString messageStr;
+    if (message.isEmpty())
+        messageStr = QLatin1String("new-window");
+
+    for (const QString &url : message)
+    {
+        const int additionalLength = url.length() + (messageStr.isEmpty() ? 0 : 1);
+        if (messageStr.length() + additionalLength + headerLen >= BufferLength)
+            break;
+
+        if (!messageStr.isEmpty())
+            messageStr += QLatin1Char('\t');
+        messageStr += url;
+    }
+
+    const std::string messageStdString = messageStr.toStdString();
+    const int length = static_cast<int>(messageStdString.size());
+    if (length < 1 || length + headerLen >= BufferLength)
     {
         qDebug() << "BrowserIPC:: failed to send message";
         return;
@@ -140,7 +351,9 @@ void BrowserIPC::sendMessage(const char *data, int length)
     m_semaphore.acquire();
 
     char *dest = reinterpret_cast<char*>(m_buffer.data());
-    memcpy(dest, data, static_cast<size_t>(length));
+    memcpy(dest, &length, sizeof(int));
+    memcpy(&dest[headerLen], messageStdString.c_str(), messageStdString.size());
+    dest[headerLen + length] = '\0';
 
     m_semaphore.release();
 }
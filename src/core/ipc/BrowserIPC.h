@@ -1,8 +1,18 @@
 #ifndef BROWSERIPC_H
 #define BROWSERIPC_H
 
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
 #include <QSharedMemory>
+#include <QStringList>
 #include <QSystemSemaphore>
+#include <QTimer>
+
+#include <vector>
+
+class QLocalServer;
+class QLocalSocket;
 
 /**
  * @class BrowserIPC
@@ -11,15 +21,26 @@
  *        only be one active instance of the application at a time,
  *        so if a second application is spawned to open a URL for example,
  *        it can ask the existing instance to do so in its stead.
+ *
+ * A message is a list of URLs to open, or an empty list to request a new window. Messages are
+ * sent through a local socket, with each message prefixed by its length, so the existing instance
+ * receives them as soon as they are written. The shared memory buffer of earlier versions is still
+ * used to detect the existing instance, and to exchange messages with instances that do not listen
+ * on the local socket.
  */
-class BrowserIPC
+class BrowserIPC : public QObject
 {
+    Q_OBJECT
+
 public:
     /// Size of the shared memory buffer
     static constexpr int BufferLength = 2048;
 
+    /// Maximum size of a message sent through the local socket, in bytes
+    static constexpr quint32 MaxMessageLength = 16 * 1024 * 1024;
+
     /// Constructs the browser IPC instance
-    BrowserIPC();
+    explicit BrowserIPC(QObject *parent = nullptr);
 
     /// Class destructor
     ~BrowserIPC();
@@ -33,21 +54,62 @@ class BrowserIPC
     /// Returns true if there is already an instance of the browser application, false otherwise.
     bool hasExistingInstance() const;
 
-    /// Returns true if a message has been posted by another instance of the application.
-    /// Otherwise returns false.
-    bool hasMessage();
+    /// Starts accepting messages from other instances of the application. Must be called from the GUI
+    /// thread, after the application object has been constructed
+    void listen();
 
-    /// Returns any messages that have been sent to the browser, in the form of a char array
-    std::vector<char> getMessage();
+    /// Stops accepting messages from other instances of the application
+    void close();
+
+    /// Sends the given URLs, or an empty list to request a new window, to the existing instance of the browser.
+    /// Falls back to the shared memory buffer if the existing instance does not accept local socket connections,
+    /// in which case URLs that do not fit in the buffer are dropped.
+    void sendMessage(const QStringList &message);
+
+    /// Returns the length-prefixed frame of the given message, as written to the local socket
+    static QByteArray encodeMessage(const QStringList &message);
+
+    /**
+     * @brief Removes the first complete frame from the given buffer and decodes its message
+     * @param buffer Data received from the local socket
+     * @param message Set to the decoded message, if a complete frame was found
+     * @return 1 if a message was decoded, 0 if the buffer does not yet hold a complete frame, or -1 if
+     *         the buffer holds an invalid frame
+     */
+    static int decodeMessage(QByteArray &buffer, QStringList &message);
+
+Q_SIGNALS:
+    /// Emitted when a message has been received from another instance of the application
+    void messageReceived(const QStringList &message);
+
+private Q_SLOTS:
+    /// Accepts the pending connections to the local server
+    void onNewConnection();
 
-    /// Attempts to send the given message (format of data param is length immediately followed by data) through this channel.
-    void sendMessage(const char *data, int length);
+    /// Checks the shared memory buffer for a message written by an instance of an earlier version
+    void checkSharedMemory();
 
 private:
+    /// Reads the data that is available from a local socket, emitting \ref messageReceived for each complete message
+    void readMessages(QLocalSocket *socket);
+
     /// Releases the shared memory connection. If this is the only application & class
     /// instance connected to the shared memory, it will then be freed.
     void release();
 
+    /// Returns true if a message has been posted to the shared memory buffer by another instance of the application.
+    /// Otherwise returns false.
+    bool hasMessage();
+
+    /// Returns the message that has been written to the shared memory buffer, in the form of a char array
+    std::vector<char> getMessage();
+
+    /// Attempts to write the given message to the shared memory buffer, in the format read by \ref getMessage
+    void sendSharedMemoryMessage(const QStringList &message);
+
+    /// Returns the name of the local server
+    static QString getServerName();
+
 private:
     /// Shared memory segment.
     QSharedMemory m_buffer;
@@ -58,6 +120,15 @@ class BrowserIPC
     /// Flag set to true if there is another IPC that owns the shared memory, false if this is the first
     /// instance of the application.
     bool m_hasPreExistingInstance;
+
+    /// Local server that accepts messages from other instances of the application
+    QLocalServer *m_server;
+
+    /// Data received from each connected socket that does not yet form a complete message
+    QHash<QLocalSocket*, QByteArray> m_pendingData;
+
+    /// Checks the shared memory buffer on a regular interval, for messages from earlier versions
+    QTimer m_sharedMemoryTimer;
 };
 
 #endif // BROWSERIPC_H
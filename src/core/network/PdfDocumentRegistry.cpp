@@ -0,0 +1,126 @@
+#include "PdfDocumentRegistry.h"
+
+#include <algorithm>
+
+#include <QByteArray>
+#include <QRandomGenerator>
+#include <QUrlQuery>
+
+namespace
+{
+    /// Returns a new random token, in hexadecimal form
+    QString createToken()
+    {
+        quint32 data[4];
+        QRandomGenerator::system()->fillRange(data);
+        return QString::fromLatin1(QByteArray(reinterpret_cast<const char*>(data), static_cast<int>(sizeof(data))).toHex());
+    }
+}
+
+PdfDocumentRegistry::PdfDocumentRegistry(QObject *parent) :
+    QObject(parent),
+    m_documents()
+{
+    setObjectName(QLatin1String("PdfDocumentRegistry"));
+}
+
+QUrl PdfDocumentRegistry::registerDocument(const QUrl &documentUrl, bool canLoadLocalFile)
+{
+    if (!canShowDocument(documentUrl, canLoadLocalFile))
+        return QUrl();
+
+    const QString token = createToken();
+    addDocument(token, documentUrl);
+
+    // The viewer opens the document named by its "file" parameter, relative to the viewer, so the document
+    // is loaded from the same origin. The "src" parameter is ignored by the viewer. Both values are percent-encoded
+    const QByteArray filePath = QByteArrayLiteral("document?token=") + token.toLatin1();
+    return QUrl::fromEncoded(QByteArrayLiteral("viper://pdfviewer/?file=") + filePath.toPercentEncoding()
+                             + QByteArrayLiteral("&src=") + documentUrl.toEncoded().toPercentEncoding());
+}
+
+bool PdfDocumentRegistry::renewDocument(const QUrl &viewerUrl, bool canLoadLocalFile)
+{
+    const QString token = getToken(viewerUrl);
+    const QUrl documentUrl = getDocumentUrl(viewerUrl);
+    if (token.isEmpty() || !canShowDocument(documentUrl, canLoadLocalFile))
+        return false;
+
+    // Drops the document if it is still registered, which happens when the viewer is reloaded before loading it
+    static_cast<void>(takeDocument(token));
+
+    addDocument(token, documentUrl);
+    return true;
+}
+
+QUrl PdfDocumentRegistry::takeDocument(const QString &token)
+{
+    auto it = std::find_if(m_documents.begin(), m_documents.end(), [&token](const PendingDocument &document) {
+        return document.Token == token;
+    });
+    if (token.isEmpty() || it == m_documents.end())
+        return QUrl();
+
+    const QUrl documentUrl = it->Url;
+    m_documents.erase(it);
+    return documentUrl;
+}
+
+bool PdfDocumentRegistry::isViewerUrl(const QUrl &url)
+{
+    return url.scheme() == QLatin1String("viper")
+            && url.host() == QLatin1String("pdfviewer")
+            && (url.path().isEmpty() || url.path() == QLatin1String("/"));
+}
+
+QUrl PdfDocumentRegistry::getDocumentUrl(const QUrl &viewerUrl)
+{
+    if (!isViewerUrl(viewerUrl))
+        return QUrl();
+
+    const QUrlQuery query(viewerUrl);
+    const QByteArray encodedUrl = query.queryItemValue(QLatin1String("src"), QUrl::FullyEncoded).toLatin1();
+    return QUrl::fromEncoded(QByteArray::fromPercentEncoding(encodedUrl));
+}
+
+QString PdfDocumentRegistry::getToken(const QUrl &viewerUrl)
+{
+    if (!isViewerUrl(viewerUrl))
+        return QString();
+
+    // The "file" parameter holds the path of the document, relative to the viewer
+    const QString filePath = QUrlQuery(viewerUrl).queryItemValue(QLatin1String("file"), QUrl::FullyDecoded);
+    const QUrl fileUrl(filePath);
+    if (fileUrl.path() != QLatin1String("document"))
+        return QString();
+
+    return QUrlQuery(fileUrl).queryItemValue(QLatin1String("token"));
+}
+
+QUrl PdfDocumentRegistry::getDisplayUrl(const QUrl &url)
+{
+    if (isViewerUrl(url))
+        return getDocumentUrl(url);
+
+    return url;
+}
+
+bool PdfDocumentRegistry::canShowDocument(const QUrl &documentUrl, bool canLoadLocalFile)
+{
+    if (!documentUrl.isValid())
+        return false;
+
+    const QString scheme = documentUrl.scheme();
+    if (scheme == QLatin1String("file"))
+        return canLoadLocalFile;
+
+    return scheme == QLatin1String("http") || scheme == QLatin1String("https");
+}
+
+void PdfDocumentRegistry::addDocument(const QString &token, const QUrl &documentUrl)
+{
+    if (m_documents.size() >= MaxPendingDocuments)
+        m_documents.pop_front();
+
+    m_documents.push_back(PendingDocument { token, documentUrl });
+}
@@ -0,0 +1,89 @@
+#ifndef PDFDOCUMENTREGISTRY_H
+#define PDFDOCUMENTREGISTRY_H
+
+#include <cstddef>
+#include <deque>
+
+#include <QObject>
+#include <QString>
+#include <QUrl>
+
+/**
+ * @class PdfDocumentRegistry
+ * @brief Keeps track of the PDF documents that the PDF.js viewer may load through the viper scheme.
+ *
+ * When a web page navigates to a PDF document, the document is registered under a random token, and the page
+ * loads the viewer with that token instead of the document URL. The viper scheme handler then serves the
+ * document of a token once, so neither web pages nor the viewer can make the browser load an arbitrary URL.
+ * Local files are only registered for navigations made by the user or by a local page.
+ */
+class PdfDocumentRegistry : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// Maximum number of documents that are registered without having been loaded. The oldest document is
+    /// dropped when another one is registered
+    static constexpr std::size_t MaxPendingDocuments = 32;
+
+    /// Constructs the document registry with an optional parent
+    explicit PdfDocumentRegistry(QObject *parent = nullptr);
+
+    /**
+     * @brief Registers the given document under a new token
+     * @param documentUrl URL of the PDF document
+     * @param canLoadLocalFile True if the navigation to the document may load a local file
+     * @return The URL of the viewer that displays the document, or an empty URL if the document may not be shown
+     */
+    QUrl registerDocument(const QUrl &documentUrl, bool canLoadLocalFile);
+
+    /**
+     * @brief Registers the document of the given viewer URL again, under the same token. Used when the viewer
+     *        is reloaded, or loaded from the history of a page
+     * @param viewerUrl URL of the viewer, as returned by \ref registerDocument
+     * @param canLoadLocalFile True if the navigation to the viewer may load a local file
+     * @return True if the document was registered, false if the viewer URL is not valid or the document may not be shown
+     */
+    bool renewDocument(const QUrl &viewerUrl, bool canLoadLocalFile);
+
+    /// Removes the document registered under the given token, returning its URL, or an empty URL if there is no such document
+    QUrl takeDocument(const QString &token);
+
+    /// Returns true if the given URL belongs to the PDF.js viewer
+    static bool isViewerUrl(const QUrl &url);
+
+    /// Returns the URL of the document displayed by the viewer with the given URL, or an empty URL if the URL does not
+    /// belong to the viewer. The document URL is only a hint for the address bar, history and session, and must not be
+    /// loaded without being registered first
+    static QUrl getDocumentUrl(const QUrl &viewerUrl);
+
+    /// Returns the token in the given viewer URL, or an empty string if the URL does not belong to the viewer
+    static QString getToken(const QUrl &viewerUrl);
+
+    /// Returns the URL under which a page with the given URL is shown to the user. This is the document URL for the
+    /// viewer, and the URL itself for any other page
+    static QUrl getDisplayUrl(const QUrl &url);
+
+private:
+    /// Returns true if a document at the given URL may be shown in the viewer
+    static bool canShowDocument(const QUrl &documentUrl, bool canLoadLocalFile);
+
+    /// Adds the document to the list of pending documents, dropping the oldest one if the list is full
+    void addDocument(const QString &token, const QUrl &documentUrl);
+
+private:
+    /// Document that has been registered, but not yet loaded by the viewer
+    struct PendingDocument
+    {
+        /// One-time token of the document
+        QString Token;
+
+        /// URL of the document
+        QUrl Url;
+    };
+
+    /// Documents that have not yet been loaded, from oldest to newest
+    std::deque<PendingDocument> m_documents;
+};
+
+#endif // PDFDOCUMENTREGISTRY_H
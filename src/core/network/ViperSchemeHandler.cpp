@@ -1,18 +1,60 @@
+#include "NetworkAccessManager.h"
+#include "PdfDocumentRegistry.h"
 #include "ViperSchemeHandler.h"
+#include "WebPageThumbnailStore.h"
 
+#include <QBuffer>
 #include <QFile>
 #include <QMimeDatabase>
 #include <QMimeType>
+#include <QNetworkReply>
+#include <QNetworkRequest>
 #include <QUrl>
+#include <QUrlQuery>
 #include <QWebEngineUrlRequestJob>
+#include <QtWebEngineCoreVersion>
 
-ViperSchemeHandler::ViperSchemeHandler(QObject *parent) :
-    QWebEngineUrlSchemeHandler(parent)
+ViperSchemeHandler::ViperSchemeHandler(const ViperServiceLocator &serviceLocator, QObject *parent) :
+    QWebEngineUrlSchemeHandler(parent),
+    m_serviceLocator(serviceLocator),
+    m_thumbnailStore(nullptr),
+    m_networkAccessMgr(nullptr),
+    m_pdfDocumentRegistry(nullptr),
+    m_pdfViewerHtml()
 {
 }
 
 void ViperSchemeHandler::requestStarted(QWebEngineUrlRequestJob *request)
 {
+    const QUrl requestUrl = request->requestUrl();
+    if (requestUrl.host() == QLatin1String("pdfviewer"))
+    {
+        if (requestUrl.path() == QLatin1String("/document"))
+            loadPdfDocument(request);
+        else if (QIODevice *viewer = loadPdfViewer(request))
+            request->reply(QByteArrayLiteral("text/html"), viewer);
+        else
+            request->fail(QWebEngineUrlRequestJob::UrlNotFound);
+        return;
+    }
+
+    const QString thumbnailHost = WebPageThumbnailStore::getHostFromThumbnailUrl(request->requestUrl());
+    if (!thumbnailHost.isEmpty())
+    {
+        // Only viper pages may load thumbnails, otherwise any web page could probe which sites the user visits
+        if (!isViperInitiator(request))
+        {
+            request->fail(QWebEngineUrlRequestJob::RequestDenied);
+            return;
+        }
+
+        if (QIODevice *thumbnail = loadThumbnail(request, thumbnailHost))
+            request->reply(QByteArrayLiteral("image/png"), thumbnail);
+        else
+            request->fail(QWebEngineUrlRequestJob::UrlNotFound);
+        return;
+    }
+
     QIODevice *contents = loadFile(request);
     if (!contents)
     {
@@ -28,6 +70,27 @@ void ViperSchemeHandler::requestStarted(QWebEngineUrlRequestJob *request)
     request->reply(mimeType, contents);
 }
 
+bool ViperSchemeHandler::isViperInitiator(const QWebEngineUrlRequestJob *request)
+{
+#if (QTWEBENGINECORE_VERSION >= QT_VERSION_CHECK(5, 11, 0))
+    return request->initiator().scheme() == QLatin1String("viper");
+#else
+    Q_UNUSED(request);
+    return true;
+#endif
+}
+
+bool ViperSchemeHandler::isPdfViewerInitiator(const QWebEngineUrlRequestJob *request)
+{
+#if (QTWEBENGINECORE_VERSION >= QT_VERSION_CHECK(5, 11, 0))
+    const QUrl initiator = request->initiator();
+    return initiator.scheme() == QLatin1String("viper") && initiator.host() == QLatin1String("pdfviewer");
+#else
+    Q_UNUSED(request);
+    return true;
+#endif
+}
+
 QIODevice *ViperSchemeHandler::loadFile(QWebEngineUrlRequestJob *request)
 {
     // Extract file name from URL
@@ -51,3 +114,103 @@ QIODevice *ViperSchemeHandler::loadFile(QWebEngineUrlRequestJob *request)
     connect(request, &QObject::destroyed, f, &QFile::deleteLater);
     return f;
 }
+
+QIODevice *ViperSchemeHandler::loadThumbnail(QWebEngineUrlRequestJob *request, const QString &host)
+{
+    if (!m_thumbnailStore)
+        m_thumbnailStore = m_serviceLocator.getServiceAs<WebPageThumbnailStore>("WebPageThumbnailStore");
+
+    if (!m_thumbnailStore)
+        return nullptr;
+
+    const QByteArray data = m_thumbnailStore->getThumbnailData(host);
+    if (data.isEmpty())
+        return nullptr;
+
+    QBuffer *buffer = new QBuffer;
+    buffer->setData(data);
+    if (!buffer->open(QIODevice::ReadOnly))
+    {
+        delete buffer;
+        return nullptr;
+    }
+
+    connect(request, &QObject::destroyed, buffer, &QBuffer::deleteLater);
+    return buffer;
+}
+
+QIODevice *ViperSchemeHandler::loadPdfViewer(QWebEngineUrlRequestJob *request)
+{
+    if (m_pdfViewerHtml.isEmpty())
+    {
+        QFile f(QLatin1String(":/viewer.html"));
+        if (!f.open(QIODevice::ReadOnly))
+            return nullptr;
+
+        m_pdfViewerHtml = f.readAll();
+    }
+
+    QBuffer *buffer = new QBuffer;
+    buffer->setData(m_pdfViewerHtml);
+    if (!buffer->open(QIODevice::ReadOnly))
+    {
+        delete buffer;
+        return nullptr;
+    }
+
+    connect(request, &QObject::destroyed, buffer, &QBuffer::deleteLater);
+    return buffer;
+}
+
+void ViperSchemeHandler::loadPdfDocument(QWebEngineUrlRequestJob *request)
+{
+    if (!m_networkAccessMgr)
+        m_networkAccessMgr = m_serviceLocator.getServiceAs<NetworkAccessManager>("NetworkAccessManager");
+
+    if (!m_pdfDocumentRegistry)
+        m_pdfDocumentRegistry = m_serviceLocator.getServiceAs<PdfDocumentRegistry>("PdfDocumentRegistry");
+
+    if (!m_networkAccessMgr || !m_pdfDocumentRegistry)
+    {
+        request->fail(QWebEngineUrlRequestJob::RequestFailed);
+        return;
+    }
+
+    // Documents are only served to the viewer, and only once, so other pages cannot use the viewer to load any URL
+    if (!isPdfViewerInitiator(request))
+    {
+        request->fail(QWebEngineUrlRequestJob::RequestDenied);
+        return;
+    }
+
+    const QString token = QUrlQuery(request->requestUrl()).queryItemValue(QLatin1String("token"));
+    const QUrl documentUrl = m_pdfDocumentRegistry->takeDocument(token);
+    if (documentUrl.isEmpty())
+    {
+        request->fail(QWebEngineUrlRequestJob::RequestDenied);
+        return;
+    }
+
+    QNetworkRequest documentRequest(documentUrl);
+    documentRequest.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::NoLessSafeRedirectPolicy);
+
+    QNetworkReply *reply = m_networkAccessMgr->get(documentRequest);
+    connect(request, &QObject::destroyed, reply, &QNetworkReply::deleteLater);
+
+    // The reply is read by the web engine as data arrives, so large documents are not buffered in full
+    // before the viewer can start parsing them. Error responses are not passed on as documents
+    auto onResponse = [request, reply](bool isFinished) {
+        const int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        const bool isRedirect = statusCode >= 300 && statusCode < 400;
+        if (reply->error() == QNetworkReply::NoError && isRedirect && !isFinished)
+            return;
+
+        QObject::disconnect(reply, nullptr, request, nullptr);
+        if (reply->error() != QNetworkReply::NoError || isRedirect || statusCode >= 400)
+            request->fail(QWebEngineUrlRequestJob::RequestFailed);
+        else
+            request->reply(QByteArrayLiteral("application/pdf"), reply);
+    };
+    connect(reply, &QNetworkReply::metaDataChanged, request, [onResponse](){ onResponse(false); });
+    connect(reply, &QNetworkReply::finished, request, [onResponse](){ onResponse(true); });
+}
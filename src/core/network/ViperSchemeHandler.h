@@ -1,29 +1,72 @@
 #ifndef VIPERSCHEMEHANDLER_H
 #define VIPERSCHEMEHANDLER_H
 
+#include "ServiceLocator.h"
+
+#include <QByteArray>
 #include <QWebEngineUrlSchemeHandler>
 
+class NetworkAccessManager;
+class PdfDocumentRegistry;
 class QIODevice;
+class WebPageThumbnailStore;
 class QWebEngineUrlRequestJob;
 
 /**
  * @class ViperSchemeHandler
- * @brief Implements the viper scheme (wrapper for qrc) for the QtWebEngine backend
+ * @brief Implements the viper scheme (wrapper for qrc) for the QtWebEngine backend.
+ *        Also serves the web page thumbnails of the \ref WebPageThumbnailStore, and the PDF.js viewer
+ *        along with the documents that it displays
  */
 class ViperSchemeHandler : public QWebEngineUrlSchemeHandler
 {
     Q_OBJECT
 
 public:
-    /// Constructs the viper scheme handler with an optional parent
-    ViperSchemeHandler(QObject *parent = nullptr);
+    /// Constructs the viper scheme handler with a reference to the service locator and an optional parent
+    ViperSchemeHandler(const ViperServiceLocator &serviceLocator, QObject *parent = nullptr);
 
     /// Called whenever a request for the viper scheme is started
     void requestStarted(QWebEngineUrlRequestJob *request) override;
 
 private:
+    /// Returns true if the request was made by a viper page. Always true for versions of QtWebEngine that do not
+    /// report the initiator of a request
+    static bool isViperInitiator(const QWebEngineUrlRequestJob *request);
+
+    /// Returns true if the request was made by the PDF.js viewer. Always true for versions of QtWebEngine that do not
+    /// report the initiator of a request, in which case the one-time token of the document is the only safeguard
+    static bool isPdfViewerInitiator(const QWebEngineUrlRequestJob *request);
+
     /// Loads the qrc file associated with the viper scheme request
     QIODevice *loadFile(QWebEngineUrlRequestJob *request);
+
+    /// Loads the thumbnail of the given host, returning a nullptr if there is no thumbnail of the host
+    QIODevice *loadThumbnail(QWebEngineUrlRequestJob *request, const QString &host);
+
+    /// Returns the HTML of the PDF.js viewer, which is read from the qrc file once and kept in memory
+    QIODevice *loadPdfViewer(QWebEngineUrlRequestJob *request);
+
+    /// Starts downloading the PDF document that was registered under the token in the query of the request. Replies with
+    /// the network reply once its headers have arrived, so the viewer receives the document as it is downloaded, or fails
+    /// the request if the token is not valid or the server responds with an error
+    void loadPdfDocument(QWebEngineUrlRequestJob *request);
+
+private:
+    /// Service locator, used to find the thumbnail store and the network access manager when they are first needed
+    const ViperServiceLocator &m_serviceLocator;
+
+    /// Web page thumbnail store
+    WebPageThumbnailStore *m_thumbnailStore;
+
+    /// Network access manager, used to download PDF documents for the viewer
+    NetworkAccessManager *m_networkAccessMgr;
+
+    /// Registry of the PDF documents that the viewer may load
+    PdfDocumentRegistry *m_pdfDocumentRegistry;
+
+    /// HTML of the PDF.js viewer
+    QByteArray m_pdfViewerHtml;
 };
 
 #endif // VIPERSCHEMEHANDLER_H
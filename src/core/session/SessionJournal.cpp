@@ -0,0 +1,447 @@
+#include "SessionJournal.h"
+
+#include <algorithm>
+
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+#include <QDebug>
+
+namespace
+{
+    /// Identifies a session journal file
+    constexpr quint32 JournalMagic = 0x56534a4e;
+
+    /// Version of the journal format
+    constexpr quint16 JournalVersion = 1;
+
+    /// Size of the journal header, in bytes
+    constexpr int HeaderSize = 6;
+
+    /// Size of the type, length and checksum that precede the payload of each record, in bytes
+    constexpr int RecordHeaderSize = 7;
+
+    /// Number of bytes that may be appended to the journal after a compaction before it is compacted again,
+    /// unless the snapshot itself is larger
+    constexpr qint64 MinCompactionThreshold = 256 * 1024;
+
+    /// Returns the header of a journal file
+    QByteArray createHeader()
+    {
+        QByteArray header;
+        QDataStream stream(&header, QIODevice::WriteOnly);
+        stream << JournalMagic << JournalVersion;
+        return header;
+    }
+
+    /// Serializes the given values into a record payload
+    template <typename... Args>
+    QByteArray createPayload(const Args&... args)
+    {
+        QByteArray payload;
+        QDataStream stream(&payload, QIODevice::WriteOnly);
+        stream.setVersion(QDataStream::Qt_5_6);
+        (stream << ... << args);
+        return payload;
+    }
+
+    /// Serializes the state of a tab into a record payload
+    QByteArray createTabPayload(const SessionTab &tab)
+    {
+        return createPayload(tab.Id, tab.Url, tab.Title, tab.IconUrl, tab.History, tab.IsPinned, tab.IsHibernating);
+    }
+}
+
+bool SessionTab::operator==(const SessionTab &other) const
+{
+    return Id == other.Id
+            && IsPinned == other.IsPinned
+            && IsHibernating == other.IsHibernating
+            && Url == other.Url
+            && Title == other.Title
+            && IconUrl == other.IconUrl
+            && History == other.History;
+}
+
+SessionJournal::SessionJournal(const QString &filePath) :
+    m_filePath(filePath),
+    m_state(),
+    m_pendingRecords(),
+    m_journalSize(0),
+    m_snapshotSize(0),
+    m_needsCompaction(true)
+{
+}
+
+SessionJournal::~SessionJournal()
+{
+    flush();
+}
+
+bool SessionJournal::load()
+{
+    m_state = SessionState();
+    m_pendingRecords.clear();
+    m_journalSize = 0;
+    m_snapshotSize = 0;
+    m_needsCompaction = true;
+
+    QFile file(m_filePath);
+    if (!file.exists() || !file.open(QIODevice::ReadOnly))
+        return false;
+
+    const QByteArray data = file.readAll();
+    file.close();
+
+    QDataStream stream(data);
+    quint32 magic = 0;
+    quint16 version = 0;
+    stream >> magic >> version;
+    if (data.size() < HeaderSize || magic != JournalMagic || version != JournalVersion)
+    {
+        qWarning() << "SessionJournal::load - file " << m_filePath << " is not a session journal";
+        return false;
+    }
+
+    int offset = HeaderSize;
+    while (data.size() - offset >= RecordHeaderSize)
+    {
+        quint8 type = 0;
+        quint32 length = 0;
+        quint16 checksum = 0;
+        stream >> type >> length >> checksum;
+
+        // Stop at a record that was only partially written, or damaged
+        if (length > static_cast<quint32>(data.size() - offset - RecordHeaderSize))
+            break;
+
+        const QByteArray payload = data.mid(offset + RecordHeaderSize, static_cast<int>(length));
+        if (qChecksum(payload.constData(), static_cast<uint>(payload.size())) != checksum)
+            break;
+
+        applyRecord(static_cast<RecordType>(type), payload);
+
+        offset += RecordHeaderSize + static_cast<int>(length);
+        stream.skipRawData(static_cast<int>(length));
+    }
+
+    if (offset < data.size())
+        qWarning() << "SessionJournal::load - ignoring " << (data.size() - offset) << " bytes of damaged records in " << m_filePath;
+
+    m_journalSize = offset;
+    m_snapshotSize = offset;
+    m_needsCompaction = offset < data.size();
+    return true;
+}
+
+const SessionState &SessionJournal::getState() const
+{
+    return m_state;
+}
+
+bool SessionJournal::hasPendingChanges() const
+{
+    return !m_pendingRecords.isEmpty();
+}
+
+void SessionJournal::clear()
+{
+    record(RecordType::Clear, QByteArray());
+}
+
+void SessionJournal::openWindow(quint32 windowId)
+{
+    record(RecordType::OpenWindow, createPayload(windowId));
+}
+
+void SessionJournal::closeWindow(quint32 windowId)
+{
+    record(RecordType::CloseWindow, createPayload(windowId));
+}
+
+void SessionJournal::setWindowGeometry(quint32 windowId, const QRect &geometry, bool isMaximized)
+{
+    record(RecordType::WindowGeometry, createPayload(windowId, geometry, isMaximized));
+}
+
+void SessionJournal::setCurrentTab(quint32 windowId, quint32 tabId)
+{
+    record(RecordType::CurrentTab, createPayload(windowId, tabId));
+}
+
+void SessionJournal::openTab(quint32 windowId, quint32 tabId, int index)
+{
+    record(RecordType::OpenTab, createPayload(windowId, tabId, static_cast<qint32>(index)));
+}
+
+void SessionJournal::closeTab(quint32 tabId)
+{
+    record(RecordType::CloseTab, createPayload(tabId));
+}
+
+void SessionJournal::moveTab(quint32 tabId, int index)
+{
+    record(RecordType::MoveTab, createPayload(tabId, static_cast<qint32>(index)));
+}
+
+void SessionJournal::updateTab(const SessionTab &tab)
+{
+    record(RecordType::UpdateTab, createTabPayload(tab));
+}
+
+bool SessionJournal::flush()
+{
+    if (m_pendingRecords.isEmpty())
+        return true;
+
+    const qint64 appendedSize = m_journalSize - m_snapshotSize + m_pendingRecords.size();
+    if (m_needsCompaction || appendedSize > std::max(m_snapshotSize, MinCompactionThreshold))
+        return compact();
+
+    QFile file(m_filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append))
+    {
+        qWarning() << "SessionJournal::flush - could not open file " << m_filePath;
+        return false;
+    }
+
+    if (file.write(m_pendingRecords) != m_pendingRecords.size() || !file.flush())
+    {
+        // The file may now end with a partial record, so it is rewritten on the next attempt
+        qWarning() << "SessionJournal::flush - could not write to file " << m_filePath;
+        m_needsCompaction = true;
+        return false;
+    }
+
+    m_journalSize += m_pendingRecords.size();
+    m_pendingRecords.clear();
+    return true;
+}
+
+bool SessionJournal::compact()
+{
+    const QByteArray snapshot = createSnapshot();
+
+    QSaveFile file(m_filePath);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qWarning() << "SessionJournal::compact - could not open file " << m_filePath;
+        return false;
+    }
+
+    file.write(snapshot);
+    if (!file.commit())
+    {
+        qWarning() << "SessionJournal::compact - could not write to file " << m_filePath;
+        return false;
+    }
+
+    m_journalSize = snapshot.size();
+    m_snapshotSize = snapshot.size();
+    m_pendingRecords.clear();
+    m_needsCompaction = false;
+    return true;
+}
+
+void SessionJournal::record(RecordType type, const QByteArray &payload)
+{
+    if (applyRecord(type, payload))
+        writeRecord(m_pendingRecords, type, payload);
+}
+
+bool SessionJournal::applyRecord(RecordType type, const QByteArray &payload)
+{
+    QDataStream stream(payload);
+    stream.setVersion(QDataStream::Qt_5_6);
+
+    switch (type)
+    {
+        case RecordType::Clear:
+        {
+            if (m_state.Windows.empty())
+                return false;
+
+            m_state.Windows.clear();
+            return true;
+        }
+        case RecordType::OpenWindow:
+        {
+            quint32 windowId = 0;
+            stream >> windowId;
+            if (findWindow(windowId) != nullptr)
+                return false;
+
+            SessionWindow window;
+            window.Id = windowId;
+            m_state.Windows.push_back(std::move(window));
+            return true;
+        }
+        case RecordType::CloseWindow:
+        {
+            quint32 windowId = 0;
+            stream >> windowId;
+
+            auto it = std::find_if(m_state.Windows.begin(), m_state.Windows.end(), [windowId](const SessionWindow &window) {
+                return window.Id == windowId;
+            });
+            if (it == m_state.Windows.end())
+                return false;
+
+            m_state.Windows.erase(it);
+            return true;
+        }
+        case RecordType::WindowGeometry:
+        {
+            quint32 windowId = 0;
+            QRect geometry;
+            bool isMaximized = false;
+            stream >> windowId >> geometry >> isMaximized;
+
+            SessionWindow *window = findWindow(windowId);
+            if (!window || (window->Geometry == geometry && window->IsMaximized == isMaximized))
+                return false;
+
+            window->Geometry = geometry;
+            window->IsMaximized = isMaximized;
+            return true;
+        }
+        case RecordType::CurrentTab:
+        {
+            quint32 windowId = 0, tabId = 0;
+            stream >> windowId >> tabId;
+
+            SessionWindow *window = findWindow(windowId);
+            if (!window || window->CurrentTabId == tabId)
+                return false;
+
+            window->CurrentTabId = tabId;
+            return true;
+        }
+        case RecordType::OpenTab:
+        {
+            quint32 windowId = 0, tabId = 0;
+            qint32 index = 0;
+            stream >> windowId >> tabId >> index;
+
+            std::size_t tabIndex = 0;
+            SessionWindow *window = findWindow(windowId);
+            if (!window || findTab(tabId, tabIndex) != nullptr)
+                return false;
+
+            SessionTab tab;
+            tab.Id = tabId;
+
+            const std::size_t insertIndex = std::min(static_cast<std::size_t>(std::max(index, 0)), window->Tabs.size());
+            window->Tabs.insert(window->Tabs.begin() + static_cast<std::ptrdiff_t>(insertIndex), std::move(tab));
+            return true;
+        }
+        case RecordType::CloseTab:
+        {
+            quint32 tabId = 0;
+            stream >> tabId;
+
+            std::size_t tabIndex = 0;
+            SessionWindow *window = findTab(tabId, tabIndex);
+            if (!window)
+                return false;
+
+            window->Tabs.erase(window->Tabs.begin() + static_cast<std::ptrdiff_t>(tabIndex));
+            return true;
+        }
+        case RecordType::MoveTab:
+        {
+            quint32 tabId = 0;
+            qint32 index = 0;
+            stream >> tabId >> index;
+
+            std::size_t tabIndex = 0;
+            SessionWindow *window = findTab(tabId, tabIndex);
+            if (!window)
+                return false;
+
+            const std::size_t newIndex = std::min(static_cast<std::size_t>(std::max(index, 0)), window->Tabs.size() - 1);
+            if (newIndex == tabIndex)
+                return false;
+
+            SessionTab tab = std::move(window->Tabs[tabIndex]);
+            window->Tabs.erase(window->Tabs.begin() + static_cast<std::ptrdiff_t>(tabIndex));
+            window->Tabs.insert(window->Tabs.begin() + static_cast<std::ptrdiff_t>(newIndex), std::move(tab));
+            return true;
+        }
+        case RecordType::UpdateTab:
+        {
+            SessionTab tab;
+            stream >> tab.Id >> tab.Url >> tab.Title >> tab.IconUrl >> tab.History >> tab.IsPinned >> tab.IsHibernating;
+
+            std::size_t tabIndex = 0;
+            SessionWindow *window = findTab(tab.Id, tabIndex);
+            if (!window || window->Tabs[tabIndex] == tab)
+                return false;
+
+            window->Tabs[tabIndex] = std::move(tab);
+            return true;
+        }
+    }
+
+    qWarning() << "SessionJournal::applyRecord - unknown record type " << static_cast<int>(type);
+    return false;
+}
+
+QByteArray SessionJournal::createSnapshot() const
+{
+    QByteArray snapshot = createHeader();
+
+    for (const SessionWindow &window : m_state.Windows)
+    {
+        writeRecord(snapshot, RecordType::OpenWindow, createPayload(window.Id));
+        writeRecord(snapshot, RecordType::WindowGeometry, createPayload(window.Id, window.Geometry, window.IsMaximized));
+
+        qint32 index = 0;
+        for (const SessionTab &tab : window.Tabs)
+        {
+            writeRecord(snapshot, RecordType::OpenTab, createPayload(window.Id, tab.Id, index++));
+            writeRecord(snapshot, RecordType::UpdateTab, createTabPayload(tab));
+        }
+
+        writeRecord(snapshot, RecordType::CurrentTab, createPayload(window.Id, window.CurrentTabId));
+    }
+
+    return snapshot;
+}
+
+SessionWindow *SessionJournal::findWindow(quint32 windowId)
+{
+    for (SessionWindow &window : m_state.Windows)
+    {
+        if (window.Id == windowId)
+            return &window;
+    }
+
+    return nullptr;
+}
+
+SessionWindow *SessionJournal::findTab(quint32 tabId, std::size_t &tabIndex)
+{
+    for (SessionWindow &window : m_state.Windows)
+    {
+        for (std::size_t i = 0; i < window.Tabs.size(); ++i)
+        {
+            if (window.Tabs[i].Id == tabId)
+            {
+                tabIndex = i;
+                return &window;
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+void SessionJournal::writeRecord(QByteArray &buffer, RecordType type, const QByteArray &payload)
+{
+    QDataStream stream(&buffer, QIODevice::WriteOnly | QIODevice::Append);
+    stream << static_cast<quint8>(type)
+           << static_cast<quint32>(payload.size())
+           << qChecksum(payload.constData(), static_cast<uint>(payload.size()));
+    stream.writeRawData(payload.constData(), payload.size());
+}
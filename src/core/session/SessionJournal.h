@@ -0,0 +1,190 @@
+#ifndef SESSIONJOURNAL_H
+#define SESSIONJOURNAL_H
+
+#include <cstddef>
+#include <vector>
+
+#include <QByteArray>
+#include <QRect>
+#include <QString>
+#include <QUrl>
+#include <QtGlobal>
+
+/// State of a tab belonging to a browsing session
+struct SessionTab
+{
+    /// Identifier of the tab, unique within the session
+    quint32 Id = 0;
+
+    /// URL of the page in the tab
+    QUrl Url;
+
+    /// Title of the page
+    QString Title;
+
+    /// URL of the page's icon
+    QUrl IconUrl;
+
+    /// Serialized navigation history of the tab
+    QByteArray History;
+
+    /// True if the tab is pinned, false if else
+    bool IsPinned = false;
+
+    /// True if the tab is hibernating, false if else
+    bool IsHibernating = false;
+
+    /// Returns true if the two tabs have the same identifier and state, false if else
+    bool operator==(const SessionTab &other) const;
+
+    /// Returns true if the two tabs differ in their identifier or state, false if else
+    bool operator!=(const SessionTab &other) const { return !(*this == other); }
+};
+
+/// State of a browser window belonging to a browsing session
+struct SessionWindow
+{
+    /// Identifier of the window, unique within the session
+    quint32 Id = 0;
+
+    /// Geometry of the window
+    QRect Geometry;
+
+    /// True if the window is maximized, false if else
+    bool IsMaximized = false;
+
+    /// Identifier of the active tab of the window
+    quint32 CurrentTabId = 0;
+
+    /// Tabs of the window, in the order they appear in its tab bar
+    std::vector<SessionTab> Tabs;
+};
+
+/// State of every window and tab in a browsing session
+struct SessionState
+{
+    /// Windows of the session, in the order they were opened
+    std::vector<SessionWindow> Windows;
+};
+
+/**
+ * @class SessionJournal
+ * @brief Keeps the state of the browsing session in an append-only file of changes, such as tabs being opened,
+ *        closed, moved or navigated.
+ *
+ * Each change is applied to the in-memory \ref SessionState and buffered as a compact binary record until the
+ * journal is flushed, so that saving the session costs as much as the changes made since the last save. Each
+ * record is framed by its length and a checksum. If the browser stops while a record is being written, the
+ * damaged record and anything after it are ignored when the journal is loaded.
+ *
+ * Once the records appended to the file outgrow the state they describe, the journal is compacted. The current
+ * state is written to a new file as a single series of records, which then replaces the journal by an atomic
+ * rename.
+ */
+class SessionJournal
+{
+public:
+    /// Constructs the session journal, given the path of the journal file
+    explicit SessionJournal(const QString &filePath);
+
+    /// Writes any pending changes to the journal file
+    ~SessionJournal();
+
+    /// Replays the journal file into the session state. Returns true if the file contained a journal, false if else
+    bool load();
+
+    /// Returns the current state of the session
+    const SessionState &getState() const;
+
+    /// Returns true if there are changes that have not been written to the journal file, false if else
+    bool hasPendingChanges() const;
+
+    /// Removes every window and tab from the session
+    void clear();
+
+    /// Adds an empty window with the given identifier to the session
+    void openWindow(quint32 windowId);
+
+    /// Removes the window with the given identifier, and its tabs, from the session
+    void closeWindow(quint32 windowId);
+
+    /// Sets the geometry and maximized state of a window
+    void setWindowGeometry(quint32 windowId, const QRect &geometry, bool isMaximized);
+
+    /// Sets the active tab of a window
+    void setCurrentTab(quint32 windowId, quint32 tabId);
+
+    /// Inserts a tab with the given identifier into a window, at the given index
+    void openTab(quint32 windowId, quint32 tabId, int index);
+
+    /// Removes the tab with the given identifier from its window
+    void closeTab(quint32 tabId);
+
+    /// Moves a tab to the given index within its window
+    void moveTab(quint32 tabId, int index);
+
+    /// Replaces the state of the tab with the same identifier as the given tab
+    void updateTab(const SessionTab &tab);
+
+    /// Appends the pending changes to the journal file, compacting the journal if it has grown large enough.
+    /// Returns true on success, false if the file could not be written
+    bool flush();
+
+    /// Replaces the journal file with a snapshot of the current state. Returns true on success, false if else
+    bool compact();
+
+private:
+    /// Types of records stored in the journal
+    enum class RecordType : quint8
+    {
+        Clear          = 1,
+        OpenWindow     = 2,
+        CloseWindow    = 3,
+        WindowGeometry = 4,
+        CurrentTab     = 5,
+        OpenTab        = 6,
+        CloseTab       = 7,
+        MoveTab        = 8,
+        UpdateTab      = 9
+    };
+
+    /// Applies the record to the session state, and buffers it to be written if it changed the state
+    void record(RecordType type, const QByteArray &payload);
+
+    /// Applies a record to the session state. Returns true if the state was changed, false if else
+    bool applyRecord(RecordType type, const QByteArray &payload);
+
+    /// Returns a journal containing only the records needed to recreate the current state
+    QByteArray createSnapshot() const;
+
+    /// Returns the window with the given identifier, or a nullptr if not found
+    SessionWindow *findWindow(quint32 windowId);
+
+    /// Finds the window containing the tab with the given identifier, and the index of the tab within it.
+    /// Returns a nullptr if the tab was not found
+    SessionWindow *findTab(quint32 tabId, std::size_t &tabIndex);
+
+    /// Appends a framed record to the given buffer
+    static void writeRecord(QByteArray &buffer, RecordType type, const QByteArray &payload);
+
+private:
+    /// Path of the journal file
+    QString m_filePath;
+
+    /// Current state of the session, including changes not yet written to the file
+    SessionState m_state;
+
+    /// Records that have not yet been written to the journal file
+    QByteArray m_pendingRecords;
+
+    /// Size of the journal file, in bytes
+    qint64 m_journalSize;
+
+    /// Size of the journal file after it was last compacted, in bytes
+    qint64 m_snapshotSize;
+
+    /// True if the file must be rewritten instead of appended to, such as after finding a damaged record, false if else
+    bool m_needsCompaction;
+};
+
+#endif // SESSIONJOURNAL_H
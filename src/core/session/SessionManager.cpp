@@ -1,13 +1,21 @@
 #include "SessionManager.h"
 #include "BrowserApplication.h"
 #include "BrowserTabWidget.h"
-#include "CommonUtil.h"
+#include "FaviconManager.h"
 #include "MainWindow.h"
-#include "WebHistory.h"
+#include "Settings.h"
+#include "TabHibernationPolicy.h"
+#include "TabRestoreQueue.h"
 #include "WebWidget.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
 #include <QByteArray>
 #include <QFile>
+#include <QFileInfo>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
@@ -15,10 +23,33 @@
 #include <QString>
 #include <QUrl>
 
+namespace
+{
+    /// Delay between a change to the session and the journal being written, in milliseconds
+    constexpr int FlushDelay = 1000;
+}
+
 SessionManager::SessionManager() :
+    QObject(nullptr),
     m_dataFile(),
-    m_savedSession(false)
+    m_savedSession(false),
+    m_journal(nullptr),
+    m_previousSession(),
+    m_windowIds(),
+    m_tabs(),
+    m_changedTabs(),
+    m_nextId(1),
+    m_flushTimer()
 {
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(FlushDelay);
+    connect(&m_flushTimer, &QTimer::timeout, this, &SessionManager::flushJournal);
+}
+
+SessionManager::~SessionManager()
+{
+    if (isRecording())
+        flushJournal();
 }
 
 bool SessionManager::alreadySaved() const
@@ -29,82 +60,303 @@ bool SessionManager::alreadySaved() const
 void SessionManager::setSessionFile(const QString &fullPath)
 {
     m_dataFile = fullPath;
+
+    const QFileInfo dataFileInfo(m_dataFile);
+    const QString journalFile = QString("%1/%2.journal").arg(dataFileInfo.absolutePath(), dataFileInfo.completeBaseName());
+
+    m_journal = std::make_unique<SessionJournal>(journalFile);
+    if (m_journal->load())
+        m_previousSession = m_journal->getState();
+    else
+        m_previousSession = loadLegacySession();
+
+    // The windows of this session replace the previous session once they are written to the journal
+    m_journal->clear();
+}
+
+void SessionManager::addWindow(MainWindow *window)
+{
+    if (!isRecording() || !window || window->isPrivate() || m_windowIds.contains(window))
+        return;
+
+    const quint32 windowId = m_nextId++;
+    m_windowIds.insert(window, windowId);
+    m_journal->openWindow(windowId);
+
+    BrowserTabWidget *tabWidget = window->getTabWidget();
+    for (int i = 0; i < tabWidget->count(); ++i)
+        addTab(windowId, tabWidget, tabWidget->getWebWidget(i));
+
+    connect(tabWidget, &BrowserTabWidget::newTabCreated, this, [this, windowId, tabWidget](WebWidget *ww){
+        addTab(windowId, tabWidget, ww);
+    });
+    connect(tabWidget, &BrowserTabWidget::tabClosing, this, &SessionManager::closeTab);
+    connect(tabWidget, &BrowserTabWidget::tabPinned, this, [this, tabWidget](int index, bool /*value*/){
+        markTabChanged(tabWidget->getWebWidget(index));
+    });
+    connect(tabWidget, &BrowserTabWidget::tabMoved, this, [this, tabWidget](int /*from*/, int to){
+        auto it = m_tabs.find(tabWidget->getWebWidget(to));
+        if (!isRecording() || it == m_tabs.end())
+            return;
+
+        m_journal->moveTab(it->Id, to);
+        scheduleFlush();
+    });
+    connect(tabWidget, &BrowserTabWidget::currentChanged, this, [this, windowId, tabWidget](int index){
+        auto it = m_tabs.find(tabWidget->getWebWidget(index));
+        if (!isRecording() || it == m_tabs.end())
+            return;
+
+        m_journal->setCurrentTab(windowId, it->Id);
+        scheduleFlush();
+    });
+
+    // A window that is closed while others remain open is no longer part of the session. The last window
+    // is kept, since closing it quits the browser
+    connect(window, &MainWindow::destroyed, this, [this, window, windowId](){
+        m_windowIds.remove(window);
+        if (!isRecording() || m_windowIds.isEmpty())
+            return;
+
+        m_journal->closeWindow(windowId);
+        scheduleFlush();
+    });
+
+    auto currentTab = m_tabs.find(tabWidget->currentWebWidget());
+    if (currentTab != m_tabs.end())
+        m_journal->setCurrentTab(windowId, currentTab->Id);
+
+    scheduleFlush();
 }
 
 void SessionManager::saveState(std::vector<MainWindow*> &windows)
 {
-    QFile dataFile(m_dataFile);
-    if (!dataFile.open(QIODevice::WriteOnly))
+    if (!isRecording())
         return;
 
-    // Construct a QJsonDocument containing an array of windows corresponding to the container passed to this method
-    QJsonObject sessionObj;
-    QJsonArray windowArray;
     for (MainWindow *win : windows)
     {
-        QJsonObject winObj;
-        QJsonArray tabArray;
-
-        // Add each tab's URL to the array
         BrowserTabWidget *tabWidget = win->getTabWidget();
-        int numTabs = tabWidget->count();
-        for (int i = 0; i < numTabs; ++i)
+        for (int i = 0; i < tabWidget->count(); ++i)
+            markTabChanged(tabWidget->getWebWidget(i));
+    }
+
+    flushJournal();
+    m_journal->compact();
+
+    m_savedSession = true;
+}
+
+void SessionManager::restoreSession(MainWindow *firstWindow, BrowserApplication *browserApplication)
+{
+    const SessionState session = std::move(m_previousSession);
+    m_previousSession = SessionState();
+
+    if (session.Windows.empty())
+        return;
+
+    FaviconManager *faviconManager = browserApplication->getFaviconManager();
+    std::vector<QUrl> tabUrls;
+
+    // Background tabs are loaded once the active tab of every window has been restored
+    Settings *settings = browserApplication->getSettings();
+    TabRestoreQueue *restoreQueue = new TabRestoreQueue(settings->getValue(BrowserSetting::SessionRestoreConcurrentLoads).toInt(),
+                                                        browserApplication);
+
+    // Only as many background tabs are loaded as automatic hibernation would keep awake, counting the active tab
+    // of each window. Without automatic hibernation, nothing would put them back to sleep, so they are loaded
+    // when they are activated
+    const TabHibernationPolicy hibernationPolicy = TabHibernationPolicy::fromSettings(settings);
+    int numBackgroundTabs = hibernationPolicy.isEnabled()
+            ? std::max(hibernationPolicy.getMaxAwakeTabs() - static_cast<int>(session.Windows.size()), 0)
+            : 0;
+
+    // Load each tab into the appropriate windows
+    MainWindow *currentWindow = firstWindow;
+    for (const SessionWindow &sessionWindow : session.Windows)
+    {
+        if (currentWindow == nullptr)
+            currentWindow = browserApplication->getNewWindow();
+
+        // Restore window properties
+        if (sessionWindow.IsMaximized)
+            currentWindow->showMaximized();
+        else if (sessionWindow.Geometry.isValid())
+            currentWindow->setGeometry(sessionWindow.Geometry);
+
+        // Restore tabs belonging to the window as placeholders, which only create a web view once they are activated
+        // or their turn comes in the restore queue
+        BrowserTabWidget *tabWidget = currentWindow->getTabWidget();
+
+        auto currentTabIt = std::find_if(sessionWindow.Tabs.begin(), sessionWindow.Tabs.end(), [&sessionWindow](const SessionTab &tab) {
+            return tab.Id == sessionWindow.CurrentTabId;
+        });
+        const int currentTab = currentTabIt != sessionWindow.Tabs.end() ? static_cast<int>(currentTabIt - sessionWindow.Tabs.begin()) : 0;
+
+        // Tabs that were awake when the session was saved, with their distance to the active tab
+        std::vector<std::pair<int, WebWidget*>> awakeTabs;
+
+        int i = 0;
+        for (const SessionTab &sessionTab : sessionWindow.Tabs)
         {
-            WebWidget *ww = tabWidget->getWebWidget(i);
-            if (!ww)
-                continue;
+            WebState webState;
+            webState.title = sessionTab.Title;
+            webState.iconUrl = sessionTab.IconUrl;
+            webState.url = sessionTab.Url;
+            webState.pageHistory = sessionTab.History;
+
+            // Icons that are not cached are loaded in one batch below, and update the tabs once they are available
+            if (faviconManager != nullptr)
+            {
+                webState.icon = faviconManager->getCachedFavicon(sessionTab.Url);
+                tabUrls.push_back(sessionTab.Url);
+            }
 
-            QJsonObject tabInfoObj;
-            tabInfoObj.insert(QLatin1String("url"), QJsonValue(ww->url().toString()));
-            tabInfoObj.insert(QLatin1String("is_pinned"), QJsonValue(tabWidget->isTabPinned(i)));
-            tabInfoObj.insert(QLatin1String("is_hibernating"), QJsonValue(ww->isHibernating()));
-            tabInfoObj.insert(QLatin1String("title"), QJsonValue(ww->getTitle()));
+            // The window already has one tab, which is reused for the first tab of the session
+            WebWidget *ww = nullptr;
+            if (i == 0)
+            {
+                ww = qobject_cast<WebWidget*>(tabWidget->widget(0));
+                if (i == currentTab)
+                    ww->setWebState(std::move(webState));
+                else
+                    ww->setPlaceholderState(std::move(webState));
+            }
+            else
+                ww = tabWidget->newPlaceholderTabAtIndex(i, std::move(webState));
+
+            tabWidget->setTabPinned(i, sessionTab.IsPinned);
 
-            QIcon icon = ww->getIcon();
-            if (icon.isNull())
-                icon = tabWidget->tabIcon(i);
+            if (i != currentTab && !sessionTab.IsHibernating)
+                awakeTabs.push_back(std::make_pair(std::abs(i - currentTab), ww));
 
-            QByteArray faviconB64 = CommonUtil::iconToBase64(icon);
-            auto faviconEncoded = QLatin1String(faviconB64.data());
-            tabInfoObj.insert(QLatin1String("icon"), QJsonValue(faviconEncoded));
-            tabInfoObj.insert(QLatin1String("icon_url"), QJsonValue(ww->getIconUrl().toString()));
+            ++i;
+        }
 
-            QByteArray tabHistoryB64 = ww->getEncodedHistory().toBase64();
-            auto tabHistoryEncoded = QLatin1String(tabHistoryB64.data());
-            tabInfoObj.insert(QLatin1String("history"), QJsonValue(tabHistoryEncoded));
+        // Background tabs are loaded after the active tab of each window, nearest to the active tab first
+        std::stable_sort(awakeTabs.begin(), awakeTabs.end(), [](const std::pair<int, WebWidget*> &a, const std::pair<int, WebWidget*> &b) {
+            return a.first < b.first;
+        });
+        for (const auto &awakeTab : awakeTabs)
+        {
+            if (numBackgroundTabs <= 0)
+                break;
 
-            tabArray.append(QJsonValue(tabInfoObj));
+            restoreQueue->addTab(awakeTab.second);
+            --numBackgroundTabs;
         }
 
-        winObj.insert(QLatin1String("tabs"), QJsonValue(tabArray));
-        winObj.insert(QLatin1String("current_tab"), QJsonValue(tabWidget->currentIndex()));
+        // Set current tab to the last active tab, which loads its page
+        tabWidget->setCurrentIndex(currentTab);
+
+        currentWindow = nullptr;
+    }
+
+    restoreQueue->start();
+
+    if (faviconManager != nullptr)
+        faviconManager->loadFavicons(tabUrls);
+}
+
+void SessionManager::addTab(quint32 windowId, BrowserTabWidget *tabWidget, WebWidget *webWidget)
+{
+    if (!isRecording() || !webWidget || m_tabs.contains(webWidget))
+        return;
 
-        // Store geometry of window
-        const QRect &winGeom = win->geometry();
-        winObj.insert(QLatin1String("geom_x"), QJsonValue(winGeom.x()));
-        winObj.insert(QLatin1String("geom_y"), QJsonValue(winGeom.y()));
-        winObj.insert(QLatin1String("geom_width"), QJsonValue(winGeom.width()));
-        winObj.insert(QLatin1String("geom_height"), QJsonValue(winGeom.height()));
+    const quint32 tabId = m_nextId++;
+    m_tabs.insert(webWidget, TrackedTab { tabId, tabWidget });
+    m_journal->openTab(windowId, tabId, tabWidget->indexOf(webWidget));
+
+    connect(webWidget, &WebWidget::loadFinished,     this, [this, webWidget](){ markTabChanged(webWidget); });
+    connect(webWidget, &WebWidget::urlChanged,       this, [this, webWidget](){ markTabChanged(webWidget); });
+    connect(webWidget, &WebWidget::titleChanged,     this, [this, webWidget](){ markTabChanged(webWidget); });
+    connect(webWidget, &WebWidget::iconUrlChanged,   this, [this, webWidget](){ markTabChanged(webWidget); });
+    connect(webWidget, &WebWidget::aboutToHibernate, this, [this, webWidget](){ markTabChanged(webWidget); });
+    connect(webWidget, &WebWidget::aboutToWake,      this, [this, webWidget](){ markTabChanged(webWidget); });
+    connect(webWidget, &WebWidget::destroyed,        this, [this, webWidget](){
+        m_tabs.remove(webWidget);
+        m_changedTabs.remove(webWidget);
+    });
+
+    markTabChanged(webWidget);
+}
 
-        winObj.insert(QLatin1String("is_maximized"), QJsonValue(win->isMaximized()));
+void SessionManager::closeTab(WebWidget *webWidget)
+{
+    auto it = m_tabs.find(webWidget);
+    if (it == m_tabs.end())
+        return;
 
-        windowArray.append(QJsonValue(winObj));
+    if (isRecording())
+    {
+        m_journal->closeTab(it->Id);
+        scheduleFlush();
     }
-    sessionObj.insert(QLatin1String("windows"), QJsonValue(windowArray));
 
-    // Save to file
-    QJsonDocument sessionDoc(sessionObj);
-    dataFile.write(sessionDoc.toJson());
-    dataFile.close();
+    m_tabs.erase(it);
+    m_changedTabs.remove(webWidget);
+}
 
-    m_savedSession = true;
+void SessionManager::markTabChanged(WebWidget *webWidget)
+{
+    if (!isRecording() || !m_tabs.contains(webWidget))
+        return;
+
+    m_changedTabs.insert(webWidget);
+    scheduleFlush();
 }
 
-void SessionManager::restoreSession(MainWindow *firstWindow, BrowserApplication *browserApplication)
+void SessionManager::scheduleFlush()
+{
+    if (!m_flushTimer.isActive())
+        m_flushTimer.start();
+}
+
+void SessionManager::flushJournal()
+{
+    m_flushTimer.stop();
+
+    for (WebWidget *ww : m_changedTabs)
+    {
+        auto it = m_tabs.find(ww);
+        if (it == m_tabs.end())
+            continue;
+
+        SessionTab tab;
+        tab.Id = it->Id;
+        tab.Url = ww->url();
+        tab.Title = ww->getTitle();
+        tab.IconUrl = ww->getIconUrl();
+        tab.History = ww->getEncodedHistory();
+        tab.IsHibernating = ww->isHibernating();
+        if (!it->TabWidget.isNull())
+            tab.IsPinned = it->TabWidget->isTabPinned(it->TabWidget->indexOf(ww));
+
+        m_journal->updateTab(tab);
+    }
+    m_changedTabs.clear();
+
+    for (auto it = m_windowIds.begin(); it != m_windowIds.end(); ++it)
+    {
+        MainWindow *win = it.key();
+        m_journal->setWindowGeometry(it.value(), win->geometry(), win->isMaximized());
+    }
+
+    m_journal->flush();
+}
+
+bool SessionManager::isRecording() const
+{
+    return m_journal != nullptr && !m_savedSession;
+}
+
+SessionState SessionManager::loadLegacySession() const
 {
+    SessionState session;
+
     QFile dataFile(m_dataFile);
     if (!dataFile.exists() || !dataFile.open(QIODevice::ReadOnly))
-        return;
+        return session;
 
     // Attempt to parse data file
     QByteArray sessionData = dataFile.readAll();
@@ -112,82 +364,62 @@ void SessionManager::restoreSession(MainWindow *firstWindow, BrowserApplication
 
     QJsonDocument sessionDoc(QJsonDocument::fromJson(sessionData));
     if (!sessionDoc.isObject())
-        return;
+        return session;
 
     QJsonObject sessionObj = sessionDoc.object();
     auto it = sessionObj.find(QLatin1String("windows"));
     if (it == sessionObj.end())
-        return;
+        return session;
 
-    // Load each tab into the appropriate windows
-    bool isFirstWindow = true;
-    MainWindow *currentWindow = firstWindow;
+    quint32 nextId = 1;
 
     QJsonArray winArray = it.value().toArray();
     for (auto winIt = winArray.constBegin(); winIt != winArray.constEnd(); ++winIt)
     {
-        if (!isFirstWindow)
-            currentWindow = browserApplication->getNewWindow();
-
-        isFirstWindow = false;
-
         QJsonObject winObject = winIt->toObject();
 
-        // Restore window properties
-        const bool isMaximized = winObject.value(QLatin1String("is_maximized")).toBool(false);
-
-        if (isMaximized)
-            currentWindow->showMaximized();
-        else if (winObject.contains(QLatin1String("geom_x")))
+        SessionWindow window;
+        window.Id = nextId++;
+        window.IsMaximized = winObject.value(QLatin1String("is_maximized")).toBool(false);
+        if (winObject.contains(QLatin1String("geom_x")))
         {
-            QRect winGeom;
-            winGeom.setX(winObject.value(QLatin1String("geom_x")).toInt());
-            winGeom.setY(winObject.value(QLatin1String("geom_y")).toInt());
-            winGeom.setWidth(winObject.value(QLatin1String("geom_width")).toInt(100));
-            winGeom.setHeight(winObject.value(QLatin1String("geom_height")).toInt(100));
-            currentWindow->setGeometry(winGeom);
+            window.Geometry = QRect(winObject.value(QLatin1String("geom_x")).toInt(),
+                                    winObject.value(QLatin1String("geom_y")).toInt(),
+                                    winObject.value(QLatin1String("geom_width")).toInt(100),
+                                    winObject.value(QLatin1String("geom_height")).toInt(100));
         }
 
-        // Restore tabs belonging to the window
-        BrowserTabWidget *tabWidget = currentWindow->getTabWidget();
-
         QJsonArray tabArray = winObject.value(QLatin1String("tabs")).toArray();
-        int i = 0;
         for (auto tabIt = tabArray.constBegin(); tabIt != tabArray.constEnd(); ++tabIt)
         {
+            SessionTab tab;
+            tab.Id = nextId++;
+
             if (tabIt->isString())
-                tabWidget->openLinkInNewTab(QUrl::fromUserInput(tabIt->toString()));
+                tab.Url = QUrl::fromUserInput(tabIt->toString());
             else if (tabIt->isObject())
             {
                 QJsonObject tabInfoObj = tabIt->toObject();
 
-                WebState webState;
-                webState.title = tabInfoObj.value(QLatin1String("title")).toString();
-                webState.iconUrl = QUrl::fromUserInput(tabInfoObj.value(QLatin1String("icon_url")).toString());
-                webState.url = QUrl::fromUserInput(tabInfoObj.value(QLatin1String("url")).toString());
-
-                const QByteArray faviconData = tabInfoObj.value(QLatin1String("icon")).toString().toLatin1();
-                if (!faviconData.isNull())
-                    webState.icon = CommonUtil::iconFromBase64(faviconData);
-
-                const QByteArray encodedHistory = tabInfoObj.value(QLatin1String("history")).toString().toLatin1();
-                webState.pageHistory = QByteArray::fromBase64(encodedHistory);
-
-                WebWidget *ww = (i == 0) ? qobject_cast<WebWidget*>(tabWidget->widget(0)) : tabWidget->newBackgroundTabAtIndex(i);
-
-                tabWidget->setTabPinned(i,
-                                        tabInfoObj.value(QLatin1String("is_pinned")).toBool());
-
-                ww->setHibernation(tabInfoObj.value(QLatin1String("is_hibernating")).toBool());
-
-                ww->setWebState(std::move(webState));
-
-                ++i;
+                tab.Title = tabInfoObj.value(QLatin1String("title")).toString();
+                tab.IconUrl = QUrl::fromUserInput(tabInfoObj.value(QLatin1String("icon_url")).toString());
+                tab.Url = QUrl::fromUserInput(tabInfoObj.value(QLatin1String("url")).toString());
+                tab.History = QByteArray::fromBase64(tabInfoObj.value(QLatin1String("history")).toString().toLatin1());
+                tab.IsPinned = tabInfoObj.value(QLatin1String("is_pinned")).toBool();
+                tab.IsHibernating = tabInfoObj.value(QLatin1String("is_hibernating")).toBool();
             }
+            else
+                continue;
+
+            window.Tabs.push_back(std::move(tab));
         }
 
-        // Set current tab to the last active tab
-        int currentTab = winObject.value(QLatin1String("current_tab")).toInt();
-        tabWidget->setCurrentIndex(currentTab);
+        const int currentTab = winObject.value(QLatin1String("current_tab")).toInt();
+        if (currentTab >= 0 && currentTab < static_cast<int>(window.Tabs.size()))
+            window.CurrentTabId = window.Tabs.at(static_cast<std::size_t>(currentTab)).Id;
+
+        session.Windows.push_back(std::move(window));
     }
+
+    return session;
 }
@@ -1,30 +1,56 @@
 #ifndef SESSIONMANAGER_H
 #define SESSIONMANAGER_H
 
-#include <QString>
+#include "SessionJournal.h"
+
+#include <memory>
 #include <vector>
 
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QSet>
+#include <QString>
+#include <QTimer>
+
 class BrowserApplication;
+class BrowserTabWidget;
 class MainWindow;
+class WebWidget;
 
 /**
  * @class SessionManager
- * @brief Handles the serialization of active browsing sessions when the application is being closed, and the
- *        deserialization of a saved browsing session when the application is being initialized
+ * @brief Records the state of the browsing session as it changes, and restores the previous browsing session
+ *        when the application is being initialized.
+ *
+ * Changes to the windows and tabs of the session are written to a \ref SessionJournal about once per second,
+ * so the session survives the browser being stopped unexpectedly.
  */
-class SessionManager
+class SessionManager : public QObject
 {
+    Q_OBJECT
+
 public:
     /// Default constructor
     SessionManager();
 
+    /// Writes any pending changes to the session journal
+    ~SessionManager();
+
     /// Returns true if the session has already been saved, false if else
     bool alreadySaved() const;
 
-    /// Sets the path of the data file in which session information is stored
+    /**
+     * @brief Sets the path of the data file in which session information was stored by older versions of the browser,
+     *        and loads the previous session from the session journal next to it, or from the data file if there is no journal.
+     *        The windows that are added afterwards replace the previous session in the journal
+     */
     void setSessionFile(const QString &fullPath);
 
-    /// Saves the state of each window in the container
+    /// Starts recording the state of the given window and its tabs in the session journal
+    void addWindow(MainWindow *window);
+
+    /// Records the final state of each window in the container, and writes the session journal
     void saveState(std::vector<MainWindow*> &windows);
 
     /**
@@ -37,11 +63,64 @@ class SessionManager
     void restoreSession(MainWindow *firstWindow, BrowserApplication *browserApplication);
 
 private:
-    /// Path of the file in which session data is stored
+    /// Starts recording the state of a tab belonging to the window with the given identifier
+    void addTab(quint32 windowId, BrowserTabWidget *tabWidget, WebWidget *webWidget);
+
+    /// Records that the tab containing the given web widget has been closed
+    void closeTab(WebWidget *webWidget);
+
+    /// Records that the state of the given tab has changed, to be written with the next flush
+    void markTabChanged(WebWidget *webWidget);
+
+    /// Schedules the pending changes to be written to the journal
+    void scheduleFlush();
+
+    /// Records the state of the changed tabs and the geometry of each window, and writes the journal
+    void flushJournal();
+
+    /// Returns true if changes to the session are being recorded, false if else
+    bool isRecording() const;
+
+    /// Loads a session that was saved by an older version of the browser in the JSON format
+    SessionState loadLegacySession() const;
+
+private:
+    /// Information about a tab whose state is being recorded
+    struct TrackedTab
+    {
+        /// Identifier of the tab in the session journal
+        quint32 Id;
+
+        /// Tab widget containing the tab
+        QPointer<BrowserTabWidget> TabWidget;
+    };
+
+    /// Path of the file in which session data was stored by older versions of the browser
     QString m_dataFile;
 
     /// True if session has already been saved, false if else
     bool m_savedSession;
+
+    /// Journal of the current browsing session
+    std::unique_ptr<SessionJournal> m_journal;
+
+    /// State of the previous browsing session, which is cleared once it has been restored
+    SessionState m_previousSession;
+
+    /// Identifiers of the windows being recorded
+    QHash<MainWindow*, quint32> m_windowIds;
+
+    /// Tabs being recorded, by their web widget
+    QHash<WebWidget*, TrackedTab> m_tabs;
+
+    /// Tabs whose state has changed since the last flush
+    QSet<WebWidget*> m_changedTabs;
+
+    /// Identifier given to the next window or tab
+    quint32 m_nextId;
+
+    /// Timer that writes pending changes to the journal
+    QTimer m_flushTimer;
 };
 
 #endif // SESSIONMANAGER_H
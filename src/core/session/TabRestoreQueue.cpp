@@ -0,0 +1,70 @@
+#include "TabRestoreQueue.h"
+#include "WebWidget.h"
+
+#include <QTimer>
+
+namespace
+{
+    /// Time given to a tab to finish loading before the next tab in the queue is started, in milliseconds
+    constexpr int LoadTimeout = 15000;
+}
+
+TabRestoreQueue::TabRestoreQueue(int maxConcurrentLoads, QObject *parent) :
+    QObject(parent),
+    m_maxConcurrentLoads(maxConcurrentLoads),
+    m_pendingTabs(),
+    m_loadingTabs()
+{
+}
+
+void TabRestoreQueue::addTab(WebWidget *webWidget)
+{
+    if (webWidget)
+        m_pendingTabs.push_back(webWidget);
+}
+
+void TabRestoreQueue::start()
+{
+    // Without any concurrent loads, tabs are only loaded when they are activated
+    if (m_maxConcurrentLoads <= 0)
+    {
+        m_pendingTabs.clear();
+        deleteLater();
+        return;
+    }
+
+    loadNext();
+}
+
+void TabRestoreQueue::loadNext()
+{
+    while (m_loadingTabs.size() < m_maxConcurrentLoads && !m_pendingTabs.empty())
+    {
+        QPointer<WebWidget> webWidget = m_pendingTabs.front();
+        m_pendingTabs.pop_front();
+
+        if (webWidget.isNull() || !webWidget->isPlaceholder())
+            continue;
+
+        WebWidget *ww = webWidget.data();
+        m_loadingTabs.insert(ww);
+
+        connect(ww, &WebWidget::loadFinished, this, [this, ww](){ onTabLoaded(ww); });
+        connect(ww, &WebWidget::destroyed, this, [this, ww](){ onTabLoaded(ww); });
+        QTimer::singleShot(LoadTimeout, this, [this, ww](){ onTabLoaded(ww); });
+
+        ww->setHibernation(false);
+    }
+
+    if (m_loadingTabs.isEmpty() && m_pendingTabs.empty())
+        deleteLater();
+}
+
+void TabRestoreQueue::onTabLoaded(WebWidget *webWidget)
+{
+    if (!m_loadingTabs.remove(webWidget))
+        return;
+
+    disconnect(webWidget, nullptr, this, nullptr);
+    loadNext();
+}
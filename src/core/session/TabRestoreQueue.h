@@ -0,0 +1,51 @@
+#ifndef TABRESTOREQUEUE_H
+#define TABRESTOREQUEUE_H
+
+#include <deque>
+
+#include <QObject>
+#include <QPointer>
+#include <QSet>
+
+class WebWidget;
+
+/**
+ * @class TabRestoreQueue
+ * @brief Loads the pages of restored background tabs in order, with a limit on the number of pages that
+ *        may load at the same time. The queue deletes itself once every tab has been loaded.
+ *
+ * Tabs that are closed, or that are activated by the user before their turn, are skipped.
+ */
+class TabRestoreQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// Constructs the queue with the number of tabs that may load at once, and an optional parent object
+    explicit TabRestoreQueue(int maxConcurrentLoads, QObject *parent = nullptr);
+
+    /// Appends the placeholder web widget of a restored tab to the queue
+    void addTab(WebWidget *webWidget);
+
+    /// Starts loading the tabs in the queue
+    void start();
+
+private:
+    /// Starts loading the next tabs in the queue, until the limit of concurrent loads is reached
+    void loadNext();
+
+    /// Called when the given web widget has finished loading its page, failed to load in time, or was destroyed
+    void onTabLoaded(WebWidget *webWidget);
+
+private:
+    /// Number of tabs that may load at the same time
+    int m_maxConcurrentLoads;
+
+    /// Tabs waiting to be loaded
+    std::deque<QPointer<WebWidget>> m_pendingTabs;
+
+    /// Tabs that are currently loading
+    QSet<WebWidget*> m_loadingTabs;
+};
+
+#endif // TABRESTOREQUEUE_H
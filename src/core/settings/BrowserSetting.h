@@ -22,6 +22,9 @@ enum class BrowserSetting
     /// Path to the bookmarks database file, relative to the storage path
     BookmarkPath,
 
+    /// Path to the cookie database file, relative to the storage path
+    CookiePath,
+
     /// Path to the web extensions database file, relative to the storage path
     ExtensionStoragePath,
 
@@ -130,6 +133,16 @@ enum class BrowserSetting
     /// Determines whether or not all new tabs should be opened in the background, without switching from the current tab
     OpenAllTabsInBackground,
 
+    /// Level of automatic hibernation of background tabs - see \ref TabHibernationMode
+    TabHibernationPolicy,
+
+    /// Memory used by the browser, in megabytes, above which background tabs are hibernated. Zero disables the limit
+    TabHibernationMemoryLimit,
+
+    /// Number of background tabs that may load at the same time while a session is being restored. Zero means background
+    /// tabs are only loaded once they are activated
+    SessionRestoreConcurrentLoads,
+
     /// Standard font
     StandardFont,
 
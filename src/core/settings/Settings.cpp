@@ -1,13 +1,14 @@
 #include "Settings.h"
 
 #include "HistoryManager.h"
+#include "TabHibernationPolicy.h"
 
 #include <QDir>
 #include <QFileInfo>
 #include <QWebEngineSettings>
 #include <QtWebEngineCoreVersion>
 
-const QString Settings::Version = QStringLiteral("1.0");
+const QString Settings::Version = QStringLiteral("1.3");
 
 Settings::Settings() :
     QObject(nullptr),
@@ -38,7 +39,12 @@ Settings::Settings() :
         { BrowserSetting::FantasyFont, QLatin1String("FantasyFont") },                { BrowserSetting::FixedFont, QLatin1String("FixedFont") },
         { BrowserSetting::StandardFontSize, QLatin1String("StandardFontSize") },      { BrowserSetting::EnableAutoFill, QLatin1String("EnableAutoFill") },
         { BrowserSetting::CachePath, QLatin1String("CachePath") },                    { BrowserSetting::ThumbnailPath, QLatin1String("ThumbnailPath") },
-        { BrowserSetting::FavoritePagesFile, QLatin1String("FavoritePagesFile") },    { BrowserSetting::Version, QLatin1String("Version") }
+        { BrowserSetting::FavoritePagesFile, QLatin1String("FavoritePagesFile") },
+        { BrowserSetting::TabHibernationPolicy, QLatin1String("TabHibernationPolicy") },
+        { BrowserSetting::TabHibernationMemoryLimit, QLatin1String("TabHibernationMemoryLimit") },
+        { BrowserSetting::SessionRestoreConcurrentLoads, QLatin1String("SessionRestoreConcurrentLoads") },
+        { BrowserSetting::CookiePath, QLatin1String("CookiePath") },
+        { BrowserSetting::Version, QLatin1String("Version") }
     }
 {
     setObjectName(QLatin1String("Settings"));
@@ -140,6 +146,9 @@ void Settings::setDefaults()
     m_settings.setValue(QLatin1String("HistoryStoragePolicy"), static_cast<int>(HistoryStoragePolicy::Remember));
     m_settings.setValue(QLatin1String("ScrollAnimatorEnabled"), false);
     m_settings.setValue(QLatin1String("OpenAllTabsInBackground"), false);
+    m_settings.setValue(QLatin1String("TabHibernationPolicy"), static_cast<int>(TabHibernationMode::Balanced));
+    m_settings.setValue(QLatin1String("TabHibernationMemoryLimit"), 4096);
+    m_settings.setValue(QLatin1String("SessionRestoreConcurrentLoads"), 3);
 
     QWebEngineSettings *webSettings = QWebEngineSettings::defaultSettings();
     m_settings.setValue(QLatin1String("StandardFont"), webSettings->fontFamily(QWebEngineSettings::StandardFont));
@@ -175,6 +184,16 @@ void Settings::updateSettings()
         m_settings.setValue(QLatin1String("NewTabPage"), static_cast<int>(NewTabType::BlankPage));
         m_settings.setValue(QLatin1String("FavoritePagesFile"), QLatin1String("favorite_pages.json"));
     }
+    if (!ok || versionNumber < 1.1f)
+    {
+        // Existing profiles keep their tabs awake, as they did before automatic hibernation was added
+        m_settings.setValue(QLatin1String("TabHibernationPolicy"), static_cast<int>(TabHibernationMode::Disabled));
+        m_settings.setValue(QLatin1String("TabHibernationMemoryLimit"), 4096);
+    }
+    if (!ok || versionNumber < 1.2f)
+        m_settings.setValue(QLatin1String("SessionRestoreConcurrentLoads"), 3);
+    if (!ok || versionNumber < 1.3f)
+        m_settings.setValue(QLatin1String("CookiePath"), QLatin1String("cookies.db"));
 
     m_settings.setValue(QLatin1String("Version"), Version);
 }
@@ -8,6 +8,7 @@ DatabaseTaskScheduler::DatabaseTaskScheduler() :
     m_cv(),
     m_thread(nullptr),
     m_tasks(),
+    m_idleTasks(),
     m_initCallbacks(),
     m_working(false)
 {
@@ -38,6 +39,13 @@ void DatabaseTaskScheduler::post(std::function<void()> &&work)
     m_cv.notify_one();
 }
 
+void DatabaseTaskScheduler::postIdle(std::function<void()> &&work)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_idleTasks.push_back(std::move(work));
+    m_cv.notify_one();
+}
+
 void DatabaseTaskScheduler::addWorker(const std::string &name, std::function<std::unique_ptr<DatabaseWorker>()> construction)
 {
     m_workersToCreate.push_back({name, construction});
@@ -67,6 +75,11 @@ void DatabaseTaskScheduler::stop()
     }
 }
 
+bool DatabaseTaskScheduler::isRunning() const
+{
+    return m_thread != nullptr;
+}
+
 void DatabaseTaskScheduler::workerThread()
 {
     for (auto &&workerInfo : m_workersToCreate)
@@ -83,14 +96,16 @@ void DatabaseTaskScheduler::workerThread()
     {
         std::unique_lock<std::mutex> lock{m_mutex};
         m_cv.wait(lock, [this](){
-            return !m_tasks.empty() || !m_working;
+            return !m_tasks.empty() || !m_idleTasks.empty() || !m_working;
         });
 
         if (!m_working && m_tasks.empty())
             break;
 
-        std::function<void()> task = std::move(m_tasks.front());
-        m_tasks.pop_front();
+        // Low priority tasks only run once all other pending work is done
+        std::deque<std::function<void()>> &queue = m_tasks.empty() ? m_idleTasks : m_tasks;
+        std::function<void()> task = std::move(queue.front());
+        queue.pop_front();
         lock.unlock();
 
         task();
@@ -52,6 +52,10 @@ class DatabaseTaskScheduler
     /// Posts a task to the end of the work queue
     void post(std::function<void()> &&work);
 
+    /// Posts a low priority task, such as database maintenance, which only runs when the work queue
+    /// is empty. Idle tasks that have not started by the time the scheduler stops are discarded
+    void postIdle(std::function<void()> &&work);
+
     /// Adds a database worker to the pool of workers. It will be constructed after calling the run() method.
     /// Anything registered with this method after calling run() will not be instantiated
     void addWorker(const std::string &name, std::function<std::unique_ptr<DatabaseWorker>()> construction);
@@ -62,6 +66,9 @@ class DatabaseTaskScheduler
     /// Stops the worker thread
     void stop();
 
+    /// Returns true if the worker thread has been started and not yet stopped, false if else
+    bool isRunning() const;
+
 private:
     /// Main loop of the worker thread
     void workerThread();
@@ -86,6 +93,9 @@ class DatabaseTaskScheduler
     /// Pending tasks
     std::deque<std::function<void()>> m_tasks;
 
+    /// Pending low priority tasks
+    std::deque<std::function<void()>> m_idleTasks;
+
     /// Callbacks to be executed after insantiating all of the database workers in the worker thread
     std::vector<std::function<void()>> m_initCallbacks;
 
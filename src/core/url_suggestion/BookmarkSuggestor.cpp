@@ -1,22 +1,19 @@
-#include "BookmarkManager.h"
-#include "BookmarkNode.h"
 #include "BookmarkSuggestor.h"
 #include "CommonUtil.h"
 #include "FastHash.h"
-#include "HistoryManager.h"
-#include "Settings.h"
+#include "FaviconManager.h"
+#include "URLSuggestionIndex.h"
 
-void BookmarkSuggestor::setServiceLocator(const ViperServiceLocator &serviceLocator)
+BookmarkSuggestor::BookmarkSuggestor(const URLSuggestionIndex &index) :
+    IURLSuggestor(),
+    m_index(index),
+    m_faviconManager(nullptr)
 {
-    m_bookmarkManager = serviceLocator.getServiceAs<BookmarkManager>("BookmarkManager");
-    m_historyManager  = serviceLocator.getServiceAs<HistoryManager>("HistoryManager");
+}
 
-    /*
-    if (Settings *settings = serviceLocator.getServiceAs<Settings>("Settings"))
-    {
-        m_databaseFile = settings->getPathValue(BrowserSetting::BookmarkPath);
-    }
-    */
+void BookmarkSuggestor::setServiceLocator(const ViperServiceLocator &serviceLocator)
+{
+    m_faviconManager = serviceLocator.getServiceAs<FaviconManager>("FaviconManager");
 }
 
 std::vector<URLSuggestion> BookmarkSuggestor::getSuggestions(const std::atomic_bool &working,
@@ -25,39 +22,33 @@ std::vector<URLSuggestion> BookmarkSuggestor::getSuggestions(const std::atomic_b
                                                              const FastHashParameters &hashParams)
 {
     std::vector<URLSuggestion> result;
-    if (!m_bookmarkManager || !m_historyManager)
-        return result;
 
     const int maxToSuggest = 20;
     int numSuggested = 0;
 
-    const QRegularExpression prefixExpr = QRegularExpression(QLatin1String("^WWW\\."));
     const bool inputStartsWithWww = searchTerm.size() >= 3 && searchTerm.startsWith(QLatin1String("WWW"));
 
-    for (const auto &it : *m_bookmarkManager)
+    for (URLSuggestionIndex::EntryId id : m_index.getBookmarks())
     {
         if (!working.load())
             return result;
 
-        if (it->getType() != BookmarkNode::Bookmark)
-            continue;
-
-        const QString url = it->getURL().toString();
+        const IndexedURL &entry = m_index.getEntry(id);
         MatchType matchType = getMatchType(searchTerm,
                                            searchTermParts,
                                            hashParams,
-                                           it->getName().toUpper(),
-                                           url.toUpper(),
-                                           it->getShortcut().toUpper());
+                                           entry.BookmarkNameUpper,
+                                           entry.URLUpper,
+                                           entry.Shortcut);
 
         if (matchType == MatchType::None)
             continue;
 
-        URLSuggestion suggestion { it, m_historyManager->getEntry(it->getURL()), matchType };
+        URLSuggestion suggestion { entry, m_faviconManager ? m_faviconManager->getCachedFavicon(entry.URL) : QIcon(), matchType };
 
-        QString suggestionHost = it->getURL().host().toUpper();
-        if (!inputStartsWithWww)
-            suggestionHost = suggestionHost.replace(prefixExpr, QString());
+        QString suggestionHost = entry.URL.host().toUpper();
+        if (!inputStartsWithWww && suggestionHost.startsWith(QLatin1String("WWW.")))
+            suggestionHost.remove(0, 4);
         suggestion.IsHostMatch = suggestionHost.startsWith(searchTerm);
 
         result.push_back(suggestion);
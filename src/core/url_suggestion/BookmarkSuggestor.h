@@ -4,21 +4,23 @@
 #include "IURLSuggestor.h"
 #include "URLSuggestionListModel.h"
 
-class BookmarkManager;
-class HistoryManager;
+class FaviconManager;
+class URLSuggestionIndex;
 
 /**
  * @class BookmarkSuggestor
  * @brief Handles URL suggestions that rely on the user's bookmark
- *        collection as a data source.
+ *        collection as a data source. Bookmarks are read from the
+ *        \ref URLSuggestionIndex , which holds their names, URLs and
+ *        shortcuts in a pre-normalized form.
  */
 class BookmarkSuggestor final : public IURLSuggestor
 {
 public:
-    /// Default constructor
-    BookmarkSuggestor() = default;
+    /// Constructs the bookmark suggestor with a reference to the suggestion index
+    explicit BookmarkSuggestor(const URLSuggestionIndex &index);
 
-    /// Injects the bookmark manager dependency, which is needed to make any suggestions for the user
+    /// Injects the favicon manager dependency, which is used to fetch the icons of suggested bookmarks
     void setServiceLocator(const ViperServiceLocator &serviceLocator) override;
 
     /// Suggests bookmarks to the user, based on the given input
@@ -42,14 +44,11 @@ class BookmarkSuggestor final : public IURLSuggestor
     MatchType getMatchTypeForSmallSearchTerm(const QString &searchTerm, const QString &title, const QString &url);
 
 private:
-    /// Used to compare bookmarks to any search term
-    BookmarkManager *m_bookmarkManager;
+    /// Contains the bookmarks that are compared to any search term
+    const URLSuggestionIndex &m_index;
 
-    /// Used to fetch metadata about bookmark URL entries
-    HistoryManager *m_historyManager;
-
-    /// String representing the location of the bookmark database
-    //QString m_databaseFile;
+    /// Gathers icons which are sent in the suggestion results
+    FaviconManager *m_faviconManager;
 };
 
 #endif // BOOKMARKSUGGESTOR_H
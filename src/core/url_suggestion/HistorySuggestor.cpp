@@ -2,10 +2,8 @@
 #include "FastHash.h"
 #include "FaviconManager.h"
 #include "HistorySuggestor.h"
-#include "Settings.h"
 #include "URLRecord.h"
-
-#include "SQLiteWrapper.h"
+#include "URLSuggestionIndex.h"
 
 #include <algorithm>
 #include <numeric>
@@ -18,20 +16,27 @@
 
 #include <QDebug>
 
-void HistorySuggestor::setServiceLocator(const ViperServiceLocator &serviceLocator)
+namespace
 {
-    m_bookmarkManager = serviceLocator.getServiceAs<BookmarkManager>("BookmarkManager");
-    m_faviconManager  = serviceLocator.getServiceAs<FaviconManager>("FaviconManager");
+    /// Minimum length of a term that can be looked up in the trigram index
+    constexpr int MinIndexedTermLength = 3;
+}
 
-    if (Settings *settings = serviceLocator.getServiceAs<Settings>("Settings"))
-    {
-        m_historyDatabaseFile = settings->getPathValue(BrowserSetting::HistoryPath);
-    }
+HistorySuggestor::HistorySuggestor(const URLSuggestionIndex &index) :
+    IURLSuggestor(),
+    m_bookmarkManager(nullptr),
+    m_faviconManager(nullptr),
+    m_index(index),
+    m_previousSearchTerm(),
+    m_previousMatches(),
+    m_previousRevision(0)
+{
 }
 
-void HistorySuggestor::setHistoryFile(const QString &historyDbFile)
+void HistorySuggestor::setServiceLocator(const ViperServiceLocator &serviceLocator)
 {
-    m_historyDatabaseFile = historyDbFile;
+    m_bookmarkManager = serviceLocator.getServiceAs<BookmarkManager>("BookmarkManager");
+    m_faviconManager  = serviceLocator.getServiceAs<FaviconManager>("FaviconManager");
 }
 
 std::vector<URLSuggestion> HistorySuggestor::getSuggestions(const std::atomic_bool &working,
@@ -39,74 +44,10 @@ std::vector<URLSuggestion> HistorySuggestor::getSuggestions(const std::atomic_bo
                                                             const QStringList &searchTermParts,
                                                             const FastHashParameters &/*hashParams*/)
 {
-    std::vector<URLSuggestion> result;
-
-    if (!m_faviconManager || m_historyDatabaseFile.isEmpty())
-        return result;
-
-    if (!m_historyDb)
-        setupConnection();
-
-    if (!m_historyDb || !m_historyDb->isValid())
-        return result;
-
-    const QString fullTermParam = QString("%%1%").arg(searchTerm);
-
-    sqlite::PreparedStatement &stmt = m_statements.at(Statement::SearchByWholeInput);
-    stmt.reset();
-    stmt << fullTermParam
-         << fullTermParam;
-    if (stmt.execute())
-    {
-        auto fullTermResult = getSuggestionsFromQuery(working, searchTerm, MatchType::URL, stmt);
-        result.insert(result.end(), std::make_move_iterator(fullTermResult.begin()), std::make_move_iterator(fullTermResult.end()));
-        if (!working.load())
-            return result;
-    }
-
-    if (searchTermParts.size() == 1)
-        return result;
-
-    // Sort search words by their string length, in descending order
-    std::vector<QString> searchWords;
-    searchWords.reserve(static_cast<size_t>(searchTermParts.size()));
-    for (const QString &word : searchTermParts)
-        searchWords.push_back(word);
-
-    std::sort(searchWords.begin(), searchWords.end(), [](const QString &a, const QString &b) -> bool {
-        return a.length() > b.length();
-    });
-
-    sqlite::PreparedStatement &stmtWords = m_statements.at(Statement::SearchBySingleWord);
+    if (!m_faviconManager)
+        return std::vector<URLSuggestion>();
 
-    for (const QString &word : searchWords)
-    {
-        if (!working.load())
-            return result;
-
-        QString wordTemp = word.size() < 4 ? QString("%%1%") : QString("%1%");
-        wordTemp = wordTemp.arg(word.trimmed().toUpper());
-        const std::string wordStdBinding = wordTemp.toStdString();
-
-        stmtWords.reset();
-        stmtWords << wordStdBinding;
-
-        if (!stmtWords.execute())
-            continue;
-
-        auto wordQueryResult = getSuggestionsFromQuery(working, searchTerm, MatchType::SearchWords, stmtWords);
-        for (auto& suggestion : wordQueryResult)
-        {
-            auto match = std::find_if(result.begin(), result.end(), [&suggestion](const URLSuggestion &other){
-                return other.HistoryId == suggestion.HistoryId;
-            });
-
-            if (match == result.end())
-                result.emplace_back(std::move(suggestion));
-        }
-    }
-
-    return result;
+    return getSuggestionsFromIndex(working, searchTerm, searchTermParts);
 }
     /*
                 std::vector<QString> historyWords = getHistoryEntryWords(record.getVisitId());
@@ -149,70 +90,141 @@ std::vector<URLSuggestion> HistorySuggestor::getSuggestions(const std::atomic_bo
             }
     */
 
-std::vector<URLSuggestion> HistorySuggestor::getSuggestionsFromQuery(const std::atomic_bool &working,
+std::vector<URLSuggestion> HistorySuggestor::getSuggestionsFromIndex(const std::atomic_bool &working,
                                                                      const QString &searchTerm,
-                                                                     MatchType queryMatchType,
-                                                                     sqlite::PreparedStatement &query)
+                                                                     const QStringList &searchTermParts)
 {
-    constexpr int maxToSuggest = 25;
-    int numSuggested = 0;
+    std::vector<URLSuggestion> result;
 
-    // Strip www prefix from urls when user does not also have this in the search term
-    const QRegularExpression prefixExpr = QRegularExpression(QLatin1String("^WWW\\."));
-    const bool inputStartsWithWww = searchTerm.size() >= 3 && searchTerm.startsWith(QLatin1String("WWW"));
+    appendIndexMatches(working, searchTerm, MatchType::URL, findIndexMatches(searchTerm), 25, result);
 
-    const VisitEntry cutoffTime = QDateTime::currentDateTime().addSecs(-864000);
+    if (searchTermParts.size() == 1)
+        return result;
 
-    std::vector<URLSuggestion> result;
+    // Sort search words by their string length, in descending order
+    std::vector<QString> searchWords;
+    searchWords.reserve(static_cast<size_t>(searchTermParts.size()));
+    for (const QString &word : searchTermParts)
+    {
+        if (word.trimmed().size() >= MinIndexedTermLength)
+            searchWords.push_back(word.trimmed());
+    }
+
+    std::sort(searchWords.begin(), searchWords.end(), [](const QString &a, const QString &b) -> bool {
+        return a.length() > b.length();
+    });
 
-    while (query.next())
+    for (const QString &word : searchWords)
     {
         if (!working.load())
             return result;
 
-        HistoryEntry entry;
-        query >> entry;
+        appendIndexMatches(working, searchTerm, MatchType::SearchWords, m_index.findBySubstring(word), 5, result);
+    }
+
+    return result;
+}
+
+std::vector<URLSuggestionIndex::EntryId> HistorySuggestor::findIndexMatches(const QString &searchTerm)
+{
+    // Any entry matching an extended term also matched the shorter one, provided that the index has not
+    // changed since, and that the host prefix of the term was not changed by the removal of "www."
+    const bool canNarrowPreviousMatches = URLSuggestionIndex::isNarrowingOf(m_previousSearchTerm, searchTerm)
+            && m_previousRevision == m_index.getRevision();
+
+    std::vector<URLSuggestionIndex::EntryId> matches;
+    if (canNarrowPreviousMatches)
+    {
+        matches = m_index.filterMatches(m_previousMatches, searchTerm);
+    }
+    else
+    {
+        // Match the whole input against the start of each host, as well as any part of the URL or title
+        matches = m_index.findByHostPrefix(searchTerm);
+        std::vector<URLSuggestionIndex::EntryId> substringMatches = m_index.findBySubstring(searchTerm);
+        matches.insert(matches.end(), substringMatches.begin(), substringMatches.end());
+
+        std::sort(matches.begin(), matches.end());
+        matches.erase(std::unique(matches.begin(), matches.end()), matches.end());
+    }
 
-        if (entry.URLTypedCount < 1
-                && entry.NumVisits < 4
-                && entry.LastVisit < cutoffTime)
-            continue;
+    m_previousSearchTerm = searchTerm;
+    m_previousMatches = matches;
+    m_previousRevision = m_index.getRevision();
 
-        std::vector<VisitEntry> emptyVisits;
-        URLRecord urlRecord{ std::move(entry), std::move(emptyVisits) };
+    return matches;
+}
 
-        URLSuggestion suggestion { urlRecord, m_faviconManager->getFavicon(urlRecord.getUrl()), queryMatchType };
+void HistorySuggestor::appendIndexMatches(const std::atomic_bool &working,
+                                          const QString &searchTerm,
+                                          MatchType matchType,
+                                          std::vector<URLSuggestionIndex::EntryId> matches,
+                                          size_t limit,
+                                          std::vector<URLSuggestion> &result)
+{
+    const VisitEntry cutoffTime = QDateTime::currentDateTime().addSecs(-864000);
 
-        QString suggestionHost = urlRecord.getUrl().host().toUpper();
-        if (!inputStartsWithWww)
-            suggestionHost = suggestionHost.replace(prefixExpr, QString());
-        suggestion.IsHostMatch = searchTerm.startsWith(suggestionHost);
+    std::sort(matches.begin(), matches.end());
+    matches.erase(std::unique(matches.begin(), matches.end()), matches.end());
+
+    matches.erase(std::remove_if(matches.begin(), matches.end(), [&](URLSuggestionIndex::EntryId id) {
+        const IndexedURL &entry = m_index.getEntry(id);
+        if (!entry.IsHistory)
+            return true;
+
+        if (entry.URLTypedCount < 1 && entry.VisitCount < 4 && entry.LastVisit < cutoffTime)
+            return true;
+
+        // Entries that were added by visits have no history identifier yet, so compare their URLs
+        const QString entryUrl = entry.URL.toString();
+        return std::find_if(result.begin(), result.end(), [&entryUrl](const URLSuggestion &other){
+            return other.URL == entryUrl;
+        }) != result.end();
+    }), matches.end());
+
+    // Keep the most frequently visited matches, as the history database query would
+    const size_t numToSuggest = std::min(limit, matches.size());
+    std::partial_sort(matches.begin(), matches.begin() + static_cast<std::ptrdiff_t>(numToSuggest), matches.end(),
+                      [this](URLSuggestionIndex::EntryId a, URLSuggestionIndex::EntryId b) {
+        const IndexedURL &entryA = m_index.getEntry(a), &entryB = m_index.getEntry(b);
+        if (entryA.VisitCount != entryB.VisitCount)
+            return entryA.VisitCount > entryB.VisitCount;
+        return entryA.URLTypedCount > entryB.URLTypedCount;
+    });
 
-        result.push_back(suggestion);
-        if (++numSuggested >= maxToSuggest)
-            return result;
+    for (size_t i = 0; i < numToSuggest; ++i)
+    {
+        if (!working.load())
+            return;
+
+        const IndexedURL &indexedUrl = m_index.getEntry(matches[i]);
+
+        HistoryEntry entry;
+        entry.VisitID = indexedUrl.HistoryId;
+        entry.URL = indexedUrl.URL;
+        entry.Title = indexedUrl.Title;
+        entry.LastVisit = indexedUrl.LastVisit;
+        entry.NumVisits = indexedUrl.VisitCount;
+        entry.URLTypedCount = indexedUrl.URLTypedCount;
+
+        result.push_back(createSuggestion(std::move(entry), searchTerm, matchType));
     }
-    return result;
 }
 
-void HistorySuggestor::setupConnection()
+URLSuggestion HistorySuggestor::createSuggestion(HistoryEntry &&entry, const QString &searchTerm, MatchType matchType)
 {
-    m_historyDb = std::make_unique<sqlite::Database>(m_historyDatabaseFile.toStdString());
-    m_statements.insert(std::make_pair(Statement::SearchByWholeInput,
-                                       m_historyDb->prepare(R"(SELECT H.VisitID, H.URL, H.Title, H.URLTypedCount, V.VisitCount, V.RecentVisit
-                                                            FROM History AS H INNER JOIN
-                                                            (SELECT VisitID, MAX(Date) AS RecentVisit, COUNT(Date) AS VisitCount FROM Visits INDEXED BY Visit_ID_Index GROUP BY VisitID) AS V
-                                                            ON H.VisitID = V.VisitID
-                                                            WHERE H.Title LIKE ? OR H.URL LIKE ?
-                                                            ORDER BY V.VisitCount DESC, H.URLTypedCount DESC LIMIT 25)")));
-    m_statements.insert(std::make_pair(Statement::SearchBySingleWord,
-                                       m_historyDb->prepare(R"(SELECT U.HistoryID, H.URL, H.Title, H.URLTypedCount, V.VisitCount, V.RecentVisit
-                                                            FROM URLWords AS U INNER JOIN Words
-                                                              ON U.WordID = Words.WordID
-                                                            INNER JOIN History AS H
-                                                              ON U.HistoryID = H.VisitID
-                                                            INNER JOIN (SELECT VisitID, MAX(Date) AS RecentVisit, COUNT(Date) AS VisitCount FROM Visits INDEXED BY Visit_ID_Index GROUP BY VisitID) AS V
-                                                              ON H.VisitID = V.VisitID
-                                                            WHERE Words.Word LIKE ?
-                                                            ORDER BY V.VisitCount DESC, V.RecentVisit DESC, H.URLTypedCount DESC LIMIT 5)")));
+    std::vector<VisitEntry> emptyVisits;
+    URLRecord urlRecord{ std::move(entry), std::move(emptyVisits) };
+
+    URLSuggestion suggestion { urlRecord, m_faviconManager->getCachedFavicon(urlRecord.getUrl()), matchType };
+
+    // Strip www prefix from urls when user does not also have this in the search term
+    const bool inputStartsWithWww = searchTerm.size() >= 3 && searchTerm.startsWith(QLatin1String("WWW"));
+
+    QString suggestionHost = urlRecord.getUrl().host().toUpper();
+    if (!inputStartsWithWww && suggestionHost.startsWith(QLatin1String("WWW.")))
+        suggestionHost.remove(0, 4);
+    suggestion.IsHostMatch = searchTerm.startsWith(suggestionHost);
+
+    return suggestion;
 }
@@ -2,20 +2,15 @@
 #define HISTORYSUGGESTOR_H
 
 #include "IURLSuggestor.h"
+#include "URLRecord.h"
+#include "URLSuggestionIndex.h"
 #include "URLSuggestionListModel.h"
 
-#include <map>
 #include <vector>
 
 class BookmarkManager;
 class FaviconManager;
 
-namespace sqlite
-{
-    class Database;
-    class PreparedStatement;
-}
-
 /**
  * @class HistorySuggestor
  * @brief Handles URL suggestions that rely on the user's browsing history
@@ -23,16 +18,9 @@ namespace sqlite
  */
 class HistorySuggestor final : public IURLSuggestor
 {
-    /// Prepared statement types
-    enum class Statement
-    {
-        SearchByWholeInput,
-        SearchBySingleWord
-    };
-
 public:
-    /// Default constructor
-    HistorySuggestor() = default;
+    /// Constructs the history suggestor, which answers suggestions from the given in-memory index
+    explicit HistorySuggestor(const URLSuggestionIndex &index);
 
     /// Default destructor
     ~HistorySuggestor() = default;
@@ -40,10 +28,6 @@ class HistorySuggestor final : public IURLSuggestor
     /// Injects the history manager and favicon manager dependencies
     void setServiceLocator(const ViperServiceLocator &serviceLocator) override;
 
-    /// Specifies which history database file the suggestor should use. If not set, the
-    /// suggestor will use the application settings to get the value
-    void setHistoryFile(const QString &historyDbFile);
-
     /// Suggests history entries to the user, based on their text input
     std::vector<URLSuggestion> getSuggestions(const std::atomic_bool &working,
                                               const QString &searchTerm,
@@ -51,14 +35,26 @@ class HistorySuggestor final : public IURLSuggestor
                                               const FastHashParameters &hashParams) override;
 
 private:
-    /// Returns a list of URL suggestions based on the result of a history suggestion query
-    std::vector<URLSuggestion> getSuggestionsFromQuery(const std::atomic_bool &working,
+    /// Returns a list of URL suggestions found in the in-memory suggestion index
+    std::vector<URLSuggestion> getSuggestionsFromIndex(const std::atomic_bool &working,
                                                        const QString &searchTerm,
-                                                       MatchType queryMatchType,
-                                                       sqlite::PreparedStatement &query);
+                                                       const QStringList &searchTermParts);
 
-    /// Connects to the history database and creates the prepared statement cache
-    void setupConnection();
+    /// Returns the entries of the index whose host begins with, or whose URL or title contains, the search term.
+    /// When the term extends that of the previous search, the previous matches are narrowed rather than re-queried
+    std::vector<URLSuggestionIndex::EntryId> findIndexMatches(const QString &searchTerm);
+
+    /// Converts the most frequently visited of the given index matches into suggestions, up to the given limit,
+    /// appending those that are not stale and not already present in the result set
+    void appendIndexMatches(const std::atomic_bool &working,
+                            const QString &searchTerm,
+                            MatchType matchType,
+                            std::vector<URLSuggestionIndex::EntryId> matches,
+                            size_t limit,
+                            std::vector<URLSuggestion> &result);
+
+    /// Creates a suggestion from the given history entry and search term
+    URLSuggestion createSuggestion(HistoryEntry &&entry, const QString &searchTerm, MatchType matchType);
 
 private:
     /// Determines whether or not a suggestion is also a bookmark
@@ -67,14 +63,17 @@ class HistorySuggestor final : public IURLSuggestor
     /// Gathers icons which are sent in the suggestion results
     FaviconManager *m_faviconManager;
 
-    /// History database handle
-    std::unique_ptr<sqlite::Database> m_historyDb;
+    /// In-memory suggestion index of the browsing history
+    const URLSuggestionIndex &m_index;
+
+    /// Search term of the last index search, used to narrow the next search when the user keeps typing
+    QString m_previousSearchTerm;
 
-    /// Stores the location of the history database
-    QString m_historyDatabaseFile;
+    /// Untruncated entries of the index that matched the last search term
+    std::vector<URLSuggestionIndex::EntryId> m_previousMatches;
 
-    /// Prepared statements used by the suggestor
-    std::map<Statement, sqlite::PreparedStatement> m_statements;
+    /// Revision of the index at the time of the last search
+    uint64_t m_previousRevision;
 };
 
 #endif // HISTORYSUGGESTOR_H
@@ -1,6 +1,7 @@
 #include "BookmarkNode.h"
 #include "URLRecord.h"
 #include "URLSuggestion.h"
+#include "URLSuggestionIndex.h"
 
 URLSuggestion::URLSuggestion(const BookmarkNode *bookmark, const HistoryEntry &historyEntry, MatchType matchType) :
     Favicon(bookmark->getIcon()),
@@ -31,3 +32,18 @@ URLSuggestion::URLSuggestion(const URLRecord &record, const QIcon &icon, MatchTy
     HistoryId(record.getVisitId())
 {
 }
+
+URLSuggestion::URLSuggestion(const IndexedURL &entry, const QIcon &icon, MatchType matchType) :
+    Favicon(icon),
+    Title(entry.IsBookmark ? entry.BookmarkName : entry.Title),
+    URL(entry.URL.toString()),
+    LastVisit(entry.LastVisit),
+    URLTypedCount(entry.URLTypedCount),
+    VisitCount(entry.VisitCount),
+    PercentMatch(0),
+    IsHostMatch(false),
+    IsBookmark(entry.IsBookmark),
+    Type(matchType),
+    HistoryId(entry.HistoryId)
+{
+}
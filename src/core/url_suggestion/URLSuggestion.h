@@ -8,6 +8,7 @@
 
 class BookmarkNode;
 struct HistoryEntry;
+struct IndexedURL;
 class URLRecord;
 
 /**
@@ -43,6 +44,10 @@ struct URLSuggestion
     /// Constructs the URL suggestion from a history record, an icon and the type of search term match
     URLSuggestion(const URLRecord &record, const QIcon &icon, MatchType matchType);
 
+    /// Constructs the URL suggestion from an entry in the \ref URLSuggestionIndex , an icon and the type of search term match.
+    /// Bookmarked entries are titled by their bookmark name
+    URLSuggestion(const IndexedURL &entry, const QIcon &icon, MatchType matchType);
+
     /// Icon associated with the url
     QIcon Favicon;
 
@@ -0,0 +1,363 @@
+#include "URLSuggestionIndex.h"
+#include "URLRecord.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+namespace
+{
+    /// Number of characters in a single trigram
+    constexpr int TrigramLength = 3;
+
+    /// Returns the upper-case host of the given URL, without any "www." prefix
+    QString getNormalizedHost(const QUrl &url)
+    {
+        QString host = url.host().toUpper();
+        if (host.startsWith(QLatin1String("WWW.")))
+            host.remove(0, 4);
+        return host;
+    }
+}
+
+URLSuggestionIndex::URLSuggestionIndex() :
+    m_entries(),
+    m_entryIds(),
+    m_hosts(),
+    m_postings(),
+    m_bookmarks(),
+    m_revision(0),
+    m_isLoading(false)
+{
+}
+
+void URLSuggestionIndex::clear()
+{
+    m_entries.clear();
+    m_entryIds.clear();
+    m_hosts.clear();
+    m_postings.clear();
+    m_bookmarks.clear();
+    ++m_revision;
+}
+
+void URLSuggestionIndex::clearBookmarks()
+{
+    // Entries are never removed, as their identifiers are referenced by the host array and
+    // posting lists. Stale postings are filtered out when candidates are verified
+    for (EntryId id : m_bookmarks)
+    {
+        IndexedURL &entry = m_entries[id];
+        entry.IsBookmark = false;
+        entry.BookmarkName.clear();
+        entry.BookmarkNameUpper.clear();
+        entry.Shortcut.clear();
+    }
+
+    m_bookmarks.clear();
+    ++m_revision;
+}
+
+void URLSuggestionIndex::clearHistory()
+{
+    for (IndexedURL &entry : m_entries)
+    {
+        entry.LastVisit = QDateTime();
+        entry.HistoryId = -1;
+        entry.VisitCount = 0;
+        entry.URLTypedCount = 0;
+        entry.IsHistory = false;
+    }
+
+    ++m_revision;
+}
+
+void URLSuggestionIndex::swap(URLSuggestionIndex &other)
+{
+    const uint64_t revision = std::max(m_revision, other.m_revision) + 1;
+
+    std::swap(m_entries, other.m_entries);
+    std::swap(m_entryIds, other.m_entryIds);
+    std::swap(m_hosts, other.m_hosts);
+    std::swap(m_postings, other.m_postings);
+    std::swap(m_bookmarks, other.m_bookmarks);
+    std::swap(m_isLoading, other.m_isLoading);
+
+    m_revision = revision;
+    other.m_revision = revision;
+}
+
+void URLSuggestionIndex::beginLoading()
+{
+    m_isLoading = true;
+}
+
+void URLSuggestionIndex::finishLoading()
+{
+    if (!m_isLoading)
+        return;
+
+    m_isLoading = false;
+
+    std::sort(m_hosts.begin(), m_hosts.end());
+
+    for (auto &it : m_postings)
+    {
+        std::vector<EntryId> &postings = it.second;
+        std::sort(postings.begin(), postings.end());
+        postings.erase(std::unique(postings.begin(), postings.end()), postings.end());
+        postings.shrink_to_fit();
+    }
+}
+
+void URLSuggestionIndex::addHistoryEntry(const HistoryEntry &entry)
+{
+    const EntryId id = getOrCreateEntry(entry.URL);
+    IndexedURL &indexedUrl = m_entries[id];
+
+    indexedUrl.HistoryId = entry.VisitID;
+    indexedUrl.LastVisit = entry.LastVisit;
+    indexedUrl.VisitCount = entry.NumVisits;
+    indexedUrl.URLTypedCount = entry.URLTypedCount;
+    indexedUrl.IsHistory = true;
+    ++m_revision;
+
+    if (indexedUrl.Title != entry.Title)
+    {
+        indexedUrl.Title = entry.Title;
+        indexedUrl.TitleUpper = entry.Title.toUpper();
+        indexText(id, indexedUrl.TitleUpper);
+    }
+}
+
+void URLSuggestionIndex::addVisit(const QUrl &url, const QString &title, const QDateTime &visitTime)
+{
+    const EntryId id = getOrCreateEntry(url);
+    IndexedURL &indexedUrl = m_entries[id];
+
+    indexedUrl.IsHistory = true;
+    indexedUrl.VisitCount++;
+    ++m_revision;
+
+    if (!indexedUrl.LastVisit.isValid() || visitTime > indexedUrl.LastVisit)
+        indexedUrl.LastVisit = visitTime;
+
+    if (!title.isEmpty() && indexedUrl.Title != title)
+    {
+        indexedUrl.Title = title;
+        indexedUrl.TitleUpper = title.toUpper();
+        indexText(id, indexedUrl.TitleUpper);
+    }
+}
+
+void URLSuggestionIndex::addBookmark(const QUrl &url, const QString &name, const QString &shortcut)
+{
+    const EntryId id = getOrCreateEntry(url);
+    IndexedURL &indexedUrl = m_entries[id];
+
+    if (!indexedUrl.IsBookmark)
+        m_bookmarks.push_back(id);
+
+    indexedUrl.IsBookmark = true;
+    indexedUrl.Shortcut = shortcut.toUpper();
+    ++m_revision;
+
+    if (indexedUrl.BookmarkName != name)
+    {
+        indexedUrl.BookmarkName = name;
+        indexedUrl.BookmarkNameUpper = name.toUpper();
+        indexText(id, indexedUrl.BookmarkNameUpper);
+    }
+}
+
+const IndexedURL &URLSuggestionIndex::getEntry(EntryId id) const
+{
+    return m_entries[id];
+}
+
+const std::vector<URLSuggestionIndex::EntryId> &URLSuggestionIndex::getBookmarks() const
+{
+    return m_bookmarks;
+}
+
+std::vector<URLSuggestionIndex::EntryId> URLSuggestionIndex::findByHostPrefix(const QString &prefix) const
+{
+    std::vector<EntryId> result;
+
+    QString hostPrefix = prefix;
+    if (hostPrefix.startsWith(QLatin1String("WWW.")))
+        hostPrefix.remove(0, 4);
+
+    if (hostPrefix.isEmpty())
+        return result;
+
+    auto it = std::lower_bound(m_hosts.begin(), m_hosts.end(), hostPrefix,
+                               [](const std::pair<QString, EntryId> &host, const QString &value) {
+        return host.first < value;
+    });
+
+    for (; it != m_hosts.end() && it->first.startsWith(hostPrefix); ++it)
+    {
+        const IndexedURL &entry = m_entries[it->second];
+        if (entry.IsHistory || entry.IsBookmark)
+            result.push_back(it->second);
+    }
+
+    return result;
+}
+
+std::vector<URLSuggestionIndex::EntryId> URLSuggestionIndex::findBySubstring(const QString &term) const
+{
+    std::vector<EntryId> result;
+
+    const int numTrigrams = term.size() - TrigramLength + 1;
+    if (numTrigrams < 1)
+        return result;
+
+    // Gather the posting list of each trigram in the term, failing fast if any are missing
+    std::vector<const std::vector<EntryId>*> postingLists;
+    postingLists.reserve(static_cast<size_t>(numTrigrams));
+
+    const QChar *termData = term.constData();
+    for (int i = 0; i < numTrigrams; ++i)
+    {
+        auto it = m_postings.find(getTrigram(termData + i));
+        if (it == m_postings.end())
+            return result;
+
+        postingLists.push_back(&it->second);
+    }
+
+    // Intersect the lists, beginning with the most selective
+    std::sort(postingLists.begin(), postingLists.end(),
+              [](const std::vector<EntryId> *a, const std::vector<EntryId> *b) {
+        return a->size() < b->size();
+    });
+    postingLists.erase(std::unique(postingLists.begin(), postingLists.end()), postingLists.end());
+
+    std::vector<EntryId> candidates = *postingLists.front();
+    std::vector<EntryId> intersection;
+    for (size_t i = 1; i < postingLists.size() && !candidates.empty(); ++i)
+    {
+        intersection.clear();
+        std::set_intersection(candidates.begin(), candidates.end(),
+                              postingLists[i]->begin(), postingLists[i]->end(),
+                              std::back_inserter(intersection));
+        candidates.swap(intersection);
+    }
+
+    // Trigrams may come from different fields, or from a title that has since changed, so verify each candidate
+    for (EntryId id : candidates)
+    {
+        const IndexedURL &entry = m_entries[id];
+        if (!entry.IsHistory && !entry.IsBookmark)
+            continue;
+
+        if (entry.URLUpper.contains(term)
+                || entry.TitleUpper.contains(term)
+                || entry.BookmarkNameUpper.contains(term))
+            result.push_back(id);
+    }
+
+    return result;
+}
+
+std::vector<URLSuggestionIndex::EntryId> URLSuggestionIndex::filterMatches(const std::vector<EntryId> &candidates,
+                                                                            const QString &term) const
+{
+    std::vector<EntryId> result;
+
+    QString hostPrefix = term;
+    if (hostPrefix.startsWith(QLatin1String("WWW.")))
+        hostPrefix.remove(0, 4);
+
+    for (EntryId id : candidates)
+    {
+        const IndexedURL &entry = m_entries[id];
+        if (!entry.IsHistory && !entry.IsBookmark)
+            continue;
+
+        if ((!hostPrefix.isEmpty() && entry.HostUpper.startsWith(hostPrefix))
+                || entry.URLUpper.contains(term)
+                || entry.TitleUpper.contains(term)
+                || entry.BookmarkNameUpper.contains(term))
+            result.push_back(id);
+    }
+
+    return result;
+}
+
+bool URLSuggestionIndex::isNarrowingOf(const QString &previousTerm, const QString &term)
+{
+    return previousTerm.size() >= TrigramLength
+            && term.startsWith(previousTerm)
+            && !term.startsWith(QLatin1String("WWW."));
+}
+
+uint64_t URLSuggestionIndex::getRevision() const
+{
+    return m_revision;
+}
+
+URLSuggestionIndex::EntryId URLSuggestionIndex::getOrCreateEntry(const QUrl &url)
+{
+    const QString urlUpper = url.toString().toUpper();
+
+    auto it = m_entryIds.find(urlUpper);
+    if (it != m_entryIds.end())
+        return it.value();
+
+    const EntryId id = static_cast<EntryId>(m_entries.size());
+
+    IndexedURL entry;
+    entry.URL = url;
+    entry.URLUpper = urlUpper;
+    entry.HostUpper = getNormalizedHost(url);
+    entry.HistoryId = -1;
+    entry.VisitCount = 0;
+    entry.URLTypedCount = 0;
+    entry.IsHistory = false;
+    entry.IsBookmark = false;
+    m_entries.push_back(std::move(entry));
+    m_entryIds.insert(urlUpper, id);
+
+    std::pair<QString, EntryId> host { m_entries.back().HostUpper, id };
+    if (m_isLoading)
+        m_hosts.push_back(std::move(host));
+    else
+        m_hosts.insert(std::upper_bound(m_hosts.begin(), m_hosts.end(), host), std::move(host));
+
+    indexText(id, urlUpper);
+    return id;
+}
+
+void URLSuggestionIndex::indexText(EntryId id, const QString &text)
+{
+    const QChar *data = text.constData();
+    for (int i = 0; i + TrigramLength <= text.size(); ++i)
+        addPosting(getTrigram(data + i), id);
+}
+
+void URLSuggestionIndex::addPosting(uint64_t trigram, EntryId id)
+{
+    std::vector<EntryId> &postings = m_postings[trigram];
+
+    // Postings are sorted and de-duplicated in finishLoading() when bulk loading
+    if (m_isLoading)
+    {
+        if (postings.empty() || postings.back() != id)
+            postings.push_back(id);
+        return;
+    }
+
+    auto it = std::lower_bound(postings.begin(), postings.end(), id);
+    if (it == postings.end() || *it != id)
+        postings.insert(it, id);
+}
+
+uint64_t URLSuggestionIndex::getTrigram(const QChar *chars)
+{
+    return (static_cast<uint64_t>(chars[0].unicode()) << 32)
+            | (static_cast<uint64_t>(chars[1].unicode()) << 16)
+            | static_cast<uint64_t>(chars[2].unicode());
+}
@@ -0,0 +1,179 @@
+#ifndef URLSUGGESTIONINDEX_H
+#define URLSUGGESTIONINDEX_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <QDateTime>
+#include <QHash>
+#include <QString>
+#include <QUrl>
+
+struct HistoryEntry;
+
+/**
+ * @struct IndexedURL
+ * @brief A single URL known to the \ref URLSuggestionIndex, along with the history and bookmark
+ *        information that is used to rank it as a suggestion
+ */
+struct IndexedURL
+{
+    /// URL of the entry
+    QUrl URL;
+
+    /// Last known title of the page
+    QString Title;
+
+    /// Name of the bookmark associated with the URL, if any
+    QString BookmarkName;
+
+    /// Upper-case form of the URL, used for matching
+    QString URLUpper;
+
+    /// Upper-case form of the URL's host, without any "www." prefix
+    QString HostUpper;
+
+    /// Upper-case form of the page title, used for matching
+    QString TitleUpper;
+
+    /// Upper-case form of the bookmark name, used for matching
+    QString BookmarkNameUpper;
+
+    /// Upper-case form of the bookmark shortcut, if any
+    QString Shortcut;
+
+    /// Date and time of the last visit to the URL
+    QDateTime LastVisit;
+
+    /// History database identifier, or -1 if the URL is not in the browsing history
+    int HistoryId;
+
+    /// Number of visits to the URL
+    int VisitCount;
+
+    /// Number of times the URL was explicitly entered by the user
+    int URLTypedCount;
+
+    /// True if the URL is part of the browsing history
+    bool IsHistory;
+
+    /// True if the URL is bookmarked
+    bool IsBookmark;
+};
+
+/**
+ * @class URLSuggestionIndex
+ * @brief In-memory index of history and bookmark URLs, owned by the \ref URLSuggestionWorker .
+ *
+ * Entries are kept in a flat array and referenced by their position. Host name prefix queries are
+ * answered by a binary search over a sorted array of hosts, and substring queries by intersecting
+ * the trigram posting lists of the search term before verifying each candidate.
+ *
+ * All search terms are expected to be in upper-case form. The index is not thread safe, and must
+ * only be used by the thread it belongs to.
+ */
+class URLSuggestionIndex
+{
+public:
+    /// Position of an entry in the index
+    using EntryId = uint32_t;
+
+    /// Constructs an empty index
+    URLSuggestionIndex();
+
+    /// Removes all entries from the index
+    void clear();
+
+    /// Removes the bookmark information from every entry in the index
+    void clearBookmarks();
+
+    /// Removes the history information from every entry in the index, so that entries which are not
+    /// bookmarked are no longer returned by searches
+    void clearHistory();
+
+    /// Exchanges the contents of this index with those of another. The revision counters of both indices are
+    /// advanced past their previous values, so that results found before the exchange are known to be outdated
+    void swap(URLSuggestionIndex &other);
+
+    /// Defers sorting of the host array and trigram postings until \ref finishLoading is called.
+    /// Used when adding a large number of entries at once
+    void beginLoading();
+
+    /// Sorts the host array and trigram postings after a bulk load
+    void finishLoading();
+
+    /// Adds or replaces the history information of the given entry
+    void addHistoryEntry(const HistoryEntry &entry);
+
+    /// Records a visit to the given URL, adding it to the index if it was not already present
+    void addVisit(const QUrl &url, const QString &title, const QDateTime &visitTime);
+
+    /// Adds bookmark information for the given URL, adding it to the index if it was not already present
+    void addBookmark(const QUrl &url, const QString &name, const QString &shortcut);
+
+    /// Returns a reference to the entry with the given identifier
+    const IndexedURL &getEntry(EntryId id) const;
+
+    /// Returns the identifiers of every bookmarked entry
+    const std::vector<EntryId> &getBookmarks() const;
+
+    /// Returns the identifiers of entries whose host name, excluding any "www." prefix, begins with the given prefix
+    std::vector<EntryId> findByHostPrefix(const QString &prefix) const;
+
+    /// Returns the identifiers of entries whose URL, page title or bookmark name contains the given term.
+    /// Terms shorter than three characters cannot be resolved by the trigram index and return no results
+    std::vector<EntryId> findBySubstring(const QString &term) const;
+
+    /// Returns the subset of the given candidates whose host begins with, or whose URL, page title or bookmark
+    /// name contains, the given term. Used to narrow the results of a previous search as the user keeps typing
+    std::vector<EntryId> filterMatches(const std::vector<EntryId> &candidates, const QString &term) const;
+
+    /// Returns true if every entry that matches the term also matched the previous term, in which case the matches of
+    /// the term can be found by passing the previous matches to \ref filterMatches . This requires the term to extend a
+    /// previous term that was long enough to be searched by substring, and to have no "www." prefix, as the host
+    /// prefix that remains once it is removed does not extend the previous term
+    static bool isNarrowingOf(const QString &previousTerm, const QString &term);
+
+    /// Returns a counter that is incremented each time the contents of the index change. Results that were
+    /// found at an earlier revision may be missing entries that have since been added or updated
+    uint64_t getRevision() const;
+
+private:
+    /// Returns the identifier of the entry associated with the given URL, creating it if needed
+    EntryId getOrCreateEntry(const QUrl &url);
+
+    /// Adds each trigram of the given upper-case text to the posting lists of the entry
+    void indexText(EntryId id, const QString &text);
+
+    /// Adds the entry to the posting list of the given trigram
+    void addPosting(uint64_t trigram, EntryId id);
+
+    /// Packs three consecutive characters into a trigram key
+    static uint64_t getTrigram(const QChar *chars);
+
+private:
+    /// Flat array of all indexed URLs
+    std::vector<IndexedURL> m_entries;
+
+    /// Maps an upper-case URL string to the identifier of its entry
+    QHash<QString, EntryId> m_entryIds;
+
+    /// Host names (upper-case, without "www.") paired with their entries, sorted by host name
+    std::vector<std::pair<QString, EntryId>> m_hosts;
+
+    /// Sorted posting lists of entry identifiers, keyed by trigram
+    std::unordered_map<uint64_t, std::vector<EntryId>> m_postings;
+
+    /// Identifiers of every bookmarked entry
+    std::vector<EntryId> m_bookmarks;
+
+    /// Incremented each time an entry is added, updated or removed
+    uint64_t m_revision;
+
+    /// True while entries are being bulk loaded, in which case the host array and postings are unsorted
+    bool m_isLoading;
+};
+
+#endif // URLSUGGESTIONINDEX_H
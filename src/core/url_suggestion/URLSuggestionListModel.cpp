@@ -38,6 +38,21 @@ void URLSuggestionListModel::setSuggestions(const std::vector<URLSuggestion> &su
     endResetModel();
 }
 
+void URLSuggestionListModel::onFaviconLoaded(const QUrl &pageUrl, const QIcon &icon)
+{
+    for (std::size_t i = 0; i < m_suggestions.size(); ++i)
+    {
+        URLSuggestion &item = m_suggestions[i];
+        if (!QUrl(item.URL).matches(pageUrl, QUrl::RemoveUserInfo | QUrl::RemoveQuery | QUrl::RemoveFragment))
+            continue;
+
+        item.Favicon = icon;
+
+        const QModelIndex itemIndex = index(static_cast<int>(i), 0);
+        emit dataChanged(itemIndex, itemIndex, { Role::Favicon });
+    }
+}
+
 bool URLSuggestionListModel::removeRows(int row, int count, const QModelIndex &parent)
 {
     if (row < 0 || row + count > rowCount())
@@ -9,6 +9,7 @@
 #include <QDateTime>
 #include <QIcon>
 #include <QString>
+#include <QUrl>
 
 /**
  * @class URLSuggestionListModel
@@ -47,6 +48,9 @@ public Q_SLOTS:
     /// Sets the suggested items to be displayed in the model
     void setSuggestions(const std::vector<URLSuggestion> &suggestions);
 
+    /// Updates the icon of the suggestions that belong to the given page
+    void onFaviconLoaded(const QUrl &pageUrl, const QIcon &icon);
+
 private:
     /// Contains suggested URLs based on the current input
     std::vector<URLSuggestion> m_suggestions;
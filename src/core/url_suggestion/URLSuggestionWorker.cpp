@@ -6,16 +6,22 @@
 #include "FaviconManager.h"
 #include "HistoryManager.h"
 #include "HistorySuggestor.h"
+#include "Settings.h"
+#include "URLRecord.h"
 #include "URLSuggestion.h"
 #include "URLSuggestionWorker.h"
 
+#include "SQLiteWrapper.h"
+
 #include <algorithm>
 #include <chrono>
 #include <iterator>
 
+#include <QFutureWatcher>
 #include <QSet>
 #include <QTimer>
 #include <QUrl>
+#include <QtConcurrent>
 
 #include <QDebug>
 
@@ -56,16 +62,25 @@ bool compareUrlSuggestions(const URLSuggestion &a, const URLSuggestion &b)
 URLSuggestionWorker::URLSuggestionWorker(QObject *parent) :
     QObject(parent),
     m_working(false),
+    m_searchGeneration(0),
     m_searchTerm(),
     m_searchWords(),
     m_suggestions(),
     m_searchTermWideStr(),
     m_differenceHash(0),
     m_searchTermHash(0),
+    m_index(),
+    m_pendingVisits(),
+    m_isRebuildInProgress(false),
+    m_isRebuildPending(false),
+    m_areBookmarksStale(true),
+    m_bookmarkManager(nullptr),
+    m_faviconManager(nullptr),
+    m_historyDatabaseFile(),
     m_handlers()
 {
-    m_handlers.push_back(std::make_unique<BookmarkSuggestor>());
-    m_handlers.push_back(std::make_unique<HistorySuggestor>());
+    m_handlers.push_back(std::make_unique<BookmarkSuggestor>(m_index));
+    m_handlers.push_back(std::make_unique<HistorySuggestor>(m_index));
 }
 
 void URLSuggestionWorker::stopWork()
@@ -73,34 +88,194 @@ void URLSuggestionWorker::stopWork()
     m_working.store(false);
 }
 
-void URLSuggestionWorker::findSuggestionsFor(const QString &text)
+void URLSuggestionWorker::setSearchGeneration(quint64 generation)
 {
-    m_searchTerm = text.toUpper().trimmed();
+    m_searchGeneration.store(generation);
+    m_working.store(false);
+}
+
+void URLSuggestionWorker::findSuggestionsFor(const QString &text, quint64 generation)
+{
+    // Mark the worker as active before checking the generation, so that a newer request
+    // arriving in between is guaranteed to cancel this one
+    m_working.store(true);
+    if (generation != m_searchGeneration.load())
+        return;
+
+    QString searchTerm = text.toUpper().trimmed();
 
     // Remove any http or https prefix from the term, since we do not want to
     // do a string check on URLs and potentially remove an HTTPS match because
-    // the user only entered HTTP 
-    QRegularExpression httpExpr(QLatin1String("^HTTP(S?)://"));
-    m_searchTerm.replace(httpExpr, QString());
+    // the user only entered HTTP
+    if (searchTerm.startsWith(QLatin1String("HTTP://")))
+        searchTerm.remove(0, 7);
+    else if (searchTerm.startsWith(QLatin1String("HTTPS://")))
+        searchTerm.remove(0, 8);
+
+    if (searchTerm != m_searchTerm)
+    {
+        m_searchTerm = searchTerm;
+
+        // Split up search term into different words
+        m_searchWords = CommonUtil::tokenizePossibleUrl(m_searchTerm);
 
-    // Split up search term into different words
-    m_searchWords = CommonUtil::tokenizePossibleUrl(m_searchTerm);
+        hashSearchTerm();
+    }
 
-    hashSearchTerm();
-    searchForHits();
+    searchForHits(generation);
 }
 
 void URLSuggestionWorker::setServiceLocator(const ViperServiceLocator &serviceLocator)
 {
     for (auto &handler : m_handlers)
         handler->setServiceLocator(serviceLocator);
+
+    if (Settings *settings = serviceLocator.getServiceAs<Settings>("Settings"))
+        m_historyDatabaseFile = settings->getPathValue(BrowserSetting::HistoryPath);
+
+    if (HistoryManager *historyManager = serviceLocator.getServiceAs<HistoryManager>("HistoryManager"))
+    {
+        connect(historyManager, &HistoryManager::pageVisited,    this, &URLSuggestionWorker::onPageVisited);
+        connect(historyManager, &HistoryManager::historyCleared, this, &URLSuggestionWorker::onHistoryCleared);
+    }
+
+    m_faviconManager = serviceLocator.getServiceAs<FaviconManager>("FaviconManager");
+
+    m_bookmarkManager = serviceLocator.getServiceAs<BookmarkManager>("BookmarkManager");
+    if (m_bookmarkManager)
+    {
+        connect(m_bookmarkManager, &BookmarkManager::bookmarksChanged, this, &URLSuggestionWorker::onBookmarksChanged);
+        connect(m_bookmarkManager, &BookmarkManager::bookmarkChanged,  this, &URLSuggestionWorker::onBookmarksChanged);
+    }
+
+    // Start loading the index from the worker's thread, which owns the index
+    QMetaObject::invokeMethod(this, "rebuildIndex", Qt::QueuedConnection);
 }
 
-void URLSuggestionWorker::searchForHits()
+void URLSuggestionWorker::rebuildIndex()
+{
+    // The history loaded by a rebuild in progress may predate the latest change, so load it again afterwards
+    if (m_isRebuildInProgress)
+    {
+        m_isRebuildPending = true;
+        return;
+    }
+
+    m_isRebuildInProgress = true;
+    m_isRebuildPending = false;
+
+    using IndexWatcher = QFutureWatcher<std::shared_ptr<URLSuggestionIndex>>;
+    IndexWatcher *watcher = new IndexWatcher(this);
+    connect(watcher, &IndexWatcher::finished, this, [this, watcher](){
+        std::shared_ptr<URLSuggestionIndex> historyIndex = watcher->result();
+        watcher->deleteLater();
+
+        m_isRebuildInProgress = false;
+        if (m_isRebuildPending)
+        {
+            rebuildIndex();
+            return;
+        }
+
+        onHistoryIndexLoaded(*historyIndex);
+    });
+    watcher->setFuture(QtConcurrent::run(&URLSuggestionWorker::loadHistoryIndex, m_historyDatabaseFile));
+}
+
+void URLSuggestionWorker::onPageVisited(const QUrl &url, const QString &title)
+{
+    const QDateTime visitTime = QDateTime::currentDateTime();
+    m_index.addVisit(url, title, visitTime);
+
+    if (m_isRebuildInProgress)
+        m_pendingVisits.push_back(PendingVisit { url, title, visitTime });
+}
+
+void URLSuggestionWorker::onHistoryCleared()
+{
+    // Hide the erased entries right away, as the remaining history is only known once the rebuild finishes
+    m_index.clearHistory();
+    m_pendingVisits.clear();
+
+    rebuildIndex();
+}
+
+void URLSuggestionWorker::onBookmarksChanged()
+{
+    m_areBookmarksStale = true;
+}
+
+void URLSuggestionWorker::updateIndex()
+{
+    if (m_areBookmarksStale)
+    {
+        m_index.beginLoading();
+        loadBookmarksIntoIndex();
+        m_index.finishLoading();
+    }
+}
+
+void URLSuggestionWorker::onHistoryIndexLoaded(URLSuggestionIndex &historyIndex)
+{
+    m_index.swap(historyIndex);
+
+    m_index.beginLoading();
+    loadBookmarksIntoIndex();
+    m_index.finishLoading();
+
+    // A visit may also have been loaded from the database, in which case it is counted twice. The visit
+    // count only affects the order of suggestions, and is corrected by the next rebuild
+    for (const PendingVisit &visit : m_pendingVisits)
+        m_index.addVisit(visit.URL, visit.Title, visit.VisitTime);
+    m_pendingVisits.clear();
+}
+
+std::shared_ptr<URLSuggestionIndex> URLSuggestionWorker::loadHistoryIndex(const QString &historyDatabaseFile)
+{
+    std::shared_ptr<URLSuggestionIndex> historyIndex = std::make_shared<URLSuggestionIndex>();
+    if (historyDatabaseFile.isEmpty())
+        return historyIndex;
+
+    sqlite::Database historyDb(historyDatabaseFile.toStdString());
+    if (!historyDb.isValid())
+        return historyIndex;
+
+    historyIndex->beginLoading();
+
+    auto stmt = historyDb.prepare(R"(SELECT H.VisitID, H.URL, H.Title, H.URLTypedCount, COUNT(V.Date), MAX(V.Date)
+                                  FROM History AS H INNER JOIN Visits AS V
+                                  ON H.VisitID = V.VisitID
+                                  GROUP BY H.VisitID)");
+    while (stmt.next())
+    {
+        HistoryEntry entry;
+        stmt >> entry;
+        historyIndex->addHistoryEntry(entry);
+    }
+
+    historyIndex->finishLoading();
+    return historyIndex;
+}
+
+void URLSuggestionWorker::loadBookmarksIntoIndex()
+{
+    m_index.clearBookmarks();
+    m_areBookmarksStale = false;
+
+    if (!m_bookmarkManager)
+        return;
+
+    std::shared_ptr<const FlatBookmarkTree> bookmarks = m_bookmarkManager->getFlatTree();
+    for (FlatBookmarkTree::NodeIndex index : bookmarks->getBookmarks())
+        m_index.addBookmark(bookmarks->getURL(index), bookmarks->getName(index), bookmarks->getShortcut(index));
+}
+
+void URLSuggestionWorker::searchForHits(quint64 generation)
 {
-    m_working.store(true);
     m_suggestions.clear();
 
+    updateIndex();
+
     QSet<QString> hits;
     FastHashParameters hashParams { m_searchTermWideStr, m_differenceHash, m_searchTermHash };
     for (auto &handler : m_handlers)
@@ -119,17 +294,41 @@ void URLSuggestionWorker::searchForHits()
             hits.insert(urlUpper);
             m_suggestions.emplace_back(suggestion);
         }
+
+        // Show the results of each handler as they arrive, rather than waiting on the slowest
+        if (!m_working.load())
+            return;
+
+        if (!suggestions.empty())
+            emitSuggestions(generation);
     }
 
-    if (!m_working.load())
-        return;
+    if (m_suggestions.empty() && m_working.load())
+        emitSuggestions(generation);
+
+    m_working.store(false);
+}
+
+void URLSuggestionWorker::emitSuggestions(quint64 generation)
+{
+    constexpr size_t maxToSuggest = 25;
 
     std::sort(m_suggestions.begin(), m_suggestions.end(), compareUrlSuggestions);
-    if (m_suggestions.size() > 25)
-        m_suggestions.erase(m_suggestions.begin() + 25, m_suggestions.end());
+    if (m_suggestions.size() > maxToSuggest)
+        m_suggestions.erase(m_suggestions.begin() + maxToSuggest, m_suggestions.end());
 
-    emit finishedSearch(m_suggestions);
-    m_working.store(false);
+    emit suggestionsFound(m_suggestions, generation);
+
+    // Suggestions only carry the icons that are already cached. The others are announced by the favicon manager
+    // after the suggestions have reached the model, which updates the rows of the affected pages
+    if (m_faviconManager && !m_suggestions.empty())
+    {
+        std::vector<QUrl> urls;
+        urls.reserve(m_suggestions.size());
+        for (const URLSuggestion &suggestion : m_suggestions)
+            urls.push_back(QUrl(suggestion.URL));
+        m_faviconManager->loadFavicons(urls);
+    }
 }
 
 void URLSuggestionWorker::hashSearchTerm()
@@ -4,6 +4,7 @@
 #include "IURLSuggestor.h"
 #include "ServiceLocator.h"
 #include "URLSuggestion.h"
+#include "URLSuggestionIndex.h"
 #include "URLSuggestionListModel.h"
 
 #include <atomic>
@@ -11,14 +12,22 @@
 #include <string>
 #include <vector>
 
+#include <QDateTime>
 #include <QObject>
 #include <QString>
 #include <QStringList>
+#include <QUrl>
+
+class BookmarkManager;
+class FaviconManager;
 
 /**
  * @class URLSuggestionWorker
  * @brief Fetches URL suggestions to populate into the \ref URLSuggestionWidget as the
- *        user types a string of text into the \ref URLLineEdit widget
+ *        user types a string of text into the \ref URLLineEdit widget.
+ *
+ * The worker keeps a \ref URLSuggestionIndex of the user's history and bookmarks, which is
+ * loaded in a background thread and kept up to date as pages are visited and bookmarks change.
  */
 class URLSuggestionWorker : public QObject
 {
@@ -28,24 +37,62 @@ class URLSuggestionWorker : public QObject
     explicit URLSuggestionWorker(QObject *parent = nullptr);
 
     /// Sets a reference to the service locator, which is used to gather the dependencies required by this worker
-    /// (namely, the \ref HistoryManager , \ref BookmarkManager , and \ref FaviconStore )
+    /// (namely, the \ref HistoryManager , \ref BookmarkManager , and \ref FaviconStore ), and schedules the
+    /// suggestion index to be built
     void setServiceLocator(const ViperServiceLocator &serviceLocator);
 
     /// Sets the internal "is working" flag to false, in order to prevent unnecessary suggestion determinations
     void stopWork();
 
+    /// Sets the generation of the most recent search request, cancelling any search that belongs to an
+    /// earlier generation. Safe to call from any thread, ahead of queueing the request itself
+    void setSearchGeneration(quint64 generation);
+
 public Q_SLOTS:
-    /// Begins a new search operation for suggestions related to the given string.
-    /// Cancels any operations in progress at the time this method is called
-    void findSuggestionsFor(const QString &text);
+    /// Begins a new search operation for suggestions related to the given string. Requests from a generation
+    /// older than the one given to \ref setSearchGeneration are discarded without being searched
+    void findSuggestionsFor(const QString &text, quint64 generation);
 
 Q_SIGNALS:
-    /// Emitted when a suggestion search is finished, passing a reference to each URL matching the input pattern
-    void finishedSearch(const std::vector<URLSuggestion> &results);
+    /// Emitted as each suggestion handler finishes (bookmarks first, followed by history), passing the sorted
+    /// results found so far for the search of the given generation
+    void suggestionsFound(const std::vector<URLSuggestion> &results, quint64 generation);
+
+private Q_SLOTS:
+    /// Loads a new suggestion index from the history database in a background thread, replacing the current
+    /// index once it is ready. Searches keep using the current index in the meantime
+    void rebuildIndex();
+
+    /// Records a visit to the given page in the suggestion index
+    void onPageVisited(const QUrl &url, const QString &title);
+
+    /// Removes the history entries from the suggestion index after some or all of the browsing history was
+    /// erased, and rebuilds the index from the remaining history
+    void onHistoryCleared();
+
+    /// Marks the bookmark entries of the suggestion index as stale
+    void onBookmarksChanged();
 
 private:
+    /// Reloads the bookmark entries of the suggestion index if they are stale
+    void updateIndex();
+
+    /// Replaces the suggestion index with the given index of the browsing history, adding the bookmarks
+    /// and any visits that were made while the index was loading
+    void onHistoryIndexLoaded(URLSuggestionIndex &historyIndex);
+
+    /// Returns a new suggestion index of every entry in the given history database. Called from a background thread
+    static std::shared_ptr<URLSuggestionIndex> loadHistoryIndex(const QString &historyDatabaseFile);
+
+    /// Replaces the bookmark entries of the suggestion index with the current bookmark collection
+    void loadBookmarksIntoIndex();
+
     /// The suggestion search operation working in a separate thread
-    void searchForHits();
+    void searchForHits(quint64 generation);
+
+    /// Sorts the suggestions found so far and emits the most relevant of them, requesting the icons of the
+    /// emitted suggestions that are not yet cached
+    void emitSuggestions(quint64 generation);
 
     /// Generates a hash of the search term before looking for suggestions
     void hashSearchTerm();
@@ -54,6 +101,9 @@ public Q_SLOTS:
     /// True if the worker thread is active, false if else
     std::atomic_bool m_working;
 
+    /// Generation of the most recent search request
+    std::atomic<quint64> m_searchGeneration;
+
     /// The search term used to find suggestions
     QString m_searchTerm;
 
@@ -72,6 +122,44 @@ public Q_SLOTS:
     /// Contains a hash of the search term string
     quint64 m_searchTermHash;
 
+    /// In-memory index of history and bookmark URLs, used by the suggestion handlers
+    URLSuggestionIndex m_index;
+
+    /// Visit to a page that was made while the suggestion index was being rebuilt
+    struct PendingVisit
+    {
+        /// URL of the page
+        QUrl URL;
+
+        /// Title of the page
+        QString Title;
+
+        /// Date and time of the visit
+        QDateTime VisitTime;
+    };
+
+    /// Visits that were made while the suggestion index was being rebuilt, which are added to the new index
+    std::vector<PendingVisit> m_pendingVisits;
+
+    /// True while a new suggestion index is being loaded in the background
+    bool m_isRebuildInProgress;
+
+    /// True if the suggestion index must be rebuilt again once the current rebuild finishes, as the history
+    /// was erased after the rebuild began
+    bool m_isRebuildPending;
+
+    /// True if the bookmark entries of the suggestion index must be reloaded before the next search
+    bool m_areBookmarksStale;
+
+    /// Bookmark collection, used to populate the suggestion index
+    BookmarkManager *m_bookmarkManager;
+
+    /// Favicon manager, used to look up the icons of the suggestions in a single batch
+    FaviconManager *m_faviconManager;
+
+    /// Location of the history database, used to populate the suggestion index
+    QString m_historyDatabaseFile;
+
     /// URL suggestion implementations
     std::vector<std::unique_ptr<IURLSuggestor>> m_handlers;
 };
@@ -1,9 +1,32 @@
-#include "CommonUtil.h"
 #include "UserScript.h"
 
 #include <QFile>
+#include <QRegularExpression>
 #include <QTextStream>
 
+namespace
+{
+    /// Returns a revision number that has not been given to any user script
+    quint64 getNextRevision()
+    {
+        static quint64 lastRevision = 0;
+        return ++lastRevision;
+    }
+
+    /// Formats the rules as the elements of a JavaScript array
+    QString getRulesJSON(const std::vector<QString> &rules)
+    {
+        QString result;
+        for (const QString &rule : rules)
+        {
+            QString ruleFix = rule;
+            ruleFix.replace(QLatin1String("\\"), QLatin1String("\\\\")).replace(QLatin1String("'"), QLatin1String("\\'"));
+            result.append(QString("'%1',").arg(ruleFix));
+        }
+        return result.left(result.size() - 1);
+    }
+}
+
 UserScript::UserScript() :
     m_name(),
     m_namespace(),
@@ -13,10 +36,12 @@ UserScript::UserScript() :
     m_isEnabled(true),
     m_injectionTime(ScriptInjectionTime::DocumentEnd),
     m_includes(),
+    m_matches(),
     m_excludes(),
     m_dependencies(),
     m_scriptData(),
-    m_dependencyData()
+    m_dependencyData(),
+    m_revision(getNextRevision())
 {
 }
 
@@ -65,6 +90,31 @@ const QString &UserScript::getScriptData() const
     return m_scriptData;
 }
 
+const std::vector<QString> &UserScript::getIncludes() const
+{
+    return m_includes;
+}
+
+const std::vector<QString> &UserScript::getMatches() const
+{
+    return m_matches;
+}
+
+const std::vector<QString> &UserScript::getExcludes() const
+{
+    return m_excludes;
+}
+
+quint64 UserScript::getRevision() const
+{
+    return m_revision;
+}
+
+void UserScript::markChanged()
+{
+    m_revision = getNextRevision();
+}
+
 bool UserScript::load(const QString &file, const QString &templateData)
 {
     QFile f(file);
@@ -72,7 +122,12 @@ bool UserScript::load(const QString &file, const QString &templateData)
         return false;
 
     m_dependencyData.clear();
+    m_includes.clear();
+    m_matches.clear();
+    m_excludes.clear();
+    m_dependencies.clear();
     m_fileName = file;
+    markChanged();
 
     // Read file line by line, adding contents to local data buffer and initially parsing the metadata block
     bool foundMetaDataStart = false, foundMetaDataEnd = false;
@@ -105,11 +160,11 @@ bool UserScript::load(const QString &file, const QString &templateData)
                 else if (key.compare("noframes") == 0)
                     m_noSubFrames = true;
                 else if (key.compare("include") == 0)
-                    m_includes.push_back(getRegExp(value));
+                    m_includes.push_back(value.trimmed());
                 else if (key.compare("exclude") == 0)
-                    m_excludes.push_back(getRegExp(value));
+                    m_excludes.push_back(value.trimmed());
                 else if (key.compare("match") == 0)
-                    m_includes.push_back(CommonUtil::getRegExpForMatchPattern(value));
+                    m_matches.push_back(value.trimmed());
                 else if (key.compare("require") == 0)
                     m_dependencies.push_back(value);
                 else if (key.compare("run-at") == 0)
@@ -135,9 +190,9 @@ bool UserScript::load(const QString &file, const QString &templateData)
     }
     f.close();
 
-    // If there are no items in the include container, add a "match everything" rule
-    if (m_includes.empty())
-        m_includes.push_back(QRegularExpression(QStringLiteral(".*")));
+    // If there are no include or match rules, add a "match everything" rule
+    if (m_includes.empty() && m_matches.empty())
+        m_includes.push_back(QStringLiteral("*"));
 
     // Copy template file into script data member, then replace variables with user script specific data
     m_scriptData = templateData;
@@ -149,40 +204,11 @@ bool UserScript::load(const QString &file, const QString &templateData)
     return true;
 }
 
-QRegularExpression UserScript::getRegExp(const QString &str)
-{
-    // Check if string is either a single '*' or empty, and if so, set regular expression to match everything
-    if (str.isEmpty() || (str.size() == 1 && str.at(0) == '*'))
-        return QRegularExpression(QStringLiteral(".*"));
-
-    QString converted;
-
-    // Check if rule is a regular expression
-    if (str.startsWith('/') && str.endsWith('/'))
-    {
-        converted = str.mid(1);
-        converted = str.left(str.size() - 1);
-        converted.replace(QStringLiteral("\\"), QStringLiteral("\\\\"));
-        return QRegularExpression(converted);
-    }
-
-    // If the method has not returned at this point, replace each occurrence of a "*" with a ".*"
-    converted = str;
-    converted.replace(QStringLiteral("*"), QStringLiteral(".*"));
-    return QRegularExpression(converted);
-}
-
 QString UserScript::getScriptJSON() const
 {
-    QString excludes;
-    for (const QRegularExpression &exp : m_excludes)
-        excludes.append(QString("\"%1\",").arg(exp.pattern()));
-    excludes = excludes.left(excludes.size() - 1);
-
-    QString includes;
-    for (const QRegularExpression &exp : m_includes)
-        includes.append(QString("\"%1\",").arg(exp.pattern()));
-    includes = includes.left(includes.size() - 1);
+    const QString excludes = getRulesJSON(m_excludes);
+    const QString includes = getRulesJSON(m_includes);
+    const QString matches = getRulesJSON(m_matches);
 
     QString descrFix = m_description;
     descrFix.replace("'", "\\'");
@@ -204,7 +230,7 @@ QString UserScript::getScriptJSON() const
             break;
     }
     return QString("{ 'description': '%1', 'excludes': [ %2 ], "
-    "'includes': [ %3 ], 'matches': [], 'name': '%4', "
-    "'namespace': '%5', 'resources': {}, 'run-at': '%6', "
-    "'version': '%7' }").arg(descrFix).arg(excludes).arg(includes).arg(nameFix).arg(namespaceFix).arg(runTime).arg(m_version);
+    "'includes': [ %3 ], 'matches': [ %4 ], 'name': '%5', "
+    "'namespace': '%6', 'resources': {}, 'run-at': '%7', "
+    "'version': '%8' }").arg(descrFix).arg(excludes).arg(includes).arg(matches).arg(nameFix).arg(namespaceFix).arg(runTime).arg(m_version);
 }
@@ -2,8 +2,8 @@
 #define USERSCRIPT_H
 
 #include <vector>
-#include <QRegularExpression>
 #include <QString>
+#include <QtGlobal>
 
 /// List of time periods in which a user script may be injected onto a page
 enum class ScriptInjectionTime
@@ -54,15 +54,27 @@ class UserScript
     /// Returns the user script in string form
     const QString &getScriptData() const;
 
+    /// Returns the @include rules of the script, which are globs applied to the whole URL
+    const std::vector<QString> &getIncludes() const;
+
+    /// Returns the @match rules of the script, which are match patterns as used by browser extensions
+    const std::vector<QString> &getMatches() const;
+
+    /// Returns the @exclude rules of the script, which are globs applied to the whole URL
+    const std::vector<QString> &getExcludes() const;
+
+    /// Returns a number that changes each time the code or dependencies of the script change
+    quint64 getRevision() const;
+
 protected:
     /// Attempts to load and parse the user script file, given the user script template.
     /// Returns true on success, false on failure
     bool load(const QString &file, const QString &templateData);
 
-private:
-    /// Converts the include or exclude rule into a QRegularExpression
-    QRegularExpression getRegExp(const QString &str);
+    /// Gives the script a new revision number, after its code or dependencies have changed
+    void markChanged();
 
+private:
     /// Converts the extracted script metadata into a JSON object
     QString getScriptJSON() const;
 
@@ -91,11 +103,14 @@ class UserScript
     /// When the script will be injected onto a page
     ScriptInjectionTime m_injectionTime;
 
-    /// Container of url include and matching rules, where the script will be injected
-    std::vector<QRegularExpression> m_includes;
+    /// Container of url include rules, where the script will be injected
+    std::vector<QString> m_includes;
+
+    /// Container of url match patterns, where the script will be injected
+    std::vector<QString> m_matches;
 
     /// Container of url excluding rules, where the script will never be injected
-    std::vector<QRegularExpression> m_excludes;
+    std::vector<QString> m_excludes;
 
     /// JavaScript dependencies
     std::vector<QString> m_dependencies;
@@ -105,6 +120,9 @@ class UserScript
 
     /// Stores script dependencies in a data buffer, which will be injected onto target sites before the user script
     QByteArray m_dependencyData;
+
+    /// Revision number of the script, see \ref getRevision
+    quint64 m_revision;
 };
 
 #endif // USERSCRIPT_H
@@ -6,14 +6,17 @@
 
 #include <QDir>
 #include <QFile>
-#include <QRegularExpression>
 #include <QNetworkRequest>
+#include <QSet>
 #include <QUrl>
 
 UserScriptManager::UserScriptManager(DownloadManager *downloadManager, Settings *settings) :
     QObject(nullptr),
     m_downloadManager(downloadManager),
-    m_model(new UserScriptModel(downloadManager, settings, this))
+    m_model(new UserScriptModel(downloadManager, settings, this)),
+    m_matcher(),
+    m_matcherRevision(0),
+    m_convertedScripts()
 {
     setObjectName(QLatin1String("UserScriptManager"));
     connect(settings, &Settings::settingChanged, this, &UserScriptManager::onSettingChanged);
@@ -38,44 +41,19 @@ QString UserScriptManager::getScriptsFor(const QUrl &url, ScriptInjectionTime in
     if (!m_model->m_enabled)
         return QString();
 
-    QByteArray resultBuffer;
-    QString urlStr = url.toString(QUrl::FullyEncoded);
+    updateMatcher();
 
-    for (const UserScript &script : m_model->m_scripts)
+    QByteArray resultBuffer;
+    for (int scriptIdx : m_matcher.match(url))
     {
-        if (!script.m_isEnabled
-                || (injectionTime != script.m_injectionTime)
+        const UserScript &script = m_model->m_scripts.at(scriptIdx);
+        if ((injectionTime != script.m_injectionTime)
                 || (script.m_noSubFrames && !isMainFrame))
             continue;
 
-        bool isExclude = false, isInclude = false;
-        for (const QRegularExpression &expr : script.m_excludes)
-        {
-            if (expr.match(urlStr).hasMatch())
-            {
-                isExclude = true;
-                break;
-            }
-        }
-
-        if (isExclude)
-            continue;
-
-        for (const QRegularExpression &expr : script.m_includes)
-        {
-            if (expr.match(urlStr).hasMatch())
-            {
-                isInclude = true;
-                break;
-            }
-        }
-
-        if (isInclude)
-        {
-            resultBuffer.append(script.m_dependencyData);
-            resultBuffer.append(QChar('\n'));
-            resultBuffer.append(script.m_scriptData);
-        }
+        resultBuffer.append(script.m_dependencyData);
+        resultBuffer.append(QChar('\n'));
+        resultBuffer.append(script.m_scriptData);
     }
 
     return QString(resultBuffer);
@@ -87,40 +65,11 @@ std::vector<QWebEngineScript> UserScriptManager::getAllScriptsFor(const QUrl &ur
     if (!m_model->m_enabled)
         return result;
 
-    QString urlStr = url.toString(QUrl::FullyEncoded);
-    for (const UserScript &script : m_model->m_scripts)
-    {
-        if (!script.m_isEnabled)
-            continue;
+    updateMatcher();
 
-        bool isExclude = false, isInclude = false;
-        for (const QRegularExpression &expr : script.m_excludes)
-        {
-            if (expr.match(urlStr).hasMatch())
-            {
-                isExclude = true;
-                break;
-            }
-        }
-
-        if (isExclude)
-            continue;
+    for (int scriptIdx : m_matcher.match(url))
+        result.push_back(getWebEngineScript(m_model->m_scripts.at(scriptIdx)));
 
-        for (const QRegularExpression &expr : script.m_includes)
-        {
-            if (expr.match(urlStr).hasMatch())
-            {
-                isInclude = true;
-                break;
-            }
-        }
-
-        if (isInclude)
-        {
-            WebEngineScriptAdapter scriptAdapter(script);
-            result.push_back(scriptAdapter.getScript());
-        }
-    }
     return result;
 }
 
@@ -181,6 +130,39 @@ void UserScriptManager::createScript(const QString &name, const QString &nameSpa
     }
 }
 
+void UserScriptManager::updateMatcher()
+{
+    if (m_matcherRevision == m_model->m_revision)
+        return;
+
+    m_matcher.build(m_model->m_scripts);
+    m_matcherRevision = m_model->m_revision;
+
+    // Forget the converted forms of scripts that have been removed
+    QSet<QString> fileNames;
+    for (const UserScript &script : m_model->m_scripts)
+        fileNames.insert(script.m_fileName);
+
+    for (auto it = m_convertedScripts.begin(); it != m_convertedScripts.end();)
+    {
+        if (fileNames.contains(it.key()))
+            ++it;
+        else
+            it = m_convertedScripts.erase(it);
+    }
+}
+
+const QWebEngineScript &UserScriptManager::getWebEngineScript(const UserScript &script)
+{
+    auto it = m_convertedScripts.find(script.m_fileName);
+    if (it == m_convertedScripts.end() || it->Revision != script.getRevision())
+    {
+        WebEngineScriptAdapter scriptAdapter(script);
+        it = m_convertedScripts.insert(script.m_fileName, ConvertedScript{ script.getRevision(), scriptAdapter.getScript() });
+    }
+    return it->Script;
+}
+
 void UserScriptManager::onSettingChanged(BrowserSetting setting, const QVariant &value)
 {
     if (setting == BrowserSetting::UserScriptsEnabled)
@@ -5,9 +5,11 @@
 #include "ISettingsObserver.h"
 
 #include "UserScript.h"
+#include "UserScriptMatcher.h"
 
 #include <memory>
 #include <vector>
+#include <QHash>
 #include <QObject>
 #include <QString>
 #include <QUrl>
@@ -19,6 +21,9 @@ class UserScriptModel;
 /**
  * @class UserScriptManager
  * @brief Manages a collection of GreaseMonkey-style user scripts
+ *
+ * The rules of the scripts are compiled into a \ref UserScriptMatcher , which is rebuilt when the scripts
+ * change. Scripts are converted into QWebEngineScripts once per revision of the script.
  */
 class UserScriptManager : public QObject, public ISettingsObserver
 {
@@ -79,11 +84,38 @@ private Q_SLOTS:
     void onSettingChanged(BrowserSetting setting, const QVariant &value) override;
 
 private:
+    /// Rebuilds the script matcher if the scripts have changed since it was last built
+    void updateMatcher();
+
+    /// Returns the QWebEngineScript form of the given user script, converting the script if it has
+    /// changed since it was last converted
+    const QWebEngineScript &getWebEngineScript(const UserScript &script);
+
+private:
+    /// A user script that has been converted into a QWebEngineScript
+    struct ConvertedScript
+    {
+        /// Revision of the user script when it was converted
+        quint64 Revision;
+
+        /// The converted script
+        QWebEngineScript Script;
+    };
+
     /// Network download manager
     DownloadManager *m_downloadManager;
 
     /// Pointer to the user scripts model
     UserScriptModel *m_model;
+
+    /// Finds the scripts that apply to a URL
+    UserScriptMatcher m_matcher;
+
+    /// Revision of the user script model that the matcher was built from
+    quint64 m_matcherRevision;
+
+    /// Converted user scripts, by the name of the file that each script was loaded from
+    QHash<QString, ConvertedScript> m_convertedScripts;
 };
 
 #endif // USERSCRIPTMANAGER_H
@@ -0,0 +1,433 @@
+#include "UserScriptMatcher.h"
+
+#include <algorithm>
+#include <optional>
+#include <utility>
+
+#include <QDebug>
+
+namespace
+{
+    /// Maximum number of origins whose rules are cached
+    constexpr std::size_t MaxCachedOrigins = 64;
+
+    /// Schemes of the URLs matched by the <all_urls> pattern
+    const char *const AllUrlSchemes[] = { "http", "https", "ftp", "file" };
+}
+
+bool UserScriptMatcher::Rule::isPathIndependent() const
+{
+    return Kind != HostKind::Url
+            && (Glob.compare(QLatin1String("*")) == 0 || Glob.compare(QLatin1String("/*")) == 0);
+}
+
+bool UserScriptMatcher::Rule::isUniversal() const
+{
+    return Kind == HostKind::Any
+            && SchemeGlob.compare(QLatin1String("*")) == 0
+            && Glob.compare(QLatin1String("*")) == 0;
+}
+
+UserScriptMatcher::UserScriptMatcher() :
+    m_rules(),
+    m_hostRoot(),
+    m_anyHostRules(),
+    m_originCache(MaxCachedOrigins, 1)
+{
+}
+
+void UserScriptMatcher::build(const std::vector<UserScript> &scripts)
+{
+    clear();
+
+    const int numScripts = static_cast<int>(scripts.size());
+    for (int i = 0; i < numScripts; ++i)
+    {
+        const UserScript &script = scripts.at(i);
+        if (!script.isEnabled())
+            continue;
+
+        for (const QString &glob : script.getIncludes())
+            compileGlob(i, false, glob);
+
+        for (const QString &pattern : script.getMatches())
+            compileMatchPattern(i, pattern);
+
+        for (const QString &glob : script.getExcludes())
+            compileGlob(i, true, glob);
+    }
+}
+
+void UserScriptMatcher::clear()
+{
+    m_rules.clear();
+    m_hostRoot.Children.clear();
+    m_hostRoot.Rules.clear();
+    m_anyHostRules.clear();
+    m_originCache.clear();
+}
+
+std::vector<int> UserScriptMatcher::match(const QUrl &url)
+{
+    if (m_rules.empty())
+        return {};
+
+    const QString urlString = url.toString(QUrl::FullyEncoded);
+    const QString scheme = url.scheme();
+    const bool hasAuthority = urlString.midRef(scheme.size(), 3).compare(QLatin1String("://")) == 0;
+
+    std::shared_ptr<const OriginRules> originRules = getOriginRules(url, hasAuthority);
+    if (originRules->IsPathIndependent)
+        return originRules->Scripts;
+
+    QString pathString = url.toString(QUrl::FullyEncoded | QUrl::RemoveScheme | QUrl::RemoveAuthority);
+    if (hasAuthority && !pathString.startsWith(QLatin1Char('/')))
+        pathString.prepend(QLatin1Char('/'));
+
+    return matchRules(originRules->Rules, urlString, pathString);
+}
+
+void UserScriptMatcher::compileGlob(int scriptIndex, bool isExclude, const QString &glob)
+{
+    Rule rule;
+    rule.ScriptIndex = scriptIndex;
+    rule.IsExclude = isExclude;
+    rule.Kind = HostKind::Url;
+    rule.SchemeGlob = QLatin1String("*");
+    rule.IsAnyPort = true;
+
+    // A single '*' or an empty rule matches everything
+    if (glob.isEmpty() || glob.compare(QLatin1String("*")) == 0)
+    {
+        rule.Kind = HostKind::Any;
+        rule.Glob = QLatin1String("*");
+        addRule(std::move(rule), QString());
+        return;
+    }
+
+    // Regular expression, checked against the whole URL
+    if (glob.size() > 2 && glob.startsWith(QLatin1Char('/')) && glob.endsWith(QLatin1Char('/')))
+    {
+        rule.RegExp = QRegularExpression(glob.mid(1, glob.size() - 2));
+        if (!rule.RegExp.isValid())
+        {
+            qWarning() << "UserScriptMatcher::compileGlob - invalid regular expression " << glob;
+            return;
+        }
+        addRule(std::move(rule), QString());
+        return;
+    }
+
+    // Globs of the form scheme://host/path are indexed by their host, if the host is either literal,
+    // '*', or a '*.' followed by a literal domain
+    const int schemeEnd = glob.indexOf(QLatin1String("://"));
+    if (schemeEnd > 0)
+    {
+        const int hostStart = schemeEnd + 3;
+        const int pathStart = glob.indexOf(QLatin1Char('/'), hostStart);
+        QString host = glob.mid(hostStart, pathStart < 0 ? -1 : pathStart - hostStart).toLower();
+
+        const int hostStarPos = host.lastIndexOf(QLatin1Char('*'));
+        const bool isHostIndexable = !host.isEmpty()
+                && !host.contains(QLatin1Char(':'))
+                && !host.contains(QLatin1Char('@'))
+                && !host.contains(QLatin1Char('?'))
+                && !host.contains(QLatin1Char('#'))
+                && (hostStarPos < 0
+                    || host.size() == 1
+                    || (hostStarPos == 0 && host.at(1) == QLatin1Char('.')));
+        if (isHostIndexable)
+        {
+            if (hostStarPos < 0)
+                rule.Kind = HostKind::Exact;
+            else if (host.size() == 1)
+                rule.Kind = HostKind::Any;
+            else
+            {
+                rule.Kind = HostKind::Subdomain;
+                host = host.mid(2);
+            }
+
+            rule.SchemeGlob = glob.left(schemeEnd).toLower();
+            rule.IsAnyPort = rule.Kind == HostKind::Any;
+            rule.Glob = pathStart < 0 ? QString(QLatin1Char('/')) : glob.mid(pathStart);
+            addRule(std::move(rule), host);
+            return;
+        }
+    }
+
+    rule.Glob = glob;
+    addRule(std::move(rule), QString());
+}
+
+void UserScriptMatcher::compileMatchPattern(int scriptIndex, const QString &pattern)
+{
+    Rule rule;
+    rule.ScriptIndex = scriptIndex;
+    rule.IsExclude = false;
+    rule.Kind = HostKind::Any;
+    rule.IsAnyPort = true;
+
+    if (pattern.compare(QLatin1String("<all_urls>")) == 0)
+    {
+        rule.Glob = QLatin1String("*");
+        for (const char *scheme : AllUrlSchemes)
+        {
+            Rule schemeRule = rule;
+            schemeRule.SchemeGlob = QLatin1String(scheme);
+            addRule(std::move(schemeRule), QString());
+        }
+        return;
+    }
+
+    const int schemeEnd = pattern.indexOf(QLatin1String("://"));
+    if (schemeEnd <= 0)
+        return;
+
+    const QString scheme = pattern.left(schemeEnd).toLower();
+    if (scheme.compare(QLatin1String("*")) != 0
+            && scheme.compare(QLatin1String("http")) != 0
+            && scheme.compare(QLatin1String("https")) != 0
+            && scheme.compare(QLatin1String("ftp")) != 0
+            && scheme.compare(QLatin1String("file")) != 0)
+        return;
+
+    // The path is mandatory, and the host may only be empty for file URLs
+    const int hostStart = schemeEnd + 3;
+    const int pathStart = pattern.indexOf(QLatin1Char('/'), hostStart);
+    if (pathStart < 0)
+        return;
+
+    QString host = pattern.mid(hostStart, pathStart - hostStart).toLower();
+    if (host.isEmpty() && scheme.compare(QLatin1String("file")) != 0)
+        return;
+
+    const int hostStarPos = host.lastIndexOf(QLatin1Char('*'));
+    if (hostStarPos < 0)
+        rule.Kind = HostKind::Exact;
+    else if (host.size() == 1)
+        rule.Kind = HostKind::Any;
+    else if (hostStarPos == 0 && host.at(1) == QLatin1Char('.'))
+    {
+        rule.Kind = HostKind::Domain;
+        host = host.mid(2);
+    }
+    else
+        return;
+
+    rule.Glob = pattern.mid(pathStart);
+
+    // A '*' scheme stands for either http or https
+    if (scheme.compare(QLatin1String("*")) == 0)
+    {
+        Rule httpRule = rule;
+        httpRule.SchemeGlob = QLatin1String("http");
+        addRule(std::move(httpRule), host);
+
+        rule.SchemeGlob = QLatin1String("https");
+    }
+    else
+        rule.SchemeGlob = scheme;
+
+    addRule(std::move(rule), host);
+}
+
+void UserScriptMatcher::addRule(Rule &&rule, const QString &host)
+{
+    const int ruleIndex = static_cast<int>(m_rules.size());
+    const HostKind kind = rule.Kind;
+    m_rules.push_back(std::move(rule));
+
+    if (kind == HostKind::Any || kind == HostKind::Url)
+    {
+        m_anyHostRules.push_back(ruleIndex);
+        return;
+    }
+
+    HostNode *node = &m_hostRoot;
+    QString label;
+    int end = host.size();
+    while (previousLabel(host, end, label))
+    {
+        std::unique_ptr<HostNode> &child = node->Children[label];
+        if (!child)
+            child = std::make_unique<HostNode>();
+
+        node = child.get();
+    }
+
+    node->Rules.push_back(ruleIndex);
+}
+
+std::shared_ptr<const UserScriptMatcher::OriginRules> UserScriptMatcher::getOriginRules(const QUrl &url, bool hasAuthority)
+{
+    const QString scheme = url.scheme();
+    const QString host = url.host(QUrl::FullyEncoded);
+    const int port = url.port();
+
+    const QString originKey = scheme + (hasAuthority ? QLatin1String("://") : QLatin1String(":")) + host
+            + QLatin1Char(':') + QString::number(port);
+    const std::string cacheKey = originKey.toStdString();
+    if (std::optional<std::shared_ptr<const OriginRules>> cachedRules = m_originCache.tryGet(cacheKey))
+        return *cachedRules;
+
+    auto originRules = std::make_shared<OriginRules>();
+    std::vector<int> &rules = originRules->Rules;
+
+    for (int ruleIndex : m_anyHostRules)
+    {
+        if (isOriginMatch(m_rules.at(ruleIndex), scheme, port, hasAuthority))
+            rules.push_back(ruleIndex);
+    }
+
+    // Follow the labels of the host from the root of the tree. Domain and Subdomain rules apply to each
+    // parent domain of the host, while Exact and Domain rules apply to the host itself
+    auto collectRules = [&](const HostNode *node, bool isHost) {
+        for (int ruleIndex : node->Rules)
+        {
+            const Rule &rule = m_rules.at(ruleIndex);
+            const bool isHostMatch = isHost ? rule.Kind != HostKind::Subdomain : rule.Kind != HostKind::Exact;
+            if (isHostMatch && isOriginMatch(rule, scheme, port, hasAuthority))
+                rules.push_back(ruleIndex);
+        }
+    };
+
+    const HostNode *node = &m_hostRoot;
+    bool isHostFound = true;
+    QString label;
+    int end = host.size();
+    while (previousLabel(host, end, label))
+    {
+        collectRules(node, false);
+
+        auto it = node->Children.find(label);
+        if (it == node->Children.end())
+        {
+            isHostFound = false;
+            break;
+        }
+
+        node = it->second.get();
+    }
+
+    if (isHostFound)
+        collectRules(node, true);
+
+    std::sort(rules.begin(), rules.end());
+
+    originRules->IsPathIndependent = std::all_of(rules.begin(), rules.end(), [this](int ruleIndex) {
+        return m_rules.at(ruleIndex).isPathIndependent();
+    });
+    if (originRules->IsPathIndependent)
+        originRules->Scripts = matchRules(rules, QString(), QString());
+
+    m_originCache.put(cacheKey, originRules);
+    return originRules;
+}
+
+std::vector<int> UserScriptMatcher::matchRules(const std::vector<int> &ruleIndices, const QString &urlString, const QString &pathString) const
+{
+    std::vector<int> result;
+
+    // The rules of a script are next to each other, as the indices are in ascending order
+    const std::size_t numRules = ruleIndices.size();
+    std::size_t i = 0;
+    while (i < numRules)
+    {
+        const int scriptIndex = m_rules.at(ruleIndices.at(i)).ScriptIndex;
+        bool isIncluded = false, isExcluded = false;
+
+        for (; i < numRules && m_rules.at(ruleIndices.at(i)).ScriptIndex == scriptIndex; ++i)
+        {
+            const Rule &rule = m_rules.at(ruleIndices.at(i));
+            if (isExcluded || (isIncluded && !rule.IsExclude))
+                continue;
+
+            bool isMatch = false;
+            if (rule.Kind == HostKind::Url)
+                isMatch = rule.Glob.isEmpty() ? rule.RegExp.match(urlString).hasMatch() : globMatch(rule.Glob, urlString);
+            else
+                isMatch = rule.isPathIndependent() || globMatch(rule.Glob, pathString);
+
+            if (isMatch)
+            {
+                if (rule.IsExclude)
+                    isExcluded = true;
+                else
+                    isIncluded = true;
+            }
+        }
+
+        if (isIncluded && !isExcluded)
+            result.push_back(scriptIndex);
+    }
+
+    return result;
+}
+
+bool UserScriptMatcher::isOriginMatch(const Rule &rule, const QString &scheme, int port, bool hasAuthority) const
+{
+    if (rule.Kind == HostKind::Url)
+        return true;
+
+    // URLs such as about:blank are only matched by rules that match everything
+    if (!hasAuthority)
+        return rule.isUniversal();
+
+    return (rule.IsAnyPort || port < 0) && globMatch(rule.SchemeGlob, scheme);
+}
+
+bool UserScriptMatcher::previousLabel(const QString &host, int &end, QString &label)
+{
+    while (end > 0)
+    {
+        const int dotPos = host.lastIndexOf(QLatin1Char('.'), end - 1);
+        const int start = dotPos + 1;
+        const int length = end - start;
+        end = dotPos;
+
+        if (length > 0)
+        {
+            label = host.mid(start, length);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool UserScriptMatcher::globMatch(const QString &glob, const QString &str)
+{
+    const int globSize = glob.size(), strSize = str.size();
+    int globPos = 0, strPos = 0;
+
+    // Position in the glob after the last '*' seen, and the position in the string that it was matched up to
+    int starGlobPos = -1, starStrPos = 0;
+
+    while (strPos < strSize)
+    {
+        if (globPos < globSize && glob.at(globPos) == QLatin1Char('*'))
+        {
+            starGlobPos = ++globPos;
+            starStrPos = strPos;
+        }
+        else if (globPos < globSize && glob.at(globPos) == str.at(strPos))
+        {
+            ++globPos;
+            ++strPos;
+        }
+        else if (starGlobPos >= 0)
+        {
+            // Let the last '*' consume one more character, and retry from there
+            globPos = starGlobPos;
+            strPos = ++starStrPos;
+        }
+        else
+            return false;
+    }
+
+    while (globPos < globSize && glob.at(globPos) == QLatin1Char('*'))
+        ++globPos;
+
+    return globPos == globSize;
+}
@@ -0,0 +1,175 @@
+#ifndef USERSCRIPTMATCHER_H
+#define USERSCRIPTMATCHER_H
+
+#include "ShardedLRUCache.h"
+#include "UserScript.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <QHash>
+#include <QRegularExpression>
+#include <QString>
+#include <QUrl>
+
+/**
+ * @class UserScriptMatcher
+ * @brief Finds the user scripts that apply to a URL, with the @include, @match and @exclude rules of every
+ *        enabled script compiled into a single structure.
+ *
+ * Rules that name a host, or a domain and its subdomains, are stored in a tree of host labels in reverse order,
+ * so only the rules of the hosts along one path of the tree are considered for a URL. Rules that apply to any
+ * host are always considered. The rules that remain for an origin are kept in a small cache, and when none of
+ * them depend on the path of the URL, the matching scripts are cached as well.
+ *
+ * Globs only treat the '*' character as a wildcard, and are matched against the whole URL. Include rules written
+ * as /regular expressions/ are also supported, but are checked against every URL.
+ */
+class UserScriptMatcher
+{
+public:
+    /// Constructs an empty matcher
+    UserScriptMatcher();
+
+    /// Compiles the rules of the enabled scripts in the given container, replacing any previously compiled rules
+    void build(const std::vector<UserScript> &scripts);
+
+    /// Removes all compiled rules
+    void clear();
+
+    /// Returns the indices of the scripts that apply to the given URL, in the order of the container that was
+    /// passed to \ref build
+    std::vector<int> match(const QUrl &url);
+
+private:
+    /// Type of host that a rule applies to
+    enum class HostKind
+    {
+        /// Any host
+        Any,
+
+        /// A single host
+        Exact,
+
+        /// A domain and each of its subdomains
+        Domain,
+
+        /// Subdomains of a domain, but not the domain itself
+        Subdomain,
+
+        /// The rule is checked against the whole URL, either as a glob or as a regular expression
+        Url
+    };
+
+    /// A compiled @include, @match or @exclude rule
+    struct Rule
+    {
+        /// Index of the script that the rule belongs to
+        int ScriptIndex;
+
+        /// True if the rule is an @exclude rule, false if it is an @include or @match rule
+        bool IsExclude;
+
+        /// Type of host that the rule applies to
+        HostKind Kind;
+
+        /// Glob of the URL schemes that the rule applies to. Not used by Url rules
+        QString SchemeGlob;
+
+        /// True if the rule applies to URLs with any port, false if it only applies to URLs without a port
+        bool IsAnyPort;
+
+        /// Glob of the path, query and fragment of the URL, or of the whole URL for a Url rule
+        QString Glob;
+
+        /// Regular expression of a Url rule, used when the glob is empty
+        QRegularExpression RegExp;
+
+        /// Returns true if the rule gives the same result for any URL of an origin that it applies to
+        bool isPathIndependent() const;
+
+        /// Returns true if the rule applies to every URL, including those without a host
+        bool isUniversal() const;
+    };
+
+    /// Hashes the labels of a host with the hash function used by Qt containers
+    struct LabelHash
+    {
+        std::size_t operator()(const QString &label) const noexcept
+        {
+            return static_cast<std::size_t>(qHash(label));
+        }
+    };
+
+    /// A domain within the tree of host labels
+    struct HostNode
+    {
+        /// Subdomains of this domain, by their leftmost label
+        std::unordered_map<QString, std::unique_ptr<HostNode>, LabelHash> Children;
+
+        /// Indices of the Exact, Domain and Subdomain rules of this domain
+        std::vector<int> Rules;
+    };
+
+    /// Rules of an origin, kept in the origin cache
+    struct OriginRules
+    {
+        /// Indices of the rules that apply to the origin, in ascending order
+        std::vector<int> Rules;
+
+        /// True if none of the rules depend on the path of the URL, in which case the result is stored in Scripts
+        bool IsPathIndependent;
+
+        /// Indices of the scripts that apply to every URL of the origin, if the rules are path independent
+        std::vector<int> Scripts;
+    };
+
+    /// Compiles an @include or @exclude glob of the script with the given index
+    void compileGlob(int scriptIndex, bool isExclude, const QString &glob);
+
+    /// Compiles an @match pattern of the script with the given index. Invalid patterns are ignored
+    void compileMatchPattern(int scriptIndex, const QString &pattern);
+
+    /// Adds the rule to the tree of host labels, or to the rules that are considered for any host
+    void addRule(Rule &&rule, const QString &host);
+
+    /**
+     * @brief Collects the rules that apply to an origin, which are cached for later calls
+     * @param url The URL
+     * @param hasAuthority True if the URL has a "scheme://" prefix, false for URLs such as about:blank
+     * @return The rules of the origin of the URL
+     */
+    std::shared_ptr<const OriginRules> getOriginRules(const QUrl &url, bool hasAuthority);
+
+    /// Returns the indices of the scripts whose rules match the URL, given the rules of its origin and
+    /// the URL both as a whole and without its scheme and authority
+    std::vector<int> matchRules(const std::vector<int> &ruleIndices, const QString &urlString, const QString &pathString) const;
+
+    /// Returns true if the rule applies to a URL with the given scheme and port, without considering the host
+    bool isOriginMatch(const Rule &rule, const QString &scheme, int port, bool hasAuthority) const;
+
+    /// Reads the label of a host that ends before the given position, moving right to left. Returns false
+    /// if the start of the host was reached
+    static bool previousLabel(const QString &host, int &end, QString &label);
+
+    /// Returns true if the string matches the glob, in which a '*' matches any sequence of characters
+    static bool globMatch(const QString &glob, const QString &str);
+
+private:
+    /// Every compiled rule, ordered by the index of its script
+    std::vector<Rule> m_rules;
+
+    /// Root of the tree of host labels
+    HostNode m_hostRoot;
+
+    /// Indices of the rules that are considered for every host
+    std::vector<int> m_anyHostRules;
+
+    /// Rules of the most recently visited origins
+    ShardedLRUCache<std::string, std::shared_ptr<const OriginRules>> m_originCache;
+};
+
+#endif // USERSCRIPTMATCHER_H
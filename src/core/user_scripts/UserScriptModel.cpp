@@ -19,6 +19,7 @@ UserScriptModel::UserScriptModel(DownloadManager *downloadManager, Settings *set
     m_scriptTemplate(),
     m_scriptDepDir(),
     m_enabled(false),
+    m_revision(1),
     m_downloadManager(downloadManager),
     m_settings(settings)
 {
@@ -39,6 +40,7 @@ void UserScriptModel::addScript(const UserScript &script)
     beginInsertRows(QModelIndex(), rowNum, rowNum);
     m_scripts.push_back(script);
     loadDependencies(rowNum);
+    ++m_revision;
     endInsertRows();
 }
 
@@ -48,6 +50,7 @@ void UserScriptModel::addScript(UserScript &&script)
     beginInsertRows(QModelIndex(), rowNum, rowNum);
     m_scripts.push_back(script);
     loadDependencies(rowNum);
+    ++m_revision;
     endInsertRows();
 }
 
@@ -143,6 +146,7 @@ bool UserScriptModel::setData(const QModelIndex &index, const QVariant &/*value*
     {
         UserScript &script = m_scripts[index.row()];
         script.setEnabled(!script.isEnabled());
+        ++m_revision;
         emit dataChanged(index, index);
         return true;
     }
@@ -170,6 +174,7 @@ bool UserScriptModel::removeRows(int row, int count, const QModelIndex &parent)
             f.remove();
         it = m_scripts.erase(it);
     }
+    ++m_revision;
     endRemoveRows();
     return true;
 }
@@ -181,7 +186,10 @@ void UserScriptModel::reloadScript(int indexRow)
 
     UserScript &script = m_scripts.at(indexRow);
     if (script.load(script.m_fileName, m_scriptTemplate))
+    {
         loadDependencies(indexRow);
+        ++m_revision;
+    }
 }
 
 void UserScriptModel::load()
@@ -248,6 +256,8 @@ void UserScriptModel::load()
     int numScripts = static_cast<int>(m_scripts.size());
     for (int i = 0; i < numScripts; ++i)
         loadDependencies(i);
+
+    ++m_revision;
 }
 
 void UserScriptModel::loadDependencies(int scriptIdx)
@@ -276,10 +286,11 @@ void UserScriptModel::loadDependencies(int scriptIdx)
             connect(item, &InternalDownloadItem::downloadFinished, [=](const QString &filePath){
                 QFile tmp(filePath);
                 QByteArray tmpData;
-                if (tmp.open(QIODevice::ReadOnly))
+                if (tmp.open(QIODevice::ReadOnly) && scriptIdx < static_cast<int>(m_scripts.size()))
                 {
                     tmpData = tmp.readAll();
                     m_scripts[scriptIdx].m_dependencyData.append(tmpData);
+                    markScriptChanged(scriptIdx);
                     tmp.close();
                 }
                 item->deleteLater();
@@ -311,3 +322,12 @@ void UserScriptModel::save()
     dataFile.write(scriptMgrDoc.toJson());
     dataFile.close();
 }
+
+void UserScriptModel::markScriptChanged(int scriptIdx)
+{
+    if (scriptIdx < 0 || scriptIdx >= static_cast<int>(m_scripts.size()))
+        return;
+
+    m_scripts.at(scriptIdx).markChanged();
+    ++m_revision;
+}
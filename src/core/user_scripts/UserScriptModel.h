@@ -81,6 +81,9 @@ public Q_SLOTS:
     /// Saves user script information to a user script configuration file
     void save();
 
+    /// Records a change to the code or dependencies of the script at the given index
+    void markScriptChanged(int scriptIdx);
+
 protected:
     /// Container used to store user scripts
     std::vector<UserScript> m_scripts;
@@ -97,6 +100,9 @@ public Q_SLOTS:
     /// True if scripts are enabled, false if else
     bool m_enabled;
 
+    /// Incremented each time a script is added, removed, enabled, disabled or changed
+    quint64 m_revision;
+
 private:
     /// Network download manager
     DownloadManager *m_downloadManager;
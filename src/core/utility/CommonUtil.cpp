@@ -1,7 +1,26 @@
 #include "CommonUtil.h"
 
+#include <algorithm>
 #include <array>
+#include <utility>
+#include <vector>
+
 #include <QBuffer>
+#include <QDataStream>
+#include <QImage>
+#include <QPixmap>
+
+namespace
+{
+    /// Identifies data produced by CommonUtil::iconToBytes
+    constexpr quint32 IconDataMagic = 0x5649434E;
+
+    /// Version of the icon data format
+    constexpr quint8 IconDataVersion = 1;
+
+    /// Largest icon resolution, in pixels, that is stored by CommonUtil::iconToBytes
+    constexpr int MaxStoredIconSize = 64;
+}
 
 namespace CommonUtil
 {
@@ -66,6 +85,122 @@ namespace CommonUtil
         return data.toBase64();
     }
 
+    QByteArray iconToBytes(const QIcon &icon)
+    {
+        return imagesToBytes(iconToImages(icon));
+    }
+
+    std::vector<QImage> iconToImages(const QIcon &icon)
+    {
+        std::vector<QImage> images;
+        if (icon.isNull())
+            return images;
+
+        std::vector<QSize> sizes;
+        for (const QSize &size : icon.availableSizes())
+        {
+            if (size.width() <= MaxStoredIconSize && size.height() <= MaxStoredIconSize)
+                sizes.push_back(size);
+        }
+
+        // Scalable icons, or those only available in large sizes, are stored at common favicon resolutions
+        if (sizes.empty())
+            sizes = { QSize(16, 16), QSize(32, 32) };
+
+        std::sort(sizes.begin(), sizes.end(), [](const QSize &a, const QSize &b) {
+            return a.width() * a.height() < b.width() * b.height();
+        });
+        sizes.erase(std::unique(sizes.begin(), sizes.end()), sizes.end());
+
+        for (const QSize &size : sizes)
+        {
+            QImage img = icon.pixmap(size).toImage();
+            if (!img.isNull())
+                images.push_back(std::move(img));
+        }
+
+        return images;
+    }
+
+    QByteArray imagesToBytes(const std::vector<QImage> &images)
+    {
+        std::vector<QByteArray> encodedImages;
+        for (const QImage &img : images)
+        {
+            if (img.isNull())
+                continue;
+
+            QByteArray imageData;
+            QBuffer buffer(&imageData);
+            if (img.save(&buffer, "PNG"))
+                encodedImages.push_back(imageData);
+        }
+
+        if (encodedImages.empty())
+            return QByteArray();
+
+        QByteArray result;
+        QDataStream stream(&result, QIODevice::WriteOnly);
+        stream.setVersion(QDataStream::Qt_5_0);
+        stream << IconDataMagic
+               << IconDataVersion
+               << static_cast<quint8>(encodedImages.size());
+        for (const QByteArray &imageData : encodedImages)
+            stream << imageData;
+
+        return result;
+    }
+
+    QIcon iconFromBytes(const QByteArray &data)
+    {
+        return iconFromImages(imagesFromBytes(data));
+    }
+
+    std::vector<QImage> imagesFromBytes(const QByteArray &data)
+    {
+        std::vector<QImage> images;
+        if (data.isEmpty())
+            return images;
+
+        QDataStream stream(data);
+        stream.setVersion(QDataStream::Qt_5_0);
+
+        quint32 magic = 0;
+        quint8 version = 0, numImages = 0;
+        stream >> magic
+               >> version
+               >> numImages;
+
+        // Data that is not in the icon format is treated as a single image file
+        if (magic != IconDataMagic || version != IconDataVersion)
+        {
+            QImage img = QImage::fromData(data);
+            if (!img.isNull())
+                images.push_back(std::move(img));
+            return images;
+        }
+
+        for (quint8 i = 0; i < numImages && stream.status() == QDataStream::Ok; ++i)
+        {
+            QByteArray imageData;
+            stream >> imageData;
+
+            QImage img = QImage::fromData(imageData, "PNG");
+            if (!img.isNull())
+                images.push_back(std::move(img));
+        }
+
+        return images;
+    }
+
+    QIcon iconFromImages(const std::vector<QImage> &images)
+    {
+        QIcon icon;
+        for (const QImage &img : images)
+            icon.addPixmap(QPixmap::fromImage(img));
+        return icon;
+    }
+
     quint64 quPow(quint64 base, quint64 exp)
     {
         quint64 result = 1;
@@ -3,8 +3,10 @@
 
 #include <string>
 #include <functional>
+#include <vector>
 
 #include <QIcon>
+#include <QImage>
 #include <QRegularExpression>
 #include <QString>
 #include <QtGlobal>
@@ -38,6 +40,28 @@ namespace CommonUtil
     /// Returns the base64 encoding of the given icon
     QByteArray iconToBase64(QIcon icon);
 
+    /// Converts the given icon into a binary form suitable for database storage, containing a PNG image
+    /// of each resolution of the icon up to 64x64 pixels
+    QByteArray iconToBytes(const QIcon &icon);
+
+    /// Returns an image of each resolution of the given icon that is stored by \ref iconToBytes , so the images
+    /// can be encoded on another thread with \ref imagesToBytes . Must be called from the GUI thread
+    std::vector<QImage> iconToImages(const QIcon &icon);
+
+    /// Converts the given images, each being a resolution of the same icon, into the binary form produced by \ref iconToBytes .
+    /// Unlike the QIcon based conversion, this is safe to call from any thread
+    QByteArray imagesToBytes(const std::vector<QImage> &images);
+
+    /// Converts the result of \ref iconToBytes , or the data of a single image file, into a QIcon
+    QIcon iconFromBytes(const QByteArray &data);
+
+    /// Converts the result of \ref iconToBytes , or the data of a single image file, into the images of each
+    /// resolution of the icon. Unlike \ref iconFromBytes , this is safe to call from any thread
+    std::vector<QImage> imagesFromBytes(const QByteArray &data);
+
+    /// Returns an icon with a pixmap of each of the given images. Must be called from the GUI thread
+    QIcon iconFromImages(const std::vector<QImage> &images);
+
     /// Computes and returns base^exp
     quint64 quPow(quint64 base, quint64 exp);
 
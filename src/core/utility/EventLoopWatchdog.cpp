@@ -0,0 +1,46 @@
+#include "EventLoopWatchdog.h"
+
+#include <algorithm>
+
+EventLoopWatchdog::EventLoopWatchdog(int intervalMs, int thresholdMs, QObject *parent) :
+    QObject(parent),
+    m_timer(),
+    m_elapsedTimer(),
+    m_intervalMs(intervalMs),
+    m_thresholdMs(thresholdMs),
+    m_stats()
+{
+    m_timer.setTimerType(Qt::PreciseTimer);
+    m_timer.setInterval(m_intervalMs);
+    connect(&m_timer, &QTimer::timeout, this, &EventLoopWatchdog::onTimeout);
+}
+
+void EventLoopWatchdog::start()
+{
+    m_elapsedTimer.start();
+    m_timer.start();
+}
+
+void EventLoopWatchdog::stop()
+{
+    m_timer.stop();
+    m_elapsedTimer.invalidate();
+}
+
+const EventLoopStallStats &EventLoopWatchdog::getStats() const
+{
+    return m_stats;
+}
+
+void EventLoopWatchdog::onTimeout()
+{
+    const qint64 delay = m_elapsedTimer.restart() - m_intervalMs;
+    if (delay < m_thresholdMs)
+        return;
+
+    ++m_stats.Count;
+    m_stats.TotalMs += delay;
+    m_stats.LongestMs = std::max(m_stats.LongestMs, delay);
+
+    emit stallDetected(delay);
+}
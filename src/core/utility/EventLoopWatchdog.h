@@ -0,0 +1,76 @@
+#ifndef EVENTLOOPWATCHDOG_H
+#define EVENTLOOPWATCHDOG_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+/// Counts how often, and for how long, an event loop was blocked
+struct EventLoopStallStats
+{
+    /// Number of stalls that were detected
+    int Count { 0 };
+
+    /// Combined duration of every stall, in milliseconds
+    qint64 TotalMs { 0 };
+
+    /// Duration of the longest stall, in milliseconds
+    qint64 LongestMs { 0 };
+};
+
+/**
+ * @class EventLoopWatchdog
+ * @brief Detects stalls of the event loop of the thread it lives in, such as the GUI thread.
+ *
+ * The watchdog starts a timer that fires at a regular interval. When the timer fires later than it
+ * should by at least the stall threshold, the event loop could not process events for that long,
+ * and the delay is recorded as a stall.
+ */
+class EventLoopWatchdog : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Constructs the watchdog. The watchdog is idle until \ref start is called
+     * @param intervalMs Interval between checks of the event loop, in milliseconds
+     * @param thresholdMs Minimum delay of a check, in milliseconds, that is recorded as a stall
+     * @param parent Parent object
+     */
+    explicit EventLoopWatchdog(int intervalMs = 250, int thresholdMs = 100, QObject *parent = nullptr);
+
+    /// Starts watching the event loop
+    void start();
+
+    /// Stops watching the event loop. The recorded stalls are kept
+    void stop();
+
+    /// Returns the stalls that were recorded since the watchdog was constructed
+    const EventLoopStallStats &getStats() const;
+
+Q_SIGNALS:
+    /// Emitted when the event loop was blocked for the given number of milliseconds
+    void stallDetected(qint64 durationMs);
+
+private Q_SLOTS:
+    /// Compares the time since the last check with the interval of the timer
+    void onTimeout();
+
+private:
+    /// Fires at the check interval
+    QTimer m_timer;
+
+    /// Measures the time since the last check
+    QElapsedTimer m_elapsedTimer;
+
+    /// Interval between checks, in milliseconds
+    int m_intervalMs;
+
+    /// Minimum delay that is recorded as a stall, in milliseconds
+    int m_thresholdMs;
+
+    /// Stalls recorded so far
+    EventLoopStallStats m_stats;
+};
+
+#endif // EVENTLOOPWATCHDOG_H
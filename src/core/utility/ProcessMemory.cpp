@@ -0,0 +1,112 @@
+#include "ProcessMemory.h"
+
+#include <unordered_map>
+#include <vector>
+
+#include <QByteArray>
+#include <QDir>
+#include <QFile>
+#include <QString>
+#include <QStringList>
+
+#if defined(Q_OS_LINUX)
+#include <unistd.h>
+#endif
+
+namespace
+{
+    /// Reads the contents of a small file in the /proc file system, which does not report the size of its files
+    QByteArray readProcFile(const QString &fileName)
+    {
+        QFile file(fileName);
+        if (!file.open(QIODevice::ReadOnly))
+            return QByteArray();
+        return file.readAll();
+    }
+
+    /// Returns the parent process identifier in the given contents of a /proc/[pid]/stat file, or -1 on failure
+    qint64 getParentPid(const QByteArray &stat)
+    {
+        // The process name is enclosed in parentheses and may contain spaces, so
+        // the fields following it are found from the last closing parenthesis
+        const int nameEnd = stat.lastIndexOf(')');
+        if (nameEnd < 0)
+            return -1;
+
+        const QList<QByteArray> fields = stat.mid(nameEnd + 1).simplified().split(' ');
+        if (fields.size() < 2)
+            return -1;
+
+        bool ok = false;
+        const qint64 parentPid = fields.at(1).toLongLong(&ok);
+        return ok ? parentPid : -1;
+    }
+}
+
+namespace ProcessMemory
+{
+    qint64 getResidentSetSize(qint64 pid)
+    {
+#if defined(Q_OS_LINUX)
+        // The second field of statm is the number of resident pages
+        const QByteArray statm = readProcFile(QString("/proc/%1/statm").arg(pid));
+        const QList<QByteArray> fields = statm.simplified().split(' ');
+        if (fields.size() < 2)
+            return -1;
+
+        bool ok = false;
+        const qint64 residentPages = fields.at(1).toLongLong(&ok);
+        if (!ok)
+            return -1;
+
+        return residentPages * static_cast<qint64>(sysconf(_SC_PAGESIZE));
+#else
+        Q_UNUSED(pid);
+        return -1;
+#endif
+    }
+
+    qint64 getProcessTreeResidentSetSize(qint64 rootPid)
+    {
+        const qint64 rootSize = getResidentSetSize(rootPid);
+        if (rootSize < 0)
+            return -1;
+
+        // Map every process to its children, then sum the sizes of the descendants of the root
+        std::unordered_map<qint64, std::vector<qint64>> children;
+        const QStringList entries = QDir(QLatin1String("/proc")).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+        for (const QString &entry : entries)
+        {
+            bool ok = false;
+            const qint64 pid = entry.toLongLong(&ok);
+            if (!ok)
+                continue;
+
+            const qint64 parentPid = getParentPid(readProcFile(QString("/proc/%1/stat").arg(pid)));
+            if (parentPid > 0)
+                children[parentPid].push_back(pid);
+        }
+
+        qint64 totalSize = rootSize;
+        std::vector<qint64> pending { rootPid };
+        while (!pending.empty())
+        {
+            const qint64 pid = pending.back();
+            pending.pop_back();
+
+            auto it = children.find(pid);
+            if (it == children.end())
+                continue;
+
+            for (qint64 childPid : it->second)
+            {
+                const qint64 childSize = getResidentSetSize(childPid);
+                if (childSize > 0)
+                    totalSize += childSize;
+                pending.push_back(childPid);
+            }
+        }
+
+        return totalSize;
+    }
+}
@@ -0,0 +1,19 @@
+#ifndef PROCESSMEMORY_H
+#define PROCESSMEMORY_H
+
+#include <QtGlobal>
+
+/// Functions that measure the memory used by the browser and the web engine processes it spawns
+namespace ProcessMemory
+{
+    /// Returns the resident set size, in bytes, of the process with the given identifier,
+    /// or -1 if it could not be determined
+    qint64 getResidentSetSize(qint64 pid);
+
+    /// Returns the combined resident set size, in bytes, of the process with the given identifier and
+    /// all of its descendants, such as the web engine's renderer processes. Returns -1 if the memory
+    /// usage could not be determined, which is the case on platforms without a /proc file system
+    qint64 getProcessTreeResidentSetSize(qint64 rootPid);
+}
+
+#endif // PROCESSMEMORY_H
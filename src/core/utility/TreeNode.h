@@ -7,7 +7,7 @@
 
 /**
  * @class TreeNode
- * @brief Implementation of a tree structure
+ * @brief Implementation of a tree structure. The type T must derive from TreeNode<T>
  */
 template <class T>
 class TreeNode
@@ -22,7 +22,7 @@ class TreeNode
     /// Appends the given node to this node, returning a raw pointer to the child node
     virtual T *appendNode(std::unique_ptr<T> node)
     {
-        node->m_parent = dynamic_cast<T*>(this);
+        node->m_parent = static_cast<T*>(this);
         T *nodePtr = node.get();
         m_children.push_back(std::move(node));
         return nodePtr;
@@ -32,7 +32,7 @@ class TreeNode
     /// If the index is invalid, this will simply append the node to the end
     virtual T *insertNode(std::unique_ptr<T> node, int index)
     {
-        node->m_parent = dynamic_cast<T*>(this);
+        node->m_parent = static_cast<T*>(this);
         T *nodePtr = node.get();
 
         if (index < 0 || index > static_cast<int>(m_children.size()))
@@ -96,7 +96,7 @@ class TreeNode
 
 protected:
     /// Pointer to the node's parent
-    T *m_parent;
+    T *m_parent = nullptr;
 
     /// Vector of child nodes belonging to this node
     std::vector< std::unique_ptr<T> > m_children;
@@ -0,0 +1,33 @@
+#include "PageScriptCollection.h"
+
+#include <QWebEngineScriptCollection>
+
+PageScriptCollection::PageScriptCollection(QWebEngineScriptCollection &collection) :
+    m_collection(collection),
+    m_scripts()
+{
+}
+
+void PageScriptCollection::setScripts(std::vector<QWebEngineScript> &&scripts)
+{
+    // Scripts of the same world run in the order they were inserted, so only the scripts before the first
+    // difference can stay in the collection. The rest are removed and inserted again in their new order
+    std::size_t numKept = 0;
+    while (numKept < m_scripts.size() && numKept < scripts.size() && m_scripts[numKept] == scripts[numKept])
+        ++numKept;
+
+    for (std::size_t i = numKept; i < m_scripts.size(); ++i)
+        m_collection.remove(m_scripts[i]);
+
+    m_scripts.resize(numKept);
+    for (std::size_t i = numKept; i < scripts.size(); ++i)
+    {
+        m_collection.insert(scripts[i]);
+        m_scripts.push_back(std::move(scripts[i]));
+    }
+}
+
+const std::vector<QWebEngineScript> &PageScriptCollection::getScripts() const
+{
+    return m_scripts;
+}
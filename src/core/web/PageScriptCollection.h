@@ -0,0 +1,41 @@
+#ifndef PAGESCRIPTCOLLECTION_H
+#define PAGESCRIPTCOLLECTION_H
+
+#include <vector>
+
+#include <QWebEngineScript>
+
+class QWebEngineScriptCollection;
+
+/**
+ * @class PageScriptCollection
+ * @brief Keeps the script collection of a web page in sync with the scripts that apply to the page's current URL.
+ *
+ * The scripts for a navigation are compared with the scripts of the previous navigation. The leading scripts that are
+ * in both, such as user scripts that apply to every site, stay in the collection, and only the scripts from the first
+ * difference onwards, such as domain-specific ad block scripts, are removed and inserted again, so the order of the
+ * given scripts is preserved. Scripts are expected to be cached by their providers, in which case an unchanged script
+ * shares its data with the script in the collection, and compares equal without comparing its source code.
+ */
+class PageScriptCollection
+{
+public:
+    /// Constructs the page script collection, given the script collection of a web page
+    explicit PageScriptCollection(QWebEngineScriptCollection &collection);
+
+    /// Replaces the scripts of the page with the given scripts, keeping their order. Scripts that precede the first
+    /// difference from the current scripts stay in the collection
+    void setScripts(std::vector<QWebEngineScript> &&scripts);
+
+    /// Returns the scripts of the page
+    const std::vector<QWebEngineScript> &getScripts() const;
+
+private:
+    /// Script collection of the web page
+    QWebEngineScriptCollection &m_collection;
+
+    /// Scripts that were inserted into the collection, in order of insertion
+    std::vector<QWebEngineScript> m_scripts;
+};
+
+#endif // PAGESCRIPTCOLLECTION_H
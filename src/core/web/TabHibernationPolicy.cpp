@@ -0,0 +1,124 @@
+#include "Settings.h"
+#include "TabHibernationPolicy.h"
+
+#include <algorithm>
+
+namespace
+{
+    /// Idle time after which a background tab is hibernated in the balanced mode (30 minutes)
+    constexpr qint64 BalancedIdleTimeout = 30 * 60 * 1000;
+
+    /// Number of tabs that may be awake at once in the balanced mode
+    constexpr int BalancedMaxAwakeTabs = 30;
+
+    /// Idle time after which a background tab is hibernated in the aggressive mode (5 minutes)
+    constexpr qint64 AggressiveIdleTimeout = 5 * 60 * 1000;
+
+    /// Number of tabs that may be awake at once in the aggressive mode
+    constexpr int AggressiveMaxAwakeTabs = 10;
+}
+
+TabHibernationPolicy::TabHibernationPolicy() :
+    TabHibernationPolicy(TabHibernationMode::Disabled, 0)
+{
+}
+
+TabHibernationPolicy::TabHibernationPolicy(TabHibernationMode mode, qint64 memoryLimit) :
+    m_mode(mode),
+    m_idleTimeout(0),
+    m_maxAwakeTabs(0),
+    m_memoryLimit(std::max<qint64>(memoryLimit, 0))
+{
+    switch (m_mode)
+    {
+        case TabHibernationMode::Balanced:
+            m_idleTimeout = BalancedIdleTimeout;
+            m_maxAwakeTabs = BalancedMaxAwakeTabs;
+            break;
+        case TabHibernationMode::Aggressive:
+            m_idleTimeout = AggressiveIdleTimeout;
+            m_maxAwakeTabs = AggressiveMaxAwakeTabs;
+            break;
+        case TabHibernationMode::Disabled:
+        default:
+            m_mode = TabHibernationMode::Disabled;
+            m_memoryLimit = 0;
+            break;
+    }
+}
+
+TabHibernationPolicy TabHibernationPolicy::fromSettings(Settings *settings)
+{
+    if (!settings)
+        return TabHibernationPolicy();
+
+    const TabHibernationMode mode = static_cast<TabHibernationMode>(settings->getValue(BrowserSetting::TabHibernationPolicy).toInt());
+    const qint64 memoryLimit = settings->getValue(BrowserSetting::TabHibernationMemoryLimit).toLongLong() * 1024 * 1024;
+    return TabHibernationPolicy(mode, memoryLimit);
+}
+
+bool TabHibernationPolicy::isEnabled() const
+{
+    return m_mode != TabHibernationMode::Disabled;
+}
+
+qint64 TabHibernationPolicy::getIdleTimeout() const
+{
+    return m_idleTimeout;
+}
+
+int TabHibernationPolicy::getMaxAwakeTabs() const
+{
+    return m_maxAwakeTabs;
+}
+
+qint64 TabHibernationPolicy::getMemoryLimit() const
+{
+    return m_memoryLimit;
+}
+
+std::vector<std::size_t> TabHibernationPolicy::selectTabs(const std::vector<TabActivity> &tabs, int numAwakeTabs,
+                                                          qint64 currentTime, qint64 memoryUsage) const
+{
+    std::vector<std::size_t> result;
+    if (!isEnabled() || tabs.empty())
+        return result;
+
+    // Order the candidates from least to most recently used
+    std::vector<std::size_t> candidates;
+    candidates.reserve(tabs.size());
+    for (std::size_t i = 0; i < tabs.size(); ++i)
+    {
+        if (!tabs[i].IsExempt)
+            candidates.push_back(i);
+    }
+    std::stable_sort(candidates.begin(), candidates.end(), [&tabs](std::size_t a, std::size_t b) {
+        return tabs[a].LastActiveTime < tabs[b].LastActiveTime;
+    });
+
+    // Number of the least recently used candidates to hibernate
+    std::size_t numToHibernate = 0;
+
+    // Any tab that has been idle for long enough is hibernated
+    while (numToHibernate < candidates.size()
+           && currentTime - tabs[candidates[numToHibernate]].LastActiveTime >= m_idleTimeout)
+    {
+        ++numToHibernate;
+    }
+
+    // Reduce the number of awake tabs to the limit
+    if (numAwakeTabs > m_maxAwakeTabs)
+        numToHibernate = std::max(numToHibernate, static_cast<std::size_t>(numAwakeTabs - m_maxAwakeTabs));
+
+    // Above the memory limit, estimate the number of tabs to hibernate from the average memory used by each awake tab
+    if (m_memoryLimit > 0 && memoryUsage > m_memoryLimit && numAwakeTabs > 0)
+    {
+        const qint64 bytesPerTab = std::max<qint64>(memoryUsage / numAwakeTabs, 1);
+        const qint64 excessTabs = (memoryUsage - m_memoryLimit + bytesPerTab - 1) / bytesPerTab;
+        numToHibernate = std::max(numToHibernate, static_cast<std::size_t>(excessTabs));
+    }
+
+    numToHibernate = std::min(numToHibernate, candidates.size());
+    result.assign(candidates.begin(), candidates.begin() + static_cast<std::ptrdiff_t>(numToHibernate));
+    return result;
+}
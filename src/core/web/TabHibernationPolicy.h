@@ -0,0 +1,94 @@
+#ifndef TABHIBERNATIONPOLICY_H
+#define TABHIBERNATIONPOLICY_H
+
+#include <cstddef>
+#include <vector>
+
+#include <QtGlobal>
+
+class Settings;
+
+/// Levels of automatic tab hibernation, stored in the \ref BrowserSetting::TabHibernationPolicy setting
+enum class TabHibernationMode
+{
+    /// Tabs are only hibernated at the request of the user
+    Disabled   = 0,
+
+    /// Tabs are hibernated after a long period of inactivity, or when many tabs are open
+    Balanced   = 1,
+
+    /// Tabs are hibernated shortly after they are left, and few tabs are kept awake
+    Aggressive = 2
+};
+
+/// Describes a background tab that may be hibernated
+struct TabActivity
+{
+    /// Time at which the tab was last shown, in milliseconds since the epoch
+    qint64 LastActiveTime;
+
+    /// True if the tab must not be hibernated, such as when it is pinned or playing audio
+    bool IsExempt;
+};
+
+/**
+ * @class TabHibernationPolicy
+ * @brief Decides which background tabs should be hibernated, from least to most recently used,
+ *        based on how long they have been idle, the number of tabs that are awake, and the memory
+ *        used by the browser
+ */
+class TabHibernationPolicy
+{
+public:
+    /// Constructs a policy that never hibernates tabs
+    TabHibernationPolicy();
+
+    /**
+     * @brief Constructs the hibernation policy
+     * @param mode Level of automatic tab hibernation
+     * @param memoryLimit Amount of memory, in bytes, that the browser and its web processes may use before
+     *        tabs are hibernated to reclaim memory. A value of zero or less disables the memory limit
+     */
+    TabHibernationPolicy(TabHibernationMode mode, qint64 memoryLimit);
+
+    /// Returns the hibernation policy chosen by the user, or a policy that never hibernates tabs if the settings are null
+    static TabHibernationPolicy fromSettings(Settings *settings);
+
+    /// Returns true if tabs may be hibernated automatically, false if else
+    bool isEnabled() const;
+
+    /// Returns the time, in milliseconds, after which an inactive background tab is hibernated
+    qint64 getIdleTimeout() const;
+
+    /// Returns the number of tabs that may be awake before background tabs are hibernated
+    int getMaxAwakeTabs() const;
+
+    /// Returns the memory limit in bytes, or zero if there is no limit
+    qint64 getMemoryLimit() const;
+
+    /**
+     * @brief Selects the tabs that should be hibernated
+     * @param tabs Background tabs that are awake and could be hibernated
+     * @param numAwakeTabs Total number of tabs that are awake, including visible and exempt tabs
+     * @param currentTime Current time, in milliseconds since the epoch
+     * @param memoryUsage Memory used by the browser and its web processes in bytes, or a negative value if unknown
+     * @return Indices of the tabs to hibernate, from least to most recently used
+     */
+    std::vector<std::size_t> selectTabs(const std::vector<TabActivity> &tabs, int numAwakeTabs,
+                                        qint64 currentTime, qint64 memoryUsage) const;
+
+private:
+    /// Level of automatic tab hibernation
+    TabHibernationMode m_mode;
+
+    /// Idle time after which a background tab is hibernated, in milliseconds
+    qint64 m_idleTimeout;
+
+    /// Number of tabs that may be awake at once
+    int m_maxAwakeTabs;
+
+    /// Memory limit, in bytes
+    qint64 m_memoryLimit;
+};
+
+#endif // TABHIBERNATIONPOLICY_H
@@ -3,8 +3,11 @@
 #include "WebPage.h"
 #include "WebView.h"
 
+#include <algorithm>
+
 #include <QAction>
 #include <QDataStream>
+#include <QTimer>
 
 const QString WebHistory::SerializationVersion = QStringLiteral("WebHistory_2.0");
 
@@ -29,7 +32,8 @@ WebHistory::WebHistory(const ViperServiceLocator &serviceLocator, WebPage *paren
     QObject(parent),
     m_faviconManager(serviceLocator.getServiceAs<FaviconManager>("FaviconManager")),
     m_page(parent),
-    m_impl(nullptr)
+    m_impl(nullptr),
+    m_isIconChangeScheduled(false)
 {
     if (m_page != nullptr)
     {
@@ -40,6 +44,9 @@ WebHistory::WebHistory(const ViperServiceLocator &serviceLocator, WebPage *paren
 
         connect(m_page, &WebPage::loadFinished, this, &WebHistory::historyChanged);
     }
+
+    if (m_faviconManager)
+        connect(m_faviconManager, &FaviconManager::faviconLoaded, this, &WebHistory::onFaviconLoaded);
 }
 
 WebHistory::~WebHistory()
@@ -129,3 +136,30 @@ void WebHistory::goToEntry(const WebHistoryEntry &entry)
     if (m_impl)
         m_impl->goToItem(entry.impl);
 }
+
+void WebHistory::onFaviconLoaded(const QUrl &pageUrl)
+{
+    if (!m_impl || m_isIconChangeScheduled)
+        return;
+
+    // Only the entries shown in the back and forward menus have their icons requested
+    const auto backEntries = m_impl->backItems(10), forwardEntries = m_impl->forwardItems(10);
+    auto isEntryOfLoadedPage = [&pageUrl](const WebHistoryEntryImpl &entry) {
+        return isEntryOfPage(entry, pageUrl);
+    };
+    if (std::none_of(backEntries.begin(), backEntries.end(), isEntryOfLoadedPage)
+            && std::none_of(forwardEntries.begin(), forwardEntries.end(), isEntryOfLoadedPage))
+        return;
+
+    m_isIconChangeScheduled = true;
+    QTimer::singleShot(0, this, [this](){
+        m_isIconChangeScheduled = false;
+        emit historyChanged();
+    });
+}
+
+bool WebHistory::isEntryOfPage(const WebHistoryEntryImpl &entry, const QUrl &pageUrl)
+{
+    const QUrl::FormattingOptions options = QUrl::RemoveUserInfo | QUrl::RemoveQuery | QUrl::RemoveFragment;
+    return entry.url().matches(pageUrl, options) || entry.iconUrl().matches(pageUrl, options);
+}
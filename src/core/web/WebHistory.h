@@ -104,6 +104,15 @@ public Q_SLOTS:
     /// Goes to and loads the specified history entry, so long as the entry is valid
     void goToEntry(const WebHistoryEntry &entry);
 
+private Q_SLOTS:
+    /// Announces a change of the history if the icon of a back or forward entry has been loaded,
+    /// so that the entries are fetched again with their icon
+    void onFaviconLoaded(const QUrl &pageUrl);
+
+private:
+    /// Returns true if the given history entry belongs to the given page
+    static bool isEntryOfPage(const WebHistoryEntryImpl &entry, const QUrl &pageUrl);
+
 private:
     /// Points to the favicon manager
     FaviconManager *m_faviconManager;
@@ -113,6 +122,10 @@ public Q_SLOTS:
 
     /// Implementation of the WebHistory functionality
     WebHistoryImpl *m_impl;
+
+    /// True if a change of the history has been scheduled after icons were loaded, so that the icons
+    /// of a batch only cause one change
+    bool m_isIconChangeScheduled;
 };
 
 #endif // WEBHISTORY_H
@@ -1,7 +1,7 @@
 #include "WebHitTestResult.h"
 #include "WebPage.h"
 
-WebHitTestResult::WebHitTestResult(WebPage *page, const QString &hitTestScript) :
+WebHitTestResult::WebHitTestResult(WebPage *page, const QVariant &hitTestData) :
     m_isEditable(false),
     m_linkUrl(),
     m_mediaUrl(),
@@ -10,7 +10,7 @@ WebHitTestResult::WebHitTestResult(WebPage *page, const QString &hitTestScript)
 {
     if (page)
     {
-        QMap<QString, QVariant> resultMap = page->runJavaScriptBlocking(hitTestScript).toMap();
+        QMap<QString, QVariant> resultMap = hitTestData.toMap();
         m_isEditable = resultMap.value(QLatin1String("isEditable")).toBool();
         m_linkUrl = resultMap.value(QLatin1String("linkUrl")).toUrl();
         m_mediaUrl = resultMap.value(QLatin1String("mediaUrl")).toUrl();
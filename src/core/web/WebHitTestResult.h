@@ -10,7 +10,7 @@ class WebPage;
 
 /**
  * @class WebHitTestResult
- * @brief Executes a 'hit test' at a given position in a web view, collecting information about the
+ * @brief Holds the result of a 'hit test' at a given position in a web view, with information about the
  *        elements at that position so they can be used to execute actions in a context menu
  */
 class WebHitTestResult
@@ -25,8 +25,9 @@ class WebHitTestResult
     };
 
 public:
-    /// Constructs the hit test result given a web page and the 'hit test' script to execute on the page
-    explicit WebHitTestResult(WebPage *page, const QString &hitTestScript);
+    /// Constructs the hit test result given a web page and the value returned by the 'hit test' script that was
+    /// executed on the page. An invalid value results in an empty hit test result
+    explicit WebHitTestResult(WebPage *page, const QVariant &hitTestData);
 
     /// Returns true if the content in the context is editable, false if else
     bool isContentEditable() const;
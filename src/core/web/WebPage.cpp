@@ -10,6 +10,7 @@
 #include "FaviconStoreBridge.h"
 #include "FavoritePagesManager.h"
 #include "MainWindow.h"
+#include "PdfDocumentRegistry.h"
 #include "RequestInterceptor.h"
 #include "SecurityManager.h"
 #include "Settings.h"
@@ -21,6 +22,7 @@
 #include "WebView.h"
 
 #include <QAuthenticator>
+#include <QDebug>
 #include <QFile>
 #include <QMessageBox>
 #include <QTimer>
@@ -34,14 +36,18 @@
 #include <algorithm>
 #include <iostream>
 #include <iterator>
+#include <memory>
 
 WebPage::WebPage(const ViperServiceLocator &serviceLocator, QObject *parent) :
     QWebEnginePage(parent),
     m_adBlockManager(serviceLocator.getServiceAs<adblock::AdBlockManager>("AdBlockManager")),
     m_userScriptManager(serviceLocator.getServiceAs<UserScriptManager>("UserScriptManager")),
+    m_pdfDocumentRegistry(serviceLocator.getServiceAs<PdfDocumentRegistry>("PdfDocumentRegistry")),
     m_history(new WebHistory(serviceLocator, this)),
     m_originalUrl(),
+    m_pendingViewerToken(),
     m_mainFrameAdBlockScript(),
+    m_pageScripts(scripts()),
     m_injectedAdblock(false),
     m_permissionsAllowed(),
     m_permissionsDenied()
@@ -55,9 +61,12 @@ WebPage::WebPage(const ViperServiceLocator &serviceLocator, QWebEngineProfile *p
     QWebEnginePage(profile, parent),
     m_adBlockManager(serviceLocator.getServiceAs<adblock::AdBlockManager>("AdBlockManager")),
     m_userScriptManager(serviceLocator.getServiceAs<UserScriptManager>("UserScriptManager")),
+    m_pdfDocumentRegistry(serviceLocator.getServiceAs<PdfDocumentRegistry>("PdfDocumentRegistry")),
     m_history(new WebHistory(serviceLocator, this)),
     m_originalUrl(),
+    m_pendingViewerToken(),
     m_mainFrameAdBlockScript(),
+    m_pageScripts(scripts()),
     m_injectedAdblock(false),
     m_permissionsAllowed(),
     m_permissionsDenied()
@@ -136,6 +145,29 @@ bool WebPage::acceptNavigationRequest(const QUrl &url, QWebEnginePage::Navigatio
     m_injectedAdblock = false;
     m_originalUrl = QUrl();
 
+    // Local PDF documents are only shown in the viewer when the user navigated to them, or when a local page links to them
+    const bool canLoadLocalFile = type == QWebEnginePage::NavigationTypeTyped
+            || type == QWebEnginePage::NavigationTypeReload
+            || type == QWebEnginePage::NavigationTypeBackForward
+            || this->url().scheme() == QLatin1String("file");
+
+    // The viewer loads its document with a one-time token. A viewer that is reloaded or loaded from the page history
+    // registers its document again, and any other navigation to the viewer is given a new token
+    const QString viewerToken = PdfDocumentRegistry::getToken(url);
+    if (PdfDocumentRegistry::isViewerUrl(url) && (viewerToken.isEmpty() || viewerToken != m_pendingViewerToken))
+    {
+        const bool isRenewed = m_pdfDocumentRegistry
+                && (type == QWebEnginePage::NavigationTypeReload || type == QWebEnginePage::NavigationTypeBackForward)
+                && m_pdfDocumentRegistry->renewDocument(url, canLoadLocalFile);
+        if (!isRenewed)
+        {
+            if (!loadPdfDocument(PdfDocumentRegistry::getDocumentUrl(url), canLoadLocalFile))
+                qWarning() << "WebPage - refused to show PDF document of viewer URL " << url;
+            return false;
+        }
+    }
+    m_pendingViewerToken.clear();
+
     // Conditionally enable PDF.JS if QtWebEngine version is >= 5.13, otherwise, unconditionally enable
 #if (QTWEBENGINECORE_VERSION >= QT_VERSION_CHECK(5, 13, 0))
     const QWebEngineSettings *pageSettings = settings();
@@ -144,25 +176,13 @@ bool WebPage::acceptNavigationRequest(const QUrl &url, QWebEnginePage::Navigatio
     {
 #endif
 
-    // Check if the request is for a PDF and try to render with PDF.js
+    // Check if the request is for a PDF and try to render with PDF.js. The viewer is served by the viper
+    // scheme handler, which streams the document to the viewer as it is downloaded. Documents that may not
+    // be shown in the viewer are left to the web engine
     const QString urlString = url.toString(QUrl::FullyEncoded);
-    if (urlString.endsWith(QLatin1String(".pdf")))
-    {
-        QFile resource(":/viewer.html");
-        bool opened = resource.open(QIODevice::ReadOnly);
-        if (opened)
-        {
-            QString data = QString::fromUtf8(resource.readAll().constData());
-            int endTag = data.indexOf("</html>");
-            data.insert(endTag - 1, QString("<script>window.Response = undefined; document.addEventListener(\"DOMContentLoaded\", function() {"
-                                            " window.PDFViewerApplicationOptions.set('verbosity', pdfjsLib.VerbosityLevel.INFOS); "
-                                            " window.PDFViewerApplication.open(\"%1\");});</script>").arg(urlString));
-            QByteArray bytes;
-            bytes.append(data);
-            setHtml(bytes, url);
-            return false;
-        }
-    }
+    if (urlString.endsWith(QLatin1String(".pdf")) && url.scheme() != QLatin1String("viper")
+            && loadPdfDocument(url, canLoadLocalFile))
+        return false;
 
 #if (QTWEBENGINECORE_VERSION >= QT_VERSION_CHECK(5, 13, 0))
     }
@@ -178,89 +198,64 @@ bool WebPage::acceptNavigationRequest(const QUrl &url, QWebEnginePage::Navigatio
     if (type != QWebEnginePage::NavigationTypeReload)
     {
         URL pageUrl(url);
-        m_mainFrameAdBlockScript = m_adBlockManager->getDomainJavaScript(pageUrl);
 
-        QWebEngineScriptCollection &scriptCollection = scripts();
-        scriptCollection.clear();
-        auto pageScripts = m_userScriptManager->getAllScriptsFor(url);
-        for (auto &script : pageScripts)
-            scriptCollection.insert(script);
+        // User scripts and the ad block scripts of the domain come from caches, so scripts that also
+        // applied to the previous page are left in the collection
+        std::vector<QWebEngineScript> pageScripts = m_userScriptManager->getAllScriptsFor(url);
 
-        if (!m_mainFrameAdBlockScript.isEmpty())
-        {
-            QWebEngineScript adBlockScript;
-            adBlockScript.setSourceCode(m_mainFrameAdBlockScript);
-            adBlockScript.setName(QLatin1String("viper-content-blocker-userworld"));
-            adBlockScript.setRunsOnSubFrames(true);
-            adBlockScript.setWorldId(QWebEngineScript::UserWorld);
-            adBlockScript.setInjectionPoint(QWebEngineScript::DocumentCreation);
-            scriptCollection.insert(adBlockScript);
-
-            // Inject into the DOM as a script tag
-            m_mainFrameAdBlockScript.replace(QString("\\"), QString("\\\\"));
-            m_mainFrameAdBlockScript.replace(QString("${"), QString("\\${"));
-            const static QString mutationScript = QStringLiteral("function selfInject() { "
-                                             "try { let script = document.createElement('script'); "
-                                             "script.appendChild(document.createTextNode(`%1`)); "
-                                             "if (document.head || document.documentElement) { (document.head || document.documentElement).appendChild(script); } "
-                                             "else { setTimeout(selfInject, 100); } "
-                                             " } catch(exc) { console.error('Could not run mutation script: ' + exc); } } selfInject();");
-            m_mainFrameAdBlockScript = mutationScript.arg(m_mainFrameAdBlockScript);
-        }
+        const adblock::DomainScript adBlockScript = m_adBlockManager->getDomainJavaScript(pageUrl);
+        if (!adBlockScript.Source.isEmpty())
+            pageScripts.push_back(adBlockScript.Script);
 
-        const QString domainFilterStyle = m_adBlockManager->getDomainStylesheet(pageUrl);
-        if (!domainFilterStyle.isEmpty())
-        {
-            QWebEngineScript adBlockCosmeticScript;
-            adBlockCosmeticScript.setRunsOnSubFrames(true);
-            adBlockCosmeticScript.setSourceCode(domainFilterStyle);
-            adBlockCosmeticScript.setName(QLatin1String("viper-cosmetic-blocker"));
-            adBlockCosmeticScript.setWorldId(QWebEngineScript::UserWorld);
-            adBlockCosmeticScript.setInjectionPoint(QWebEngineScript::DocumentCreation);
-            scriptCollection.insert(adBlockCosmeticScript);
-        }
+        // Also inject into the DOM as a script tag, once the page has loaded
+        m_mainFrameAdBlockScript = adBlockScript.PageSource;
+
+        const adblock::DomainScript adBlockCosmeticScript = m_adBlockManager->getDomainStylesheet(pageUrl);
+        if (!adBlockCosmeticScript.Source.isEmpty())
+            pageScripts.push_back(adBlockCosmeticScript.Script);
+
+        m_pageScripts.setScripts(std::move(pageScripts));
 
         if (type != QWebEnginePage::NavigationTypeBackForward)
-            m_originalUrl = url;
+            m_originalUrl = PdfDocumentRegistry::getDisplayUrl(url);
     }
 
     return true;
 }
 
-void WebPage::runJavaScriptNonBlocking(const QString &scriptSource, QVariant &result)
+bool WebPage::loadPdfDocument(const QUrl &documentUrl, bool canLoadLocalFile)
 {
-    runJavaScript(scriptSource, [&](const QVariant &returnValue) {
-        result.setValue(returnValue);
-    });
+    if (!m_pdfDocumentRegistry)
+        return false;
+
+    const QUrl viewerUrl = m_pdfDocumentRegistry->registerDocument(documentUrl, canLoadLocalFile);
+    if (viewerUrl.isEmpty())
+        return false;
+
+    m_pendingViewerToken = PdfDocumentRegistry::getToken(viewerUrl);
+    load(viewerUrl);
+    return true;
 }
 
-QVariant WebPage::runJavaScriptBlocking(const QString &scriptSource)
+void WebPage::runJavaScriptAsync(const QString &scriptSource, std::function<void(const QVariant&)> callback, int timeoutMs)
 {
-    QPointer<QEventLoop> loop = new QEventLoop();
-    QVariant result;
+    // Shared by the script callback and the timeout, whichever comes first
+    auto pendingCallback = std::make_shared<std::function<void(const QVariant&)>>(std::move(callback));
+    auto finish = [pendingCallback](const QVariant &result) {
+        if (!*pendingCallback)
+            return;
 
-    runJavaScript(scriptSource, [&result, loop](const QVariant &returnValue){
-        if (!loop.isNull() && loop->isRunning())
-        {
-            result = returnValue;
-            loop->quit();
-        }
-    });
+        std::function<void(const QVariant&)> callbackToInvoke = std::move(*pendingCallback);
+        *pendingCallback = nullptr;
+        callbackToInvoke(result);
+    };
 
-    QTimer::singleShot(1000, loop.data(), [&loop](){
-        if (!loop.isNull() && loop->isRunning())
-            loop->quit();
-    });
-    connect(this, &WebPage::renderProcessTerminated, this, [&loop](RenderProcessTerminationStatus terminationStatus, int /*exitCode*/){
-        if (!loop.isNull() && terminationStatus != WebPage::NormalTerminationStatus)
-            loop->quit();
+    // A render process that is hung or has terminated never returns the result, so give up after the timeout
+    QTimer::singleShot(timeoutMs, this, [finish](){
+        finish(QVariant());
     });
-    connect(this, &WebPage::destroyed, loop.data(), &QEventLoop::quit);
-
-    loop->exec(QEventLoop::ExcludeUserInputEvents);
-    delete loop;
 
-    return result;
+    runJavaScript(scriptSource, finish);
 }
 
 void WebPage::javaScriptConsoleMessage(WebPage::JavaScriptConsoleMessageLevel level, const QString &message, int lineId, const QString &sourceId)
@@ -1,9 +1,11 @@
 #ifndef WEBPAGE_H
 #define WEBPAGE_H
 
+#include "PageScriptCollection.h"
 #include "ServiceLocator.h"
 #include "UserScript.h"
 
+#include <functional>
 #include <utility>
 #include <vector>
 
@@ -21,6 +23,7 @@ namespace adblock {
     class AdBlockManager;
 }
 
+class PdfDocumentRegistry;
 class UserScriptManager;
 class WebHistory;
 
@@ -53,11 +56,14 @@ class WebPage : public QWebEnginePage
     /// Returns the URL associated with the page after a navigation request was accepted, but before it was fully loaded.
     const QUrl &getOriginalUrl() const;
 
-    /// Executes the given JavaScript code (in string form), storing the result in the given reference
-    void runJavaScriptNonBlocking(const QString &scriptSource, QVariant &result);
-
-    /// Executes the given JavaScript code (string form), and waits until the result can be returned
-    QVariant runJavaScriptBlocking(const QString &scriptSource);
+    /**
+     * @brief Executes the given JavaScript code (in string form) without waiting for it to finish
+     * @param scriptSource Source of the script, which runs in the main world of the page
+     * @param callback Invoked exactly once on the thread of the page, either with the result of the script, or with an
+     *                 invalid QVariant if the script did not finish within the timeout. Not invoked if the page is destroyed first
+     * @param timeoutMs Maximum time to wait for the result, in milliseconds
+     */
+    void runJavaScriptAsync(const QString &scriptSource, std::function<void(const QVariant&)> callback, int timeoutMs = 1000);
 
 Q_SIGNALS:
     /// Emitted when a print request is made from the web page
@@ -110,6 +116,10 @@ private Q_SLOTS:
     /// Connects web engine page signals to their handlers
     void setupSlots(const ViperServiceLocator &serviceLocator);
 
+    /// Registers the given PDF document and loads the viewer that displays it. Returns false if the document may not
+    /// be shown in the viewer, in which case nothing is loaded
+    bool loadPdfDocument(const QUrl &documentUrl, bool canLoadLocalFile);
+
     /// Returns true if the web feature is permitted for the given origin, false if not explicitly
     /// allowed (does not imply that a permission has been denied).
     bool isPermissionAllowed(const QUrl &securityOrigin, WebPage::Feature feature) const;
@@ -126,15 +136,24 @@ private Q_SLOTS:
     /// User script system manager
     UserScriptManager *m_userScriptManager;
 
+    /// Registry of the PDF documents that the viewer may load
+    PdfDocumentRegistry *m_pdfDocumentRegistry;
+
     /// Stores the history of the web page
     WebHistory *m_history;
 
     /// Contains the original URL of the current page, as passed to the WebPage in the acceptNavigationRequest method
     QUrl m_originalUrl;
 
+    /// Token of the PDF viewer that was loaded by \ref loadPdfDocument, whose document is already registered
+    QString m_pendingViewerToken;
+
     /// Scripts injected by ad block during load progress and load finish
     QString m_mainFrameAdBlockScript;
 
+    /// User scripts and ad block scripts that are injected into the page as it loads
+    PageScriptCollection m_pageScripts;
+
     /// Flag indicating whether or not we need to inject the adblock script into the DOM
     bool m_injectedAdblock;
 
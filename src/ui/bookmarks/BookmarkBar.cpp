@@ -34,6 +34,7 @@ void BookmarkBar::setBookmarkManager(BookmarkManager *manager)
 {
     m_bookmarkManager = manager;
     connect(m_bookmarkManager, &BookmarkManager::bookmarksChanged, this, &BookmarkBar::refresh);
+    connect(m_bookmarkManager, &BookmarkManager::bookmarkIconsChanged, this, &BookmarkBar::refresh);
     refresh();
 }
 
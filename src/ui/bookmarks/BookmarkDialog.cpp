@@ -24,11 +24,15 @@ BookmarkDialog::BookmarkDialog(BookmarkManager *bookmarkMgr, QWidget *parent) :
     const int maxTextWidth = std::max(width(), 290) * 3 / 4;
     QFontMetrics folderFontMetrics(font());
     // Populate combo box with each folder in the bookmark collection
-    const BookmarkNode *rootNode = m_bookmarkManager->getRoot();
-    for (const auto it : *m_bookmarkManager)
+    std::shared_ptr<const FlatBookmarkTree> bookmarks = m_bookmarkManager->getFlatTree();
+    for (FlatBookmarkTree::NodeIndex index : bookmarks->getFolders())
     {
-        if (it != rootNode && it->getType() == BookmarkNode::Folder)
-            ui->comboBoxFolder->addItem(folderFontMetrics.elidedText(it->getName(), Qt::ElideRight, maxTextWidth) , QVariant::fromValue((void *)it));
+        // Skip the root folder
+        if (index == 0)
+            continue;
+
+        ui->comboBoxFolder->addItem(folderFontMetrics.elidedText(bookmarks->getName(index), Qt::ElideRight, maxTextWidth),
+                                    QVariant::fromValue((void *)bookmarks->getNode(index)));
     }
 
     ui->comboBoxFolder->setCurrentIndex(0);
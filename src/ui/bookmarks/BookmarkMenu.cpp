@@ -91,6 +91,7 @@ void BookmarkMenu::setup()
     connect(m_removePageBookmarks, &QAction::triggered, [=](){ emit removePageFromBookmarks(false); });
 
     connect(m_bookmarkManager, &BookmarkManager::bookmarksChanged, this, &BookmarkMenu::resetMenu);
+    connect(m_bookmarkManager, &BookmarkManager::bookmarkIconsChanged, this, &BookmarkMenu::resetMenu);
 
     resetMenu();
 }
@@ -7,11 +7,13 @@
 #include "BookmarkNode.h"
 
 #include <algorithm>
+#include <memory>
 #include <set>
 #include <vector>
 #include <QCloseEvent>
 #include <QDir>
 #include <QFileDialog>
+#include <QFutureWatcher>
 #include <QMenu>
 #include <QRegExp>
 #include <QResizeEvent>
@@ -245,17 +247,28 @@ void BookmarkWidget::onImportExportBoxChanged(int index)
             if (fileName.isNull())
                 return;
 
-            // Create an "Imported Bookmarks" folder
-            BookmarkNode *importFolder = m_bookmarkManager->addFolder(tr("Imported Bookmarks"), m_bookmarkManager->getRoot());
-            resetFolderModel();
+            // Parse the file in the background, then attach all of its bookmarks at once. The folder is only
+            // created once parsing is done, as the user may remove other folders in the meantime
+            using ImportWatcher = QFutureWatcher<std::shared_ptr<BookmarkNode>>;
+            ImportWatcher *watcher = new ImportWatcher(this);
+            connect(watcher, &ImportWatcher::finished, this, [this, watcher, fileName](){
+                std::shared_ptr<BookmarkNode> importedNodes = watcher->result();
+                watcher->deleteLater();
 
-            QtConcurrent::run([=](){
-                BookmarkImporter importer(m_bookmarkManager);
-                if (!importer.import(fileName, importFolder))
+                if (!importedNodes)
+                {
                     qDebug() << "Error: In BookmarkWidget, could not import bookmarks from file " << fileName;
+                    return;
+                }
 
+                // Create an "Imported Bookmarks" folder
+                BookmarkNode *importFolder = m_bookmarkManager->addFolder(tr("Imported Bookmarks"), m_bookmarkManager->getRoot());
+                m_bookmarkManager->attachNodes(importedNodes.get(), importFolder);
                 resetFolderModel();
             });
+            watcher->setFuture(QtConcurrent::run([fileName](){
+                return std::shared_ptr<BookmarkNode>(BookmarkImporter::readFile(fileName));
+            }));
 
             break;
         }
@@ -9,7 +9,7 @@
 #include <QWebEngineCookieStore>
 #include <QWebEngineProfile>
 
-CookieWidget::CookieWidget(QWidget *parent) :
+CookieWidget::CookieWidget(CookieJar *cookieJar, QWidget *parent) :
     QWidget(parent),
     ui(new Ui::CookieWidget),
     m_cookieDialog(new CookieModifyDialog(this)),
@@ -18,7 +18,7 @@ CookieWidget::CookieWidget(QWidget *parent) :
     ui->setupUi(this);
     setObjectName(QLatin1String("CookieWidget"));
 
-    ui->tableViewCookies->setModel(new CookieTableModel(this));
+    ui->tableViewCookies->setModel(new CookieTableModel(cookieJar, this));
     ui->tableViewCookieDetail->setModel(new DetailedCookieTableModel(this));
 
     // Enable search for cookies
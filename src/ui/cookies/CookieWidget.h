@@ -20,8 +20,8 @@ class CookieWidget : public QWidget
     Q_OBJECT
 
 public:
-    /// Constructs the cookie widget
-    explicit CookieWidget(QWidget *parent = 0);
+    /// Constructs the cookie widget, given a pointer to the cookie jar
+    explicit CookieWidget(CookieJar *cookieJar, QWidget *parent = 0);
     ~CookieWidget();
 
     /// Resets the checkbox states in the table view
@@ -42,6 +42,7 @@ void HistoryMenu::addHistoryItem(const QUrl &url, const QString &title, const QI
 {
     QAction *historyItem = new QAction(title);
     historyItem->setIcon(favicon);
+    historyItem->setData(url);
     connect(historyItem, &QAction::triggered, this, [this, url](){
         emit loadUrl(url);
     });
@@ -61,6 +62,7 @@ void HistoryMenu::prependHistoryItem(const QUrl &url, const QString &title, cons
 
     QAction *historyItem = new QAction(title);
     historyItem->setIcon(favicon);
+    historyItem->setData(url);
     connect(historyItem, &QAction::triggered, this, [this, url](){
         emit loadUrl(url);
     });
@@ -110,11 +112,25 @@ void HistoryMenu::onPageVisited(const QUrl &url, const QString &title)
     prependHistoryItem(url, title, m_faviconManager->getFavicon(url));
 }
 
+void HistoryMenu::onFaviconLoaded(const QUrl &pageUrl, const QIcon &icon)
+{
+    QList<QAction*> menuActions = actions();
+    for (int i = 3; i < menuActions.size(); ++i)
+    {
+        QAction *item = menuActions.at(i);
+        if (item->data().toUrl().matches(pageUrl, QUrl::RemoveUserInfo | QUrl::RemoveQuery | QUrl::RemoveFragment))
+            item->setIcon(icon);
+    }
+}
+
 void HistoryMenu::setup()
 {
     connect(m_historyManager, &HistoryManager::pageVisited,    this, &HistoryMenu::onPageVisited);
     connect(m_historyManager, &HistoryManager::historyCleared, this, &HistoryMenu::resetItems, Qt::QueuedConnection);
 
+    if (m_faviconManager)
+        connect(m_faviconManager, &FaviconManager::faviconLoaded, this, &HistoryMenu::onFaviconLoaded);
+
     m_actionShowHistory = addAction(QLatin1String("&Show all History"));
     m_actionShowHistory->setShortcut(QKeySequence(Qt::CTRL + Qt::SHIFT + Qt::Key_H));
 
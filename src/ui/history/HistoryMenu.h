@@ -54,6 +54,9 @@ private Q_SLOTS:
     /// Called when a page has been visited by the user
     void onPageVisited(const QUrl &url, const QString &title);
 
+    /// Sets the icon of the history items of the given page, once its icon has been loaded by the favicon manager
+    void onFaviconLoaded(const QUrl &pageUrl, const QIcon &icon);
+
 private:
     /// Binds the pageVisited signal from the \ref HistoryManager to a slot that adds the
     /// page to the top of the history menu. Also binds the reset menu signal to the reset items slot
@@ -8,6 +8,7 @@
 #include <QList>
 #include <QMenu>
 #include <QResizeEvent>
+#include <QScrollBar>
 #include <QSortFilterProxyModel>
 #include <QStandardItemModel>
 
@@ -15,7 +16,9 @@ HistoryWidget::HistoryWidget(QWidget *parent) :
     QWidget(parent),
     ui(new Ui::HistoryWidget),
     m_proxyModel(new QSortFilterProxyModel(this)),
-    m_timeRange(HistoryRange::Day)
+    m_timeRange(HistoryRange::Day),
+    m_tableModel(nullptr),
+    m_topRow(-1)
 {
     setAttribute(Qt::WA_DeleteOnClose, true);
 
@@ -39,13 +42,29 @@ HistoryWidget::~HistoryWidget()
 
 void HistoryWidget::setServiceLocator(const ViperServiceLocator &serviceLocator)
 {
-    HistoryTableModel *tableModel = new HistoryTableModel(serviceLocator, this);
-    m_proxyModel->setSourceModel(tableModel);
+    m_tableModel = new HistoryTableModel(serviceLocator, this);
+    m_proxyModel->setSourceModel(m_tableModel);
     ui->tableView->setModel(m_proxyModel);
 
-    // Model will emit the signals in a separate thread, force a queued connection to upadte the UI without resizing the window or hiding/showing the window
-    connect(tableModel, &HistoryTableModel::rowsAboutToBeInserted, m_proxyModel, &QSortFilterProxyModel::rowsAboutToBeInserted, Qt::QueuedConnection);
-    connect(tableModel, &HistoryTableModel::rowsInserted, m_proxyModel, &QSortFilterProxyModel::rowsInserted, Qt::QueuedConnection);
+    // The model only keeps a window of the history, so rows are added and removed at the top as the view scrolls.
+    // Keep the rows that were on screen in place when that happens
+    connect(ui->tableView->verticalScrollBar(), &QScrollBar::valueChanged, this, &HistoryWidget::onTableScrolled);
+    connect(m_tableModel, &HistoryTableModel::rowsAboutToBeInserted, this, [this](const QModelIndex &, int first, int){
+        if (first == 0)
+            saveTopRow();
+    });
+    connect(m_tableModel, &HistoryTableModel::rowsInserted, this, [this](const QModelIndex &, int first, int last){
+        if (first == 0)
+            restoreTopRow(last - first + 1);
+    });
+    connect(m_tableModel, &HistoryTableModel::rowsAboutToBeRemoved, this, [this](const QModelIndex &, int first, int){
+        if (first == 0)
+            saveTopRow();
+    });
+    connect(m_tableModel, &HistoryTableModel::rowsRemoved, this, [this](const QModelIndex &, int first, int last){
+        if (first == 0)
+            restoreTopRow(first - last - 1);
+    });
 
     ui->tableView->setContextMenuPolicy(Qt::CustomContextMenu);
     connect(ui->tableView, &QTableView::customContextMenuRequested, this, &HistoryWidget::onContextMenuRequested);
@@ -53,7 +72,8 @@ void HistoryWidget::setServiceLocator(const ViperServiceLocator &serviceLocator)
 
 void HistoryWidget::loadHistory()
 {
-    static_cast<HistoryTableModel*>(m_proxyModel->sourceModel())->loadFromDate(getLoadDate());
+    if (m_tableModel)
+        m_tableModel->loadFromDate(getLoadDate());
 }
 
 void HistoryWidget::resizeEvent(QResizeEvent *event)
@@ -106,6 +126,31 @@ void HistoryWidget::searchHistory()
     m_proxyModel->setFilterRegExp(ui->lineEditSearch->text());
 }
 
+void HistoryWidget::onTableScrolled(int value)
+{
+    if (m_tableModel && value == ui->tableView->verticalScrollBar()->minimum())
+        m_tableModel->fetchNewer();
+}
+
+void HistoryWidget::saveTopRow()
+{
+    const QModelIndex topIndex = ui->tableView->indexAt(QPoint(0, 0));
+    m_topRow = topIndex.isValid() ? m_proxyModel->mapToSource(topIndex).row() : -1;
+}
+
+void HistoryWidget::restoreTopRow(int offset)
+{
+    if (m_topRow < 0)
+        return;
+
+    const int row = std::max(m_topRow + offset, 0);
+    m_topRow = -1;
+
+    const QModelIndex topIndex = m_proxyModel->mapFromSource(m_tableModel->index(row, 0));
+    if (topIndex.isValid())
+        ui->tableView->scrollTo(topIndex, QAbstractItemView::PositionAtTop);
+}
+
 void HistoryWidget::setupCriteriaList()
 {
     QStringList listItems;
@@ -10,6 +10,7 @@ class HistoryWidget;
 }
 
 class HistoryManager;
+class HistoryTableModel;
 class QSortFilterProxyModel;
 
 /// Range of times used to narrow browser history shown in the table
@@ -70,7 +71,17 @@ private Q_SLOTS:
     /// Called to search the browser history for a search term contained in the line edit widget
     void searchHistory();
 
+    /// Loads the visits that were removed from the top of the table when the view is scrolled to the top
+    void onTableScrolled(int value);
+
 private:
+    /// Remembers the row of the table model shown at the top of the view, before rows are added to or removed from
+    /// the top of the model
+    void saveTopRow();
+
+    /// Scrolls the view back to the row saved by \ref saveTopRow, which has moved by the given number of rows
+    void restoreTopRow(int offset);
+
     /// Sets the items in the history criteria list
     void setupCriteriaList();
 
@@ -89,6 +100,12 @@ private Q_SLOTS:
 
     /// Time range being used to view history
     HistoryRange m_timeRange;
+
+    /// Table model of the visits in the selected time range
+    HistoryTableModel *m_tableModel;
+
+    /// Row of the table model that was shown at the top of the view before the rows at the top changed, or -1
+    int m_topRow;
 };
 
 #endif // HISTORYWIDGET_H
@@ -1,4 +1,5 @@
 #include "BrowserApplication.h"
+#include "FaviconManager.h"
 #include "URLSuggestionItemDelegate.h"
 #include "URLSuggestionListModel.h"
 #include "URLSuggestionWidget.h"
@@ -21,6 +22,7 @@ URLSuggestionWidget::URLSuggestionWidget(QWidget *parent) :
     m_worker(nullptr),
     m_lineEdit(nullptr),
     m_searchTerm(),
+    m_searchGeneration(0),
     m_workerThread()
 {
     setAttribute(Qt::WA_ShowWithoutActivating, true);
@@ -46,7 +48,7 @@ URLSuggestionWidget::URLSuggestionWidget(QWidget *parent) :
     m_worker->moveToThread(&m_workerThread);
     connect(&m_workerThread, &QThread::finished, m_worker, &QObject::deleteLater);
     connect(this, &URLSuggestionWidget::determineSuggestions, m_worker, &URLSuggestionWorker::findSuggestionsFor);
-    connect(m_worker, &URLSuggestionWorker::finishedSearch, m_model, &URLSuggestionListModel::setSuggestions);
+    connect(m_worker, &URLSuggestionWorker::suggestionsFound, this, &URLSuggestionWidget::onSuggestionsFound);
 
     // Setup layout
     auto vboxLayout = new QVBoxLayout(this);
@@ -223,15 +225,17 @@ void URLSuggestionWidget::suggestForInput(const QString &text)
 
     if (text.isEmpty())
     {
+        m_worker->setSearchGeneration(++m_searchGeneration);
         close();
         m_searchTerm = text;
         return;
     }
 
     m_searchTerm = text;
-    //m_worker->findSuggestionsFor(text);
-    m_worker->stopWork();
-    emit determineSuggestions(text);
+
+    // Cancel the search in progress, and any that are still queued, before requesting the new one
+    m_worker->setSearchGeneration(++m_searchGeneration);
+    emit determineSuggestions(text, m_searchGeneration);
 
     if (!isVisible() && m_lineEdit != nullptr)
         alignAndShow(m_lineEdit->mapToGlobal(m_lineEdit->pos()), m_lineEdit->frameGeometry());
@@ -246,6 +250,9 @@ void URLSuggestionWidget::setURLLineEdit(URLLineEdit *lineEdit)
 void URLSuggestionWidget::setServiceLocator(const ViperServiceLocator &serviceLocator)
 {
     m_worker->setServiceLocator(serviceLocator);
+
+    if (FaviconManager *faviconManager = serviceLocator.getServiceAs<FaviconManager>("FaviconManager"))
+        connect(faviconManager, &FaviconManager::faviconLoaded, m_model, &URLSuggestionListModel::onFaviconLoaded);
 }
 
 QSize URLSuggestionWidget::sizeHint() const
@@ -271,3 +278,9 @@ void URLSuggestionWidget::onSuggestionClicked(const QModelIndex &index)
         emit urlChosen(QUrl(index.data(URLSuggestionListModel::Link).toString()));
     }
 }
+
+void URLSuggestionWidget::onSuggestionsFound(const std::vector<URLSuggestion> &results, quint64 generation)
+{
+    if (generation == m_searchGeneration)
+        m_model->setSuggestions(results);
+}
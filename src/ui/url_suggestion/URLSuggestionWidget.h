@@ -2,6 +2,9 @@
 #define URLSUGGESTIONWIDGET_H
 
 #include "ServiceLocator.h"
+#include "URLSuggestion.h"
+
+#include <vector>
 
 #include <QString>
 #include <QThread>
@@ -61,12 +64,16 @@ class URLSuggestionWidget final : public QWidget
     void noSuggestionChosen(const QString &originalText);
 
     /// Bound to the suggestion worker's findSuggestionsFor(...) slot
-    void determineSuggestions(const QString &text);
+    void determineSuggestions(const QString &text, quint64 generation);
 
 private Q_SLOTS:
     /// Called when an item in the suggestion list at the given index is clicked
     void onSuggestionClicked(const QModelIndex &index);
 
+    /// Called when the suggestion worker has found results for the search of the given generation.
+    /// Results belonging to any search other than the most recent one are discarded
+    void onSuggestionsFound(const std::vector<URLSuggestion> &results, quint64 generation);
+
 private:
     /// List view containing suggested URLs
     QListView *m_suggestionList;
@@ -83,6 +90,9 @@ private Q_SLOTS:
     /// The term being searched for suggestions
     QString m_searchTerm;
 
+    /// Incremented for each new search, used to discard results of searches that were superseded
+    quint64 m_searchGeneration;
+
     /// Worker thread
     QThread m_workerThread;
 };
@@ -39,9 +39,11 @@ WebView::WebView(bool privateView, QWidget *parent) :
     m_progress(0),
     m_privateView(privateView),
     m_contextMenuHelper(),
-    m_jsCallbackResult(),
-    m_viewFocusProxy(nullptr),
-    m_thumbnail()
+    m_linkPressPos(),
+    m_linkPressUrl(),
+    m_isLinkHitTestFinished(false),
+    m_linkHitTestId(0),
+    m_viewFocusProxy(nullptr)
 {
     setAcceptDrops(true);
     setObjectName(QLatin1String("webView"));
@@ -100,11 +102,26 @@ QString WebView::getTitle() const
     return pageUrl.host();
 }
 
-const QPixmap &WebView::getThumbnail()
+QImage WebView::grabFrame()
 {
-    if (m_thumbnail.isNull())
-        makeThumbnailOfPage();
-    return m_thumbnail;
+    // Read the frame buffer directly, rather than grabbing the widget into a pixmap that would
+    // have to be converted back into an image
+    QQuickWidget *qQuickChild = qobject_cast<QQuickWidget*>(focusProxy());
+    if (!qQuickChild)
+    {
+        QList<QQuickWidget*> children = findChildren<QQuickWidget*>();
+        for (int i = children.size() - 1; i >= 0; --i)
+        {
+            QQuickWidget *w = children.at(i);
+            if (w && w->isVisible())
+            {
+                qQuickChild = w;
+                break;
+            }
+        }
+    }
+
+    return (qQuickChild != nullptr) ? qQuickChild->grabFramebuffer() : QImage();
 }
 
 void WebView::load(const QUrl &url)
@@ -203,8 +220,15 @@ QString WebView::getContextMenuScript(const QPoint &pos)
 
 void WebView::showContextMenu(const QPoint &globalPos, const QPoint &relativePos)
 {
-    WebHitTestResult contextMenuData(m_page, getContextMenuScript(relativePos));
+    QPointer<WebView> self(this);
+    m_page->runJavaScriptAsync(getContextMenuScript(relativePos), [self, globalPos](const QVariant &result){
+        if (self)
+            self->openContextMenu(globalPos, WebHitTestResult(self->m_page, result));
+    });
+}
 
+void WebView::openContextMenu(const QPoint &globalPos, const WebHitTestResult &contextMenuData)
+{
     const bool askWhereToSave = m_settings->getValue(BrowserSetting::AskWhereToSaveDownloads).toBool();
 
     QMenu *menu = new QMenu(this);
@@ -347,77 +371,74 @@ void WebView::onFullScreenRequested(QWebEngineFullScreenRequest request)
 
 void WebView::onLoadFinished(bool ok)
 {
+    Q_UNUSED(ok);
+
     m_progress = 100;
 
     emit iconChanged(icon());
+}
 
-    if (ok && !isOnBlankPage())
-        makeThumbnailOfPage();
-    else
-        m_thumbnail = QPixmap();
+void WebView::setViewFocusProxy(QWidget *w)
+{
+    m_viewFocusProxy = w;
 }
 
-void WebView::makeThumbnailOfPage()
+void WebView::_mousePressEvent(QMouseEvent *event)
 {
-    QQuickWidget *qQuickChild = qobject_cast<QQuickWidget*>(focusProxy());
-    if (qQuickChild)
-    {
-        m_thumbnail = qQuickChild->grab().scaled(QSize(375, 500));
+    if (!isOpenLinkClick(event))
         return;
-    }
 
-    QList<QQuickWidget*> children = findChildren<QQuickWidget*>();
-    for (int i = children.size() - 1; i >= 0; --i)
-    {
-        QQuickWidget *w = children.at(i);
-        if (w && w->isVisible())
-        {
-            qQuickChild = w;
-            break;
-        }
-    }
+    const int hitTestId = ++m_linkHitTestId;
+    m_linkPressPos = event->pos();
+    m_linkPressUrl = QUrl();
+    m_isLinkHitTestFinished = false;
+
+    QPointer<WebView> self(this);
+    m_page->runJavaScriptAsync(getContextMenuScript(event->pos()), [self, hitTestId](const QVariant &result){
+        if (!self || self->m_linkHitTestId != hitTestId)
+            return;
 
-    m_thumbnail = (qQuickChild != nullptr) ? qQuickChild->grab().scaled(QSize(375, 500)) : QPixmap();
+        WebHitTestResult hitTest(self->m_page, result);
+        self->m_linkPressUrl = hitTest.linkUrl();
+        self->m_isLinkHitTestFinished = true;
+    });
 }
 
-void WebView::setViewFocusProxy(QWidget *w)
+void WebView::_mouseReleaseEvent(QMouseEvent *event)
 {
-    m_viewFocusProxy = w;
+    if (!isOpenLinkClick(event))
+        return;
+
+    // If the hit test has not finished yet, the page handles the click itself
+    const bool isHitTestUsable = m_isLinkHitTestFinished
+            && (event->pos() - m_linkPressPos).manhattanLength() < QApplication::startDragDistance();
+    const QUrl linkUrl = m_linkPressUrl;
+
+    ++m_linkHitTestId;
+    m_linkPressUrl = QUrl();
+    m_isLinkHitTestFinished = false;
+
+    if (!isHitTestUsable || linkUrl.isEmpty() || !linkUrl.isValid())
+        return;
+
+    if (event->button() == Qt::MiddleButton || (event->modifiers() & Qt::ControlModifier))
+        emit openInNewBackgroundTab(linkUrl);
+    else
+        emit openInNewWindowRequest(linkUrl, m_privateView);
+
+    event->accept();
 }
 
-void WebView::_mouseReleaseEvent(QMouseEvent *event)
+bool WebView::isOpenLinkClick(const QMouseEvent *event)
 {
     switch (event->button())
     {
-        case Qt::LeftButton:
         case Qt::MiddleButton:
-        {
-            WebHitTestResult hitTest(m_page, getContextMenuScript(event->pos()));
-
-            const QUrl linkUrl = hitTest.linkUrl();
-            if (!linkUrl.isEmpty() && linkUrl.isValid())
-            {
-                if (event->button() == Qt::MiddleButton)
-                {
-                    emit openInNewBackgroundTab(linkUrl);
-                    event->accept();
-                }
-                else if (event->modifiers() & Qt::ControlModifier)
-                {
-                    emit openInNewBackgroundTab(linkUrl);
-                    event->accept();
-                }
-                else if (event->modifiers() & Qt::ShiftModifier)
-                {
-                    emit openInNewWindowRequest(linkUrl, m_privateView);
-                    event->accept();
-                }
-            }
-
-            break;
-        }
+            return true;
+        case Qt::LeftButton:
+            return (event->modifiers() & (Qt::ControlModifier | Qt::ShiftModifier)) != 0;
         default:
-            break;
+            return false;
     }
 }
 
@@ -3,13 +3,17 @@
 
 #include "ServiceLocator.h"
 
+#include <QImage>
+#include <QPoint>
 #include <QPointer>
+#include <QUrl>
 #include <QWebEngineContextMenuData>
 #include <QWebEngineFullScreenRequest>
 #include <QWebEngineView>
 
 class HttpRequest;
 class Settings;
+class WebHitTestResult;
 class WebPage;
 
 class QLabel;
@@ -65,8 +69,9 @@ class WebView : public QWebEngineView
     /// Returns a pointer to the \ref WebPage
     WebPage *getPage() const;
 
-    /// Returns a thumbnail of the current page, or a null QPixmap if the thumbnail could not be obtained
-    const QPixmap &getThumbnail();
+    /// Captures the visible area of the page, returning it as an image at the resolution of the view,
+    /// or a null image if it could not be captured
+    QImage grabFrame();
 
 public Q_SLOTS:
     /// Resets the zoom factor to its base value
@@ -93,12 +98,17 @@ private Q_SLOTS:
     void setViewFocusProxy(QWidget *w);
 
 protected:
-    /// Event handler for context menu displays
+    /// Event handler for context menu displays. Runs a hit test at the relative position, and shows the menu
+    /// once the result of the hit test is available
     void showContextMenu(const QPoint &globalPos, const QPoint &relativePos);
 
     /// Does nothing
     void contextMenuEvent(QContextMenuEvent *event) override;
 
+    /// Handles the mouse button press event. If releasing the button may open a link in a new tab or window,
+    /// starts a hit test for the link under the cursor, so that the result is known by the time the button is released
+    void _mousePressEvent(QMouseEvent *event);
+
     /// Handles the mouse button release event, needed for the middle mouse button release event
     void _mouseReleaseEvent(QMouseEvent *event);
 
@@ -114,6 +124,13 @@ private Q_SLOTS:
     /// Handles resize events
     //void resizeEvent(QResizeEvent *event) override;
 
+private:
+    /// Shows the context menu at the given global position, with actions based on the given hit test result
+    void openContextMenu(const QPoint &globalPos, const WebHitTestResult &contextMenuData);
+
+    /// Returns true if the mouse button and keyboard modifiers of the event are used to open a link in a new tab or window
+    static bool isOpenLinkClick(const QMouseEvent *event);
+
 protected:
     /// returns the context menu helper script source, with the template parameters
     /// substituted for the coordinates given by parameter pos, scaled to the page's zoom factor
@@ -141,10 +158,6 @@ private Q_SLOTS:
     /// Emitted when the page of the view has requested full screen to be enabled if on is true, or disabled if on is false
     void fullScreenRequested(bool on);
 
-private:
-    /// Generates a thumbnail of the current web page
-    void makeThumbnailOfPage();
-
 private:
     /// Web page behind this view
     WebPage *m_page;
@@ -161,14 +174,20 @@ private Q_SLOTS:
     /// Context menu helper script template
     QString m_contextMenuHelper;
 
-    /// Stores the result of an asynchronous javascript callback
-    QVariant m_jsCallbackResult;
+    /// Position of the last mouse press that may open a link in a new tab or window
+    QPoint m_linkPressPos;
+
+    /// URL of the link under the cursor at the last such mouse press, if any
+    QUrl m_linkPressUrl;
+
+    /// True if the hit test of the last such mouse press has finished, false if else
+    bool m_isLinkHitTestFinished;
+
+    /// Incremented on each such mouse press, so that the results of earlier hit tests are discarded
+    int m_linkHitTestId;
 
     /// Pointer to the WebView's focus proxy
     QPointer<QWidget> m_viewFocusProxy;
-
-    /// Thumbnail of the current page
-    QPixmap m_thumbnail;
 };
 
 #endif // WEBVIEW_H
@@ -4,6 +4,7 @@
 #include "HistoryManager.h"
 #include "HttpRequest.h"
 #include "MainWindow.h"
+#include "PdfDocumentRegistry.h"
 #include "Settings.h"
 #include "WebWidget.h"
 #include "WebHistory.h"
@@ -14,8 +15,11 @@
 #include "WebView.h"
 
 #include <chrono>
+#include <utility>
 #include <QAction>
+#include <QDateTime>
 #include <QHideEvent>
+#include <QKeyEvent>
 #include <QMouseEvent>
 #include <QQuickWidget>
 #include <QShowEvent>
@@ -25,6 +29,16 @@
 #include <QDebug>
 
 WebWidget::WebWidget(const ViperServiceLocator &serviceLocator, bool privateMode, QWidget *parent) :
+    WebWidget(serviceLocator, privateMode, false, WebState(), parent)
+{
+}
+
+WebWidget::WebWidget(const ViperServiceLocator &serviceLocator, bool privateMode, WebState &&state, QWidget *parent) :
+    WebWidget(serviceLocator, privateMode, true, std::move(state), parent)
+{
+}
+
+WebWidget::WebWidget(const ViperServiceLocator &serviceLocator, bool privateMode, bool isPlaceholder, WebState &&state, QWidget *parent) :
     QWidget(parent),
     m_serviceLocator(serviceLocator),
     m_adBlockManager(serviceLocator.getServiceAs<adblock::AdBlockManager>("AdBlockManager")),
@@ -42,29 +56,44 @@ WebWidget::WebWidget(const ViperServiceLocator &serviceLocator, bool privateMode
     m_contextMenuPosGlobal(),
     m_contextMenuPosRelative(),
     m_viewFocusProxy(nullptr),
-    m_hibernating(false),
-    m_savedState(),
-    m_lastTypedUrl()
+    m_hibernating(isPlaceholder),
+    m_savedState(std::move(state)),
+    m_lastTypedUrl(),
+    m_isPlaceholder(isPlaceholder),
+    m_hasUserInput(false),
+    m_lastActiveTime(QDateTime::currentMSecsSinceEpoch())
 {
     setObjectName(QLatin1String("webWidget"));
 
     m_mainWindow = qobject_cast<MainWindow*>(window());
 
-    setupWebView();
+    if (!m_isPlaceholder)
+        setupWebView();
 
     QVBoxLayout *vLayout = new QVBoxLayout(this);
     vLayout->setContentsMargins(0, 0, 0, 0);
     vLayout->setSpacing(0);
-    vLayout->addWidget(m_view);
     setLayout(vLayout);
 
-    setFocusProxy(m_view);
+    if (m_isPlaceholder)
+    {
+        setCursor(Qt::PointingHandCursor);
+        setAutoFillBackground(true);
+    }
+    else
+    {
+        vLayout->addWidget(m_view);
+        setFocusProxy(m_view);
+    }
 
     if (BrowserTabWidget *tabWidget = qobject_cast<BrowserTabWidget*>(parentWidget()))
     {
         connect(tabWidget, &BrowserTabWidget::tabPinned, this, &WebWidget::onTabPinned);
     }
 
+    if (m_faviconManager)
+        connect(m_faviconManager, &FaviconManager::faviconLoaded, this, &WebWidget::onFaviconLoaded);
+
     if (!m_privateMode)
     {
         if (HistoryManager *historyMgr = serviceLocator.getServiceAs<HistoryManager>("HistoryManager"))
@@ -103,6 +132,11 @@ bool WebWidget::isHibernating() const
     return m_hibernating;
 }
 
+bool WebWidget::isPlaceholder() const
+{
+    return m_isPlaceholder;
+}
+
 bool WebWidget::isOnBlankPage() const
 {
     if (m_hibernating)
@@ -111,6 +145,29 @@ bool WebWidget::isOnBlankPage() const
     return m_view->isOnBlankPage();
 }
 
+bool WebWidget::isPlayingAudio() const
+{
+    if (m_hibernating)
+        return false;
+
+    return m_page->recentlyAudible();
+}
+
+bool WebWidget::hasUserInput() const
+{
+    return m_hasUserInput;
+}
+
+qint64 WebWidget::getLastActiveTime() const
+{
+    return m_lastActiveTime;
+}
+
+void WebWidget::markActive()
+{
+    m_lastActiveTime = QDateTime::currentMSecsSinceEpoch();
+}
+
 QIcon WebWidget::getIcon() const
 {
     if (m_hibernating)
@@ -119,7 +176,7 @@ QIcon WebWidget::getIcon() const
     QIcon icon { m_page->icon() };
 
     if (icon.isNull() && m_faviconManager != nullptr)
-        return m_faviconManager->getFavicon(m_page->url());
+        return m_faviconManager->getFavicon(url());
 
     return icon;
 }
@@ -189,6 +246,8 @@ void WebWidget::setHibernation(bool on)
     if (m_hibernating == on)
         return;
 
+    m_isPlaceholder = false;
+
     if (on)
     {
         emit aboutToHibernate();
@@ -247,6 +306,16 @@ void WebWidget::setWebState(WebState &&state)
         emit loadFinished(false);
 }
 
+void WebWidget::setPlaceholderState(WebState &&state)
+{
+    setHibernation(true);
+
+    m_savedState = std::move(state);
+    m_isPlaceholder = true;
+
+    emit loadFinished(false);
+}
+
 const QUrl &WebWidget::getLastTypedUrl() const
 {
     return m_lastTypedUrl;
@@ -305,7 +374,8 @@ QUrl WebWidget::url() const
     if (m_hibernating)
         return m_savedState.url;
 
-    return m_page->url();
+    // The PDF viewer is shown under the URL of its document, in the tab as well as in the history and session
+    return PdfDocumentRegistry::getDisplayUrl(m_page->url());
 }
 
 QUrl WebWidget::getOriginalUrl() const
@@ -451,6 +521,17 @@ void WebWidget::onTabPinned(int index, bool value)
     }
 }
 
+void WebWidget::onFaviconLoaded(const QUrl &pageUrl, const QIcon &icon)
+{
+    // An awake widget asks the favicon manager for its icon each time it is needed
+    if (!m_hibernating
+            || !m_savedState.url.matches(pageUrl, QUrl::RemoveUserInfo | QUrl::RemoveQuery | QUrl::RemoveFragment))
+        return;
+
+    m_savedState.icon = icon;
+    emit iconChanged(icon);
+}
+
 void WebWidget::saveState()
 {
     BrowserTabWidget *tabWidget = qobject_cast<BrowserTabWidget*>(parentWidget());
@@ -485,9 +566,12 @@ void WebWidget::setupWebView()
     connect(m_page, &WebPage::linkHovered,          this, &WebWidget::linkHovered);
     connect(m_page, &WebPage::titleChanged,         this, &WebWidget::titleChanged);
     connect(m_page, &WebPage::windowCloseRequested, this, &WebWidget::closeRequest);
-    connect(m_page, &WebPage::urlChanged,           this, &WebWidget::urlChanged);
+    connect(m_page, &WebPage::urlChanged,           this, [this](const QUrl &url){
+        emit urlChanged(PdfDocumentRegistry::getDisplayUrl(url));
+    });
 
     connect(m_page, &WebPage::loadStarted, this, [this](){
+        m_hasUserInput = false;
         m_adBlockManager->loadStarted(m_page->url().adjusted(QUrl::RemoveFragment));
     });
 
@@ -556,6 +640,16 @@ bool WebWidget::eventFilter(QObject *watched, QEvent *event)
             }
             break;
         }
+        case QEvent::KeyPress:
+        {
+            // Only text typed into an editable element counts as input, not keys used to scroll or navigate. The
+            // web engine enables input methods on the view while an editable element has focus
+            if (watched == m_viewFocusProxy && !m_hasUserInput
+                    && !static_cast<QKeyEvent*>(event)->text().isEmpty()
+                    && m_viewFocusProxy->inputMethodQuery(Qt::ImEnabled).toBool())
+                m_hasUserInput = true;
+            break;
+        }
         case QEvent::Wheel:
         {
             if (watched == m_viewFocusProxy || watched == m_view->getViewFocusProxy())
@@ -577,6 +671,12 @@ bool WebWidget::eventFilter(QObject *watched, QEvent *event)
             }
             break;
         }
+        case QEvent::MouseButtonPress:
+        {
+            if (watched == m_viewFocusProxy || watched == m_view->getViewFocusProxy())
+                m_view->_mousePressEvent(static_cast<QMouseEvent*>(event));
+            break;
+        }
         case QEvent::MouseButtonRelease:
         {
             if (watched == m_viewFocusProxy || watched == m_view->getViewFocusProxy())
@@ -51,6 +51,16 @@ class WebWidget : public QWidget
      */
     explicit WebWidget(const ViperServiceLocator &serviceLocator, bool privateMode, QWidget *parent = nullptr);
 
+    /**
+     * @brief Constructs the WebWidget as a placeholder, which holds the state of a page without creating a web view
+     *        until the widget is activated or woken from hibernation. Used when restoring a browsing session
+     * @param serviceLocator Web browser service registry / locator
+     * @param privateMode Set to true if the web view should be off-the-record, false if a regular web view
+     * @param state State of the page that will be loaded once the widget is activated
+     * @param parent Pointer to the parent widget
+     */
+    WebWidget(const ViperServiceLocator &serviceLocator, bool privateMode, WebState &&state, QWidget *parent = nullptr);
+
     /// WebWidget destructor
     ~WebWidget();
 
@@ -63,9 +73,25 @@ class WebWidget : public QWidget
     /// Returns true if the web widget is in hibernation mode, false if else
     bool isHibernating() const;
 
+    /// Returns true if the web widget is a placeholder whose page has not been loaded since it was restored, false if else
+    bool isPlaceholder() const;
+
     /// Returns true if the view's page is blank, with no resources being loaded
     bool isOnBlankPage() const;
 
+    /// Returns true if the page has played audio recently, false if else
+    bool isPlayingAudio() const;
+
+    /// Returns true if the user has typed into an editable element of the current page since it was
+    /// loaded, such as when filling in a form, false if else
+    bool hasUserInput() const;
+
+    /// Returns the time at which the widget was last shown or hidden, in milliseconds since the epoch
+    qint64 getLastActiveTime() const;
+
+    /// Records the current time as the last time the widget was in use
+    void markActive();
+
     /// Returns the icon associated with the current page
     QIcon getIcon() const;
 
@@ -119,6 +145,10 @@ class WebWidget : public QWidget
     /// Sets the state of the web widget as it was during a hibernation event
     void setWebState(WebState &&state);
 
+    /// Hibernates the web widget with the given state, making it a placeholder that loads the page
+    /// once the widget is activated or woken from hibernation
+    void setPlaceholderState(WebState &&state);
+
     /// Returns the last url that was manually typed by the user, or an empty url if not applicable
     const QUrl &getLastTypedUrl() const;
 
@@ -213,6 +243,9 @@ private Q_SLOTS:
     /// Handles a tab pinned state change event notification
     void onTabPinned(int index, bool value);
 
+    /// Updates the icon held by a hibernating widget once the stored icon of its page has been loaded
+    void onFaviconLoaded(const QUrl &pageUrl, const QIcon &icon);
+
 private:
     /// Forces a repaint of the inner web page
     void forceRepaint();
@@ -223,6 +256,9 @@ private Q_SLOTS:
     /// Instantiates the web view and its page, binding them to the web widget
     void setupWebView();
 
+    /// Constructs the web widget, either with a web view or as a hibernating placeholder that holds the given state
+    WebWidget(const ViperServiceLocator &serviceLocator, bool privateMode, bool isPlaceholder, WebState &&state, QWidget *parent);
+
 private:
     /// Web browser service locator
     const ViperServiceLocator &m_serviceLocator;
@@ -273,6 +309,15 @@ private Q_SLOTS:
 
     /// Last URL typed by the user
     QUrl m_lastTypedUrl;
+
+    /// True if the widget is a placeholder whose page has not yet been loaded, false if else
+    bool m_isPlaceholder;
+
+    /// True if the user has typed into an editable element of the current page, false if else
+    bool m_hasUserInput;
+
+    /// Time at which the widget was last shown or hidden, in milliseconds since the epoch
+    qint64 m_lastActiveTime;
 };
 
 #endif // WEBWIDGET_H
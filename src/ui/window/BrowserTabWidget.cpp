@@ -7,6 +7,7 @@
 #include "WebView.h"
 
 #include <algorithm>
+#include <utility>
 #include <QEvent>
 #include <QKeyEvent>
 #include <QMouseEvent>
@@ -42,6 +43,7 @@ BrowserTabWidget::BrowserTabWidget(const ViperServiceLocator &serviceLocator, bo
     connect(this, &BrowserTabWidget::currentChanged,       this, &BrowserTabWidget::onCurrentChanged);
 
     connect(m_tabBar, &BrowserTabBar::tabPinned,           this, &BrowserTabWidget::tabPinned);
+    connect(m_tabBar, &BrowserTabBar::tabMoved,            this, &BrowserTabWidget::tabMoved);
     connect(m_tabBar, &BrowserTabBar::duplicateTabRequest, this, &BrowserTabWidget::duplicateTab);
     connect(m_tabBar, &BrowserTabBar::newTabRequest,       this, [this](){
         static_cast<void>(newBackgroundTab());
@@ -51,6 +53,9 @@ BrowserTabWidget::BrowserTabWidget(const ViperServiceLocator &serviceLocator, bo
             webWidget->reload();
     });
 
+    if (m_faviconManager)
+        connect(m_faviconManager, &FaviconManager::faviconLoaded, this, &BrowserTabWidget::onFaviconLoaded);
+
     QCoreApplication::instance()->installEventFilter(this);
 }
 
@@ -206,6 +211,27 @@ WebWidget *BrowserTabWidget::createWebWidget()
         ww->view()->setMaximumWidth(m_mainWindow->maximumWidth());
     }
 
+    connectWebWidget(ww);
+
+    auto newTabPage = static_cast<NewTabType>(m_settings->getValue(BrowserSetting::NewTabPage).toInt());
+    switch (newTabPage)
+    {
+        case NewTabType::HomePage:
+            ww->load(QUrl::fromUserInput(m_settings->getValue(BrowserSetting::HomePage).toString()));
+            break;
+        case NewTabType::BlankPage:
+            ww->loadBlankPage();
+            break;
+        case NewTabType::FavoritesPage:
+            ww->load(QUrl(QLatin1String("viper://newtab")));
+            break;
+    }
+
+    return ww;
+}
+
+void BrowserTabWidget::connectWebWidget(WebWidget *ww)
+{
     // Connect web view signals to functionalty
     connect(ww, &WebWidget::iconChanged,            this, &BrowserTabWidget::onIconChanged);
     connect(ww, &WebWidget::loadFinished,           this, &BrowserTabWidget::onLoadFinished);
@@ -237,22 +263,6 @@ WebWidget *BrowserTabWidget::createWebWidget()
             m_faviconManager->updateIcon(url, ww->url(), ww->getIcon());
         });
     }
-
-    auto newTabPage = static_cast<NewTabType>(m_settings->getValue(BrowserSetting::NewTabPage).toInt());
-    switch (newTabPage)
-    {
-        case NewTabType::HomePage:
-            ww->load(QUrl::fromUserInput(m_settings->getValue(BrowserSetting::HomePage).toString()));
-            break;
-        case NewTabType::BlankPage:
-            ww->loadBlankPage();
-            break;
-        case NewTabType::FavoritesPage:
-            ww->load(QUrl(QLatin1String("viper://newtab")));
-            break;
-    }
-
-    return ww;
 }
 
 WebWidget *BrowserTabWidget::newTab()
@@ -294,7 +304,37 @@ WebWidget *BrowserTabWidget::newBackgroundTab()
 WebWidget *BrowserTabWidget::newBackgroundTabAtIndex(int index)
 {
     WebWidget *ww = createWebWidget();
+    insertBackgroundTab(index, ww);
 
+    ww->view()->resize(ww->size());
+    //ww->show();
+
+    emit newTabCreated(ww);
+    return ww;
+}
+
+WebWidget *BrowserTabWidget::newPlaceholderTabAtIndex(int index, WebState &&state)
+{
+    const QString title = state.title;
+    const QIcon icon = state.icon;
+
+    WebWidget *ww = new WebWidget(m_serviceLocator, m_privateBrowsing, std::move(state), this);
+    if (m_mainWindow)
+        ww->setMaximumWidth(m_mainWindow->maximumWidth());
+
+    connectWebWidget(ww);
+
+    index = insertBackgroundTab(index, ww);
+    setTabText(index, title);
+    setTabToolTip(index, title);
+    setTabIcon(index, icon);
+
+    emit newTabCreated(ww);
+    return ww;
+}
+
+int BrowserTabWidget::insertBackgroundTab(int index, WebWidget *ww)
+{
     if (index >= 0)
     {
         if (index > count())
@@ -305,14 +345,13 @@ WebWidget *BrowserTabWidget::newBackgroundTabAtIndex(int index)
             ++m_nextTabIndex;
     }
     else
-        m_nextTabIndex = insertTab(m_nextTabIndex, ww, QLatin1String("New Tab")) + 1;
+    {
+        index = insertTab(m_nextTabIndex, ww, QLatin1String("New Tab"));
+        m_nextTabIndex = index + 1;
+    }
 
     ww->resize(currentWidget()->size());
-    ww->view()->resize(ww->size());
-    //ww->show();
-
-    emit newTabCreated(ww);
-    return ww;
+    return index;
 }
 
 void BrowserTabWidget::onIconChanged(const QIcon &icon)
@@ -397,10 +436,18 @@ void BrowserTabWidget::onCurrentChanged(int index)
     if (!ww)
         return;
 
+    // Load the page of a restored tab the first time it is activated
+    if (ww->isPlaceholder())
+        ww->setHibernation(false);
+
     if (m_activeView && m_activeView != ww && getWebWidget(m_lastTabIndex) != nullptr)
+    {
+        m_activeView->markActive();
         m_activeView->hide();
+    }
 
     ww->show();
+    ww->markActive();
 
     m_activeView = ww;
 
@@ -464,6 +511,18 @@ void BrowserTabWidget::onUrlChanged(const QUrl &url)
         setTabIcon(indexOf(ww), m_faviconManager->getFavicon(url));
 }
 
+void BrowserTabWidget::onFaviconLoaded(const QUrl &pageUrl)
+{
+    for (int i = 0; i < count(); ++i)
+    {
+        // The icon provided by the page itself takes precedence over the stored icon. Hibernating
+        // widgets update their saved icon themselves, announcing it with iconChanged
+        WebWidget *ww = getWebWidget(i);
+        if (ww && !ww->isHibernating() && ww->url().matches(pageUrl, QUrl::RemoveUserInfo | QUrl::RemoveQuery | QUrl::RemoveFragment))
+            setTabIcon(i, ww->getIcon());
+    }
+}
+
 void BrowserTabWidget::onViewCloseRequested()
 {
     WebWidget *ww = qobject_cast<WebWidget*>(sender());
@@ -59,6 +59,9 @@ class BrowserTabWidget : public QTabWidget
     /// Emitted when the pinned state of a tab at the given index has changed (i.e., from pin -> unpin or unpin -> pin)
     void tabPinned(int index, bool value);
 
+    /// Emitted when a tab has been moved from one index to another
+    void tabMoved(int from, int to);
+
     /// Emitted when the title of the active tab's web page has changed
     void titleChanged(const QString &title);
 
@@ -113,6 +116,15 @@ public Q_SLOTS:
      */
     WebWidget *newBackgroundTabAtIndex(int index);
 
+    /**
+     * @brief Creates a new tab in the background, with a placeholder \ref WebWidget that does not load its page
+     *        until the tab is activated or woken from hibernation
+     * @param index The index at which, if valid, the tab will be inserted.
+     * @param state State of the page belonging to the tab
+     * @return A pointer to the tab's WebWidget
+     */
+    WebWidget *newPlaceholderTabAtIndex(int index, WebState &&state);
+
     /// Called when the icon for a web view has changed
     void onIconChanged(const QIcon &icon);
 
@@ -159,6 +171,9 @@ private Q_SLOTS:
     /// Called when the URL of a page has changed
     void onUrlChanged(const QUrl &url);
 
+    /// Updates the icon of each tab displaying the given page, once its icon has been loaded by the favicon manager
+    void onFaviconLoaded(const QUrl &pageUrl);
+
     /// Emitted when a view requests that it be closed
     void onViewCloseRequested();
 
@@ -167,6 +182,13 @@ private Q_SLOTS:
     /// and returning a pointer to the widget. Used during creation of a new tab
     WebWidget *createWebWidget();
 
+    /// Binds the signals of the given web widget to the appropriate handlers
+    void connectWebWidget(WebWidget *ww);
+
+    /// Inserts a tab containing the given web widget at the given index, without making it the current tab.
+    /// Returns the index of the new tab
+    int insertBackgroundTab(int index, WebWidget *ww);
+
     /// Saves the tab at the given index before closing it
     void saveTab(int index);
 
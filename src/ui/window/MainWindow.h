@@ -42,6 +42,7 @@ class WebWidget;
  */
 class MainWindow : public QMainWindow
 {
+    friend class BrowserApplication;
     friend class BrowserTabBar;
     friend class BrowserTabWidget;
     friend class NavigationToolBar;
@@ -56,6 +56,9 @@ SearchEngineLineEdit::SearchEngineLineEdit(QWidget *parent) :
 void SearchEngineLineEdit::setFaviconManager(FaviconManager *faviconManager)
 {
     m_faviconManager = faviconManager;
+    if (m_faviconManager)
+        connect(m_faviconManager, &FaviconManager::faviconLoaded, this, &SearchEngineLineEdit::onFaviconLoaded);
+
     loadSearchEngines();
 }
 
@@ -125,6 +128,20 @@ void SearchEngineLineEdit::removeSearchEngine(const QString &name)
         setSearchEngine(SearchEngineManager::instance().getDefaultSearchEngine());
 }
 
+void SearchEngineLineEdit::onFaviconLoaded(const QUrl &pageUrl, const QIcon &icon)
+{
+    if (!m_searchEngineMenu)
+        return;
+
+    SearchEngineManager &manager = SearchEngineManager::instance();
+    for (QAction *currAction : m_searchEngineMenu->actions())
+    {
+        const QUrl engineUrl(manager.getQueryString(currAction->text()));
+        if (engineUrl.matches(pageUrl, QUrl::RemoveUserInfo | QUrl::RemoveQuery | QUrl::RemoveFragment))
+            currAction->setIcon(icon);
+    }
+}
+
 void SearchEngineLineEdit::resizeEvent(QResizeEvent *event)
 {
     QLineEdit::resizeEvent(event);
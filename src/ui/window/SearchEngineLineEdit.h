@@ -4,6 +4,7 @@
 #include "SearchEngineManager.h"
 
 #include <QHash>
+#include <QIcon>
 #include <QLineEdit>
 #include <QUrl>
 
@@ -50,6 +51,9 @@ private Q_SLOTS:
      */
     void removeSearchEngine(const QString &name);
 
+    /// Sets the icon of the search engines on the given page, once its icon has been loaded by the favicon manager
+    void onFaviconLoaded(const QUrl &pageUrl, const QIcon &icon);
+
 protected:
     /// Paints the line edit with the search icon shown on its leftmost end
     virtual void resizeEvent(QResizeEvent *event) override;
@@ -0,0 +1,207 @@
+#include "BrowserTabWidget.h"
+#include "ProcessMemory.h"
+#include "TabHibernationScheduler.h"
+#include "WebWidget.h"
+
+#include <vector>
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFutureWatcher>
+#include <QTimer>
+#include <QTimerEvent>
+#include <QtConcurrent>
+
+namespace
+{
+    /// Interval between regular checks for tabs to hibernate, in milliseconds
+    constexpr int CheckInterval = 30 * 1000;
+
+    /// Delay between a tab being created and the check that follows it, in milliseconds
+    constexpr int NewTabCheckDelay = 2000;
+
+    /// Delay between hibernating tabs and measuring the memory that was reclaimed, in milliseconds.
+    /// Web processes take a moment to release the memory of a page once it has been destroyed
+    constexpr int MeasurementDelay = 5000;
+}
+
+TabHibernationScheduler::TabHibernationScheduler(Settings *settings, QObject *parent) :
+    QObject(parent),
+    m_settings(settings),
+    m_policy(),
+    m_tabWidgets(),
+    m_timerId(0),
+    m_isCheckScheduled(false),
+    m_isCheckInProgress(false),
+    m_isMeasurementPending(false),
+    m_memoryBeforeHibernation(0),
+    m_statistics()
+{
+    loadPolicy();
+
+    if (m_settings)
+        connect(m_settings, &Settings::settingChanged, this, &TabHibernationScheduler::onSettingChanged);
+
+    m_timerId = startTimer(CheckInterval, Qt::VeryCoarseTimer);
+}
+
+void TabHibernationScheduler::addTabWidget(BrowserTabWidget *tabWidget)
+{
+    if (!tabWidget)
+        return;
+
+    m_tabWidgets.append(tabWidget);
+    connect(tabWidget, &BrowserTabWidget::newTabCreated, this, &TabHibernationScheduler::scheduleCheck);
+    connect(tabWidget, &BrowserTabWidget::destroyed, this, [this](){
+        m_tabWidgets.removeAll(QPointer<BrowserTabWidget>());
+    });
+}
+
+const TabHibernationStatistics &TabHibernationScheduler::getStatistics() const
+{
+    return m_statistics;
+}
+
+void TabHibernationScheduler::checkTabs()
+{
+    m_isCheckScheduled = false;
+
+    if (!m_policy.isEnabled() || m_isCheckInProgress)
+        return;
+
+    // Skip reading the memory usage when there is no tab to hibernate
+    std::vector<WebWidget*> candidates;
+    std::vector<TabActivity> activity;
+    collectTabs(candidates, activity);
+    if (candidates.empty())
+        return;
+
+    m_isCheckInProgress = true;
+    measureMemoryUsage([this](qint64 memoryUsage){
+        m_isCheckInProgress = false;
+        hibernateTabs(memoryUsage);
+    });
+}
+
+void TabHibernationScheduler::timerEvent(QTimerEvent *event)
+{
+    if (event->timerId() == m_timerId)
+        checkTabs();
+    else
+        QObject::timerEvent(event);
+}
+
+void TabHibernationScheduler::onSettingChanged(BrowserSetting setting, const QVariant &/*value*/)
+{
+    if (setting == BrowserSetting::TabHibernationPolicy || setting == BrowserSetting::TabHibernationMemoryLimit)
+        loadPolicy();
+}
+
+void TabHibernationScheduler::loadPolicy()
+{
+    if (m_settings)
+        m_policy = TabHibernationPolicy::fromSettings(m_settings);
+}
+
+void TabHibernationScheduler::scheduleCheck()
+{
+    if (m_isCheckScheduled || !m_policy.isEnabled())
+        return;
+
+    m_isCheckScheduled = true;
+    QTimer::singleShot(NewTabCheckDelay, this, &TabHibernationScheduler::checkTabs);
+}
+
+int TabHibernationScheduler::collectTabs(std::vector<WebWidget*> &candidates, std::vector<TabActivity> &activity) const
+{
+    int numAwakeTabs = 0;
+
+    for (const QPointer<BrowserTabWidget> &tabWidget : m_tabWidgets)
+    {
+        if (tabWidget.isNull())
+            continue;
+
+        const int currentIndex = tabWidget->currentIndex();
+        for (int i = 0; i < tabWidget->count(); ++i)
+        {
+            WebWidget *ww = tabWidget->getWebWidget(i);
+            if (!ww || ww->isHibernating())
+                continue;
+
+            ++numAwakeTabs;
+            if (i == currentIndex)
+                continue;
+
+            const bool isExempt = tabWidget->isTabPinned(i)
+                    || ww->isPlayingAudio()
+                    || ww->hasUserInput()
+                    || ww->isInspectorActive()
+                    || ww->getProgress() < 100;
+
+            candidates.push_back(ww);
+            activity.push_back(TabActivity { ww->getLastActiveTime(), isExempt });
+        }
+    }
+
+    return numAwakeTabs;
+}
+
+void TabHibernationScheduler::hibernateTabs(qint64 memoryUsage)
+{
+    if (!m_policy.isEnabled())
+        return;
+
+    // Tabs may have changed while the memory usage was measured, so they are gathered again
+    std::vector<WebWidget*> candidates;
+    std::vector<TabActivity> activity;
+    const int numAwakeTabs = collectTabs(candidates, activity);
+    if (candidates.empty())
+        return;
+
+    const std::vector<std::size_t> selectedTabs
+            = m_policy.selectTabs(activity, numAwakeTabs, QDateTime::currentMSecsSinceEpoch(), memoryUsage);
+    if (selectedTabs.empty())
+        return;
+
+    for (std::size_t index : selectedTabs)
+        candidates.at(index)->setHibernation(true);
+
+    m_statistics.HibernatedTabs += static_cast<int>(selectedTabs.size());
+    emit statisticsChanged(m_statistics);
+
+    // Measure the memory used by the browser before the first group of tabs that has not yet been measured
+    if (memoryUsage > 0 && !m_isMeasurementPending)
+    {
+        m_isMeasurementPending = true;
+        m_memoryBeforeHibernation = memoryUsage;
+        QTimer::singleShot(MeasurementDelay, this, &TabHibernationScheduler::measureReclaimedMemory);
+    }
+}
+
+void TabHibernationScheduler::measureReclaimedMemory()
+{
+    measureMemoryUsage([this](qint64 memoryUsage){
+        m_isMeasurementPending = false;
+        if (memoryUsage < 0)
+            return;
+
+        const qint64 reclaimed = m_memoryBeforeHibernation - memoryUsage;
+        if (reclaimed <= 0)
+            return;
+
+        m_statistics.ReclaimedBytes += reclaimed;
+        emit statisticsChanged(m_statistics);
+    });
+}
+
+void TabHibernationScheduler::measureMemoryUsage(std::function<void(qint64)> &&callback)
+{
+    // The watcher belongs to the scheduler, so the callback is dropped if the scheduler is destroyed first
+    QFutureWatcher<qint64> *watcher = new QFutureWatcher<qint64>(this);
+    connect(watcher, &QFutureWatcher<qint64>::finished, this, [watcher, callback](){
+        callback(watcher->result());
+        watcher->deleteLater();
+    });
+    watcher->setFuture(QtConcurrent::run(&ProcessMemory::getProcessTreeResidentSetSize,
+                                         static_cast<qint64>(QCoreApplication::applicationPid())));
+}
@@ -0,0 +1,116 @@
+#ifndef TABHIBERNATIONSCHEDULER_H
+#define TABHIBERNATIONSCHEDULER_H
+
+#include "Settings.h"
+#include "TabHibernationPolicy.h"
+
+#include <functional>
+#include <vector>
+
+#include <QList>
+#include <QObject>
+#include <QPointer>
+
+class BrowserTabWidget;
+class WebWidget;
+
+/// Counters describing the tabs that were hibernated automatically
+struct TabHibernationStatistics
+{
+    /// Number of tabs that have been hibernated by the scheduler
+    int HibernatedTabs = 0;
+
+    /// Amount of memory, in bytes, reclaimed by hibernating tabs
+    qint64 ReclaimedBytes = 0;
+};
+
+/**
+ * @class TabHibernationScheduler
+ * @brief Periodically hibernates the least recently used background tabs of every browser window,
+ *        according to the \ref TabHibernationPolicy chosen by the user.
+ *
+ * Pinned tabs, tabs that are playing audio, tabs that the user has typed into, tabs with an open
+ * inspector and tabs that are still loading are never hibernated automatically.
+ */
+class TabHibernationScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// Constructs the scheduler with a pointer to the application settings and an optional parent
+    explicit TabHibernationScheduler(Settings *settings, QObject *parent = nullptr);
+
+    /// Adds the tabs of a browser window to the set of tabs managed by the scheduler
+    void addTabWidget(BrowserTabWidget *tabWidget);
+
+    /// Returns the counters of the tabs hibernated so far, and the memory reclaimed by doing so
+    const TabHibernationStatistics &getStatistics() const;
+
+Q_SIGNALS:
+    /// Emitted when tabs have been hibernated, or the memory they reclaimed has been measured
+    void statisticsChanged(const TabHibernationStatistics &statistics);
+
+public Q_SLOTS:
+    /// Measures the memory used by the browser in the background, then hibernates any background tabs
+    /// that are selected by the hibernation policy
+    void checkTabs();
+
+protected:
+    /// Called on a regular interval to check if any tabs should be hibernated
+    void timerEvent(QTimerEvent *event) override;
+
+private Q_SLOTS:
+    /// Handles a change in the value of a browser setting
+    void onSettingChanged(BrowserSetting setting, const QVariant &value);
+
+private:
+    /// Creates the hibernation policy from the user's settings
+    void loadPolicy();
+
+    /// Schedules a call to checkTabs(), so that several new tabs only trigger one check
+    void scheduleCheck();
+
+    /// Gathers the background tabs that are awake, and the activity of each of them. Returns the total number
+    /// of tabs that are awake
+    int collectTabs(std::vector<WebWidget*> &candidates, std::vector<TabActivity> &activity) const;
+
+    /// Hibernates the tabs selected by the hibernation policy, given the memory used by the browser
+    void hibernateTabs(qint64 memoryUsage);
+
+    /// Called some time after tabs have been hibernated, to measure the memory that was reclaimed
+    void measureReclaimedMemory();
+
+    /// Measures the memory used by the browser and its web processes on a worker thread, which reads it from
+    /// the /proc file system, and passes it to the callback on the thread of the scheduler
+    void measureMemoryUsage(std::function<void(qint64)> &&callback);
+
+private:
+    /// Application settings
+    Settings *m_settings;
+
+    /// Decides which tabs are hibernated
+    TabHibernationPolicy m_policy;
+
+    /// Tab widgets of the open browser windows
+    QList<QPointer<BrowserTabWidget>> m_tabWidgets;
+
+    /// Identifier of the timer that periodically calls checkTabs()
+    int m_timerId;
+
+    /// True if a call to checkTabs() has been scheduled, false if else
+    bool m_isCheckScheduled;
+
+    /// True if a check is waiting for the memory usage of the browser, false if else
+    bool m_isCheckInProgress;
+
+    /// True if the memory reclaimed by the last hibernated tabs is waiting to be measured, false if else
+    bool m_isMeasurementPending;
+
+    /// Memory used by the browser before the tabs that are waiting to be measured were hibernated
+    qint64 m_memoryBeforeHibernation;
+
+    /// Counters of hibernated tabs and reclaimed memory
+    TabHibernationStatistics m_statistics;
+};
+
+#endif // TABHIBERNATIONSCHEDULER_H
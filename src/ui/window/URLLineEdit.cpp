@@ -268,12 +268,13 @@ bool URLLineEdit::isInputForBookmarkShortcut(const QString &input)
     if (delimIdx > 0)
         urlTextStart = urlTextStart.left(delimIdx);
 
-    for (auto it : *m_bookmarkManager)
+    std::shared_ptr<const FlatBookmarkTree> bookmarks = m_bookmarkManager->getFlatTree();
+    for (FlatBookmarkTree::NodeIndex index : bookmarks->getBookmarks())
     {
-        if (it->getType() == BookmarkNode::Bookmark
-                && (urlTextStart.compare(it->getShortcut()) == 0 || urlText.compare(it->getShortcut()) == 0))
+        const QString &shortcut = bookmarks->getShortcut(index);
+        if (urlTextStart.compare(shortcut) == 0 || urlText.compare(shortcut) == 0)
         {
-            QString bookmarkUrl = it->getURL().toString(QUrl::FullyEncoded);
+            QString bookmarkUrl = bookmarks->getURL(index).toString(QUrl::FullyEncoded);
             if (delimIdx > 0 && bookmarkUrl.contains(QLatin1String("%25s")))
                 urlText = bookmarkUrl.replace(QLatin1String("%25s"), urlText.mid(delimIdx + 1));
             else
@@ -34,8 +34,8 @@ AdBlockManager::AdBlockManager(const ViperServiceLocator &, QObject *parent) :
     m_subscriptions(),
     m_resourceMap(),
     m_resourceContentTypeMap(),
-    m_domainStylesheetCache(24),
-    m_jsInjectionCache(24),
+    m_domainStylesheetCache(MaxCachedStringBytes, 4),
+    m_jsInjectionCache(MaxCachedStringBytes, 4),
     m_emptyStr(),
     m_adBlockModel(nullptr),
     m_log(nullptr),
@@ -96,14 +96,14 @@ const QString &AdBlockManager::getStylesheet(const URL &/*url*/) const
     return m_emptyStr;
 }
 
-const QString &AdBlockManager::getDomainStylesheet(const URL &/*url*/)
+DomainScript AdBlockManager::getDomainStylesheet(const URL &/*url*/)
 {
-    return m_emptyStr;
+    return DomainScript();
 }
 
-const QString &AdBlockManager::getDomainJavaScript(const URL &/*url*/)
+DomainScript AdBlockManager::getDomainJavaScript(const URL &/*url*/)
 {
-    return m_emptyStr;
+    return DomainScript();
 }
 
 bool AdBlockManager::shouldBlockRequest(QWebEngineUrlRequestInfo &/*info*/, const QUrl &/*firstPartyUrl*/)
@@ -0,0 +1,163 @@
+#include "BookmarkImporter.h"
+#include "BookmarkManager.h"
+#include "BookmarkNode.h"
+#include "DatabaseTaskScheduler.h"
+#include "ServiceLocator.h"
+
+#include <memory>
+#include <set>
+
+#include <QFile>
+#include <QObject>
+#include <QString>
+#include <QTest>
+#include <QTextStream>
+
+/// Tests the parsing of Netscape formatted bookmark files, and their import into the bookmark collection
+class BookmarkImporterTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    BookmarkImporterTest() :
+        QObject(nullptr),
+        m_htmlFile(QLatin1String("BookmarkImporterTest.html"))
+    {
+    }
+
+private slots:
+    /// Removes the bookmark file written by each test
+    void cleanup()
+    {
+        if (QFile::exists(m_htmlFile))
+            QFile::remove(m_htmlFile);
+    }
+
+    /// Tests that folders, bookmarks and their names are read from the file, in order
+    void testReadFile()
+    {
+        writeFile(QLatin1String(
+                      "<!DOCTYPE NETSCAPE-Bookmark-file-1>\n"
+                      "<!-- This is an automatically generated file.\n"
+                      "     It will be read and overwritten.\n"
+                      "     DO NOT EDIT! -->\n"
+                      "<META HTTP-EQUIV=\"Content-Type\" CONTENT=\"text/html; charset=UTF-8\">\n"
+                      "<TITLE>Bookmarks</TITLE>\n<H1>Bookmarks</H1>\n"
+                      "<DL><p>\n"
+                      "    <DT><H3 ADD_DATE=\"1500000000\">Reading &amp; Writing</H3>\n"
+                      "    <DL><p>\n"
+                      "        <DT><A HREF=\"https://viper-browser.com/\" ADD_DATE=\"1500000000\">Viper Browser</A>\n"
+                      "        <DT><H3>Empty</H3>\n"
+                      "        <DL><p>\n"
+                      "        </DL><p>\n"
+                      "        <dt><a href='https://example.com/?a=1&amp;b=2' title=\"a > b\">Example &#8211; Site</a>\n"
+                      "    </DL><p>\n"
+                      "    <DT><A HREF=\"https://second.example.com/\">Second</A>\n"
+                      "</DL><p>\n"));
+
+        std::unique_ptr<BookmarkNode> root = BookmarkImporter::readFile(m_htmlFile);
+        QVERIFY(root != nullptr);
+        QCOMPARE(root->getNumChildren(), 2);
+
+        BookmarkNode *folder = root->getNode(0);
+        QCOMPARE(folder->getType(), BookmarkNode::Folder);
+        QCOMPARE(folder->getName(), QLatin1String("Reading & Writing"));
+        QCOMPARE(folder->getNumChildren(), 3);
+
+        QCOMPARE(folder->getNode(0)->getName(), QLatin1String("Viper Browser"));
+        QCOMPARE(folder->getNode(0)->getURL(), QUrl(QLatin1String("https://viper-browser.com/")));
+
+        QCOMPARE(folder->getNode(1)->getType(), BookmarkNode::Folder);
+        QCOMPARE(folder->getNode(1)->getNumChildren(), 0);
+
+        QCOMPARE(folder->getNode(2)->getName(), QString::fromUtf8("Example – Site"));
+        QCOMPARE(folder->getNode(2)->getURL(), QUrl(QLatin1String("https://example.com/?a=1&b=2")));
+
+        QCOMPARE(root->getNode(1)->getName(), QLatin1String("Second"));
+        QCOMPARE(root->getNode(1)->getParent(), root.get());
+    }
+
+    /// Tests that files without a bookmark list are rejected
+    void testReadInvalidFile()
+    {
+        writeFile(QLatin1String("<html><body>Not a bookmark file</body></html>"));
+        QVERIFY(BookmarkImporter::readFile(m_htmlFile) == nullptr);
+        QVERIFY(BookmarkImporter::readFile(QLatin1String("DoesNotExist.html")) == nullptr);
+    }
+
+    /// Tests that a large file is imported into the bookmark collection in one operation, and reports the time taken
+    void testLargeImport()
+    {
+        const int numFolders = 50, bookmarksPerFolder = 1000;
+
+        QFile file(m_htmlFile);
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Text));
+        QTextStream stream(&file);
+        stream.setCodec("UTF-8");
+        stream << "<!DOCTYPE NETSCAPE-Bookmark-file-1>\n<DL><p>\n";
+        for (int i = 0; i < numFolders; ++i)
+        {
+            stream << "<DT><H3>Folder " << i << "</H3>\n<DL><p>\n";
+            for (int j = 0; j < bookmarksPerFolder; ++j)
+                stream << "<DT><A HREF=\"https://site" << j << ".folder" << i << ".com/\">Site " << j << "</A>\n";
+            stream << "</DL><p>\n";
+        }
+        stream << "</DL><p>\n";
+        stream.flush();
+        file.close();
+
+        std::shared_ptr<BookmarkNode> root = std::make_shared<BookmarkNode>(BookmarkNode::Folder, QLatin1String("Root Folder"));
+        ViperServiceLocator serviceLocator;
+        DatabaseTaskScheduler taskScheduler;
+        BookmarkManager manager(serviceLocator, taskScheduler, nullptr);
+        manager.setRootNode(root);
+
+        BookmarkNode *importFolder = manager.addFolder(QLatin1String("Imported Bookmarks"), root.get());
+        QVERIFY(importFolder != nullptr);
+        manager.waitToFinishList();
+
+        BookmarkImporter importer(&manager);
+        QVERIFY(importer.import(m_htmlFile, importFolder));
+
+        QCOMPARE(importFolder->getNumChildren(), numFolders);
+        QCOMPARE(importFolder->getNode(numFolders - 1)->getNumChildren(), bookmarksPerFolder);
+        QVERIFY(manager.isBookmarked(QUrl(QLatin1String("https://site999.folder49.com/"))));
+
+        // Every node needs its own identifier, and its parent must be identified before it
+        std::set<int> uniqueIds { importFolder->getUniqueId() };
+        for (int i = 0; i < numFolders; ++i)
+        {
+            BookmarkNode *folder = importFolder->getNode(i);
+            QVERIFY(uniqueIds.insert(folder->getUniqueId()).second);
+            for (int j = 0; j < folder->getNumChildren(); ++j)
+            {
+                BookmarkNode *bookmark = folder->getNode(j);
+                QVERIFY(bookmark->getUniqueId() > folder->getUniqueId());
+                QVERIFY(uniqueIds.insert(bookmark->getUniqueId()).second);
+                if (j > 0)
+                    QVERIFY(folder->getNode(j - 1)->getSortKey() < bookmark->getSortKey());
+            }
+        }
+
+        manager.waitToFinishList();
+    }
+
+private:
+    /// Writes the given contents to the bookmark file
+    void writeFile(const QString &contents)
+    {
+        QFile file(m_htmlFile);
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Text));
+        QTextStream stream(&file);
+        stream.setCodec("UTF-8");
+        stream << contents;
+    }
+
+private:
+    /// Bookmark file used for testing
+    QString m_htmlFile;
+};
+
+QTEST_APPLESS_MAIN(BookmarkImporterTest)
+
+#include "BookmarkImporterTest.moc"
@@ -57,6 +57,13 @@ private slots:
     /// still thinks the node is bookmarked
     void testIsBookmarkedAfterDeletingParentFolder();
 
+    /// Adds bookmarks to the bookmarks bar and moves them around, for the next test case
+    void testReorderingBookmarks();
+
+    /// Verifies that the order of the bookmarks from the previous test case, testReorderingBookmarks(),
+    /// was saved to the database
+    void testReorderingPersisted();
+
 private:
     /// Bookmark database file used for testing
     QString m_dbFile;
@@ -212,6 +219,38 @@ void BookmarkIntegrationTest::testIsBookmarkedAfterDeletingParentFolder()
     QVERIFY(!m_bookmarkManager->isBookmarked(testUrl));
 }
 
+void BookmarkIntegrationTest::testReorderingBookmarks()
+{
+    BookmarkNode *bookmarkBar = m_bookmarkManager->getBookmarksBar();
+    QVERIFY(bookmarkBar != nullptr);
+    QCOMPARE(bookmarkBar->getNumChildren(), 1);
+
+    m_bookmarkManager->appendBookmark(QLatin1String("First"), QUrl(QLatin1String("https://first.example.com/")), bookmarkBar);
+    m_bookmarkManager->appendBookmark(QLatin1String("Second"), QUrl(QLatin1String("https://second.example.com/")), bookmarkBar);
+    m_bookmarkManager->insertBookmark(QLatin1String("Third"), QUrl(QLatin1String("https://third.example.com/")), bookmarkBar, 1);
+
+    // Order is now: Search Engine, Third, First, Second
+    m_bookmarkManager->setBookmarkPosition(bookmarkBar->getNode(3), 0);
+    m_bookmarkManager->removeBookmark(QUrl(QLatin1String("https://first.example.com/")));
+
+    QCOMPARE(bookmarkBar->getNumChildren(), 3);
+    QCOMPARE(bookmarkBar->getNode(0)->getName(), QLatin1String("Second"));
+    QCOMPARE(bookmarkBar->getNode(1)->getName(), QLatin1String("Search Engine"));
+    QCOMPARE(bookmarkBar->getNode(2)->getName(), QLatin1String("Third"));
+}
+
+void BookmarkIntegrationTest::testReorderingPersisted()
+{
+    BookmarkNode *bookmarkBar = m_bookmarkManager->getBookmarksBar();
+    QVERIFY(bookmarkBar != nullptr);
+
+    QCOMPARE(bookmarkBar->getNumChildren(), 3);
+    QCOMPARE(bookmarkBar->getNode(0)->getName(), QLatin1String("Second"));
+    QCOMPARE(bookmarkBar->getNode(1)->getName(), QLatin1String("Search Engine"));
+    QCOMPARE(bookmarkBar->getNode(2)->getName(), QLatin1String("Third"));
+    QVERIFY(!m_bookmarkManager->isBookmarked(QUrl(QLatin1String("https://first.example.com/"))));
+}
+
 QTEST_GUILESS_MAIN(BookmarkIntegrationTest)
 
 #include "BookmarkIntegrationTest.moc"
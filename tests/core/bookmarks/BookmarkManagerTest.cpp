@@ -7,6 +7,7 @@
 #include <chrono>
 #include <memory>
 #include <thread>
+#include <vector>
 
 #include <QObject>
 #include <QString>
@@ -35,6 +36,12 @@ private slots:
 
     void testBookmarkCheckWithTrailingSlash();
 
+    void testChangingBookmarkUrl();
+
+    void testReorderingBookmarks();
+
+    void testFlatTreeFollowsEdits();
+
 private:
     /// Root node/folder used in bookmark management tests
     std::shared_ptr<BookmarkNode> m_root;
@@ -236,6 +243,96 @@ void BookmarkManagerTest::testBookmarkCheckWithTrailingSlash()
     QVERIFY2(m_manager->isBookmarked(compareToUrl), "Bookmark manager should ignore trailing slashes when checking if a URL is bookmarked");
 }
 
+void BookmarkManagerTest::testChangingBookmarkUrl()
+{
+    QUrl oldUrl { QLatin1String("https://old.example.com/page") };
+    QUrl newUrl { QLatin1String("https://new.example.com/page") };
+
+    m_manager->appendBookmark(QLatin1String("Example"), oldUrl, m_root.get());
+    BookmarkNode *bookmark = m_manager->getBookmark(oldUrl);
+    QVERIFY2(bookmark != nullptr, "Bookmark manager should have inserted the bookmark into the collection");
+
+    m_manager->setBookmarkURL(bookmark, newUrl);
+    QVERIFY2(!m_manager->isBookmarked(oldUrl), "Bookmark manager should no longer find the bookmark by its old URL");
+    QCOMPARE(m_manager->getBookmark(newUrl), bookmark);
+
+    // Lookups ignore the scheme and any "www." prefix
+    QCOMPARE(m_manager->getBookmark(QUrl(QLatin1String("http://www.new.example.com/page"))), bookmark);
+
+    m_manager->removeBookmark(newUrl);
+    QVERIFY2(!m_manager->isBookmarked(newUrl), "Bookmark manager should have removed the bookmark from the collection");
+}
+
+void BookmarkManagerTest::testReorderingBookmarks()
+{
+    BookmarkNode *folder = m_manager->addFolder(QLatin1String("Reorder"), m_root.get());
+    QVERIFY2(folder != nullptr, "Folder should exist");
+
+    const std::vector<QString> names { QLatin1String("A"), QLatin1String("B"), QLatin1String("C"), QLatin1String("D") };
+    for (const QString &name : names)
+        m_manager->appendBookmark(name, QUrl(QString("https://%1.example.com/").arg(name)), folder);
+
+    auto verifySortKeys = [folder](){
+        for (int i = 1; i < folder->getNumChildren(); ++i)
+        {
+            if (folder->getNode(i - 1)->getSortKey() >= folder->getNode(i)->getSortKey())
+                return false;
+        }
+        return true;
+    };
+
+    // Moving a bookmark should only change the moved node
+    m_manager->m_journal.clear();
+    m_manager->setBookmarkPosition(folder->getNode(3), 1);
+    QCOMPARE(folder->getNode(1)->getName(), QLatin1String("D"));
+    QCOMPARE(m_manager->m_journal.size(), static_cast<size_t>(1));
+    QVERIFY2(verifySortKeys(), "Sort keys should follow the order of the bookmarks");
+
+    m_manager->setBookmarkPosition(folder->getNode(0), 3);
+    QCOMPARE(folder->getNode(3)->getName(), QLatin1String("A"));
+    QVERIFY2(verifySortKeys(), "Sort keys should follow the order of the bookmarks");
+
+    // Repeatedly inserting at the same position eventually exhausts the gap between two keys
+    for (int i = 0; i < 16; ++i)
+    {
+        m_manager->insertBookmark(QString("Inserted %1").arg(i), QUrl(QString("https://inserted%1.example.com/").arg(i)), folder, 1);
+        QVERIFY2(verifySortKeys(), "Sort keys should follow the order of the bookmarks");
+    }
+    QCOMPARE(folder->getNode(1)->getName(), QLatin1String("Inserted 15"));
+}
+
+void BookmarkManagerTest::testFlatTreeFollowsEdits()
+{
+    const QUrl oldUrl { QLatin1String("https://flat.example.com/old") };
+    const QUrl newUrl { QLatin1String("https://flat.example.com/new") };
+
+    m_manager->appendBookmark(QLatin1String("Old Name"), oldUrl, m_root.get());
+    BookmarkNode *bookmark = m_manager->getBookmark(oldUrl);
+    QVERIFY2(bookmark != nullptr, "Bookmark manager should have inserted the bookmark into the collection");
+
+    m_manager->setBookmarkName(bookmark, QLatin1String("New Name"));
+    m_manager->setBookmarkShortcut(bookmark, QLatin1String("nn"));
+    m_manager->setBookmarkURL(bookmark, newUrl);
+    m_manager->waitToFinishList();
+
+    // The flat copy of the tree should hold the new values of the bookmark, rather than the values it was created with
+    std::shared_ptr<const FlatBookmarkTree> flatTree = m_manager->getFlatTree();
+    bool found = false;
+    for (FlatBookmarkTree::NodeIndex index : flatTree->getBookmarks())
+    {
+        if (flatTree->getNode(index) != bookmark)
+            continue;
+
+        found = true;
+        QCOMPARE(flatTree->getName(index), QLatin1String("New Name"));
+        QCOMPARE(flatTree->getShortcut(index), QLatin1String("nn"));
+        QCOMPARE(flatTree->getURL(index), newUrl);
+    }
+    QVERIFY2(found, "Flat tree should contain the edited bookmark");
+
+    m_manager->removeBookmark(newUrl);
+}
+
 QTEST_APPLESS_MAIN(BookmarkManagerTest)
 
 #include "BookmarkManagerTest.moc"
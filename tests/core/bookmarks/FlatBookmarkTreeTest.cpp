@@ -0,0 +1,187 @@
+#include "BookmarkNode.h"
+#include "FlatBookmarkTree.h"
+
+#include <deque>
+#include <memory>
+
+#include <QObject>
+#include <QString>
+#include <QTest>
+#include <QUrl>
+
+/// Tests the flat, depth-first copy of the bookmark tree
+class FlatBookmarkTreeTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    FlatBookmarkTreeTest() :
+        QObject(nullptr)
+    {
+    }
+
+private slots:
+    /// Tests that an empty or missing tree produces an empty flat tree
+    void testEmptyTree()
+    {
+        FlatBookmarkTree nullTree(nullptr);
+        QVERIFY(nullTree.empty());
+        QVERIFY(nullTree.getBookmarks().empty());
+
+        BookmarkNode root(BookmarkNode::Folder, QLatin1String("Root"));
+        FlatBookmarkTree flatTree(&root);
+        QCOMPARE(flatTree.size(), std::size_t(1));
+        QCOMPARE(flatTree.getParentIndex(0), FlatBookmarkTree::InvalidIndex);
+        QCOMPARE(flatTree.getSubtreeEnd(0), FlatBookmarkTree::NodeIndex(1));
+        QCOMPARE(flatTree.getFolders().size(), std::size_t(1));
+    }
+
+    /// Tests that nodes are stored in depth-first order, with the correct parents and subtree ranges
+    void testTreeLayout()
+    {
+        // Root
+        //  - Folder A
+        //     - Bookmark 1
+        //     - Folder B
+        //        - Bookmark 2
+        //  - Bookmark 3
+        BookmarkNode root(BookmarkNode::Folder, QLatin1String("Root"));
+        root.setUniqueId(0);
+        BookmarkNode *folderA = appendNode(&root, BookmarkNode::Folder, QLatin1String("Folder A"), 1);
+        appendNode(folderA, BookmarkNode::Bookmark, QLatin1String("Bookmark 1"), 2, QLatin1String("https://one.example.com/"));
+        BookmarkNode *folderB = appendNode(folderA, BookmarkNode::Folder, QLatin1String("Folder B"), 3);
+        BookmarkNode *bookmark2 = appendNode(folderB, BookmarkNode::Bookmark, QLatin1String("Bookmark 2"), 4, QLatin1String("https://two.example.com/"));
+        bookmark2->setShortcut(QLatin1String("two"));
+        appendNode(&root, BookmarkNode::Bookmark, QLatin1String("Bookmark 3"), 5, QLatin1String("https://three.example.com/"));
+
+        FlatBookmarkTree flatTree(&root);
+        QCOMPARE(flatTree.size(), std::size_t(6));
+
+        for (FlatBookmarkTree::NodeIndex i = 0; i < 6; ++i)
+            QCOMPARE(flatTree.getUniqueId(i), static_cast<int>(i));
+
+        QCOMPARE(flatTree.getParentIndex(1), FlatBookmarkTree::NodeIndex(0));
+        QCOMPARE(flatTree.getParentIndex(2), FlatBookmarkTree::NodeIndex(1));
+        QCOMPARE(flatTree.getParentIndex(3), FlatBookmarkTree::NodeIndex(1));
+        QCOMPARE(flatTree.getParentIndex(4), FlatBookmarkTree::NodeIndex(3));
+        QCOMPARE(flatTree.getParentIndex(5), FlatBookmarkTree::NodeIndex(0));
+
+        QCOMPARE(flatTree.getSubtreeEnd(0), FlatBookmarkTree::NodeIndex(6));
+        QCOMPARE(flatTree.getSubtreeEnd(1), FlatBookmarkTree::NodeIndex(5));
+        QCOMPARE(flatTree.getSubtreeEnd(2), FlatBookmarkTree::NodeIndex(3));
+        QCOMPARE(flatTree.getSubtreeEnd(3), FlatBookmarkTree::NodeIndex(5));
+        QCOMPARE(flatTree.getSubtreeEnd(5), FlatBookmarkTree::NodeIndex(6));
+
+        QCOMPARE(flatTree.getName(3), QLatin1String("Folder B"));
+        QCOMPARE(flatTree.getType(3), BookmarkNode::Folder);
+        QCOMPARE(flatTree.getURL(4), QUrl(QLatin1String("https://two.example.com/")));
+        QCOMPARE(flatTree.getShortcut(4), QLatin1String("two"));
+        QVERIFY(flatTree.getShortcut(2).isEmpty());
+        QVERIFY(flatTree.getURL(1).isEmpty());
+        QCOMPARE(flatTree.getNode(4), bookmark2);
+
+        const std::vector<FlatBookmarkTree::NodeIndex> expectedBookmarks { 2, 4, 5 };
+        const std::vector<FlatBookmarkTree::NodeIndex> expectedFolders { 0, 1, 3 };
+        QVERIFY(flatTree.getBookmarks() == expectedBookmarks);
+        QVERIFY(flatTree.getFolders() == expectedFolders);
+    }
+
+    /// Tests that nodes sharing a name or URL refer to the same interned value
+    void testInterning()
+    {
+        BookmarkNode root(BookmarkNode::Folder, QLatin1String("Root"));
+        const QString url = QLatin1String("https://example.com/");
+        appendNode(&root, BookmarkNode::Bookmark, QLatin1String("Example"), 1, url);
+        appendNode(&root, BookmarkNode::Bookmark, QLatin1String("Example"), 2, url);
+
+        FlatBookmarkTree flatTree(&root);
+        QCOMPARE(&flatTree.getName(1), &flatTree.getName(2));
+        QCOMPARE(&flatTree.getURL(1), &flatTree.getURL(2));
+    }
+
+    /// Compares a scan of every bookmark through the node tree against a scan of the flat tree
+    void benchmarkNodeTreeScan()
+    {
+        BookmarkNode root(BookmarkNode::Folder, QLatin1String("Root"));
+        buildLargeTree(&root);
+
+        int numMatches = 0;
+        QBENCHMARK
+        {
+            numMatches = 0;
+            std::deque<const BookmarkNode*> queue { &root };
+            while (!queue.empty())
+            {
+                const BookmarkNode *node = queue.front();
+                queue.pop_front();
+
+                if (node->getType() == BookmarkNode::Bookmark)
+                {
+                    if (node->getShortcut().isEmpty())
+                        ++numMatches;
+                    continue;
+                }
+
+                for (int i = 0; i < node->getNumChildren(); ++i)
+                    queue.push_back(node->getNode(i));
+            }
+        }
+        QCOMPARE(numMatches, NumFolders * BookmarksPerFolder);
+    }
+
+    /// Compares a scan of every bookmark through the flat tree against a scan of the node tree
+    void benchmarkFlatTreeScan()
+    {
+        BookmarkNode root(BookmarkNode::Folder, QLatin1String("Root"));
+        buildLargeTree(&root);
+        FlatBookmarkTree flatTree(&root);
+
+        int numMatches = 0;
+        QBENCHMARK
+        {
+            numMatches = 0;
+            for (FlatBookmarkTree::NodeIndex index : flatTree.getBookmarks())
+            {
+                if (flatTree.getShortcut(index).isEmpty())
+                    ++numMatches;
+            }
+        }
+        QCOMPARE(numMatches, NumFolders * BookmarksPerFolder);
+    }
+
+private:
+    /// Appends a node to the given folder, returning a pointer to the new node
+    BookmarkNode *appendNode(BookmarkNode *folder, BookmarkNode::NodeType type, const QString &name, int uniqueId,
+                             const QString &url = QString())
+    {
+        BookmarkNode *node = folder->appendNode(std::make_unique<BookmarkNode>(type, name));
+        node->setUniqueId(uniqueId);
+        if (!url.isEmpty())
+            node->setURL(QUrl(url));
+        return node;
+    }
+
+    /// Fills the given root folder with \ref NumFolders folders of \ref BookmarksPerFolder bookmarks each
+    void buildLargeTree(BookmarkNode *root)
+    {
+        int uniqueId = 1;
+        for (int i = 0; i < NumFolders; ++i)
+        {
+            BookmarkNode *folder = appendNode(root, BookmarkNode::Folder, QString("Folder %1").arg(i), uniqueId++);
+            for (int j = 0; j < BookmarksPerFolder; ++j)
+                appendNode(folder, BookmarkNode::Bookmark, QString("Site %1").arg(j), uniqueId++,
+                           QString("https://site%1.folder%2.com/").arg(j).arg(i));
+        }
+    }
+
+private:
+    /// Number of folders in the tree used for benchmarking
+    static constexpr int NumFolders = 1000;
+
+    /// Number of bookmarks in each folder of the benchmark tree
+    static constexpr int BookmarksPerFolder = 100;
+};
+
+QTEST_APPLESS_MAIN(FlatBookmarkTreeTest)
+
+#include "FlatBookmarkTreeTest.moc"
@@ -0,0 +1,164 @@
+#include "ShardedLRUCache.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <QObject>
+#include <QString>
+#include <QtTest>
+
+/// Measures the cost of a string by its length
+struct StringLengthCost
+{
+    std::size_t operator()(const std::string &value) const
+    {
+        return value.size();
+    }
+};
+
+class ShardedLRUCacheTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    ShardedLRUCacheTest() :
+        QObject(nullptr)
+    {
+    }
+
+private Q_SLOTS:
+    /// Verifies that the least recently used entry is evicted once the cache is full
+    void testEvictsLeastRecentlyUsed()
+    {
+        ShardedLRUCache<int, int> cache(3, 1);
+        cache.put(1, 10);
+        cache.put(2, 20);
+        cache.put(3, 30);
+
+        // Mark the first entry as recently used, so the second is evicted instead
+        QCOMPARE(cache.tryGet(1).value_or(0), 10);
+        cache.put(4, 40);
+
+        QVERIFY(cache.has(1));
+        QVERIFY(!cache.has(2));
+        QVERIFY(cache.has(3));
+        QVERIFY(cache.has(4));
+        QVERIFY(!cache.tryGet(2).has_value());
+
+        const CacheStatistics stats = cache.getStatistics();
+        QCOMPARE(stats.Hits, uint64_t{1});
+        QCOMPARE(stats.Misses, uint64_t{1});
+        QCOMPARE(stats.Evictions, uint64_t{1});
+        QCOMPARE(stats.Size, std::size_t{3});
+    }
+
+    /// Verifies that entries are bounded by their total cost
+    void testCostBudget()
+    {
+        ShardedLRUCache<std::string, std::string, StringLengthCost> cache(10, 1);
+        cache.put("a", std::string(6, 'a'));
+        cache.put("b", std::string(4, 'b'));
+        QCOMPARE(cache.getStatistics().Cost, std::size_t{10});
+
+        cache.put("c", std::string(3, 'c'));
+        QVERIFY(!cache.has("a"));
+        QVERIFY(cache.has("b"));
+        QCOMPARE(cache.getStatistics().Cost, std::size_t{7});
+
+        // Replacing a value updates the total cost
+        cache.put("b", std::string(1, 'b'));
+        QCOMPARE(cache.getStatistics().Cost, std::size_t{4});
+
+        // Entries that can never fit are rejected
+        QVERIFY(!cache.put("d", std::string(11, 'd')));
+        QVERIFY(!cache.has("d"));
+
+        // An explicit cost overrides the cost function
+        QVERIFY(cache.put("e", std::string(1, 'e'), 6));
+        QCOMPARE(cache.getStatistics().Cost, std::size_t{10});
+    }
+
+    /// Verifies that entries can be removed and the cache cleared
+    void testRemoveAndClear()
+    {
+        ShardedLRUCache<int, QString> cache(16, 4);
+        for (int i = 0; i < 8; ++i)
+            cache.put(i, QString::number(i));
+
+        QVERIFY(cache.remove(3));
+        QVERIFY(!cache.remove(3));
+        QVERIFY(!cache.has(3));
+        QCOMPARE(cache.tryGet(4).value_or(QString()), QLatin1String("4"));
+
+        // Nodes released by the removal are reused
+        cache.put(3, QLatin1String("three"));
+        QCOMPARE(cache.tryGet(3).value_or(QString()), QLatin1String("three"));
+
+        cache.clear();
+        QCOMPARE(cache.getStatistics().Size, std::size_t{0});
+        QVERIFY(!cache.has(4));
+    }
+
+    /// Verifies that concurrent readers and writers keep the cache within its budget
+    void testConcurrentAccess()
+    {
+        const std::size_t maxEntries = 256;
+        ShardedLRUCache<int, int> cache(maxEntries, 8);
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t)
+        {
+            threads.emplace_back([&cache, t]() {
+                for (int i = 0; i < 20000; ++i)
+                {
+                    cache.put((i + t) % 1024, i);
+                    cache.tryGet((i * 7) % 1024);
+                }
+            });
+        }
+        for (std::thread &thread : threads)
+            thread.join();
+
+        const CacheStatistics stats = cache.getStatistics();
+        QVERIFY(stats.Size <= maxEntries);
+        QCOMPARE(stats.Hits + stats.Misses, uint64_t{80000});
+    }
+
+    /// Measures lookups in a cache that is full, with a mix of hits and misses
+    void benchmarkTryGet()
+    {
+        ShardedLRUCache<std::string, int> cache(1024, 8);
+        std::vector<std::string> keys;
+        for (int i = 0; i < 2048; ++i)
+            keys.push_back(QString("https://site%1.example.com/").arg(i).toStdString());
+        for (int i = 0; i < 1024; ++i)
+            cache.put(keys.at(static_cast<std::size_t>(i)), i);
+
+        int numHits = 0;
+        QBENCHMARK {
+            for (const std::string &key : keys)
+            {
+                if (cache.tryGet(key))
+                    ++numHits;
+            }
+        }
+        QVERIFY(numHits > 0);
+    }
+
+    /// Measures insertions into a full cache, each of which evicts an entry
+    void benchmarkPut()
+    {
+        ShardedLRUCache<int, int> cache(1024, 8);
+        int key = 0;
+        QBENCHMARK {
+            for (int i = 0; i < 4096; ++i, ++key)
+                cache.put(key, i);
+        }
+        QVERIFY(cache.getStatistics().Size <= 1024);
+    }
+};
+
+QTEST_APPLESS_MAIN(ShardedLRUCacheTest)
+
+#include "ShardedLRUCacheTest.moc"
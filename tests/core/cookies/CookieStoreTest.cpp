@@ -0,0 +1,176 @@
+#include "CookieStore.h"
+#include "DatabaseFactory.h"
+
+#include <memory>
+#include <vector>
+
+#include <QDateTime>
+#include <QFile>
+#include <QHash>
+#include <QNetworkCookie>
+#include <QObject>
+#include <QString>
+#include <QTest>
+
+/// Tests the persistence and paging of cookies in the cookie database
+class CookieStoreTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    CookieStoreTest() :
+        QObject(nullptr),
+        m_dbFile(QLatin1String("CookieStoreTest.db"))
+    {
+    }
+
+private slots:
+    /// Called before any tests are executed
+    void initTestCase()
+    {
+        if (QFile::exists(m_dbFile))
+            QFile::remove(m_dbFile);
+    }
+
+    /// Removes the database written by each test
+    void cleanup()
+    {
+        if (QFile::exists(m_dbFile))
+            QFile::remove(m_dbFile);
+    }
+
+    /// Verifies that saved cookies are replaced by cookies with the same key, and can be removed
+    void testApplyChanges()
+    {
+        {
+            std::unique_ptr<CookieStore> cookieStore = DatabaseFactory::createWorker<CookieStore>(m_dbFile);
+            cookieStore->applyChanges({ createCookie("example.com", "a", "1"), createCookie("example.com", "b", "2") }, {});
+            cookieStore->applyChanges({ createCookie("example.com", "a", "3") }, { createCookie("example.com", "b", QByteArray()) });
+        }
+
+        std::unique_ptr<CookieStore> cookieStore = DatabaseFactory::createWorker<CookieStore>(m_dbFile);
+        std::vector<QNetworkCookie> cookies = cookieStore->getCookiePage(QString(), QNetworkCookie(), 10);
+        QCOMPARE(cookies.size(), std::size_t(1));
+        QCOMPARE(cookies.at(0).name(), QByteArray("a"));
+        QCOMPARE(cookies.at(0).value(), QByteArray("3"));
+        QVERIFY(!cookies.at(0).isSessionCookie());
+    }
+
+    /// Verifies that pages of cookies follow each other without gaps or repeats, and that the search filter applies
+    void testPaging()
+    {
+        std::unique_ptr<CookieStore> cookieStore = DatabaseFactory::createWorker<CookieStore>(m_dbFile);
+
+        const int numCookies = 1000;
+        std::vector<QNetworkCookie> savedCookies;
+        for (int i = 0; i < numCookies; ++i)
+            savedCookies.push_back(createCookie(QString("site%1.example.com").arg(i % 100), QByteArray::number(i), "value"));
+        cookieStore->applyChanges(savedCookies, {});
+
+        int numLoaded = 0;
+        QNetworkCookie lastCookie;
+        for (;;)
+        {
+            std::vector<QNetworkCookie> page = cookieStore->getCookiePage(QString(), lastCookie, 64);
+            if (page.empty())
+                break;
+
+            for (const QNetworkCookie &cookie : page)
+            {
+                QVERIFY(CookieStore::getCookieKey(lastCookie) < CookieStore::getCookieKey(cookie));
+                lastCookie = cookie;
+            }
+            numLoaded += static_cast<int>(page.size());
+        }
+        QCOMPARE(numLoaded, numCookies);
+
+        std::vector<QNetworkCookie> matches = cookieStore->getCookiePage(QLatin1String("SITE42."), QNetworkCookie(), numCookies);
+        QCOMPARE(matches.size(), std::size_t(10));
+        for (const QNetworkCookie &cookie : matches)
+            QCOMPARE(cookie.domain(), QLatin1String("site42.example.com"));
+
+        // Wildcard characters in the filter are matched literally
+        QVERIFY(cookieStore->getCookiePage(QLatin1String("site_"), QNetworkCookie(), numCookies).empty());
+    }
+
+    /// Verifies that expired cookies are removed, while session cookies are kept
+    void testRemoveExpired()
+    {
+        std::unique_ptr<CookieStore> cookieStore = DatabaseFactory::createWorker<CookieStore>(m_dbFile);
+
+        const QDateTime now = QDateTime::currentDateTime();
+        QNetworkCookie expired = createCookie("example.com", "expired", "1");
+        expired.setExpirationDate(now.addSecs(-60));
+        QNetworkCookie session = createCookie("example.com", "session", "2");
+        session.setExpirationDate(QDateTime());
+
+        cookieStore->applyChanges({ expired, session, createCookie("example.com", "valid", "3") }, {});
+        cookieStore->removeExpiredCookies(now.toMSecsSinceEpoch());
+
+        std::vector<QNetworkCookie> cookies = cookieStore->getCookiePage(QString(), QNetworkCookie(), 10);
+        QCOMPARE(cookies.size(), std::size_t(2));
+        QCOMPARE(cookies.at(0).name(), QByteArray("session"));
+        QVERIFY(cookies.at(0).isSessionCookie());
+        QCOMPARE(cookies.at(1).name(), QByteArray("valid"));
+
+        cookieStore->removeAllCookies();
+        QVERIFY(cookieStore->getCookiePage(QString(), QNetworkCookie(), 10).empty());
+    }
+
+    /// Verifies that the session cookies of a previous session are removed when the store is loaded
+    void testRemoveSessionCookiesOnLoad()
+    {
+        {
+            std::unique_ptr<CookieStore> cookieStore = DatabaseFactory::createWorker<CookieStore>(m_dbFile);
+            QNetworkCookie session = createCookie("example.com", "session", "1");
+            session.setExpirationDate(QDateTime());
+            cookieStore->applyChanges({ session, createCookie("example.com", "valid", "2") }, {});
+        }
+
+        std::unique_ptr<CookieStore> cookieStore = DatabaseFactory::createWorker<CookieStore>(m_dbFile);
+        std::vector<QNetworkCookie> cookies = cookieStore->getCookiePage(QString(), QNetworkCookie(), 10);
+        QCOMPARE(cookies.size(), std::size_t(1));
+        QCOMPARE(cookies.at(0).name(), QByteArray("valid"));
+    }
+
+    /// Verifies that the digests of stored cookies match the cookies they were saved from, and change with them
+    void testCookieDigests()
+    {
+        std::unique_ptr<CookieStore> cookieStore = DatabaseFactory::createWorker<CookieStore>(m_dbFile);
+
+        QNetworkCookie cookie = createCookie("example.com", "a", "1");
+        cookie.setSecure(true);
+        cookieStore->applyChanges({ cookie }, {});
+
+        const QHash<QByteArray, QByteArray> digests = cookieStore->getCookieDigests();
+        QCOMPARE(digests.size(), 1);
+        QCOMPARE(digests.value(CookieStore::getCookieKey(cookie)), CookieStore::getCookieDigest(cookie));
+
+        QNetworkCookie changedCookie = cookie;
+        changedCookie.setValue("2");
+        QVERIFY(CookieStore::getCookieDigest(changedCookie) != CookieStore::getCookieDigest(cookie));
+
+        changedCookie = cookie;
+        changedCookie.setHttpOnly(true);
+        QVERIFY(CookieStore::getCookieDigest(changedCookie) != CookieStore::getCookieDigest(cookie));
+    }
+
+private:
+    /// Returns a cookie that expires in one day, given its domain, name and value
+    QNetworkCookie createCookie(const QString &domain, const QByteArray &name, const QByteArray &value)
+    {
+        QNetworkCookie cookie(name, value);
+        cookie.setDomain(domain);
+        cookie.setPath(QLatin1String("/"));
+        cookie.setExpirationDate(QDateTime::currentDateTime().addDays(1));
+        return cookie;
+    }
+
+private:
+    /// Cookie database file used for testing
+    QString m_dbFile;
+};
+
+QTEST_APPLESS_MAIN(CookieStoreTest)
+
+#include "CookieStoreTest.moc"
@@ -0,0 +1,94 @@
+#include "DomainSuffixIndex.h"
+
+#include <QObject>
+#include <QString>
+#include <QTest>
+
+/// Tests the lookups used for third party cookie exemptions and cookie domains
+class DomainSuffixIndexTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    DomainSuffixIndexTest() : QObject(nullptr) {}
+
+private slots:
+    /// Verifies that a host matches the index only if it is, or belongs to, one of the domains in the index
+    void testContainsParentOf()
+    {
+        DomainSuffixIndex index;
+        index.insert(QLatin1String("example.com"));
+        index.insert(QLatin1String("cdn.example.org"));
+
+        QVERIFY(index.containsParentOf(QLatin1String("example.com")));
+        QVERIFY(index.containsParentOf(QLatin1String("www.example.com")));
+        QVERIFY(index.containsParentOf(QLatin1String("a.b.cdn.example.org")));
+
+        QVERIFY(!index.containsParentOf(QLatin1String("badexample.com")));
+        QVERIFY(!index.containsParentOf(QLatin1String("example.org")));
+        QVERIFY(!index.containsParentOf(QLatin1String("com")));
+        QVERIFY(!index.containsParentOf(QString()));
+    }
+
+    /// Verifies that a domain matches the index if the index has any domain within it
+    void testContainsSubdomainOf()
+    {
+        DomainSuffixIndex index;
+        index.insert(QLatin1String(".www.example.com"));
+
+        QVERIFY(index.containsSubdomainOf(QLatin1String("www.example.com")));
+        QVERIFY(index.containsSubdomainOf(QLatin1String("example.com")));
+        QVERIFY(index.containsSubdomainOf(QLatin1String(".example.com")));
+
+        QVERIFY(!index.containsSubdomainOf(QLatin1String("mail.example.com")));
+        QVERIFY(!index.containsSubdomainOf(QLatin1String("ample.com")));
+        QVERIFY(!index.containsSubdomainOf(QString()));
+    }
+
+    /// Verifies that a domain inserted more than once stays in the index until each copy is removed
+    void testRemove()
+    {
+        DomainSuffixIndex index;
+        index.insert(QLatin1String("example.com"));
+        index.insert(QLatin1String(".example.com"));
+        index.insert(QLatin1String("www.example.com"));
+        QCOMPARE(index.size(), std::size_t(3));
+
+        QVERIFY(!index.remove(QLatin1String("com")));
+        QVERIFY(!index.remove(QLatin1String("mail.example.com")));
+
+        QVERIFY(index.remove(QLatin1String("example.com")));
+        QVERIFY(index.containsParentOf(QLatin1String("mail.example.com")));
+
+        QVERIFY(index.remove(QLatin1String("example.com")));
+        QVERIFY(!index.containsParentOf(QLatin1String("mail.example.com")));
+        QVERIFY(index.containsSubdomainOf(QLatin1String("example.com")));
+
+        QVERIFY(index.remove(QLatin1String("www.example.com")));
+        QVERIFY(!index.containsSubdomainOf(QLatin1String("com")));
+        QVERIFY(index.empty());
+    }
+
+    /// Verifies that lookups stay correct with many domains in the index
+    void testManyDomains()
+    {
+        const int numDomains = 20000;
+
+        DomainSuffixIndex index;
+        for (int i = 0; i < numDomains; ++i)
+            index.insert(QString(".site%1.example.com").arg(i));
+
+        QCOMPARE(index.size(), std::size_t(numDomains));
+        QVERIFY(index.containsSubdomainOf(QLatin1String("site19999.example.com")));
+        QVERIFY(!index.containsSubdomainOf(QLatin1String("site20000.example.com")));
+        QVERIFY(index.containsParentOf(QLatin1String("www.site42.example.com")));
+
+        index.clear();
+        QVERIFY(index.empty());
+        QVERIFY(!index.containsSubdomainOf(QLatin1String("example.com")));
+    }
+};
+
+QTEST_APPLESS_MAIN(DomainSuffixIndexTest)
+
+#include "DomainSuffixIndexTest.moc"
@@ -21,7 +21,15 @@ private slots:
 
     void testSaveAndRetrieveRecordsFromDatabase();
 
+    void testNewDatabaseUsesIncrementalVacuum();
+
+    void testCompactEnablesIncrementalVacuum();
+
 private:
+    /// Returns the auto vacuum mode of the given database, where 2 is incremental
+    int getAutoVacuumMode(sqlite::Database &dbHandle);
+
+
     QString m_dbFile;
 };
 
@@ -76,6 +84,37 @@ void DatabaseWorkerTest::testSaveAndRetrieveRecordsFromDatabase()
     }
 }
 
+void DatabaseWorkerTest::testNewDatabaseUsesIncrementalVacuum()
+{
+    auto testDatabase = DatabaseFactory::createWorker<FakeDatabaseWorker>(m_dbFile);
+    QCOMPARE(getAutoVacuumMode(testDatabase->getHandle()), 2);
+}
+
+void DatabaseWorkerTest::testCompactEnablesIncrementalVacuum()
+{
+    // Create a database in the format of earlier versions, without auto vacuum
+    {
+        sqlite::Database dbHandle(m_dbFile.toStdString());
+        QVERIFY(dbHandle.execute("PRAGMA auto_vacuum=NONE"));
+        QVERIFY(dbHandle.execute("CREATE TABLE Information(id INTEGER PRIMARY KEY, name TEXT NOT NULL)"));
+    }
+
+    auto testDatabase = DatabaseFactory::createWorker<FakeDatabaseWorker>(m_dbFile);
+    QCOMPARE(getAutoVacuumMode(testDatabase->getHandle()), 0);
+
+    QVERIFY(testDatabase->compact());
+    QCOMPARE(getAutoVacuumMode(testDatabase->getHandle()), 2);
+}
+
+int DatabaseWorkerTest::getAutoVacuumMode(sqlite::Database &dbHandle)
+{
+    int mode = -1;
+    auto query = dbHandle.prepare(R"(PRAGMA auto_vacuum)");
+    if (query.next())
+        query >> mode;
+    return mode;
+}
+
 QTEST_APPLESS_MAIN(DatabaseWorkerTest)
 
 #include "DatabaseWorkerTest.moc"
@@ -1,6 +1,9 @@
 #include "DatabaseFactory.h"
 #include "HistoryStore.h"
 
+#include <limits>
+#include <vector>
+
 #include <QFile>
 #include <QObject>
 #include <QString>
@@ -132,6 +135,98 @@ private slots:
         QCOMPARE(records.at(1).getUrl(), secondUrlRequested);
     }
 
+    /// Tests that visits can be paged through from most to least recent
+    void testGetVisitPage()
+    {
+        std::unique_ptr<HistoryStore> historyStore = DatabaseFactory::createWorker<HistoryStore>(m_dbFile);
+
+        const QUrl url { QUrl::fromUserInput("https://viper-browser.com") };
+        const QDateTime startDate = QDateTime::currentDateTime().addDays(-1);
+        const int numVisits = 5;
+        for (int i = 0; i < numVisits; ++i)
+            historyStore->addVisit(url, QLatin1String("Viper Browser"), startDate.addSecs(i * 60), url, false);
+
+        QDateTime cursorDate = QDateTime::currentDateTime().addDays(1);
+        qint64 cursorRowId = std::numeric_limits<qint64>::max();
+        std::vector<HistoryVisit> visits;
+        for (;;)
+        {
+            std::vector<HistoryVisit> page = historyStore->getVisitPage(startDate, cursorDate, cursorRowId, 2);
+            if (page.empty())
+                break;
+
+            QVERIFY(page.size() <= 2);
+            cursorDate = page.back().Date;
+            cursorRowId = page.back().RowID;
+            visits.insert(visits.end(), page.begin(), page.end());
+        }
+
+        QCOMPARE(visits.size(), static_cast<size_t>(numVisits));
+        for (int i = 0; i < numVisits; ++i)
+        {
+            QCOMPARE(visits.at(static_cast<size_t>(i)).URL, url);
+            QCOMPARE(visits.at(static_cast<size_t>(i)).Date, startDate.addSecs((numVisits - 1 - i) * 60));
+        }
+    }
+
+    /// Tests that the visits preceding a loaded visit can be paged through back to the most recent visit
+    void testGetNewerVisitPage()
+    {
+        std::unique_ptr<HistoryStore> historyStore = DatabaseFactory::createWorker<HistoryStore>(m_dbFile);
+
+        const QUrl url { QUrl::fromUserInput("https://viper-browser.com") };
+        const QDateTime startDate = QDateTime::currentDateTime().addDays(-1);
+        const int numVisits = 5;
+        for (int i = 0; i < numVisits; ++i)
+            historyStore->addVisit(url, QLatin1String("Viper Browser"), startDate.addSecs(i * 60), url, false);
+
+        // Start from the least recent visit
+        std::vector<HistoryVisit> oldestPage = historyStore->getVisitPage(startDate, startDate.addSecs(1), std::numeric_limits<qint64>::max(), 1);
+        QCOMPARE(oldestPage.size(), static_cast<size_t>(1));
+        QCOMPARE(oldestPage.at(0).Date, startDate);
+
+        // The closest newer visits are returned first, in order of most to least recent
+        std::vector<HistoryVisit> page = historyStore->getNewerVisitPage(oldestPage.at(0).Date, oldestPage.at(0).RowID, 2);
+        QCOMPARE(page.size(), static_cast<size_t>(2));
+        QCOMPARE(page.at(0).Date, startDate.addSecs(2 * 60));
+        QCOMPARE(page.at(1).Date, startDate.addSecs(60));
+
+        page = historyStore->getNewerVisitPage(page.at(0).Date, page.at(0).RowID, 10);
+        QCOMPARE(page.size(), static_cast<size_t>(2));
+        QCOMPARE(page.at(0).Date, startDate.addSecs(4 * 60));
+        QCOMPARE(page.at(1).Date, startDate.addSecs(3 * 60));
+
+        QVERIFY(historyStore->getNewerVisitPage(page.at(0).Date, page.at(0).RowID, 10).empty());
+    }
+
+    /// Tests that clearing the last hour of history only removes entries without any older visits
+    void testClearLastHour()
+    {
+        std::unique_ptr<HistoryStore> historyStore = DatabaseFactory::createWorker<HistoryStore>(m_dbFile);
+
+        const QDateTime now = QDateTime::currentDateTime();
+        const int numEntries = 2000;
+        for (int i = 0; i < numEntries; ++i)
+        {
+            const QUrl url { QString("https://site%1.example.com").arg(i) };
+            historyStore->addVisit(url, QLatin1String("Example"), now.addDays(-1).addSecs(i), url, false);
+        }
+
+        const QUrl recentUrl { QUrl::fromUserInput("https://viper-browser.com") };
+        const QUrl revisitedUrl { QUrl::fromUserInput("https://site0.example.com") };
+        historyStore->addVisit(recentUrl, QLatin1String("Viper Browser"), now.addSecs(-60), recentUrl, false);
+        historyStore->addVisit(revisitedUrl, QLatin1String("Example"), now.addSecs(-60), revisitedUrl, false);
+
+        historyStore->clearHistoryFrom(now.addSecs(-3600));
+
+        QVERIFY2(!historyStore->contains(recentUrl), "HistoryStore::clearHistoryFrom did not remove the entry");
+        QVERIFY2(historyStore->contains(revisitedUrl), "HistoryStore::clearHistoryFrom removed an entry with older visits");
+        QCOMPARE(historyStore->getTimesVisited(revisitedUrl), 1);
+
+        historyStore->performMaintenance();
+        QVERIFY(historyStore->contains(revisitedUrl));
+    }
+
     /*
      * todo: test cases for:
 
@@ -0,0 +1,122 @@
+#include "DatabaseFactory.h"
+#include "ServiceLocator.h"
+#include "WebPageThumbnailStore.h"
+
+#include <memory>
+#include <vector>
+
+#include <QByteArray>
+#include <QColor>
+#include <QFile>
+#include <QImage>
+#include <QObject>
+#include <QString>
+#include <QTest>
+#include <QUrl>
+
+/// Tests the processing, caching and storage of web page thumbnails
+class WebPageThumbnailStoreTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    WebPageThumbnailStoreTest() :
+        QObject(nullptr),
+        m_dbFile(QLatin1String("WebPageThumbnailStoreTest.db"))
+    {
+    }
+
+private slots:
+    /// Removes the database file before any tests are executed
+    void initTestCase()
+    {
+        if (QFile::exists(m_dbFile))
+            QFile::remove(m_dbFile);
+    }
+
+    /// Removes the database file after each test
+    void cleanup()
+    {
+        if (QFile::exists(m_dbFile))
+            QFile::remove(m_dbFile);
+    }
+
+    /// Tests that captured frames are scaled to the thumbnail size, and that gray frames are rejected
+    void testProcessThumbnail()
+    {
+        QVERIFY(WebPageThumbnailStore::processThumbnail(QImage()).isEmpty());
+
+        QImage grayFrame(1280, 720, QImage::Format_ARGB32_Premultiplied);
+        grayFrame.fill(Qt::white);
+        QVERIFY(WebPageThumbnailStore::processThumbnail(grayFrame).isEmpty());
+
+        const QByteArray data = WebPageThumbnailStore::processThumbnail(makeFrame(1280, 2000));
+        QVERIFY(!data.isEmpty());
+
+        const QImage thumbnail = QImage::fromData(data, "PNG");
+        QCOMPARE(thumbnail.size(), WebPageThumbnailStore::ThumbnailSize);
+    }
+
+    /// Tests that a thumbnail URL refers back to the host of the page
+    void testThumbnailUrl()
+    {
+        const QUrl thumbnailUrl = WebPageThumbnailStore::getThumbnailUrl(QUrl(QLatin1String("https://Viper-Browser.com/about")));
+        QCOMPARE(thumbnailUrl.scheme(), QLatin1String("viper"));
+        QCOMPARE(WebPageThumbnailStore::getHostFromThumbnailUrl(thumbnailUrl), QLatin1String("viper-browser.com"));
+
+        QVERIFY(WebPageThumbnailStore::getThumbnailUrl(QUrl(QLatin1String("about:blank"))).isEmpty());
+        QVERIFY(WebPageThumbnailStore::getHostFromThumbnailUrl(QUrl(QLatin1String("viper://newtab"))).isEmpty());
+        QVERIFY(WebPageThumbnailStore::getHostFromThumbnailUrl(QUrl(QLatin1String("https://thumbnails/example.com"))).isEmpty());
+    }
+
+    /// Tests that a thumbnail is shared by the hosts of a redirect, and can be read back from the
+    /// database once it is no longer held in memory
+    void testThumbnailStorage()
+    {
+        ViperServiceLocator serviceLocator;
+        std::unique_ptr<WebPageThumbnailStore> store = DatabaseFactory::createWorker<WebPageThumbnailStore>(serviceLocator, m_dbFile);
+
+        const QByteArray data = WebPageThumbnailStore::processThumbnail(makeFrame(800, 600));
+        QVERIFY(!data.isEmpty());
+
+        const std::vector<QString> hosts { QLatin1String("example.com"), QLatin1String("www.example.com") };
+        store->onThumbnailProcessed(hosts, data);
+
+        QCOMPARE(store->getThumbnailData(QLatin1String("www.example.com")), data);
+        QVERIFY(store->hasThumbnail(QUrl(QLatin1String("https://example.com/page"))));
+        QVERIFY(!store->hasThumbnail(QUrl(QLatin1String("https://other.example.com/"))));
+
+        // Only one copy of the thumbnail is held in memory
+        QCOMPARE(store->m_thumbnails.getStatistics().Size, std::size_t(1));
+
+        store->writePendingThumbnails();
+        store->m_thumbnails.clear();
+        store->m_hostAliases.clear();
+
+        QCOMPARE(store->getThumbnailData(QLatin1String("example.com")), data);
+        QCOMPARE(store->getThumbnailData(QLatin1String("www.example.com")), data);
+        QVERIFY(store->getThumbnailData(QLatin1String("other.example.com")).isEmpty());
+    }
+
+private:
+    /// Returns a frame of the given size with a colored header, as found on a typical web page
+    QImage makeFrame(int width, int height)
+    {
+        QImage frame(width, height, QImage::Format_ARGB32_Premultiplied);
+        frame.fill(Qt::white);
+        for (int y = 0; y < height / 8; ++y)
+        {
+            for (int x = 0; x < width; ++x)
+                frame.setPixelColor(x, y, QColor(30, 90, 200));
+        }
+        return frame;
+    }
+
+private:
+    /// Path to the thumbnail database used for testing
+    QString m_dbFile;
+};
+
+QTEST_GUILESS_MAIN(WebPageThumbnailStoreTest)
+
+#include "WebPageThumbnailStoreTest.moc"
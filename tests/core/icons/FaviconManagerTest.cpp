@@ -1,11 +1,20 @@
 #include "CommonUtil.h"
 #include "DatabaseFactory.h"
+#include "DatabaseTaskScheduler.h"
 #include "FaviconManager.h"
+#include "FaviconStore.h"
 #include "NetworkAccessManager.h"
 
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
 #include <QCryptographicHash>
 #include <QDateTime>
 #include <QFile>
+#include <QIcon>
+#include <QImage>
 #include <QObject>
 #include <QSignalSpy>
 #include <QString>
@@ -49,7 +58,11 @@ private slots:
     {
         NetworkAccessManager accessManager;
 
-        m_faviconManager = new FaviconManager(QLatin1String("FaviconManagerTest.db"));
+        DatabaseTaskScheduler taskScheduler;
+        taskScheduler.addWorker("FaviconStore", std::bind(DatabaseFactory::createDBWorker<FaviconStore>, m_dbFile));
+        taskScheduler.run();
+
+        m_faviconManager = new FaviconManager(taskScheduler);
         m_faviconManager->setNetworkAccessManager(&accessManager);
 
         QString iconEncoded = QStringLiteral("iVBORw0KGgoAAAANSUhEUgAAACAAAAAgCAYAAABzenr0AAAACXBIWXMAAA1hAAAMxAHulkC1AAAEmklEQVRYha1XX2hbVRz+vnNv02xrIxu9N1mSlTiuIL26PdStiMjciyjq9ElkTwMfrMhEdOjDYEunU/BBJw71QXwUpA+WoQznZGygOOdEO6aCQWKbP7e5rptpM9qkyc+HJttdctNma76nnN/vnO/7zrknv3MO0SFs2w7Muu5uAfZAZAhAVMgoAFAkByAH8ncCJzYZxpnLly+XO+Hlah0ShhFZIA+LyF4AoQ79Fkl+HhQZS7uuc0cGLMvqnS8WDwJ4VUQ2dCh8KzlZAvBeXyh0NJVKLXZsoD7rCREZuRNhHyPngyLP+K1Gi4G4aW5bEvlagHg3xD1CGZ18IlMoTLY1kDCMyAJwodviXhNBYId3JVTjh2VZvQvkhFecwB8EviB55Q70rhEYJ/BLIyBAfIGcsCyrt8XAfLF4sPmbU6ljjus+d+/QUARKPQ9y2Tk5D/ISgXMEzoKcBPDfcoqzBPYPmGbYcd1nSR71corISH1zNyZ5Y9Olmnc7NW2n4zgXGm3bMPquaNrg6Ojon8lkstZEzHg8fo+mae7U1NTVRjwcDt+NWu3vW3jJUlDESruuQwCImObHIjLavIZK1x/I5/MX/da3U0Sj0cFqpfJPc5zkJ06h8KKybTtQLzKtqFaH1iIOALVazfaLi8he27YDatZ1d8OnwpEsQdPOrdWApmk/kfzXJxWadd3dSoA9bcYeyefzLUt3u8hms1cg8rpfToA9qn6wtEAPBL5cq3gDwQ0b/LlEhhSAaHOcZGl6ejrVLQPpdPoaySmfVFQ1jtQmFEhKtwwAAERmWkJkVNFTjG72lYGuigMA2cJJQCkAfju0PxwOm93STiQSQfh8agCuAuB7YVAij3bLwOL167tEpNcn5SiK/Og3SEReFpFVb0ydQIBX/OIUOa9Anm0zaMfmcPi1tYpHDGOfiDzmmyTPqtDGjd8CmPM1IfJuxDSPDA8P99yucDKZVBHTPCDAp226zG0SOdU4jI6LyEt1V+9r5M9VkTcgsg0ACEyD/EwB36tA4GImk5n1Y9y6detdpVJpWAEP1kT2QcRqZ5BKHXdmZvYrANBFjpEsAwCXB7oDIg+B/BUABNgiIoerIqcq5fKJZDLZ8tcFgOtzcxOo1b6r1WpvrShOLvaIHKtPbhkR0xwTkUP1ZlEPBGyS65bK5R+8dUFT6unczMwJP+JIJPKIVKtn2gl7DIw5hUIS8BShvlDo7frNBgBC1XJ5LJPJ/BUUuZ/kAQAfKKVeWN/f/007Yl3XJ9vlPOqTfaHQOzea3lw0Gt1SrVTOA9gMoEpNe8pxnJOrknoQNowKAL1NOq/19IzkcrlpXwMAEDPN7UsiJ2+YIE8DOE1gToDww7t2HR0fH6+uYGAJgOYnrpOPZwuF37xB30ITi8XiS5XKVxDZ3pwbMM3eld59YcOoovl8IS9puv5kLpdrORF9d3M2m830h0IjJMdI3vKkKpVKvmO8cjd1WSb55rr163f6ibc1AACpVGrRKRSSPYBNpT4EUAQ5n0gkllZUJ6+CnCf5kR4I3OcUCofS6fTCKqZXh20YfYODgxtX6xeLxeKWZXX6isb/mQzVddO1ixsAAAAASUVORK5CYII=");
@@ -71,21 +84,108 @@ private slots:
         QTest::qWait(500);
 
         m_faviconManager->setNetworkAccessManager(nullptr);
+
+        delete m_faviconManager;
+        m_faviconManager = nullptr;
     }
 
-    void testCanDownloadIconFromUrl()
+    /// Verifies that an icon which is not cached is announced once it has been loaded on the database thread
+    void testLoadsStoredIconAsynchronously()
     {
-        //todo: this
+        const QUrl pageUrl(QLatin1String("https://example.com/page"));
+        {
+            std::unique_ptr<FaviconStore> faviconStore = DatabaseFactory::createWorker<FaviconStore>(m_dbFile);
+            QImage image(16, 16, QImage::Format_ARGB32);
+            image.fill(Qt::red);
+            const std::vector<int> iconIds = faviconStore->saveIcons({
+                std::make_pair(QUrl(QLatin1String("https://example.com/favicon.ico")), CommonUtil::imagesToBytes({ image }))
+            });
+            QCOMPARE(iconIds.size(), std::size_t(1));
+            faviconStore->addPageMapping(pageUrl, iconIds.at(0));
+        }
+
+        DatabaseTaskScheduler taskScheduler;
+        taskScheduler.addWorker("FaviconStore", std::bind(DatabaseFactory::createDBWorker<FaviconStore>, m_dbFile));
+        m_faviconManager = new FaviconManager(taskScheduler);
+        taskScheduler.run();
+
+        QSignalSpy spy(m_faviconManager, &FaviconManager::faviconLoaded);
+        m_faviconManager->getFavicon(pageUrl);
+        QVERIFY(spy.wait(2000));
+        QCOMPARE(spy.at(0).at(0).toUrl(), pageUrl);
+        QVERIFY(!spy.at(0).at(1).value<QIcon>().isNull());
+
+        // The icon is now served from the cache, without another lookup
+        QVERIFY(!m_faviconManager->getFavicon(pageUrl).isNull());
+        QTest::qWait(100);
+        QCOMPARE(spy.count(), 1);
+
+        taskScheduler.stop();
+        delete m_faviconManager;
+        m_faviconManager = nullptr;
     }
 
-    /* favicon mgr definition
-    explicit FaviconManager(DatabaseTaskScheduler &taskScheduler);
+    /// Verifies that the icons of several pages are looked up together, and that pages without an icon are skipped
+    void testLoadsIconsInBatch()
+    {
+        const QUrl firstUrl(QLatin1String("https://example.com/first")), secondUrl(QLatin1String("https://example.org/second"));
+        {
+            std::unique_ptr<FaviconStore> faviconStore = DatabaseFactory::createWorker<FaviconStore>(m_dbFile);
+            QImage image(16, 16, QImage::Format_ARGB32);
+            image.fill(Qt::blue);
+            const std::vector<int> iconIds = faviconStore->saveIcons({
+                std::make_pair(QUrl(QLatin1String("https://example.com/favicon.ico")), CommonUtil::imagesToBytes({ image }))
+            });
+            QCOMPARE(iconIds.size(), std::size_t(1));
+            faviconStore->addPageMapping(firstUrl, iconIds.at(0));
+            faviconStore->addPageMapping(secondUrl, iconIds.at(0));
+        }
 
-    void setNetworkAccessManager(NetworkAccessManager *networkAccessManager);
+        DatabaseTaskScheduler taskScheduler;
+        taskScheduler.addWorker("FaviconStore", std::bind(DatabaseFactory::createDBWorker<FaviconStore>, m_dbFile));
+        m_faviconManager = new FaviconManager(taskScheduler);
+        taskScheduler.run();
+
+        QSignalSpy spy(m_faviconManager, &FaviconManager::faviconLoaded);
+        m_faviconManager->loadFavicons({ firstUrl, secondUrl, QUrl(QLatin1String("https://example.net/no-icon")) });
+        QTRY_COMPARE_WITH_TIMEOUT(spy.count(), 2, 2000);
+        QCOMPARE(spy.at(0).at(0).toUrl(), firstUrl);
+        QCOMPARE(spy.at(1).at(0).toUrl(), secondUrl);
+
+        // Cached pages are not looked up again
+        m_faviconManager->loadFavicons({ firstUrl, secondUrl });
+        QTest::qWait(100);
+        QCOMPARE(spy.count(), 2);
+
+        taskScheduler.stop();
+        delete m_faviconManager;
+        m_faviconManager = nullptr;
+    }
+
+    /// Verifies that the manager can be destroyed while its lookups are still queued on the database thread
+    void testCanDestroyManagerWithPendingLookups()
+    {
+        DatabaseTaskScheduler taskScheduler;
+        taskScheduler.addWorker("FaviconStore", std::bind(DatabaseFactory::createDBWorker<FaviconStore>, m_dbFile));
+        m_faviconManager = new FaviconManager(taskScheduler);
+        taskScheduler.run();
+
+        std::vector<QUrl> urls;
+        for (int i = 0; i < 100; ++i)
+            urls.push_back(QUrl(QString("https://example.com/%1").arg(i)));
+        m_faviconManager->loadFavicons(urls);
+
+        delete m_faviconManager;
+        m_faviconManager = nullptr;
 
-    void getFavicon(const QUrl &url, std::function<void(QIcon)> callback);
+        QTest::qWait(100);
+        taskScheduler.stop();
+    }
 
-    void updateIcon(const QString &iconHRef, const QUrl &pageUrl, const QIcon &pageIcon);*/
+    void testCanDownloadIconFromUrl()
+    {
+        //todo: this
+    }
 
 private:
     /// Database file name used for tests
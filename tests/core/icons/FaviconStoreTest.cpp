@@ -0,0 +1,85 @@
+#include "DatabaseFactory.h"
+#include "FaviconStore.h"
+
+#include <memory>
+
+#include <QFile>
+#include <QObject>
+#include <QString>
+#include <QTest>
+#include <QUrl>
+
+class FaviconStoreTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    FaviconStoreTest() :
+        QObject(nullptr),
+        m_dbFile(QLatin1String("FaviconStoreTest.db"))
+    {
+    }
+
+private slots:
+    /// Called before any tests are executed
+    void initTestCase()
+    {
+        if (QFile::exists(m_dbFile))
+            QFile::remove(m_dbFile);
+    }
+
+    /// Called after every test function, removing the database file
+    void cleanup()
+    {
+        if (QFile::exists(m_dbFile))
+            QFile::remove(m_dbFile);
+    }
+
+    /// Tests that icon URLs which only differ by scheme or "www." prefix resolve to the same favicon
+    void testIconUrlIndex()
+    {
+        std::unique_ptr<FaviconStore> faviconStore = DatabaseFactory::createWorker<FaviconStore>(m_dbFile);
+
+        const int iconId = faviconStore->getFaviconIdForIconUrl(QUrl(QLatin1String("https://www.github.com/favicon.ico")));
+        QVERIFY(iconId > 0);
+        QCOMPARE(faviconStore->getFaviconIdForIconUrl(QUrl(QLatin1String("http://github.com/favicon.ico"))), iconId);
+        QVERIFY(faviconStore->getFaviconIdForIconUrl(QUrl(QLatin1String("https://gitlab.com/favicon.ico"))) != iconId);
+    }
+
+    /// Tests that pages without their own mapping use the icon of a page on the same host or registrable domain
+    void testHostAndDomainFallback()
+    {
+        std::unique_ptr<FaviconStore> faviconStore = DatabaseFactory::createWorker<FaviconStore>(m_dbFile);
+
+        const int iconId = faviconStore->getFaviconIdForIconUrl(QUrl(QLatin1String("https://github.com/favicon.ico")));
+        faviconStore->addPageMapping(QUrl(QLatin1String("https://www.github.com/LeFroid/Viper-Browser")), iconId);
+
+        QCOMPARE(faviconStore->getFaviconId(QUrl(QLatin1String("https://www.github.com/LeFroid/Viper-Browser"))), iconId);
+        QCOMPARE(faviconStore->getFaviconId(QUrl(QLatin1String("https://github.com/trending"))), iconId);
+        QCOMPARE(faviconStore->getFaviconId(QUrl(QLatin1String("https://gist.github.com/LeFroid"))), iconId);
+        QCOMPARE(faviconStore->getFaviconId(QUrl(QLatin1String("https://example.com/github.com"))), -1);
+    }
+
+    /// Tests that icon data can be saved and replaced
+    void testSaveIconData()
+    {
+        std::unique_ptr<FaviconStore> faviconStore = DatabaseFactory::createWorker<FaviconStore>(m_dbFile);
+
+        const int iconId = faviconStore->getFaviconIdForIconUrl(QUrl(QLatin1String("https://github.com/favicon.ico")));
+        QVERIFY(faviconStore->getIconData(iconId).isEmpty());
+
+        faviconStore->saveIconData(iconId, QByteArray("first"));
+        QCOMPARE(faviconStore->getIconData(iconId), QByteArray("first"));
+
+        faviconStore->saveIconData(iconId, QByteArray("second"));
+        QCOMPARE(faviconStore->getIconData(iconId), QByteArray("second"));
+    }
+
+private:
+    /// Database file used for testing
+    QString m_dbFile;
+};
+
+QTEST_APPLESS_MAIN(FaviconStoreTest)
+
+#include "FaviconStoreTest.moc"
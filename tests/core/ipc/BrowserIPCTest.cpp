@@ -0,0 +1,84 @@
+#include "BrowserIPC.h"
+
+#include <QByteArray>
+#include <QObject>
+#include <QSignalSpy>
+#include <QString>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QTest>
+
+/// Tests the messages sent between instances of the browser
+class BrowserIPCTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    BrowserIPCTest() : QObject(nullptr) {}
+
+private slots:
+    /// Verifies that messages are decoded from a stream of frames, including frames that arrive in pieces
+    void testFraming()
+    {
+        QStringList urls;
+        for (int i = 0; i < 500; ++i)
+            urls.append(QString("https://example.com/page/%1").arg(i));
+
+        const QByteArray stream = BrowserIPC::encodeMessage(urls) + BrowserIPC::encodeMessage(QStringList());
+
+        QByteArray buffer;
+        QStringList message;
+        QList<QStringList> messages;
+        for (int i = 0; i < stream.size(); i += 100)
+        {
+            buffer.append(stream.mid(i, 100));
+
+            int result = 0;
+            while ((result = BrowserIPC::decodeMessage(buffer, message)) > 0)
+                messages.append(message);
+            QCOMPARE(result, 0);
+        }
+
+        QVERIFY(buffer.isEmpty());
+        QCOMPARE(messages.size(), 2);
+        QCOMPARE(messages.at(0), urls);
+        QVERIFY(messages.at(1).isEmpty());
+    }
+
+    /// Verifies that frames which claim to be longer than the maximum message length are rejected
+    void testInvalidFrame()
+    {
+        QByteArray buffer(4, '\xff');
+        QStringList message;
+        QCOMPARE(BrowserIPC::decodeMessage(buffer, message), -1);
+    }
+
+    /// Verifies that messages sent by another instance are received through the local socket
+    void testSocketRoundTrip()
+    {
+        // Keep the socket out of the runtime directory of a browser that may be running
+        QTemporaryDir runtimeDir;
+        QVERIFY(runtimeDir.isValid());
+        qputenv("XDG_RUNTIME_DIR", runtimeDir.path().toLocal8Bit());
+
+        BrowserIPC receiver;
+        receiver.listen();
+        QSignalSpy spy(&receiver, &BrowserIPC::messageReceived);
+
+        const QStringList urls { QLatin1String("https://example.com"), QLatin1String("https://example.org/a b") };
+
+        BrowserIPC sender;
+        sender.sendMessage(urls);
+        sender.sendMessage(QStringList());
+
+        QTRY_COMPARE(spy.count(), 2);
+        QCOMPARE(spy.at(0).at(0).toStringList(), urls);
+        QVERIFY(spy.at(1).at(0).toStringList().isEmpty());
+
+        receiver.close();
+    }
+};
+
+QTEST_GUILESS_MAIN(BrowserIPCTest)
+
+#include "BrowserIPCTest.moc"
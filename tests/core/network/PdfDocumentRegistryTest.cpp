@@ -0,0 +1,118 @@
+#include "PdfDocumentRegistry.h"
+
+#include <cstddef>
+#include <vector>
+
+#include <QObject>
+#include <QString>
+#include <QTest>
+#include <QUrl>
+
+/// Tests the registration of the PDF documents that the viewer may load
+class PdfDocumentRegistryTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    PdfDocumentRegistryTest() : QObject(nullptr) {}
+
+private slots:
+    /// Verifies that a registered document can be loaded once through the token of its viewer URL
+    void testDocumentIsLoadedOnce()
+    {
+        PdfDocumentRegistry registry;
+        const QUrl documentUrl(QLatin1String("https://example.com/files/a%20b.pdf?version=2&page=%2F1"));
+
+        const QUrl viewerUrl = registry.registerDocument(documentUrl, false);
+        QVERIFY(PdfDocumentRegistry::isViewerUrl(viewerUrl));
+        QCOMPARE(PdfDocumentRegistry::getDocumentUrl(viewerUrl), documentUrl);
+        QCOMPARE(PdfDocumentRegistry::getDisplayUrl(viewerUrl), documentUrl);
+
+        const QString token = PdfDocumentRegistry::getToken(viewerUrl);
+        QVERIFY(!token.isEmpty());
+        QCOMPARE(registry.takeDocument(token), documentUrl);
+
+        // The token cannot be used again
+        QVERIFY(registry.takeDocument(token).isEmpty());
+    }
+
+    /// Verifies that documents are not served for tokens that were never registered
+    void testUnknownTokenIsRefused()
+    {
+        PdfDocumentRegistry registry;
+        const QUrl viewerUrl = registry.registerDocument(QUrl(QLatin1String("https://example.com/a.pdf")), false);
+
+        QVERIFY(registry.takeDocument(QString()).isEmpty());
+        QVERIFY(registry.takeDocument(QLatin1String("0123456789abcdef0123456789abcdef")).isEmpty());
+
+        // A viewer URL made up by a page has no token of its own
+        const QUrl madeUpUrl(QLatin1String("viper://pdfviewer/?file=document%3Furl%3Dfile%253A%252F%252F%252Fetc%252Fpasswd"));
+        QVERIFY(PdfDocumentRegistry::getToken(madeUpUrl).isEmpty());
+        QVERIFY(!registry.renewDocument(madeUpUrl, true));
+
+        // The registered document is still available
+        QVERIFY(!registry.takeDocument(PdfDocumentRegistry::getToken(viewerUrl)).isEmpty());
+    }
+
+    /// Verifies that local files are only registered for navigations that may load them
+    void testLocalFileRequiresLocalNavigation()
+    {
+        PdfDocumentRegistry registry;
+        const QUrl documentUrl = QUrl::fromLocalFile(QLatin1String("/tmp/document.pdf"));
+
+        QVERIFY(registry.registerDocument(documentUrl, false).isEmpty());
+
+        const QUrl viewerUrl = registry.registerDocument(documentUrl, true);
+        QVERIFY(!viewerUrl.isEmpty());
+        QCOMPARE(registry.takeDocument(PdfDocumentRegistry::getToken(viewerUrl)), documentUrl);
+
+        // Reloading the viewer is subject to the same rule
+        QVERIFY(!registry.renewDocument(viewerUrl, false));
+        QVERIFY(registry.takeDocument(PdfDocumentRegistry::getToken(viewerUrl)).isEmpty());
+    }
+
+    /// Verifies that documents are only loaded over the network or from local files
+    void testUnsupportedSchemesAreRefused()
+    {
+        PdfDocumentRegistry registry;
+        QVERIFY(registry.registerDocument(QUrl(QLatin1String("viper://pdfviewer/document.pdf")), true).isEmpty());
+        QVERIFY(registry.registerDocument(QUrl(QLatin1String("qrc:/document.pdf")), true).isEmpty());
+        QVERIFY(registry.registerDocument(QUrl(QLatin1String("ftp://example.com/document.pdf")), true).isEmpty());
+        QVERIFY(registry.registerDocument(QUrl(), true).isEmpty());
+    }
+
+    /// Verifies that a viewer which is loaded again registers its document under the same token
+    void testRenewDocument()
+    {
+        PdfDocumentRegistry registry;
+        const QUrl documentUrl(QLatin1String("https://example.com/a.pdf"));
+        const QUrl viewerUrl = registry.registerDocument(documentUrl, false);
+        const QString token = PdfDocumentRegistry::getToken(viewerUrl);
+        QCOMPARE(registry.takeDocument(token), documentUrl);
+
+        QVERIFY(registry.renewDocument(viewerUrl, false));
+        QCOMPARE(registry.takeDocument(token), documentUrl);
+        QVERIFY(registry.takeDocument(token).isEmpty());
+
+        QVERIFY(!registry.renewDocument(documentUrl, false));
+    }
+
+    /// Verifies that the oldest documents are dropped when too many are waiting to be loaded
+    void testOldestDocumentIsDropped()
+    {
+        PdfDocumentRegistry registry;
+        std::vector<QString> tokens;
+        for (std::size_t i = 0; i <= PdfDocumentRegistry::MaxPendingDocuments; ++i)
+        {
+            const QUrl viewerUrl = registry.registerDocument(QUrl(QString("https://example.com/%1.pdf").arg(i)), false);
+            tokens.push_back(PdfDocumentRegistry::getToken(viewerUrl));
+        }
+
+        QVERIFY(registry.takeDocument(tokens.front()).isEmpty());
+        QCOMPARE(registry.takeDocument(tokens.back()), QUrl(QString("https://example.com/%1.pdf").arg(PdfDocumentRegistry::MaxPendingDocuments)));
+    }
+};
+
+QTEST_APPLESS_MAIN(PdfDocumentRegistryTest)
+
+#include "PdfDocumentRegistryTest.moc"
@@ -0,0 +1,194 @@
+#include "SessionJournal.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QObject>
+#include <QString>
+#include <QTest>
+
+/// Tests the recording, replay and compaction of the session journal
+class SessionJournalTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    SessionJournalTest() :
+        QObject(nullptr),
+        m_journalFile(QLatin1String("SessionJournalTest.journal"))
+    {
+    }
+
+private slots:
+    /// Removes the journal file written by each test
+    void cleanup()
+    {
+        if (QFile::exists(m_journalFile))
+            QFile::remove(m_journalFile);
+    }
+
+    /// Verifies that changes written to the journal are replayed into the same session state
+    void testReplay()
+    {
+        {
+            SessionJournal journal(m_journalFile);
+            QVERIFY(!journal.load());
+
+            journal.openWindow(1);
+            journal.setWindowGeometry(1, QRect(10, 20, 800, 600), false);
+            journal.openTab(1, 1, 0);
+            journal.openTab(1, 2, 1);
+            journal.openTab(1, 3, 1);
+            journal.updateTab(createTab(1, QLatin1String("https://viper-browser.com/")));
+            journal.updateTab(createTab(2, QLatin1String("https://example.com/")));
+            journal.updateTab(createTab(3, QLatin1String("https://example.org/")));
+            journal.setCurrentTab(1, 2);
+            QVERIFY(journal.flush());
+
+            journal.openWindow(2);
+            journal.openTab(2, 4, 0);
+            journal.moveTab(1, 2);
+            journal.closeTab(3);
+            QVERIFY(journal.flush());
+        }
+
+        SessionJournal journal(m_journalFile);
+        QVERIFY(journal.load());
+
+        const SessionState &state = journal.getState();
+        QCOMPARE(state.Windows.size(), std::size_t(2));
+
+        const SessionWindow &window = state.Windows.at(0);
+        QCOMPARE(window.Geometry, QRect(10, 20, 800, 600));
+        QCOMPARE(window.CurrentTabId, quint32(2));
+        QCOMPARE(window.Tabs.size(), std::size_t(2));
+        QVERIFY(window.Tabs.at(0) == createTab(2, QLatin1String("https://example.com/")));
+        QVERIFY(window.Tabs.at(1) == createTab(1, QLatin1String("https://viper-browser.com/")));
+
+        QCOMPARE(state.Windows.at(1).Tabs.size(), std::size_t(1));
+    }
+
+    /// Verifies that a record which was only partially written is ignored, along with anything after it
+    void testDamagedRecord()
+    {
+        qint64 validSize = 0;
+        {
+            SessionJournal journal(m_journalFile);
+            journal.load();
+            journal.openWindow(1);
+            journal.openTab(1, 1, 0);
+            journal.updateTab(createTab(1, QLatin1String("https://viper-browser.com/")));
+            QVERIFY(journal.flush());
+            validSize = QFileInfo(m_journalFile).size();
+
+            journal.updateTab(createTab(1, QLatin1String("https://example.com/")));
+            QVERIFY(journal.flush());
+        }
+
+        // Cut the last record short, as if the browser stopped while writing it
+        QFile file(m_journalFile);
+        QVERIFY(file.resize(QFileInfo(m_journalFile).size() - 3));
+
+        SessionJournal journal(m_journalFile);
+        QVERIFY(journal.load());
+        QCOMPARE(journal.getState().Windows.size(), std::size_t(1));
+        QCOMPARE(journal.getState().Windows.at(0).Tabs.at(0).Url, QUrl(QLatin1String("https://viper-browser.com/")));
+
+        // The next change rewrites the journal without the damaged record
+        journal.openTab(1, 2, 1);
+        QVERIFY(journal.flush());
+
+        SessionJournal reloaded(m_journalFile);
+        QVERIFY(reloaded.load());
+        QCOMPARE(reloaded.getState().Windows.at(0).Tabs.size(), std::size_t(2));
+        QVERIFY(QFileInfo(m_journalFile).size() > validSize);
+    }
+
+    /// Verifies that changes which do not affect the session state are not written
+    void testUnchangedState()
+    {
+        SessionJournal journal(m_journalFile);
+        journal.load();
+        journal.openWindow(1);
+        journal.openTab(1, 1, 0);
+        journal.updateTab(createTab(1, QLatin1String("https://viper-browser.com/")));
+        QVERIFY(journal.flush());
+
+        journal.updateTab(createTab(1, QLatin1String("https://viper-browser.com/")));
+        journal.setCurrentTab(2, 1);
+        journal.moveTab(1, 5);
+        QVERIFY(!journal.hasPendingChanges());
+    }
+
+    /// Verifies that the journal is compacted once it has grown past the size of the state it describes
+    void testCompaction()
+    {
+        const int numNavigations = 2000;
+        SessionTab tab = createTab(1, QString());
+        {
+            SessionJournal journal(m_journalFile);
+            journal.load();
+            journal.openWindow(1);
+            journal.openTab(1, 1, 0);
+
+            for (int i = 0; i < numNavigations; ++i)
+            {
+                tab.Url = QUrl(QString("https://site%1.example.com/").arg(i));
+                tab.History.append(QByteArray(16, 'h'));
+                journal.updateTab(tab);
+                QVERIFY(journal.flush());
+            }
+        }
+
+        // Without compaction, the journal would hold every version of the tab's history
+        QVERIFY(QFileInfo(m_journalFile).size() < 4 * tab.History.size() + 512 * 1024);
+
+        SessionJournal journal(m_journalFile);
+        QVERIFY(journal.load());
+        QVERIFY(journal.getState().Windows.at(0).Tabs.at(0) == tab);
+    }
+
+    /// Verifies that clearing the session replaces its windows with the ones recorded afterwards
+    void testClear()
+    {
+        {
+            SessionJournal journal(m_journalFile);
+            journal.load();
+            journal.openWindow(1);
+            journal.openTab(1, 1, 0);
+            QVERIFY(journal.flush());
+        }
+
+        {
+            SessionJournal journal(m_journalFile);
+            QVERIFY(journal.load());
+            journal.clear();
+            journal.openWindow(1);
+            journal.openTab(1, 7, 0);
+        }
+
+        SessionJournal journal(m_journalFile);
+        QVERIFY(journal.load());
+        QCOMPARE(journal.getState().Windows.size(), std::size_t(1));
+        QCOMPARE(journal.getState().Windows.at(0).Tabs.at(0).Id, quint32(7));
+    }
+
+private:
+    /// Returns a tab with the given identifier and URL
+    SessionTab createTab(quint32 id, const QString &url)
+    {
+        SessionTab tab;
+        tab.Id = id;
+        tab.Url = QUrl(url);
+        tab.Title = url;
+        tab.History = url.toUtf8();
+        return tab;
+    }
+
+private:
+    /// Journal file used for testing
+    QString m_journalFile;
+};
+
+QTEST_APPLESS_MAIN(SessionJournalTest)
+
+#include "SessionJournalTest.moc"
@@ -1,13 +1,14 @@
 #include "CommonUtil.h"
 #include "DatabaseFactory.h"
+#include "DatabaseTaskScheduler.h"
 #include "FastHash.h"
 #include "FaviconManager.h"
-#include "HistoryManager.h"
-#include "HistoryStore.h"
+#include "FaviconStore.h"
 #include "HistorySuggestor.h"
 #include "ServiceLocator.h"
-#include "Settings.h"
+#include "URLRecord.h"
 #include "URLSuggestion.h"
+#include "URLSuggestionIndex.h"
 
 #include <atomic>
 #include <QDateTime>
@@ -16,7 +17,6 @@
 #include <QTest>
 
 const static QString TEST_FAVICON_DB_FILE = QStringLiteral("HISTORY_SUGGESTOR_TEST_FAVICON.db");
-const static QString TEST_DB_FILE = QStringLiteral("HISTORY_SUGGESTOR_TEST.db");
 
 class HistorySuggestorTest : public QObject
 {
@@ -38,63 +38,61 @@ class HistorySuggestorTest : public QObject
         return result;
     }
 
+    /// Adds a history entry with a single visit to the given index
+    void addHistoryEntry(URLSuggestionIndex &index, int visitId, const QUrl &url, const QString &title,
+                         const QDateTime &lastVisit, int urlTypedCount)
+    {
+        HistoryEntry entry;
+        entry.VisitID = visitId;
+        entry.URL = url;
+        entry.Title = title;
+        entry.LastVisit = lastVisit;
+        entry.NumVisits = 1;
+        entry.URLTypedCount = urlTypedCount;
+        index.addHistoryEntry(entry);
+    }
+
 private Q_SLOTS:
     /// Called before any tests are executed
     void initTestCase()
     {
-        if (QFile::exists(TEST_DB_FILE))
-            QFile::remove(TEST_DB_FILE);
-
         if (QFile::exists(TEST_FAVICON_DB_FILE))
             QFile::remove(TEST_FAVICON_DB_FILE);
     }
 
-    /// Called after every test function. This closes the DB connection and deallocates / clears
-    /// the HistoryStore instance
+    /// Called after every test function, removing the favicon database
     void cleanup()
     {
-        if (QFile::exists(TEST_DB_FILE))
-            QFile::remove(TEST_DB_FILE);
-
         if (QFile::exists(TEST_FAVICON_DB_FILE))
             QFile::remove(TEST_FAVICON_DB_FILE);
     }
 
     void testThatEntriesMatchByUrl()
     {
-        std::thread t1([this](){
         DatabaseTaskScheduler taskScheduler;
-        taskScheduler.addWorker("HistoryStore", std::bind(DatabaseFactory::createDBWorker<HistoryStore>, TEST_DB_FILE));
+        taskScheduler.addWorker("FaviconStore", std::bind(DatabaseFactory::createDBWorker<FaviconStore>, TEST_FAVICON_DB_FILE));
+        taskScheduler.run();
 
         ViperServiceLocator serviceLocator;
 
-        FaviconManager faviconManager(TEST_FAVICON_DB_FILE);
-        HistoryManager historyManager(serviceLocator, taskScheduler);
-
+        FaviconManager faviconManager(taskScheduler);
         QVERIFY(serviceLocator.addService(faviconManager.objectName().toStdString(), &faviconManager));
-        QVERIFY(serviceLocator.addService(historyManager.objectName().toStdString(), &historyManager));
-
-        taskScheduler.run();
 
-        // Let initialization routine complete
-        QTest::qWait(500);
+        URLSuggestionIndex index;
 
-        // Add a couple of entries to the database
+        // Add a couple of entries to the index
         QUrl firstUrl { QUrl::fromUserInput("https://viper-browser.com") },
              secondUrl { QUrl::fromUserInput("https://a.datacenter.website.net/landing") };
 
-        historyManager.addVisit(firstUrl, QLatin1String("Viper Browser"), QDateTime::currentDateTime(), firstUrl, true);
-        historyManager.addVisit(secondUrl, QLatin1String("Other Webpage"), QDateTime::currentDateTime(), secondUrl, true);
+        addHistoryEntry(index, 1, firstUrl, QLatin1String("Viper Browser"), QDateTime::currentDateTime(), 1);
+        addHistoryEntry(index, 2, secondUrl, QLatin1String("Other Webpage"), QDateTime::currentDateTime(), 1);
 
         // Finally instantiate the history suggestor
-        HistorySuggestor suggestor;
+        HistorySuggestor suggestor(index);
         suggestor.setServiceLocator(serviceLocator);
-        suggestor.setHistoryFile(TEST_DB_FILE);
 
         std::atomic_bool working { true };
 
-        QTest::qWait(2000);
-
         // Match by url and then by url tokens
         QString searchTerm("BROWSER.COM");
         FastHashParameters hashParams = getHashParams(searchTerm);
@@ -133,45 +131,34 @@ private Q_SLOTS:
         result = suggestor.getSuggestions(working, searchTerm, CommonUtil::tokenizePossibleUrl(searchTerm), hashParams);
 
         QVERIFY2(result.empty(), "Expected result set to be empty");
-        });
-        t1.join();
     }
 
     void testThatEntriesMatchByTitle()
     {
-        std::thread t1([this](){
         DatabaseTaskScheduler taskScheduler;
-        taskScheduler.addWorker("HistoryStore", std::bind(DatabaseFactory::createDBWorker<HistoryStore>, TEST_DB_FILE));
+        taskScheduler.addWorker("FaviconStore", std::bind(DatabaseFactory::createDBWorker<FaviconStore>, TEST_FAVICON_DB_FILE));
+        taskScheduler.run();
 
         ViperServiceLocator serviceLocator;
 
-        FaviconManager faviconManager(TEST_FAVICON_DB_FILE);
-        HistoryManager historyManager(serviceLocator, taskScheduler);
-
+        FaviconManager faviconManager(taskScheduler);
         QVERIFY(serviceLocator.addService(faviconManager.objectName().toStdString(), &faviconManager));
-        QVERIFY(serviceLocator.addService(historyManager.objectName().toStdString(), &historyManager));
 
-        taskScheduler.run();
-
-        // Let initialization routine complete
-        QTest::qWait(500);
+        URLSuggestionIndex index;
 
-        // Add a couple of entries to the database
+        // Add a couple of entries to the index
         QUrl firstUrl { QUrl::fromUserInput("https://randomblog.com") },
              secondUrl { QUrl::fromUserInput("https://charity.org/faq") };
 
-        historyManager.addVisit(firstUrl, QLatin1String("Reliable News"), QDateTime::currentDateTime(), firstUrl, true);
-        historyManager.addVisit(secondUrl, QLatin1String("Donate Today | FAQ"), QDateTime::currentDateTime().addDays(-1), secondUrl, false);
+        addHistoryEntry(index, 1, firstUrl, QLatin1String("Reliable News"), QDateTime::currentDateTime(), 1);
+        addHistoryEntry(index, 2, secondUrl, QLatin1String("Donate Today | FAQ"), QDateTime::currentDateTime().addDays(-1), 0);
 
         // Finally instantiate the history suggestor
-        HistorySuggestor suggestor;
+        HistorySuggestor suggestor(index);
         suggestor.setServiceLocator(serviceLocator);
-        suggestor.setHistoryFile(TEST_DB_FILE);
 
         std::atomic_bool working { true };
 
-        QTest::qWait(2000);
-
         // Match by title only
         QString searchTerm("NEWS");
         FastHashParameters hashParams = getHashParams(searchTerm);
@@ -206,8 +193,55 @@ private Q_SLOTS:
             QVERIFY(!suggestion.IsHostMatch);
             QVERIFY(suggestion.URLTypedCount == 0);
         }
-        });
-        t1.join();
+    }
+
+    void testThatEntriesMatchBySubstring()
+    {
+        DatabaseTaskScheduler taskScheduler;
+        taskScheduler.addWorker("FaviconStore", std::bind(DatabaseFactory::createDBWorker<FaviconStore>, TEST_FAVICON_DB_FILE));
+        taskScheduler.run();
+
+        ViperServiceLocator serviceLocator;
+
+        FaviconManager faviconManager(taskScheduler);
+        QVERIFY(serviceLocator.addService(faviconManager.objectName().toStdString(), &faviconManager));
+
+        URLSuggestionIndex index;
+
+        QUrl firstUrl { QUrl::fromUserInput("https://github.com/viper-browser") };
+        index.addVisit(firstUrl, QLatin1String("Repository"), QDateTime::currentDateTime());
+
+        // Revisit with a new title, which should replace the indexed title of the entry
+        index.addVisit(firstUrl, QLatin1String("Viper Source Code"), QDateTime::currentDateTime().addSecs(1));
+
+        HistorySuggestor suggestor(index);
+        suggestor.setServiceLocator(serviceLocator);
+
+        std::atomic_bool working { true };
+
+        // Match the middle of the host name
+        QString searchTerm("ITHU");
+        FastHashParameters hashParams = getHashParams(searchTerm);
+
+        std::vector<URLSuggestion> result =
+                suggestor.getSuggestions(working, searchTerm, CommonUtil::tokenizePossibleUrl(searchTerm), hashParams);
+
+        QVERIFY2(result.size() == 1, "Expected result set to have a single entry");
+        QVERIFY2(result[0].URL.compare(QLatin1String("https://github.com/viper-browser")) == 0, "URL Should match expectation");
+        QVERIFY(result[0].VisitCount == 2);
+
+        searchTerm = QLatin1String("SOURCE");
+        hashParams = getHashParams(searchTerm);
+        result = suggestor.getSuggestions(working, searchTerm, CommonUtil::tokenizePossibleUrl(searchTerm), hashParams);
+
+        QVERIFY2(result.size() == 1, "Expected result set to have a single entry");
+        QVERIFY2(result[0].Title.compare(QLatin1String("Viper Source Code")) == 0, "Title should match expectation");
+
+        searchTerm = QLatin1String("REPOSITORY");
+        hashParams = getHashParams(searchTerm);
+        result = suggestor.getSuggestions(working, searchTerm, CommonUtil::tokenizePossibleUrl(searchTerm), hashParams);
+
+        QVERIFY2(result.empty(), "Expected the previous title to be removed from the index");
     }
 
     void testThatStaleEntriesDontMatch()
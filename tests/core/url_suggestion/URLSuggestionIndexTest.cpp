@@ -0,0 +1,240 @@
+#include "URLRecord.h"
+#include "URLSuggestionIndex.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <QDateTime>
+#include <QObject>
+#include <QTest>
+#include <QUrl>
+
+class URLSuggestionIndexTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    URLSuggestionIndexTest() :
+        QObject(nullptr)
+    {
+    }
+
+private:
+    /// Returns the URLs of each of the given entries, in sorted order
+    std::vector<QString> getUrls(const URLSuggestionIndex &index, const std::vector<URLSuggestionIndex::EntryId> &ids)
+    {
+        std::vector<QString> result;
+        for (URLSuggestionIndex::EntryId id : ids)
+            result.push_back(index.getEntry(id).URL.toString());
+
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    /// Adds a history entry with the given URL and title to the index
+    void addHistoryEntry(URLSuggestionIndex &index, const QString &url, const QString &title, int visitId)
+    {
+        HistoryEntry entry;
+        entry.VisitID = visitId;
+        entry.URL = QUrl(url);
+        entry.Title = title;
+        entry.NumVisits = 1;
+        entry.LastVisit = QDateTime::currentDateTime();
+        index.addHistoryEntry(entry);
+    }
+
+private Q_SLOTS:
+    /// Verifies that hosts are matched by prefix, ignoring any www. prefix
+    void testHostPrefixMatch()
+    {
+        URLSuggestionIndex index;
+        index.beginLoading();
+        addHistoryEntry(index, QLatin1String("https://www.github.com/viper"), QLatin1String("Viper"), 1);
+        addHistoryEntry(index, QLatin1String("https://gitlab.com"), QLatin1String("GitLab"), 2);
+        addHistoryEntry(index, QLatin1String("https://example.com"), QLatin1String("Example"), 3);
+        index.finishLoading();
+
+        std::vector<QString> urls = getUrls(index, index.findByHostPrefix(QLatin1String("GIT")));
+        QCOMPARE(urls.size(), size_t{2});
+        QCOMPARE(urls.at(0), QLatin1String("https://gitlab.com"));
+        QCOMPARE(urls.at(1), QLatin1String("https://www.github.com/viper"));
+
+        urls = getUrls(index, index.findByHostPrefix(QLatin1String("WWW.GITH")));
+        QCOMPARE(urls.size(), size_t{1});
+
+        QVERIFY(index.findByHostPrefix(QLatin1String("VIPER")).empty());
+    }
+
+    /// Verifies that substrings of URLs and titles are found through the trigram postings
+    void testSubstringMatch()
+    {
+        URLSuggestionIndex index;
+        addHistoryEntry(index, QLatin1String("https://github.com/viper"), QLatin1String("Viper Source"), 1);
+        addHistoryEntry(index, QLatin1String("https://charity.org/faq"), QLatin1String("Donate Today"), 2);
+
+        std::vector<QString> urls = getUrls(index, index.findBySubstring(QLatin1String("ITHU")));
+        QCOMPARE(urls.size(), size_t{1});
+        QCOMPARE(urls.at(0), QLatin1String("https://github.com/viper"));
+
+        urls = getUrls(index, index.findBySubstring(QLatin1String("DONATE")));
+        QCOMPARE(urls.size(), size_t{1});
+        QCOMPARE(urls.at(0), QLatin1String("https://charity.org/faq"));
+
+        // Terms that do not appear in any entry are not matched
+        QVERIFY(index.findBySubstring(QLatin1String("HUB.ORG")).empty());
+
+        // Too short to be resolved by trigrams
+        QVERIFY(index.findBySubstring(QLatin1String("GI")).empty());
+    }
+
+    /// Verifies that visits update existing entries and that new titles become searchable
+    void testIncrementalVisit()
+    {
+        URLSuggestionIndex index;
+        addHistoryEntry(index, QLatin1String("https://github.com/viper"), QLatin1String("Dashboard"), 1);
+
+        index.addVisit(QUrl(QLatin1String("https://github.com/viper")), QLatin1String("Release Notes"), QDateTime::currentDateTime());
+        index.addVisit(QUrl(QLatin1String("https://news.site")), QLatin1String("Headlines"), QDateTime::currentDateTime());
+
+        std::vector<URLSuggestionIndex::EntryId> ids = index.findBySubstring(QLatin1String("RELEASE"));
+        QCOMPARE(ids.size(), size_t{1});
+        QCOMPARE(index.getEntry(ids.at(0)).VisitCount, 2);
+
+        // The previous title is no longer reported as a match
+        QVERIFY(index.findBySubstring(QLatin1String("DASHBOARD")).empty());
+
+        ids = index.findByHostPrefix(QLatin1String("NEWS"));
+        QCOMPARE(ids.size(), size_t{1});
+        QVERIFY(index.getEntry(ids.at(0)).IsHistory);
+    }
+
+    /// Verifies that the matches of a search term can be narrowed to those of a longer term
+    void testFilterMatches()
+    {
+        URLSuggestionIndex index;
+        addHistoryEntry(index, QLatin1String("https://www.github.com/viper"), QLatin1String("Viper"), 1);
+        addHistoryEntry(index, QLatin1String("https://gitlab.com"), QLatin1String("GitLab"), 2);
+        addHistoryEntry(index, QLatin1String("https://example.com/git"), QLatin1String("Example"), 3);
+
+        std::vector<URLSuggestionIndex::EntryId> candidates = index.findByHostPrefix(QLatin1String("GIT"));
+        std::vector<URLSuggestionIndex::EntryId> substringMatches = index.findBySubstring(QLatin1String("GIT"));
+        candidates.insert(candidates.end(), substringMatches.begin(), substringMatches.end());
+
+        std::vector<QString> urls = getUrls(index, index.filterMatches(candidates, QLatin1String("GITH")));
+        QCOMPARE(urls.size(), size_t{1});
+        QCOMPARE(urls.at(0), QLatin1String("https://www.github.com/viper"));
+
+        urls = getUrls(index, index.filterMatches(candidates, QLatin1String("GITLAB.COM")));
+        QCOMPARE(urls.size(), size_t{1});
+        QCOMPARE(urls.at(0), QLatin1String("https://gitlab.com"));
+    }
+
+    /// Verifies that the matches of a term with a "www." prefix are not narrowed from those of a shorter term,
+    /// as the prefix is removed before hosts are matched
+    void testNarrowingWithWwwPrefix()
+    {
+        URLSuggestionIndex index;
+        addHistoryEntry(index, QLatin1String("https://www.github.com/viper"), QLatin1String("Viper"), 1);
+        addHistoryEntry(index, QLatin1String("https://example.com"), QLatin1String("Example"), 2);
+
+        QVERIFY(URLSuggestionIndex::isNarrowingOf(QLatin1String("GIT"), QLatin1String("GITH")));
+        QVERIFY(!URLSuggestionIndex::isNarrowingOf(QLatin1String("GI"), QLatin1String("GIT")));
+        QVERIFY(!URLSuggestionIndex::isNarrowingOf(QLatin1String("GIT"), QLatin1String("GOT")));
+        QVERIFY(!URLSuggestionIndex::isNarrowingOf(QLatin1String("WWW"), QLatin1String("WWW.EX")));
+        QVERIFY(!URLSuggestionIndex::isNarrowingOf(QLatin1String("WWW.E"), QLatin1String("WWW.EX")));
+
+        // The host of example.com begins with "EX", but the entry did not match "WWW"
+        std::vector<URLSuggestionIndex::EntryId> candidates = index.findByHostPrefix(QLatin1String("WWW"));
+        std::vector<URLSuggestionIndex::EntryId> substringMatches = index.findBySubstring(QLatin1String("WWW"));
+        candidates.insert(candidates.end(), substringMatches.begin(), substringMatches.end());
+        QCOMPARE(getUrls(index, candidates), std::vector<QString>({ QLatin1String("https://www.github.com/viper") }));
+
+        QCOMPARE(getUrls(index, index.findByHostPrefix(QLatin1String("WWW.EX"))),
+                 std::vector<QString>({ QLatin1String("https://example.com") }));
+    }
+
+    /// Verifies that the revision of the index changes along with its contents
+    void testRevision()
+    {
+        URLSuggestionIndex index;
+        const uint64_t initialRevision = index.getRevision();
+
+        addHistoryEntry(index, QLatin1String("https://github.com"), QLatin1String("GitHub"), 1);
+        const uint64_t historyRevision = index.getRevision();
+        QVERIFY(historyRevision != initialRevision);
+
+        index.findBySubstring(QLatin1String("GITHUB"));
+        QCOMPARE(index.getRevision(), historyRevision);
+
+        index.addVisit(QUrl(QLatin1String("https://github.com")), QString(), QDateTime::currentDateTime());
+        QVERIFY(index.getRevision() != historyRevision);
+    }
+
+    /// Verifies that bookmark entries can be cleared and reloaded
+    void testBookmarks()
+    {
+        URLSuggestionIndex index;
+        index.addBookmark(QUrl(QLatin1String("https://docs.qt.io")), QLatin1String("Qt Documentation"), QLatin1String("qt"));
+        QCOMPARE(index.getBookmarks().size(), size_t{1});
+        QCOMPARE(index.getEntry(index.getBookmarks().at(0)).Shortcut, QLatin1String("QT"));
+        QCOMPARE(index.findBySubstring(QLatin1String("DOCUMENT")).size(), size_t{1});
+
+        index.clearBookmarks();
+        QVERIFY(index.getBookmarks().empty());
+        QVERIFY(index.findBySubstring(QLatin1String("DOCUMENT")).empty());
+        QVERIFY(index.findByHostPrefix(QLatin1String("DOCS")).empty());
+
+        index.addBookmark(QUrl(QLatin1String("https://docs.qt.io")), QLatin1String("Qt Docs"), QString());
+        QCOMPARE(index.getBookmarks().size(), size_t{1});
+        QCOMPARE(index.findByHostPrefix(QLatin1String("DOCS")).size(), size_t{1});
+    }
+
+    /// Verifies that clearing the history keeps bookmarked entries, and that visits are counted from zero afterwards
+    void testClearHistory()
+    {
+        URLSuggestionIndex index;
+        addHistoryEntry(index, QLatin1String("https://github.com"), QLatin1String("GitHub"), 1);
+        addHistoryEntry(index, QLatin1String("https://docs.qt.io"), QLatin1String("Qt Documentation"), 2);
+        index.addBookmark(QUrl(QLatin1String("https://docs.qt.io")), QLatin1String("Qt Docs"), QString());
+
+        const uint64_t revision = index.getRevision();
+        index.clearHistory();
+        QVERIFY(index.getRevision() != revision);
+
+        QVERIFY(index.findByHostPrefix(QLatin1String("GITHUB")).empty());
+        QVERIFY(index.findBySubstring(QLatin1String("GITHUB")).empty());
+
+        const std::vector<URLSuggestionIndex::EntryId> bookmarkMatches = index.findByHostPrefix(QLatin1String("DOCS"));
+        QCOMPARE(bookmarkMatches.size(), size_t{1});
+        QVERIFY(!index.getEntry(bookmarkMatches.at(0)).IsHistory);
+        QCOMPARE(index.getEntry(bookmarkMatches.at(0)).VisitCount, 0);
+
+        index.addVisit(QUrl(QLatin1String("https://github.com")), QString(), QDateTime::currentDateTime());
+        const std::vector<URLSuggestionIndex::EntryId> historyMatches = index.findByHostPrefix(QLatin1String("GITHUB"));
+        QCOMPARE(historyMatches.size(), size_t{1});
+        QCOMPARE(index.getEntry(historyMatches.at(0)).VisitCount, 1);
+    }
+
+    /// Verifies that swapping two indices exchanges their contents and advances both revisions
+    void testSwap()
+    {
+        URLSuggestionIndex index, other;
+        addHistoryEntry(index, QLatin1String("https://github.com"), QLatin1String("GitHub"), 1);
+        addHistoryEntry(other, QLatin1String("https://docs.qt.io"), QLatin1String("Qt Documentation"), 1);
+
+        const uint64_t revision = std::max(index.getRevision(), other.getRevision());
+        index.swap(other);
+
+        QVERIFY(index.getRevision() > revision);
+        QVERIFY(other.getRevision() > revision);
+        QVERIFY(index.findByHostPrefix(QLatin1String("GITHUB")).empty());
+        QCOMPARE(getUrls(index, index.findByHostPrefix(QLatin1String("DOCS"))),
+                 std::vector<QString>({ QLatin1String("https://docs.qt.io") }));
+        QCOMPARE(getUrls(other, other.findByHostPrefix(QLatin1String("GITHUB"))),
+                 std::vector<QString>({ QLatin1String("https://github.com") }));
+    }
+};
+
+QTEST_APPLESS_MAIN(URLSuggestionIndexTest)
+
+#include "URLSuggestionIndexTest.moc"
@@ -0,0 +1,133 @@
+#include "UserScript.h"
+#include "UserScriptMatcher.h"
+
+#include <vector>
+
+#include <QFile>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QTest>
+#include <QUrl>
+
+/// Exposes the loading of user scripts from a file, for testing
+class TestUserScript : public UserScript
+{
+public:
+    using UserScript::load;
+};
+
+/// Tests the matching of user scripts to URLs by their @include, @match and @exclude rules
+class UserScriptMatcherTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    UserScriptMatcherTest() :
+        QObject(nullptr),
+        m_scriptFile(QLatin1String("UserScriptMatcherTest.user.js"))
+    {
+    }
+
+private slots:
+    /// Removes the script file written by each test
+    void cleanup()
+    {
+        if (QFile::exists(m_scriptFile))
+            QFile::remove(m_scriptFile);
+    }
+
+    /// Verifies that host rules only match the named host, or the named domain and its subdomains
+    void testHostRules()
+    {
+        std::vector<UserScript> scripts;
+        scripts.push_back(loadScript({ QLatin1String("@include http://example.com/*") }));
+        scripts.push_back(loadScript({ QLatin1String("@match *://*.example.com/foo*") }));
+        scripts.push_back(loadScript({ QLatin1String("@include https://*.example.org/*") }));
+        scripts.push_back(loadScript({ QLatin1String("@match file:///home/*") }));
+
+        UserScriptMatcher matcher;
+        matcher.build(scripts);
+
+        // Check each URL twice, the second time with the rules of its origin in the cache
+        for (int i = 0; i < 2; ++i)
+        {
+            QCOMPARE(matcher.match(QUrl(QLatin1String("http://example.com/"))), std::vector<int>({ 0 }));
+            QCOMPARE(matcher.match(QUrl(QLatin1String("http://example.com/foo"))), std::vector<int>({ 0, 1 }));
+            QCOMPARE(matcher.match(QUrl(QLatin1String("https://a.b.example.com/foobar?q=1"))), std::vector<int>({ 1 }));
+            QCOMPARE(matcher.match(QUrl(QLatin1String("https://www.example.org/index.html"))), std::vector<int>({ 2 }));
+            QCOMPARE(matcher.match(QUrl(QLatin1String("file:///home/user/page.html"))), std::vector<int>({ 3 }));
+
+            QVERIFY(matcher.match(QUrl(QLatin1String("http://badexample.com/foo"))).empty());
+            QVERIFY(matcher.match(QUrl(QLatin1String("https://example.org/"))).empty());
+            QVERIFY(matcher.match(QUrl(QLatin1String("http://example.com:8080/"))).empty());
+            QVERIFY(matcher.match(QUrl(QLatin1String("ftp://example.com/foo"))).empty());
+            QVERIFY(matcher.match(QUrl(QLatin1String("http://evil.com/?http://example.com/"))).empty());
+        }
+    }
+
+    /// Verifies that scripts without rules match every URL, and that exclude rules take priority over include rules
+    void testIncludeAndExclude()
+    {
+        std::vector<UserScript> scripts;
+        scripts.push_back(loadScript({}));
+        scripts.push_back(loadScript({ QLatin1String("@include *://*.example.org/*"), QLatin1String("@exclude */private/*") }));
+        scripts.push_back(loadScript({ QLatin1String("@include /^https?://regex\\.net/.*$/") }));
+        scripts.push_back(loadScript({ QLatin1String("@include *example.net*") }));
+
+        UserScriptMatcher matcher;
+        matcher.build(scripts);
+
+        QCOMPARE(matcher.match(QUrl(QLatin1String("about:blank"))), std::vector<int>({ 0 }));
+        QCOMPARE(matcher.match(QUrl(QLatin1String("https://www.example.org/public/"))), std::vector<int>({ 0, 1 }));
+        QCOMPARE(matcher.match(QUrl(QLatin1String("https://www.example.org/private/"))), std::vector<int>({ 0 }));
+        QCOMPARE(matcher.match(QUrl(QLatin1String("http://regex.net/page"))), std::vector<int>({ 0, 2 }));
+        QCOMPARE(matcher.match(QUrl(QLatin1String("http://www.example.net/"))), std::vector<int>({ 0, 3 }));
+    }
+
+    /// Verifies that disabled scripts are not matched, and that rebuilding the matcher replaces the cached results
+    void testRebuild()
+    {
+        std::vector<UserScript> scripts;
+        scripts.push_back(loadScript({ QLatin1String("@match https://example.com/*") }));
+
+        UserScriptMatcher matcher;
+        matcher.build(scripts);
+        QCOMPARE(matcher.match(QUrl(QLatin1String("https://example.com/"))), std::vector<int>({ 0 }));
+
+        scripts.at(0).setEnabled(false);
+        matcher.build(scripts);
+        QVERIFY(matcher.match(QUrl(QLatin1String("https://example.com/"))).empty());
+
+        matcher.clear();
+        QVERIFY(matcher.match(QUrl(QLatin1String("https://example.com/"))).empty());
+    }
+
+private:
+    /// Writes a user script with the given metadata lines to the script file, and loads it
+    UserScript loadScript(const QStringList &metaData)
+    {
+        QFile f(m_scriptFile);
+        if (!f.open(QIODevice::WriteOnly | QIODevice::Text))
+            return UserScript();
+
+        QByteArray scriptData("// ==UserScript==\n// @name Test\n");
+        for (const QString &line : metaData)
+            scriptData.append(QString("// %1\n").arg(line).toUtf8());
+        scriptData.append("// ==/UserScript==\n\nconsole.log('test');\n");
+        f.write(scriptData);
+        f.close();
+
+        TestUserScript script;
+        script.load(m_scriptFile, QLatin1String("{{USER_SCRIPT}}"));
+        return script;
+    }
+
+private:
+    /// User script file used for testing
+    QString m_scriptFile;
+};
+
+QTEST_APPLESS_MAIN(UserScriptMatcherTest)
+
+#include "UserScriptMatcherTest.moc"
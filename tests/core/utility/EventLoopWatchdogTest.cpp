@@ -0,0 +1,51 @@
+#include "EventLoopWatchdog.h"
+
+#include <QObject>
+#include <QSignalSpy>
+#include <QTest>
+#include <QThread>
+
+/// Tests the detection of event loop stalls
+class EventLoopWatchdogTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    EventLoopWatchdogTest() : QObject(nullptr) {}
+
+private slots:
+    /// Verifies that an idle event loop is not reported as stalled
+    void testIdleEventLoop()
+    {
+        EventLoopWatchdog watchdog(20, 200);
+        watchdog.start();
+        QTest::qWait(200);
+
+        QCOMPARE(watchdog.getStats().Count, 0);
+    }
+
+    /// Verifies that blocking the event loop is reported as a stall of about the same duration
+    void testBlockedEventLoop()
+    {
+        EventLoopWatchdog watchdog(20, 200);
+        QSignalSpy spy(&watchdog, &EventLoopWatchdog::stallDetected);
+        watchdog.start();
+
+        QThread::msleep(400);
+        QTest::qWait(100);
+
+        QCOMPARE(watchdog.getStats().Count, 1);
+        QCOMPARE(spy.count(), 1);
+        QVERIFY(watchdog.getStats().LongestMs >= 300);
+        QCOMPARE(watchdog.getStats().TotalMs, watchdog.getStats().LongestMs);
+
+        watchdog.stop();
+        QThread::msleep(400);
+        QTest::qWait(100);
+        QCOMPARE(watchdog.getStats().Count, 1);
+    }
+};
+
+QTEST_GUILESS_MAIN(EventLoopWatchdogTest)
+
+#include "EventLoopWatchdogTest.moc"
@@ -0,0 +1,88 @@
+#include "TabHibernationPolicy.h"
+
+#include <vector>
+
+#include <QObject>
+#include <QTest>
+
+namespace
+{
+    /// One minute, in milliseconds
+    constexpr qint64 Minute = 60 * 1000;
+
+    /// Memory unit used by the tests
+    constexpr qint64 MB = 1024 * 1024;
+}
+
+/// Tests the selection of background tabs to hibernate by the \ref TabHibernationPolicy
+class TabHibernationPolicyTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /// Verifies that no tabs are selected when automatic hibernation is disabled
+    void testDisabled()
+    {
+        TabHibernationPolicy policy;
+        QVERIFY(!policy.isEnabled());
+
+        std::vector<TabActivity> tabs { { 0, false }, { 0, false } };
+        QVERIFY(policy.selectTabs(tabs, 100, 1000 * Minute, 100000 * MB).empty());
+    }
+
+    /// Verifies that tabs which have been idle past the timeout are selected from least to most recently used
+    void testIdleTimeout()
+    {
+        TabHibernationPolicy policy(TabHibernationMode::Aggressive, 0);
+        const qint64 now = 1000 * Minute;
+
+        std::vector<TabActivity> tabs {
+            { now - 6 * Minute, false },
+            { now - 1 * Minute, false },
+            { now - 20 * Minute, false },
+            { now - 30 * Minute, true }
+        };
+
+        const std::vector<std::size_t> expected { 2, 0 };
+        QCOMPARE(policy.selectTabs(tabs, 5, now, -1), expected);
+    }
+
+    /// Verifies that the least recently used tabs are selected when too many tabs are awake, skipping exempt tabs
+    void testMaxAwakeTabs()
+    {
+        TabHibernationPolicy policy(TabHibernationMode::Balanced, 0);
+        const qint64 now = 1000 * Minute;
+
+        std::vector<TabActivity> tabs;
+        for (int i = 0; i < 40; ++i)
+            tabs.push_back(TabActivity { now - i * 1000, i == 39 });
+
+        // 41 awake tabs including the current tab, 11 more than the limit
+        const std::vector<std::size_t> selected = policy.selectTabs(tabs, 41, now, -1);
+        QCOMPARE(selected.size(), std::size_t(11));
+        QCOMPARE(selected.front(), std::size_t(38));
+        QCOMPARE(selected.back(), std::size_t(28));
+    }
+
+    /// Verifies that enough tabs are selected to bring the estimated memory usage under the limit
+    void testMemoryLimit()
+    {
+        TabHibernationPolicy policy(TabHibernationMode::Balanced, 1000 * MB);
+        const qint64 now = 1000 * Minute;
+
+        std::vector<TabActivity> tabs;
+        for (int i = 0; i < 9; ++i)
+            tabs.push_back(TabActivity { now - i * 1000, false });
+
+        // 10 awake tabs using 130MB each, 300MB above the limit
+        const std::vector<std::size_t> selected = policy.selectTabs(tabs, 10, now, 1300 * MB);
+        const std::vector<std::size_t> expected { 8, 7, 6 };
+        QCOMPARE(selected, expected);
+
+        QVERIFY(policy.selectTabs(tabs, 10, now, 900 * MB).empty());
+    }
+};
+
+QTEST_APPLESS_MAIN(TabHibernationPolicyTest)
+
+#include "TabHibernationPolicyTest.moc"